@@ -67,37 +67,34 @@ double CAddrInfo::GetChance(int64_t nNow) const
 
 CAddrInfo* CAddrMan::Find(const CService& addr, int* pnId)
 {
-    CService addr2 = addr;
-    if (!discriminatePorts) {
-        addr2.SetPort(0);
-    }
-
-    std::map<CService, int>::iterator it = mapAddr.find(addr2);
+    auto it = mapAddr.find(GetAddrKey(addr));
     if (it == mapAddr.end())
         return nullptr;
     if (pnId)
         *pnId = (*it).second;
-    std::map<int, CAddrInfo>::iterator it2 = mapInfo.find((*it).second);
-    if (it2 != mapInfo.end())
-        return &(*it2).second;
+    if (IsUsedId((*it).second))
+        return &vInfo[(*it).second];
     return nullptr;
 }
 
 CAddrInfo* CAddrMan::Create(const CAddress& addr, const CNetAddr& addrSource, int* pnId)
 {
-    CService addr2 = addr;
-    if (!discriminatePorts) {
-        addr2.SetPort(0);
+    int nId;
+    if (!vFreeIds.empty()) {
+        nId = vFreeIds.back();
+        vFreeIds.pop_back();
+        vInfo[nId] = CAddrInfo(addr, addrSource);
+    } else {
+        nId = vInfo.size();
+        vInfo.emplace_back(addr, addrSource);
+        vNewRefs.emplace_back();
     }
-
-    int nId = nIdCount++;
-    mapInfo[nId] = CAddrInfo(addr, addrSource);
-    mapAddr[addr2] = nId;
-    mapInfo[nId].nRandomPos = vRandom.size();
+    mapAddr[GetAddrKey(addr)] = nId;
+    vInfo[nId].nRandomPos = vRandom.size();
     vRandom.push_back(nId);
     if (pnId)
         *pnId = nId;
-    return &mapInfo[nId];
+    return &vInfo[nId];
 }
 
 void CAddrMan::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2)
@@ -110,11 +107,11 @@ void CAddrMan::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2)
     int nId1 = vRandom[nRndPos1];
     int nId2 = vRandom[nRndPos2];
 
-    assert(mapInfo.count(nId1) == 1);
-    assert(mapInfo.count(nId2) == 1);
+    assert(IsUsedId(nId1));
+    assert(IsUsedId(nId2));
 
-    mapInfo[nId1].nRandomPos = nRndPos2;
-    mapInfo[nId2].nRandomPos = nRndPos1;
+    vInfo[nId1].nRandomPos = nRndPos2;
+    vInfo[nId2].nRandomPos = nRndPos1;
 
     vRandom[nRndPos1] = nId2;
     vRandom[nRndPos2] = nId1;
@@ -122,20 +119,18 @@ void CAddrMan::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2)
 
 void CAddrMan::Delete(int nId)
 {
-    assert(mapInfo.count(nId) != 0);
-    CAddrInfo& info = mapInfo[nId];
+    assert(IsUsedId(nId));
+    CAddrInfo& info = vInfo[nId];
     assert(!info.fInTried);
     assert(info.nRefCount == 0);
 
-    CService addr = info;
-    if (!discriminatePorts) {
-        addr.SetPort(0);
-    }
-
     SwapRandom(info.nRandomPos, vRandom.size() - 1);
     vRandom.pop_back();
-    mapAddr.erase(addr);
-    mapInfo.erase(nId);
+    mapAddr.erase(GetAddrKey(info));
+    // the slot is reused, so a pending collision must not outlive its entry
+    m_tried_collisions.erase(nId);
+    info = CAddrInfo();
+    vFreeIds.push_back(nId);
     nNew--;
 }
 
@@ -144,25 +139,43 @@ void CAddrMan::ClearNew(int nUBucket, int nUBucketPos)
     // if there is an entry in the specified bucket, delete it.
     if (vvNew[nUBucket][nUBucketPos] != -1) {
         int nIdDelete = vvNew[nUBucket][nUBucketPos];
-        CAddrInfo& infoDelete = mapInfo[nIdDelete];
-        assert(infoDelete.nRefCount > 0);
-        infoDelete.nRefCount--;
-        vvNew[nUBucket][nUBucketPos] = -1;
-        if (infoDelete.nRefCount == 0) {
+        UnsetNew(nUBucket, nUBucketPos);
+        if (vInfo[nIdDelete].nRefCount == 0) {
             Delete(nIdDelete);
         }
     }
 }
 
+void CAddrMan::SetNew(int nUBucket, int nUBucketPos, int nId)
+{
+    assert(vvNew[nUBucket][nUBucketPos] == -1);
+    CAddrInfo& info = vInfo[nId];
+    assert(info.nRefCount < ADDRMAN_NEW_BUCKETS_PER_ADDRESS);
+    vNewRefs[nId][info.nRefCount++] = nUBucket * ADDRMAN_BUCKET_SIZE + nUBucketPos;
+    vvNew[nUBucket][nUBucketPos] = nId;
+}
+
+void CAddrMan::UnsetNew(int nUBucket, int nUBucketPos)
+{
+    int nId = vvNew[nUBucket][nUBucketPos];
+    assert(IsUsedId(nId));
+    CAddrInfo& info = vInfo[nId];
+    auto& refs = vNewRefs[nId];
+    const uint16_t nSlot = nUBucket * ADDRMAN_BUCKET_SIZE + nUBucketPos;
+    int i = 0;
+    while (i < info.nRefCount && refs[i] != nSlot)
+        i++;
+    assert(i < info.nRefCount);
+    refs[i] = refs[--info.nRefCount];
+    vvNew[nUBucket][nUBucketPos] = -1;
+}
+
 void CAddrMan::MakeTried(CAddrInfo& info, int nId)
 {
     // remove the entry from all new buckets
-    for (int bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; bucket++) {
-        int pos = info.GetBucketPosition(nKey, true, bucket);
-        if (vvNew[bucket][pos] == nId) {
-            vvNew[bucket][pos] = -1;
-            info.nRefCount--;
-        }
+    while (info.nRefCount > 0) {
+        int nSlot = vNewRefs[nId][info.nRefCount - 1];
+        UnsetNew(nSlot / ADDRMAN_BUCKET_SIZE, nSlot % ADDRMAN_BUCKET_SIZE);
     }
     nNew--;
 
@@ -176,8 +189,8 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId)
     if (vvTried[nKBucket][nKBucketPos] != -1) {
         // find an item to evict
         int nIdEvict = vvTried[nKBucket][nKBucketPos];
-        assert(mapInfo.count(nIdEvict) == 1);
-        CAddrInfo& infoOld = mapInfo[nIdEvict];
+        assert(IsUsedId(nIdEvict));
+        CAddrInfo& infoOld = vInfo[nIdEvict];
 
         // Remove the to-be-evicted item from the tried set.
         infoOld.fInTried = false;
@@ -191,8 +204,8 @@ void CAddrMan::MakeTried(CAddrInfo& info, int nId)
         assert(vvNew[nUBucket][nUBucketPos] == -1);
 
         // Enter it into the new set again.
-        infoOld.nRefCount = 1;
-        vvNew[nUBucket][nUBucketPos] = nIdEvict;
+        assert(infoOld.nRefCount == 0);
+        SetNew(nUBucket, nUBucketPos, nIdEvict);
         nNew++;
     }
     assert(vvTried[nKBucket][nKBucketPos] == -1);
@@ -231,21 +244,13 @@ void CAddrMan::Good_(const CService& addr, bool test_before_evict, int64_t nTime
     if (info.fInTried)
         return;
 
-    // find a bucket it is in now
-    int nRnd = RandomInt(ADDRMAN_NEW_BUCKET_COUNT);
-    int nUBucket = -1;
-    for (unsigned int n = 0; n < ADDRMAN_NEW_BUCKET_COUNT; n++) {
-        int nB = (n + nRnd) % ADDRMAN_NEW_BUCKET_COUNT;
-        int nBpos = info.GetBucketPosition(nKey, true, nB);
-        if (vvNew[nB][nBpos] == nId) {
-            nUBucket = nB;
-            break;
-        }
-    }
+    // The buckets referencing nId are tracked in vNewRefs, so no scan over all "new" buckets is needed.
+    // The random draw of the former scan start is kept so the RandomInt() sequence stays unchanged.
+    RandomInt(ADDRMAN_NEW_BUCKET_COUNT);
 
-    // if no bucket is found, something bad happened;
+    // if it is in no bucket, something bad happened;
     // TODO: maybe re-add the node, but for now, just bail out
-    if (nUBucket == -1)
+    if (info.nRefCount == 0)
         return;
 
     // which tried bucket to move the entry to
@@ -320,7 +325,7 @@ bool CAddrMan::Add_(const CAddress& addr, const CNetAddr& source, int64_t nTimeP
     if (vvNew[nUBucket][nUBucketPos] != nId) {
         bool fInsert = vvNew[nUBucket][nUBucketPos] == -1;
         if (!fInsert) {
-            CAddrInfo& infoExisting = mapInfo[vvNew[nUBucket][nUBucketPos]];
+            CAddrInfo& infoExisting = vInfo[vvNew[nUBucket][nUBucketPos]];
             if (infoExisting.IsTerrible() || (infoExisting.nRefCount > 1 && pinfo->nRefCount == 0)) {
                 // Overwrite the existing new table entry.
                 fInsert = true;
@@ -328,8 +333,7 @@ bool CAddrMan::Add_(const CAddress& addr, const CNetAddr& source, int64_t nTimeP
         }
         if (fInsert) {
             ClearNew(nUBucket, nUBucketPos);
-            pinfo->nRefCount++;
-            vvNew[nUBucket][nUBucketPos] = nId;
+            SetNew(nUBucket, nUBucketPos, nId);
         } else {
             if (pinfo->nRefCount == 0) {
                 Delete(nId);
@@ -382,8 +386,8 @@ CAddrInfo CAddrMan::Select_(bool newOnly)
                 nKBucketPos = (nKBucketPos + insecure_rand.randbits(ADDRMAN_BUCKET_SIZE_LOG2)) % ADDRMAN_BUCKET_SIZE;
             }
             int nId = vvTried[nKBucket][nKBucketPos];
-            assert(mapInfo.count(nId) == 1);
-            CAddrInfo& info = mapInfo[nId];
+            assert(IsUsedId(nId));
+            CAddrInfo& info = vInfo[nId];
             if (RandomInt(1 << 30) < fChanceFactor * info.GetChance() * (1 << 30))
                 return info;
             fChanceFactor *= 1.2;
@@ -399,8 +403,8 @@ CAddrInfo CAddrMan::Select_(bool newOnly)
                 nUBucketPos = (nUBucketPos + insecure_rand.randbits(ADDRMAN_BUCKET_SIZE_LOG2)) % ADDRMAN_BUCKET_SIZE;
             }
             int nId = vvNew[nUBucket][nUBucketPos];
-            assert(mapInfo.count(nId) == 1);
-            CAddrInfo& info = mapInfo[nId];
+            assert(IsUsedId(nId));
+            CAddrInfo& info = vInfo[nId];
             if (RandomInt(1 << 30) < fChanceFactor * info.GetChance() * (1 << 30))
                 return info;
             fChanceFactor *= 1.2;
@@ -417,9 +421,10 @@ int CAddrMan::Check_()
     if (vRandom.size() != (size_t)(nTried + nNew))
         return -7;
 
-    for (const auto& entry : mapInfo) {
-        int n = entry.first;
-        const CAddrInfo& info = entry.second;
+    for (int n = 0; n < (int)vInfo.size(); n++) {
+        const CAddrInfo& info = vInfo[n];
+        if (info.nRandomPos == -1)
+            continue;
         if (info.fInTried) {
             if (!info.nLastSuccess)
                 return -1;
@@ -432,8 +437,13 @@ int CAddrMan::Check_()
             if (!info.nRefCount)
                 return -4;
             mapNew[n] = info.nRefCount;
+            for (int i = 0; i < info.nRefCount; i++) {
+                int nSlot = vNewRefs[n][i];
+                if (vvNew[nSlot / ADDRMAN_BUCKET_SIZE][nSlot % ADDRMAN_BUCKET_SIZE] != n)
+                    return -20;
+            }
         }
-        if (mapAddr[info] != n)
+        if (mapAddr[GetAddrKey(info)] != n)
             return -5;
         if (info.nRandomPos < 0 || (size_t)info.nRandomPos >= vRandom.size() || vRandom[info.nRandomPos] != n)
             return -14;
@@ -453,9 +463,9 @@ int CAddrMan::Check_()
              if (vvTried[n][i] != -1) {
                  if (!setTried.count(vvTried[n][i]))
                      return -11;
-                 if (mapInfo[vvTried[n][i]].GetTriedBucket(nKey) != n)
+                 if (vInfo[vvTried[n][i]].GetTriedBucket(nKey) != n)
                      return -17;
-                 if (mapInfo[vvTried[n][i]].GetBucketPosition(nKey, false, n) != i)
+                 if (vInfo[vvTried[n][i]].GetBucketPosition(nKey, false, n) != i)
                      return -18;
                  setTried.erase(vvTried[n][i]);
              }
@@ -467,7 +477,7 @@ int CAddrMan::Check_()
             if (vvNew[n][i] != -1) {
                 if (!mapNew.count(vvNew[n][i]))
                     return -12;
-                if (mapInfo[vvNew[n][i]].GetBucketPosition(nKey, true, n) != i)
+                if (vInfo[vvNew[n][i]].GetBucketPosition(nKey, true, n) != i)
                     return -19;
                 if (--mapNew[vvNew[n][i]] == 0)
                     mapNew.erase(vvNew[n][i]);
@@ -499,9 +509,9 @@ void CAddrMan::GetAddr_(std::vector<CAddress>& vAddr)
 
         int nRndPos = RandomInt(vRandom.size() - n) + n;
         SwapRandom(n, nRndPos);
-        assert(mapInfo.count(vRandom[n]) == 1);
+        assert(IsUsedId(vRandom[n]));
 
-        const CAddrInfo& ai = mapInfo[vRandom[n]];
+        const CAddrInfo& ai = vInfo[vRandom[n]];
         if (!ai.IsTerrible())
             vAddr.push_back(ai);
     }
@@ -573,11 +583,11 @@ void CAddrMan::ResolveCollisions_()
 
         bool erase_collision = false;
 
-        // If id_new not found in mapInfo remove it from m_tried_collisions
-        if (mapInfo.count(id_new) != 1) {
+        // If id_new not found in vInfo remove it from m_tried_collisions
+        if (!IsUsedId(id_new)) {
             erase_collision = true;
         } else {
-            CAddrInfo& info_new = mapInfo[id_new];
+            CAddrInfo& info_new = vInfo[id_new];
 
             // Which tried bucket to move the entry to.
             int tried_bucket = info_new.GetTriedBucket(nKey);
@@ -588,7 +598,7 @@ void CAddrMan::ResolveCollisions_()
 
                 // Get the to-be-evicted address that is being tested
                 int id_old = vvTried[tried_bucket][tried_bucket_pos];
-                CAddrInfo& info_old = mapInfo[id_old];
+                CAddrInfo& info_old = vInfo[id_old];
 
                 // Has successfully connected in last X hours
                 if (GetAdjustedTime() - info_old.nLastSuccess < ADDRMAN_REPLACEMENT_HOURS*(60*60)) {
@@ -628,19 +638,21 @@ CAddrInfo CAddrMan::SelectTriedCollision_()
     std::advance(it, GetRandInt(m_tried_collisions.size()));
     int id_new = *it;
 
-    // If id_new not found in mapInfo remove it from m_tried_collisions
-    if (mapInfo.count(id_new) != 1) {
+    // If id_new not found in vInfo remove it from m_tried_collisions
+    if (!IsUsedId(id_new)) {
         m_tried_collisions.erase(it);
         return CAddrInfo();
     }
 
-    CAddrInfo& newInfo = mapInfo[id_new];
+    CAddrInfo& newInfo = vInfo[id_new];
 
     // which tried bucket to move the entry to
     int tried_bucket = newInfo.GetTriedBucket(nKey);
     int tried_bucket_pos = newInfo.GetBucketPosition(nKey, false, tried_bucket);
 
     int id_old = vvTried[tried_bucket][tried_bucket_pos];
+    if (id_old == -1)
+        return CAddrInfo();
 
-    return mapInfo[id_old];
+    return vInfo[id_old];
 }
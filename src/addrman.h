@@ -6,6 +6,7 @@
 #ifndef BITCOIN_ADDRMAN_H
 #define BITCOIN_ADDRMAN_H
 
+#include <hash.h>
 #include <netaddress.h>
 #include <protocol.h>
 #include <random.h>
@@ -13,9 +14,12 @@
 #include <timedata.h>
 #include <util.h>
 
+#include <array>
+#include <limits>
 #include <map>
 #include <set>
 #include <stdint.h>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -182,6 +186,30 @@ public:
 //! the maximum number of tried addr collisions to store
 #define ADDRMAN_SET_TRIED_COLLISION_SIZE 10
 
+static_assert(ADDRMAN_NEW_BUCKET_COUNT * ADDRMAN_BUCKET_SIZE <= 1 << 16, "new table positions must fit in uint16_t");
+
+/**
+ * Salted hasher for the CService -> nId index. The salt prevents peers from
+ * crafting addresses that all land in the same hash bucket.
+ */
+class CAddrManServiceHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    CAddrManServiceHasher() :
+        k0(GetRand(std::numeric_limits<uint64_t>::max())),
+        k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+    size_t operator()(const CService& addr) const
+    {
+        std::vector<unsigned char> vchKey = addr.GetKey();
+        return CSipHasher(k0, k1).Write(vchKey.data(), vchKey.size()).Finalize();
+    }
+};
+
 /**
  * Stochastical (IP) address manager
  */
@@ -191,14 +219,18 @@ private:
     //! critical section to protect the inner data structures
     mutable CCriticalSection cs;
 
-    //! last used nId
-    int nIdCount;
+    //! table with information about all nIds, indexed by nId. Unused slots have nRandomPos == -1
+    std::vector<CAddrInfo> vInfo;
 
-    //! table with information about all nIds
-    std::map<int, CAddrInfo> mapInfo;
+    //! unused slots in vInfo, reused before vInfo is grown
+    std::vector<int> vFreeIds;
+
+    //! positions (nUBucket * ADDRMAN_BUCKET_SIZE + nUBucketPos) in vvNew referring to each nId, indexed by nId.
+    //! Only the first nRefCount entries of the referenced CAddrInfo are valid.
+    std::vector<std::array<uint16_t, ADDRMAN_NEW_BUCKETS_PER_ADDRESS>> vNewRefs;
 
     //! find an nId based on its network address
-    std::map<CService, int> mapAddr;
+    std::unordered_map<CService, int, CAddrManServiceHasher> mapAddr;
 
     //! randomly-ordered vector of all nIds
     std::vector<int> vRandom;
@@ -231,6 +263,22 @@ protected:
     //! Source of random numbers for randomization in inner loops
     FastRandomContext insecure_rand;
 
+    //! Key of addr in mapAddr (the port is ignored unless ports are discriminated).
+    CService GetAddrKey(const CService& addr) const
+    {
+        CService key = addr;
+        if (!discriminatePorts) {
+            key.SetPort(0);
+        }
+        return key;
+    }
+
+    //! Whether nId refers to a live entry in vInfo.
+    bool IsUsedId(int nId) const
+    {
+        return nId >= 0 && (size_t)nId < vInfo.size() && vInfo[nId].nRandomPos != -1;
+    }
+
     //! Find an entry.
     CAddrInfo* Find(const CService& addr, int *pnId = nullptr);
 
@@ -250,6 +298,12 @@ protected:
     //! Clear a position in a "new" table. This is the only place where entries are actually deleted.
     void ClearNew(int nUBucket, int nUBucketPos);
 
+    //! Store nId in an empty position of a "new" table and record the reference.
+    void SetNew(int nUBucket, int nUBucketPos, int nId);
+
+    //! Drop the reference held by a non-empty position of a "new" table, without deleting the entry.
+    void UnsetNew(int nUBucket, int nUBucketPos);
+
     //! Mark an entry "good", possibly moving it from "new" to "tried".
     void Good_(const CService &addr, bool test_before_evict, int64_t time);
 
@@ -306,7 +360,7 @@ public:
      * as incompatible. This is necessary because it did not check the version number on
      * deserialization.
      *
-     * Notice that vvTried, mapAddr and vVector are never encoded explicitly;
+     * Notice that vvTried, mapAddr and vRandom are never encoded explicitly;
      * they are instead reconstructed from the other information.
      *
      * vvNew is serialized, but only used if ADDRMAN_UNKNOWN_BUCKET_COUNT didn't change,
@@ -332,21 +386,20 @@ public:
 
         int nUBuckets = ADDRMAN_NEW_BUCKET_COUNT ^ (1 << 30);
         s << nUBuckets;
-        std::map<int, int> mapUnkIds;
+        std::vector<int> vUnkIds(vInfo.size(), -1);
         int nIds = 0;
-        for (const auto& entry : mapInfo) {
-            mapUnkIds[entry.first] = nIds;
-            const CAddrInfo &info = entry.second;
-            if (info.nRefCount) {
+        for (size_t nId = 0; nId < vInfo.size(); nId++) {
+            const CAddrInfo &info = vInfo[nId];
+            vUnkIds[nId] = nIds;
+            if (info.nRandomPos != -1 && info.nRefCount) {
                 assert(nIds != nNew); // this means nNew was wrong, oh ow
                 s << info;
                 nIds++;
             }
         }
         nIds = 0;
-        for (const auto& entry : mapInfo) {
-            const CAddrInfo &info = entry.second;
-            if (info.fInTried) {
+        for (const CAddrInfo &info : vInfo) {
+            if (info.nRandomPos != -1 && info.fInTried) {
                 assert(nIds != nTried); // this means nTried was wrong, oh ow
                 s << info;
                 nIds++;
@@ -361,7 +414,7 @@ public:
             s << nSize;
             for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
                 if (vvNew[bucket][i] != -1) {
-                    int nIndex = mapUnkIds[vvNew[bucket][i]];
+                    int nIndex = vUnkIds[vvNew[bucket][i]];
                     s << nIndex;
                 }
             }
@@ -398,10 +451,14 @@ public:
         }
 
         // Deserialize entries from the new table.
+        vInfo.resize(nNew);
+        vNewRefs.resize(nNew);
+        vRandom.reserve(nNew + nTried);
+        mapAddr.reserve(nNew + nTried);
         for (int n = 0; n < nNew; n++) {
-            CAddrInfo &info = mapInfo[n];
+            CAddrInfo &info = vInfo[n];
             s >> info;
-            mapAddr[info] = n;
+            mapAddr[GetAddrKey(info)] = n;
             info.nRandomPos = vRandom.size();
             vRandom.push_back(n);
             if (nVersion != 1 || nUBuckets != ADDRMAN_NEW_BUCKET_COUNT) {
@@ -410,12 +467,10 @@ public:
                 int nUBucket = info.GetNewBucket(nKey);
                 int nUBucketPos = info.GetBucketPosition(nKey, true, nUBucket);
                 if (vvNew[nUBucket][nUBucketPos] == -1) {
-                    vvNew[nUBucket][nUBucketPos] = n;
-                    info.nRefCount++;
+                    SetNew(nUBucket, nUBucketPos, n);
                 }
             }
         }
-        nIdCount = nNew;
 
         // Deserialize entries from the tried table.
         int nLost = 0;
@@ -425,13 +480,14 @@ public:
             int nKBucket = info.GetTriedBucket(nKey);
             int nKBucketPos = info.GetBucketPosition(nKey, false, nKBucket);
             if (vvTried[nKBucket][nKBucketPos] == -1) {
+                int nId = vInfo.size();
                 info.nRandomPos = vRandom.size();
                 info.fInTried = true;
-                vRandom.push_back(nIdCount);
-                mapInfo[nIdCount] = info;
-                mapAddr[info] = nIdCount;
-                vvTried[nKBucket][nKBucketPos] = nIdCount;
-                nIdCount++;
+                vRandom.push_back(nId);
+                vInfo.push_back(info);
+                vNewRefs.emplace_back();
+                mapAddr[GetAddrKey(info)] = nId;
+                vvTried[nKBucket][nKBucketPos] = nId;
             } else {
                 nLost++;
             }
@@ -446,11 +502,10 @@ public:
                 int nIndex = 0;
                 s >> nIndex;
                 if (nIndex >= 0 && nIndex < nNew) {
-                    CAddrInfo &info = mapInfo[nIndex];
+                    CAddrInfo &info = vInfo[nIndex];
                     int nUBucketPos = info.GetBucketPosition(nKey, true, bucket);
                     if (nVersion == 1 && nUBuckets == ADDRMAN_NEW_BUCKET_COUNT && vvNew[bucket][nUBucketPos] == -1 && info.nRefCount < ADDRMAN_NEW_BUCKETS_PER_ADDRESS) {
-                        info.nRefCount++;
-                        vvNew[bucket][nUBucketPos] = nIndex;
+                        SetNew(bucket, nUBucketPos, nIndex);
                     }
                 }
             }
@@ -458,13 +513,11 @@ public:
 
         // Prune new entries with refcount 0 (as a result of collisions).
         int nLostUnk = 0;
-        for (std::map<int, CAddrInfo>::const_iterator it = mapInfo.begin(); it != mapInfo.end(); ) {
-            if (it->second.fInTried == false && it->second.nRefCount == 0) {
-                std::map<int, CAddrInfo>::const_iterator itCopy = it++;
-                Delete(itCopy->first);
+        for (int nId = 0; nId < (int)vInfo.size(); nId++) {
+            const CAddrInfo &info = vInfo[nId];
+            if (info.nRandomPos != -1 && info.fInTried == false && info.nRefCount == 0) {
+                Delete(nId);
                 nLostUnk++;
-            } else {
-                it++;
             }
         }
         if (nLost + nLostUnk > 0) {
@@ -490,12 +543,14 @@ public:
             }
         }
 
-        nIdCount = 0;
         nTried = 0;
         nNew = 0;
         nLastGood = 1; //Initially at 1 so that "never" is strictly worse.
-        mapInfo.clear();
+        std::vector<CAddrInfo>().swap(vInfo);
+        std::vector<int>().swap(vFreeIds);
+        std::vector<std::array<uint16_t, ADDRMAN_NEW_BUCKETS_PER_ADDRESS>>().swap(vNewRefs);
         mapAddr.clear();
+        m_tried_collisions.clear();
     }
 
     CAddrMan(bool _discriminatePorts = false) :
@@ -0,0 +1,126 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addrman.h>
+#include <bench/bench.h>
+#include <random.h>
+#include <util.h>
+
+#include <vector>
+
+/* A "source" is a source address from which we have received a bunch of other addresses. */
+
+static constexpr size_t NUM_SOURCES = 64;
+static constexpr size_t NUM_ADDRESSES_PER_SOURCE = 256;
+
+static std::vector<CAddress> g_sources;
+static std::vector<std::vector<CAddress>> g_addresses;
+
+static void CreateAddresses()
+{
+    if (g_sources.size() > 0) { // already created
+        return;
+    }
+
+    FastRandomContext rng(uint256(std::vector<unsigned char>(32, 123)));
+
+    auto randAddr = [&rng]() {
+        in6_addr addr;
+        memcpy(&addr, rng.randbytes(sizeof(addr)).data(), sizeof(addr));
+
+        uint16_t port;
+        memcpy(&port, rng.randbytes(sizeof(port)).data(), sizeof(port));
+        if (port == 0) {
+            port = 1;
+        }
+
+        CAddress ret(CService(addr, port), NODE_NETWORK);
+
+        ret.nTime = GetAdjustedTime();
+
+        return ret;
+    };
+
+    for (size_t source_i = 0; source_i < NUM_SOURCES; ++source_i) {
+        g_sources.emplace_back(randAddr());
+        g_addresses.emplace_back();
+        for (size_t addr_i = 0; addr_i < NUM_ADDRESSES_PER_SOURCE; ++addr_i) {
+            g_addresses[source_i].emplace_back(randAddr());
+        }
+    }
+}
+
+static void AddAddressesToAddrMan(CAddrMan& addrman)
+{
+    for (size_t source_i = 0; source_i < NUM_SOURCES; ++source_i) {
+        addrman.Add(g_addresses[source_i], g_sources[source_i]);
+    }
+}
+
+static void FillAddrMan(CAddrMan& addrman)
+{
+    CreateAddresses();
+
+    AddAddressesToAddrMan(addrman);
+}
+
+/* Benchmarks */
+
+static void AddrManAdd(benchmark::State& state)
+{
+    CreateAddresses();
+
+    CAddrMan addrman;
+
+    while (state.KeepRunning()) {
+        AddAddressesToAddrMan(addrman);
+        addrman.Clear();
+    }
+}
+
+static void AddrManSelect(benchmark::State& state)
+{
+    CAddrMan addrman;
+
+    FillAddrMan(addrman);
+
+    while (state.KeepRunning()) {
+        const auto& address = addrman.Select();
+        assert(address.GetPort() > 0);
+    }
+}
+
+static void AddrManGetAddr(benchmark::State& state)
+{
+    CAddrMan addrman;
+
+    FillAddrMan(addrman);
+
+    while (state.KeepRunning()) {
+        const auto& addresses = addrman.GetAddr();
+        assert(addresses.size() > 0);
+    }
+}
+
+static void AddrManGood(benchmark::State& state)
+{
+    CAddrMan addrman;
+
+    FillAddrMan(addrman);
+
+    size_t source_i = 0;
+    size_t addr_i = 0;
+    while (state.KeepRunning()) {
+        addrman.Good(g_addresses[source_i][addr_i]);
+        if (++addr_i == NUM_ADDRESSES_PER_SOURCE) {
+            addr_i = 0;
+            source_i = (source_i + 1) % NUM_SOURCES;
+        }
+    }
+}
+
+BENCHMARK(AddrManAdd, 5);
+BENCHMARK(AddrManSelect, 1000000);
+BENCHMARK(AddrManGetAddr, 500);
+BENCHMARK(AddrManGood, 200000);
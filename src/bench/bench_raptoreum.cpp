@@ -48,6 +48,10 @@ static void SetupBenchArgs()
     gArgs.AddArg("-plot-plotlyurl=<uri>", strprintf("URL to use for plotly.js (default: %s)", DEFAULT_PLOT_PLOTLYURL), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-plot-width=<x>", strprintf("Plot width in pixel (default: %u)", DEFAULT_PLOT_WIDTH), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-plot-height=<x>", strprintf("Plot height in pixel (default: %u)", DEFAULT_PLOT_HEIGHT), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-loadgen-coins=<n>", "Coins spent by every MempoolLoad benchmark stream (default: 4000)", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-loadgen-chain=<n>", "Length of the chained packages of MempoolLoadChained (default: 25)", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-loadgen-inputs=<n>", "Inputs of the CoinJoin shaped transactions of MempoolLoadCoinJoin (default: 20)", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-replay-corpus=<dir>", "Block corpus replayed by the BlockReplay benchmark, see bench/block_replay.cpp. BlockReplay also honors -testnet, -devnet, -regtest, -dbcache, -par and -assumevalid", false, OptionsCategory::OPTIONS);
 }
 
 int main(int argc, char** argv)
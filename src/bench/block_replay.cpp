@@ -0,0 +1,321 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chainparams.h>
+#include <coinjoin/coinjoin.h>
+#include <evo/deterministicmns.h>
+#include <evo/evodb.h>
+#include <llmq/quorums_init.h>
+#include <node/coinstats.h>
+#include <primitives/powcache.h>
+#include <protocol.h>
+#include <scheduler.h>
+#include <script/sigcache.h>
+#include <streams.h>
+#include <txdb.h>
+#include <util.h>
+#include <utilstrencodings.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/thread.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+/*
+ * Replays a recorded block corpus through ProcessNewBlock on a temporary datadir, without
+ * any networking, to measure full validation throughput (IBD/reindex). The corpus given with
+ * -replay-corpus=<dir> consists of
+ *
+ *   <dir>/base/    (optional) network datadir of a node at the start height, that is its
+ *                  blocks/, chainstate/, evodb/ and llmq/ directories. Without it the replay
+ *                  starts at the genesis block.
+ *   <dir>/blocks/  blk?????.dat files holding the blocks to replay, as written by a node or by
+ *                  -loadblock compatible tools. A node writes blocks in the order it received
+ *                  them, so they are put in chain order before replaying.
+ *
+ * The chain is selected with -testnet/-devnet/-regtest, and -dbcache, -par and -assumevalid
+ * are honored like in the node (-assumevalid defaults to 0, verifying every script). Every
+ * evaluation starts from a fresh copy of the base with empty signature, script and PoW caches
+ * and prints a report with blocks/s, tx/s, the PoW share, a ConnectBlock breakdown and the
+ * peak RSS to stderr. Without -replay-corpus the benchmark does nothing.
+ */
+
+static std::vector<std::shared_ptr<const CBlock>> ReadCorpusBlocks(const fs::path& dir, const CChainParams& chainparams)
+{
+    std::vector<fs::path> vecFiles;
+    for (fs::directory_iterator it(dir); it != fs::directory_iterator(); ++it) {
+        const std::string strName = it->path().filename().string();
+        if (strName.compare(0, 3, "blk") == 0 && it->path().extension() == ".dat") {
+            vecFiles.emplace_back(it->path());
+        }
+    }
+    std::sort(vecFiles.begin(), vecFiles.end());
+
+    std::vector<std::shared_ptr<const CBlock>> vecBlocks;
+    for (const auto& path : vecFiles) {
+        std::ifstream file(path.string(), std::ios::binary);
+        std::vector<char> vchData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        CDataStream ss(vchData.data(), vchData.data() + vchData.size(), SER_DISK, CLIENT_VERSION);
+        while (ss.size() >= CMessageHeader::MESSAGE_START_SIZE + sizeof(uint32_t)) {
+            CMessageHeader::MessageStartChars pchMessageStart;
+            ss.read((char*)pchMessageStart, sizeof(pchMessageStart));
+            if (memcmp(pchMessageStart, chainparams.MessageStart(), sizeof(pchMessageStart)) != 0) {
+                // blk files are preallocated, the rest of the file is zeroes
+                break;
+            }
+            uint32_t nSize;
+            ss >> nSize;
+            auto pblock = std::make_shared<CBlock>();
+            ss >> *pblock;
+            vecBlocks.emplace_back(std::move(pblock));
+        }
+    }
+    return vecBlocks;
+}
+
+/**
+ * Order the blocks so that each one follows its parent. Blocks whose parent is not part of
+ * the corpus (the child of the base tip, or genesis) come first, the others wait until their
+ * parent was placed, the same way LoadExternalBlockFile defers out of order blocks.
+ */
+static std::vector<std::shared_ptr<const CBlock>> OrderCorpusBlocks(const std::vector<std::shared_ptr<const CBlock>>& vecBlocks)
+{
+    std::set<uint256> setHashes;
+    for (const auto& pblock : vecBlocks) {
+        setHashes.insert(pblock->GetHash());
+    }
+
+    std::vector<std::shared_ptr<const CBlock>> vecOrdered;
+    vecOrdered.reserve(vecBlocks.size());
+    std::multimap<uint256, std::shared_ptr<const CBlock>> mapBlocksUnknownParent;
+    for (const auto& pblock : vecBlocks) {
+        if (setHashes.count(pblock->hashPrevBlock)) {
+            mapBlocksUnknownParent.emplace(pblock->hashPrevBlock, pblock);
+        } else {
+            vecOrdered.push_back(pblock);
+        }
+    }
+    for (size_t i = 0; i < vecOrdered.size(); i++) {
+        auto range = mapBlocksUnknownParent.equal_range(vecOrdered[i]->GetHash());
+        for (auto it = range.first; it != range.second; ++it) {
+            vecOrdered.push_back(it->second);
+        }
+        mapBlocksUnknownParent.erase(range.first, range.second);
+    }
+    return vecOrdered;
+}
+
+static void CopyDirectory(const fs::path& from, const fs::path& to)
+{
+    fs::create_directories(to);
+    for (fs::directory_iterator it(from); it != fs::directory_iterator(); ++it) {
+        if (fs::is_directory(it->status())) {
+            CopyDirectory(it->path(), to / it->path().filename());
+        } else {
+            fs::copy_file(it->path(), to / it->path().filename());
+        }
+    }
+}
+
+static int64_t GetPeakRSS()
+{
+#ifndef WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return (int64_t)usage.ru_maxrss * 1024;
+    }
+#endif
+    return -1;
+}
+
+/** The chainstate of a node, loaded from a datadir the way init does it */
+class ReplayChainState
+{
+public:
+    ReplayChainState(const CChainParams& chainparams, const fs::path& base)
+    {
+        if (!base.empty()) {
+            CopyDirectory(base, GetDataDir());
+        }
+
+        // Same split as in init
+        int64_t nTotalCache = (gArgs.GetArg("-dbcache", nDefaultDbCache) << 20);
+        nTotalCache = std::max(nTotalCache, nMinDbCache << 20);
+        nTotalCache = std::min(nTotalCache, nMaxDbCache << 20);
+        int64_t nBlockTreeDBCache = std::min(nTotalCache / 8, nMaxBlockDBCache << 20);
+        nTotalCache -= nBlockTreeDBCache;
+        int64_t nCoinDBCache = std::min(std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)), nMaxCoinsDBCache << 20);
+        nTotalCache -= nCoinDBCache;
+        nCoinCacheUsage = nTotalCache;
+        int64_t nEvoDbCache = 1024 * 1024 * 16;
+
+        LOCK(cs_main);
+        pblocktree.reset(new CBlockTreeDB(nBlockTreeDBCache, false, false));
+        evoDb.reset(new CEvoDB(nEvoDbCache, false, false));
+        deterministicMNManager.reset(new CDeterministicMNManager(*evoDb));
+        llmq::InitLLMQSystem(*evoDb, false);
+
+        if (!LoadBlockIndex(chainparams) || !LoadGenesisBlock(chainparams)) {
+            throw std::runtime_error("Error loading block database");
+        }
+        pcoinsdbview.reset(new CCoinsViewDB(nCoinDBCache, false, false));
+        if (!pcoinsdbview->Upgrade() || !ReplayBlocks(chainparams, pcoinsdbview.get())) {
+            throw std::runtime_error("Error loading chainstate database");
+        }
+        pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
+        if (fCoinStatsIndex) {
+            g_coins_stats_tracker.Load(*pcoinsdbview);
+            pcoinsdbview->SetCoinsStatsTracker(&g_coins_stats_tracker);
+        }
+        if (!evoDb->CommitRootTransaction()) {
+            throw std::runtime_error("Failed to commit EvoDB");
+        }
+        if (!pcoinsTip->GetBestBlock().IsNull() && !LoadChainTip(chainparams)) {
+            throw std::runtime_error("Error initializing block database");
+        }
+    }
+
+    ~ReplayChainState()
+    {
+        SyncWithValidationInterfaceQueue();
+        FlushStateToDisk();
+        UnloadBlockIndex();
+        pcoinsTip.reset();
+        pcoinsdbview.reset();
+        llmq::DestroyLLMQSystem();
+        deterministicMNManager.reset();
+        evoDb.reset();
+        pblocktree.reset();
+    }
+};
+
+static void PrintReplayReport(const std::vector<std::shared_ptr<const CBlock>>& vecBlocks, int64_t nTimeReplay,
+                              const CBlockValidationTimings& before, const CBlockValidationTimings& after)
+{
+    size_t nTxs = 0, nSpecialTxs = 0, nFutureTxs = 0;
+    for (const auto& pblock : vecBlocks) {
+        nTxs += pblock->vtx.size();
+        for (const auto& tx : pblock->vtx) {
+            if (tx->nVersion >= 3 && tx->nType != TRANSACTION_NORMAL) {
+                nSpecialTxs++;
+            }
+            if (tx->nType == TRANSACTION_FUTURE) {
+                nFutureTxs++;
+            }
+        }
+    }
+    const double nSeconds = nTimeReplay * 0.000001;
+    const int64_t nBlocks = after.nBlocks - before.nBlocks;
+    auto share = [&](int64_t nTime) {
+        return nTimeReplay ? 100.0 * nTime / nTimeReplay : 0.0;
+    };
+    auto stage = [&](const char* strName, int64_t nBefore, int64_t nAfter) {
+        std::cerr << strprintf("#   %-28s %10.2fs %6.2f%% %9.3fms/blk\n", strName, (nAfter - nBefore) * 0.000001, share(nAfter - nBefore),
+                               nBlocks ? (nAfter - nBefore) * 0.001 / nBlocks : 0.0);
+    };
+
+    std::cerr << strprintf("# BlockReplay: %d blocks (%u txs, %u special, %u future) in %.2fs, %.2f blocks/s, %.2f tx/s, peak RSS %.1fMiB\n",
+                           nBlocks, nTxs, nSpecialTxs, nFutureTxs, nSeconds, nSeconds > 0 ? nBlocks / nSeconds : 0.0,
+                           nSeconds > 0 ? nTxs / nSeconds : 0.0, GetPeakRSS() / 1024.0 / 1024.0);
+    stage("PoW", before.nPoW, after.nPoW);
+    stage("ConnectTip", before.nTotal, after.nTotal);
+    stage("  read from disk", before.nReadFromDisk, after.nReadFromDisk);
+    stage("  ConnectBlock", before.nConnectTotal, after.nConnectTotal);
+    stage("    sanity checks", before.nCheck, after.nCheck);
+    stage("    fork checks", before.nForks, after.nForks);
+    stage("    special txs", before.nProcessSpecial, after.nProcessSpecial);
+    stage("    connect txs", before.nConnect, after.nConnect);
+    stage("    verify txins", before.nVerify, after.nVerify);
+    stage("    raptoreum specific", before.nRaptoreumSpecific, after.nRaptoreumSpecific);
+    stage("    index writing", before.nIndex, after.nIndex);
+    stage("    callbacks", before.nCallbacks, after.nCallbacks);
+    stage("  flush", before.nFlush, after.nFlush);
+    stage("  write chainstate", before.nChainState, after.nChainState);
+    stage("  post connect", before.nPostConnect, after.nPostConnect);
+}
+
+static void BlockReplay(benchmark::State& state)
+{
+    if (!gArgs.IsArgSet("-replay-corpus")) {
+        return;
+    }
+    const fs::path corpus = fs::absolute(gArgs.GetArg("-replay-corpus", ""));
+    const fs::path base = fs::is_directory(corpus / "base") ? corpus / "base" : fs::path();
+
+    SelectParams(gArgs.GetChainName());
+    const CChainParams& chainparams = Params();
+    hashAssumeValid = uint256S(gArgs.GetArg("-assumevalid", "0"));
+    CCoinJoin::InitStandardDenominations();
+
+    const std::vector<std::shared_ptr<const CBlock>> vecBlocks = OrderCorpusBlocks(ReadCorpusBlocks(corpus / "blocks", chainparams));
+    if (vecBlocks.empty()) {
+        throw std::runtime_error(strprintf("no blocks found in %s", (corpus / "blocks").string()));
+    }
+
+    // -par=0 means autodetect, like in init
+    nScriptCheckThreads = gArgs.GetArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
+    if (nScriptCheckThreads <= 0) {
+        nScriptCheckThreads += GetNumCores();
+    }
+    nScriptCheckThreads = nScriptCheckThreads <= 1 ? 0 : std::min(nScriptCheckThreads, MAX_SCRIPTCHECK_THREADS);
+
+    CScheduler scheduler;
+    boost::thread_group threadGroup;
+    threadGroup.create_thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+    for (int i = 0; i < nScriptCheckThreads - 1; i++) {
+        threadGroup.create_thread(&ThreadScriptCheck);
+        threadGroup.create_thread(&ThreadBlockCheck);
+    }
+
+    const fs::path root = GetDataDir(false);
+    int nEval = 0;
+    while (state.KeepRunning()) {
+        gArgs.ForceSetArg("-datadir", (root / strprintf("replay%d", nEval++)).string());
+        ClearDatadirCache();
+
+        InitSignatureCache();
+        InitScriptExecutionCache();
+        CPowCache::Instance().Clear();
+
+        ReplayChainState chainState(chainparams, base);
+
+        const CBlockValidationTimings before = GetBlockValidationTimings();
+        const int64_t nTimeStart = GetTimeMicros();
+        for (const auto& pblock : vecBlocks) {
+            if (!ProcessNewBlock(chainparams, pblock, true, nullptr)) {
+                throw std::runtime_error(strprintf("ProcessNewBlock failed for block %s", pblock->GetHash().ToString()));
+            }
+        }
+        SyncWithValidationInterfaceQueue();
+        const int64_t nTimeReplay = GetTimeMicros() - nTimeStart;
+
+        {
+            LOCK(cs_main);
+            if (chainActive.Tip()->GetBlockHash() != vecBlocks.back()->GetHash()) {
+                throw std::runtime_error(strprintf("replay stopped at height %d (%s)", chainActive.Height(), chainActive.Tip()->GetBlockHash().ToString()));
+            }
+        }
+        PrintReplayReport(vecBlocks, nTimeReplay, before, GetBlockValidationTimings());
+    }
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+    GetMainSignals().FlushBackgroundCallbacks();
+    GetMainSignals().UnregisterBackgroundSignalScheduler();
+    gArgs.ForceSetArg("-datadir", root.string());
+    ClearDatadirCache();
+}
+
+BENCHMARK(BlockReplay, 1);
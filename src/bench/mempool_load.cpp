@@ -0,0 +1,313 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <evo/providertx.h>
+#include <evo/specialtx.h>
+#include <future/fee.h>
+#include <key.h>
+#include <miner.h>
+#include <script/interpreter.h>
+#include <script/sigcache.h>
+#include <script/standard.h>
+#include <test/test_raptoreum.h>
+#include <txmempool.h>
+#include <util.h>
+#include <validation.h>
+
+#include <iostream>
+
+/*
+ * In-process load generator for mempool admission and block assembly on the regtest
+ * TestChain100Setup chain, without any networking. Every benchmark prebuilds a stream of
+ * signed transactions and, per iteration, feeds the whole stream through AcceptToMemoryPool
+ * with cold signature and script caches, builds a block template from the resulting mempool
+ * and clears it again. The admission rate, template build latency and mempool memory per tx
+ * are printed to stderr.
+ *
+ * The streams are sized with -loadgen-coins=<n> (coins spent per stream), -loadgen-chain=<n>
+ * (length of the chained packages), -loadgen-depth=<n> (length of the deep chains, for which
+ * the mempool package limits are lifted) and -loadgen-inputs=<n> (inputs of the CoinJoin shaped
+ * transactions). The deep chains pay less fee with every step, so block assembly takes every
+ * transaction as a package of its own and has to update the rest of the chain each time.
+ *
+ * InstantSend locking needs LLMQ quorums, which the fixture doesn't have, so only the
+ * InstantSend conflict checks done inside AcceptToMemoryPool are covered.
+ */
+
+static const int DEFAULT_LOADGEN_COINS = 4000;
+static const int DEFAULT_LOADGEN_CHAIN = 25;
+static const int DEFAULT_LOADGEN_DEPTH = 500;
+static const int DEFAULT_LOADGEN_INPUTS = 20;
+
+//! Fan out transactions are kept well below the standard size limit
+static const int COINS_PER_FANOUT = 1000;
+
+//! Generous flat fee rate, in duffs per byte of the estimated size
+static const CAmount LOADGEN_FEE_PER_BYTE = 10;
+
+namespace {
+
+struct LoadCoin {
+    COutPoint outpoint;
+    CAmount nValue;
+};
+
+enum class LoadKind {
+    STANDARD,
+    FUTURE,
+    CHAINED,
+    DEEP_CHAIN,
+    COINJOIN,
+};
+
+class LoadGenSetup : public TestChain100Setup
+{
+public:
+    CScript scriptCoins;
+    std::vector<LoadCoin> vecCoins;
+
+    explicit LoadGenSetup(int nCoins)
+    {
+        // The fixture is meant for tests, turn off the checks that would dominate the numbers
+        fCheckBlockIndex = false;
+        mempool.setSanityCheck(0.0);
+
+        scriptCoins = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+        const CScript scriptCoinbase = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+        // Split one mature coinbase per block into many P2PKH coins
+        for (size_t i = 0; (int)vecCoins.size() < nCoins && i < coinbaseTxns.size(); i++) {
+            const CTransaction& coinbase = coinbaseTxns[i];
+            auto it = std::find_if(coinbase.vout.begin(), coinbase.vout.end(), [&](const CTxOut& out) { return out.scriptPubKey == scriptCoinbase; });
+            assert(it != coinbase.vout.end());
+
+            const int nOutputs = std::min(COINS_PER_FANOUT, nCoins - (int)vecCoins.size());
+            const CAmount nFee = LOADGEN_FEE_PER_BYTE * (200 + 34 * nOutputs);
+            CMutableTransaction tx;
+            tx.vin.emplace_back(COutPoint(coinbase.GetHash(), it - coinbase.vout.begin()));
+            tx.vout.assign(nOutputs, CTxOut((it->nValue - nFee) / nOutputs, scriptCoins));
+            Sign(tx, 0, scriptCoinbase, SIGHASH_ALL, false);
+            CreateAndProcessBlock({tx}, scriptCoinbase);
+
+            const uint256 txid = tx.GetHash();
+            for (int n = 0; n < nOutputs; n++) {
+                vecCoins.push_back({COutPoint(txid, n), tx.vout[n].nValue});
+            }
+        }
+        assert((int)vecCoins.size() == nCoins);
+    }
+
+    void Sign(CMutableTransaction& tx, size_t nIn, const CScript& scriptCode, int nHashType, bool fPushPubKey) const
+    {
+        uint256 hash = SignatureHash(scriptCode, tx, nIn, nHashType, 0, SigVersion::BASE);
+        std::vector<unsigned char> vchSig;
+        bool fSigned = coinbaseKey.Sign(hash, vchSig);
+        assert(fSigned);
+        vchSig.push_back((unsigned char)nHashType);
+        tx.vin[nIn].scriptSig = CScript() << vchSig;
+        if (fPushPubKey) {
+            tx.vin[nIn].scriptSig << ToByteVector(coinbaseKey.GetPubKey());
+        }
+    }
+
+    void SignAll(CMutableTransaction& tx, int nHashType = SIGHASH_ALL) const
+    {
+        for (size_t i = 0; i < tx.vin.size(); i++) {
+            Sign(tx, i, scriptCoins, nHashType, true);
+        }
+    }
+
+    static CAmount EstimateFee(size_t nInputs, size_t nOutputs, size_t nPayloadSize = 0)
+    {
+        return LOADGEN_FEE_PER_BYTE * (10 + 148 * nInputs + 34 * nOutputs + nPayloadSize);
+    }
+
+    std::vector<CTransactionRef> MakeStream(LoadKind kind, int nChain, int nInputs) const
+    {
+        std::vector<CTransactionRef> vecTxs;
+        switch (kind) {
+        case LoadKind::STANDARD:
+            for (const auto& coin : vecCoins) {
+                CMutableTransaction tx;
+                tx.vin.emplace_back(coin.outpoint);
+                const CAmount nValue = (coin.nValue - EstimateFee(1, 2)) / 2;
+                tx.vout.assign(2, CTxOut(nValue, scriptCoins));
+                SignAll(tx);
+                vecTxs.emplace_back(MakeTransactionRef(tx));
+            }
+            break;
+        case LoadKind::FUTURE:
+            for (const auto& coin : vecCoins) {
+                CMutableTransaction tx;
+                tx.nVersion = 3;
+                tx.nType = TRANSACTION_FUTURE;
+                tx.vin.emplace_back(coin.outpoint);
+
+                CFutureTx ftx;
+                ftx.maturity = 10;
+                ftx.lockTime = 60 * 60;
+                ftx.lockOutputIndex = 0;
+                ftx.fee = getFutureFees();
+                const CAmount nValue = (coin.nValue - EstimateFee(1, 2, 100) - ftx.fee * COIN) / 2;
+                tx.vout.assign(2, CTxOut(nValue, scriptCoins));
+                ftx.inputsHash = CalcTxInputsHash(CTransaction(tx));
+                SetTxPayload(tx, ftx);
+                SignAll(tx);
+                vecTxs.emplace_back(MakeTransactionRef(tx));
+            }
+            break;
+        case LoadKind::CHAINED:
+            for (size_t i = 0; i + nChain <= vecCoins.size(); i += nChain) {
+                // Spend one coin through a chain of transactions, skipping the other coins of the
+                // package so all streams end up with a similar number of transactions
+                COutPoint prevout = vecCoins[i].outpoint;
+                CAmount nValue = vecCoins[i].nValue;
+                for (int n = 0; n < nChain; n++) {
+                    CMutableTransaction tx;
+                    tx.vin.emplace_back(prevout);
+                    nValue -= EstimateFee(1, 1);
+                    tx.vout.emplace_back(nValue, scriptCoins);
+                    SignAll(tx);
+                    vecTxs.emplace_back(MakeTransactionRef(tx));
+                    prevout = COutPoint(tx.GetHash(), 0);
+                }
+            }
+            break;
+        case LoadKind::DEEP_CHAIN:
+            for (size_t i = 0; i + nChain <= vecCoins.size(); i += nChain) {
+                COutPoint prevout = vecCoins[i].outpoint;
+                CAmount nValue = vecCoins[i].nValue;
+                for (int n = 0; n < nChain; n++) {
+                    CMutableTransaction tx;
+                    tx.vin.emplace_back(prevout);
+                    nValue -= EstimateFee(1, 1) + (nChain - n) * LOADGEN_FEE_PER_BYTE;
+                    tx.vout.emplace_back(nValue, scriptCoins);
+                    SignAll(tx);
+                    vecTxs.emplace_back(MakeTransactionRef(tx));
+                    prevout = COutPoint(tx.GetHash(), 0);
+                }
+            }
+            break;
+        case LoadKind::COINJOIN:
+            for (size_t i = 0; i + nInputs <= vecCoins.size(); i += nInputs) {
+                // Equal inputs and outputs, every input signed on its own like CoinJoin does
+                CMutableTransaction tx;
+                CAmount nValueIn = 0;
+                for (int n = 0; n < nInputs; n++) {
+                    tx.vin.emplace_back(vecCoins[i + n].outpoint);
+                    nValueIn += vecCoins[i + n].nValue;
+                }
+                const CAmount nValue = (nValueIn - EstimateFee(nInputs, nInputs)) / nInputs;
+                tx.vout.assign(nInputs, CTxOut(nValue, scriptCoins));
+                SignAll(tx, SIGHASH_ALL | SIGHASH_ANYONECANPAY);
+                vecTxs.emplace_back(MakeTransactionRef(tx));
+            }
+            break;
+        }
+        return vecTxs;
+    }
+};
+
+} // namespace
+
+static void MempoolLoad(benchmark::State& state, LoadKind kind)
+{
+    const int nCoins = gArgs.GetArg("-loadgen-coins", DEFAULT_LOADGEN_COINS);
+    int nChain = std::max<int>(1, gArgs.GetArg("-loadgen-chain", DEFAULT_LOADGEN_CHAIN));
+    if (kind == LoadKind::DEEP_CHAIN) {
+        nChain = std::max<int>(1, gArgs.GetArg("-loadgen-depth", DEFAULT_LOADGEN_DEPTH));
+        gArgs.ForceSetArg("-limitancestorcount", std::to_string(nChain));
+        gArgs.ForceSetArg("-limitdescendantcount", std::to_string(nChain));
+        gArgs.ForceSetArg("-limitancestorsize", std::to_string(nChain));
+        gArgs.ForceSetArg("-limitdescendantsize", std::to_string(nChain));
+    }
+    const int nInputs = std::max<int>(1, gArgs.GetArg("-loadgen-inputs", DEFAULT_LOADGEN_INPUTS));
+
+    // The fixture starts and stops its own secp256k1 signing context and uses its own datadir
+    const std::string strDataDir = gArgs.GetArg("-datadir", "");
+    ECC_Stop();
+    {
+        LoadGenSetup setup(nCoins);
+        const std::vector<CTransactionRef> vecTxs = setup.MakeStream(kind, nChain, nInputs);
+        const CScript scriptPayout = CScript() << OP_TRUE;
+
+        size_t nRuns = 0, nAccepted = 0, nTemplateTxs = 0, nMemory = 0;
+        int64_t nTimeAccept = 0, nTimeTemplate = 0;
+        while (state.KeepRunning()) {
+            InitSignatureCache();
+            InitScriptExecutionCache();
+
+            LOCK(cs_main);
+            const int64_t nTime1 = GetTimeMicros();
+            for (const auto& tx : vecTxs) {
+                CValidationState validationState;
+                if (AcceptToMemoryPool(mempool, validationState, tx, nullptr, false, 0)) {
+                    nAccepted++;
+                } else if (nRuns == 0) {
+                    std::cerr << strprintf("# %s: rejected: %s\n", state.m_name, FormatStateMessage(validationState));
+                }
+            }
+            const int64_t nTime2 = GetTimeMicros();
+            nMemory += mempool.size() ? mempool.DynamicMemoryUsage() / mempool.size() : 0;
+            std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptPayout);
+            const int64_t nTime3 = GetTimeMicros();
+            nTemplateTxs += pblocktemplate->block.vtx.size() - 1;
+            nTimeAccept += nTime2 - nTime1;
+            nTimeTemplate += nTime3 - nTime2;
+            nRuns++;
+
+            mempool.clear();
+        }
+
+        if (nRuns) {
+            std::cerr << strprintf("# %s: %u/%u txs admitted, %.1f tx/s, template with %u txs in %.2fms, %u bytes/tx in the mempool\n",
+                                   state.m_name, nAccepted / nRuns, vecTxs.size(), nTimeAccept ? nAccepted * 1000000.0 / nTimeAccept : 0.0,
+                                   nTemplateTxs / nRuns, nTimeTemplate * 0.001 / nRuns, nMemory / nRuns);
+        }
+    }
+    ECC_Start();
+    gArgs.ForceSetArg("-datadir", strDataDir);
+    ClearDatadirCache();
+    if (kind == LoadKind::DEEP_CHAIN) {
+        gArgs.ForceSetArg("-limitancestorcount", std::to_string(DEFAULT_ANCESTOR_LIMIT));
+        gArgs.ForceSetArg("-limitdescendantcount", std::to_string(DEFAULT_DESCENDANT_LIMIT));
+        gArgs.ForceSetArg("-limitancestorsize", std::to_string(DEFAULT_ANCESTOR_SIZE_LIMIT));
+        gArgs.ForceSetArg("-limitdescendantsize", std::to_string(DEFAULT_DESCENDANT_SIZE_LIMIT));
+    }
+}
+
+static void MempoolLoadStandard(benchmark::State& state)
+{
+    MempoolLoad(state, LoadKind::STANDARD);
+}
+
+static void MempoolLoadFuture(benchmark::State& state)
+{
+    MempoolLoad(state, LoadKind::FUTURE);
+}
+
+static void MempoolLoadChained(benchmark::State& state)
+{
+    MempoolLoad(state, LoadKind::CHAINED);
+}
+
+static void MempoolLoadDeepChain(benchmark::State& state)
+{
+    MempoolLoad(state, LoadKind::DEEP_CHAIN);
+}
+
+static void MempoolLoadCoinJoin(benchmark::State& state)
+{
+    MempoolLoad(state, LoadKind::COINJOIN);
+}
+
+BENCHMARK(MempoolLoadStandard, 1);
+BENCHMARK(MempoolLoadFuture, 1);
+BENCHMARK(MempoolLoadChained, 1);
+BENCHMARK(MempoolLoadDeepChain, 1);
+BENCHMARK(MempoolLoadCoinJoin, 1);
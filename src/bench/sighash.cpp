@@ -0,0 +1,63 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <random.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+
+// A consolidation style transaction spending nInputs P2PKH outputs to two outputs
+static CTransaction MakeManyInputTx(size_t nInputs)
+{
+    FastRandomContext insecure_rand(true);
+    CMutableTransaction tx;
+    tx.vin.resize(nInputs);
+    for (auto& txin : tx.vin) {
+        txin.prevout = COutPoint(insecure_rand.rand256(), insecure_rand.randrange(4));
+        // signature and pubkey sized push data
+        txin.scriptSig << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+    }
+    tx.vout.resize(2);
+    for (auto& txout : tx.vout) {
+        txout.nValue = insecure_rand.randrange(100000000);
+        txout.scriptPubKey = GetScriptForDestination(CKeyID(uint160(insecure_rand.randbytes(20))));
+    }
+    return CTransaction(tx);
+}
+
+// Signature hashes of all inputs, as done when verifying the transaction
+static void SignatureHashAllInputs(benchmark::State& state, size_t nInputs, bool fPrecomputed)
+{
+    const CTransaction tx = MakeManyInputTx(nInputs);
+    const CScript scriptCode = GetScriptForDestination(CKeyID(uint160()));
+
+    while (state.KeepRunning()) {
+        if (fPrecomputed) {
+            PrecomputedTransactionData txdata(tx);
+            for (size_t i = 0; i < nInputs; i++) {
+                SignatureHash(scriptCode, tx, i, SIGHASH_ALL, 0, SigVersion::BASE, &txdata);
+            }
+        } else {
+            for (size_t i = 0; i < nInputs; i++) {
+                SignatureHash(scriptCode, tx, i, SIGHASH_ALL, 0, SigVersion::BASE);
+            }
+        }
+    }
+}
+
+static void SignatureHash_10Inputs(benchmark::State& state) { SignatureHashAllInputs(state, 10, false); }
+static void SignatureHash_10Inputs_Precomputed(benchmark::State& state) { SignatureHashAllInputs(state, 10, true); }
+static void SignatureHash_100Inputs(benchmark::State& state) { SignatureHashAllInputs(state, 100, false); }
+static void SignatureHash_100Inputs_Precomputed(benchmark::State& state) { SignatureHashAllInputs(state, 100, true); }
+static void SignatureHash_500Inputs(benchmark::State& state) { SignatureHashAllInputs(state, 500, false); }
+static void SignatureHash_500Inputs_Precomputed(benchmark::State& state) { SignatureHashAllInputs(state, 500, true); }
+
+BENCHMARK(SignatureHash_10Inputs, 20 * 1000);
+BENCHMARK(SignatureHash_10Inputs_Precomputed, 20 * 1000);
+BENCHMARK(SignatureHash_100Inputs, 200);
+BENCHMARK(SignatureHash_100Inputs_Precomputed, 200);
+BENCHMARK(SignatureHash_500Inputs, 10);
+BENCHMARK(SignatureHash_500Inputs_Precomputed, 10);
@@ -0,0 +1,328 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bootstrap.h>
+
+#include <chainparams.h>
+#include <clientversion.h>
+#include <consensus/merkle.h>
+#include <init.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <primitives/powcache.h>
+#include <streams.h>
+#include <util.h>
+#include <validation.h>
+
+#include <ctpl.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static fs::path GetBootstrapFilename(const fs::path& dir, uint32_t nFile)
+{
+    return dir / strprintf("blocks%05u.dat", nFile);
+}
+
+bool ExportBootstrap(const fs::path& dir, int nStartHeight, int nEndHeight, std::string& strError)
+{
+    const CChainParams& chainparams = Params();
+
+    CBootstrapIndexHeader header;
+    memcpy(&header.nNetworkMagic, chainparams.MessageStart(), sizeof(header.nNetworkMagic));
+    header.nStartHeight = nStartHeight;
+    header.nBlocks = nEndHeight - nStartHeight + 1;
+
+    std::vector<CBootstrapIndexEntry> vecEntries;
+    vecEntries.reserve(header.nBlocks);
+
+    fs::create_directories(dir);
+    std::unique_ptr<CAutoFile> fileout;
+    uint32_t nFile = 0;
+    uint64_t nOffset = 0;
+    uint256 hashPrev;
+
+    for (int nHeight = nStartHeight; nHeight <= nEndHeight; nHeight++) {
+        if (ShutdownRequested()) {
+            strError = "Shutdown requested";
+            return false;
+        }
+
+        CBlock block;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* pindex = chainActive[nHeight];
+            if (!pindex || !(pindex->nStatus & BLOCK_HAVE_DATA) || !ReadBlockFromDisk(block, pindex, chainparams.GetConsensus())) {
+                strError = strprintf("Block at height %d not available", nHeight);
+                return false;
+            }
+        }
+        if (nHeight != nStartHeight && block.hashPrevBlock != hashPrev) {
+            strError = strprintf("Active chain changed at height %d during the export", nHeight);
+            return false;
+        }
+
+        CBootstrapIndexEntry entry;
+        entry.hash = block.GetHash();
+        // Already computed by ReadBlockFromDisk, so this is a cache hit
+        entry.powHash = block.GetPOWHash();
+        entry.nSize = ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+
+        if (!fileout || nOffset + entry.nSize > BOOTSTRAP_MAX_FILE_SIZE) {
+            if (fileout) {
+                FileCommit(fileout->Get());
+                nFile++;
+            }
+            fileout.reset(new CAutoFile(fsbridge::fopen(GetBootstrapFilename(dir, nFile), "wb"), SER_DISK, CLIENT_VERSION));
+            if (fileout->IsNull()) {
+                strError = strprintf("Failed to open %s", GetBootstrapFilename(dir, nFile).string());
+                return false;
+            }
+            nOffset = 0;
+        }
+        entry.nFile = nFile;
+        entry.nOffset = nOffset;
+        *fileout << block;
+        nOffset += entry.nSize;
+
+        vecEntries.push_back(entry);
+        hashPrev = entry.hash;
+    }
+    if (fileout) {
+        FileCommit(fileout->Get());
+        fileout.reset();
+    }
+
+    // Write the index last, so an interrupted export doesn't look complete
+    fs::path pathTmp = dir / "index.dat.tmp";
+    {
+        CAutoFile indexout(fsbridge::fopen(pathTmp, "wb"), SER_DISK, CLIENT_VERSION);
+        if (indexout.IsNull()) {
+            strError = strprintf("Failed to open %s", pathTmp.string());
+            return false;
+        }
+        indexout << header;
+        for (const auto& entry : vecEntries) {
+            indexout << entry;
+        }
+        FileCommit(indexout.Get());
+    }
+    if (!RenameOver(pathTmp, dir / "index.dat")) {
+        strError = "Failed to rename the index file";
+        return false;
+    }
+
+    LogPrintf("%s: exported blocks %d to %d to %s in %u files\n", __func__, nStartHeight, nEndHeight, dir.string(), nFile + 1);
+    return true;
+}
+
+namespace {
+
+/** Read only view of a whole file, memory mapped where that is available */
+class CBootstrapFile
+{
+private:
+    const unsigned char* pData{nullptr};
+    size_t nSize{0};
+#ifdef WIN32
+    std::vector<unsigned char> vchData;
+#endif
+
+public:
+    explicit CBootstrapFile(const fs::path& path)
+    {
+#ifndef WIN32
+        int fd = open(path.string().c_str(), O_RDONLY);
+        if (fd == -1) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                posix_madvise(p, st.st_size, POSIX_MADV_SEQUENTIAL);
+                pData = (const unsigned char*)p;
+                nSize = st.st_size;
+            }
+        }
+        close(fd);
+#else
+        CAutoFile filein(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        if (!filein.IsNull()) {
+            vchData.resize(fs::file_size(path));
+            filein.read((char*)vchData.data(), vchData.size());
+            pData = vchData.data();
+            nSize = vchData.size();
+        }
+#endif
+    }
+
+    ~CBootstrapFile()
+    {
+#ifndef WIN32
+        if (pData) {
+            munmap((void*)pData, nSize);
+        }
+#endif
+    }
+
+    CBootstrapFile(const CBootstrapFile&) = delete;
+    CBootstrapFile& operator=(const CBootstrapFile&) = delete;
+
+    const unsigned char* GetData() const { return pData; }
+    size_t GetSize() const { return nSize; }
+};
+
+struct CPreVerifiedBlock {
+    std::shared_ptr<const CBlock> pblock;
+    uint256 powHash;
+    std::string strError;
+};
+
+/** The context free checks that don't need the chain, run on the worker threads */
+CPreVerifiedBlock PreVerifyBlock(const CBootstrapIndexEntry& entry, const unsigned char* pData, const Consensus::Params& params)
+{
+    CPreVerifiedBlock result;
+    auto pblock = std::make_shared<CBlock>();
+    try {
+        CDataStream ss((const char*)pData, (const char*)pData + entry.nSize, SER_DISK, CLIENT_VERSION);
+        ss >> *pblock;
+    } catch (const std::exception& e) {
+        result.strError = strprintf("Failed to deserialize block %s: %s", entry.hash.ToString(), e.what());
+        return result;
+    }
+    if (pblock->GetHash() != entry.hash) {
+        result.strError = strprintf("Block hash mismatch, expected %s", entry.hash.ToString());
+        return result;
+    }
+    result.powHash = pblock->ComputeHash();
+    if (result.powHash != entry.powHash || !CheckProofOfWork(result.powHash, pblock->nBits, params)) {
+        result.strError = strprintf("Proof of work failed for block %s", entry.hash.ToString());
+        return result;
+    }
+    bool mutated;
+    if (BlockMerkleRoot(*pblock, &mutated) != pblock->hashMerkleRoot || mutated) {
+        result.strError = strprintf("Merkle root mismatch for block %s", entry.hash.ToString());
+        return result;
+    }
+    result.pblock = pblock;
+    return result;
+}
+
+} // namespace
+
+bool ImportBootstrap(const CChainParams& chainparams, const fs::path& dir, int& nImported, std::string& strError)
+{
+    nImported = 0;
+
+    CBootstrapIndexHeader header;
+    std::vector<CBootstrapIndexEntry> vecEntries;
+    {
+        CAutoFile filein(fsbridge::fopen(dir / "index.dat", "rb"), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull()) {
+            strError = strprintf("Failed to open %s", (dir / "index.dat").string());
+            return false;
+        }
+        try {
+            filein >> header;
+            if (header.nMagic != BOOTSTRAP_MAGIC || header.nVersion != BOOTSTRAP_VERSION) {
+                strError = "Unknown bootstrap format";
+                return false;
+            }
+            if (memcmp(&header.nNetworkMagic, chainparams.MessageStart(), sizeof(header.nNetworkMagic)) != 0) {
+                strError = "Bootstrap is for a different network";
+                return false;
+            }
+            for (uint32_t i = 0; i < header.nBlocks; i++) {
+                vecEntries.emplace_back();
+                filein >> vecEntries.back();
+            }
+        } catch (const std::exception& e) {
+            strError = strprintf("Failed to read the bootstrap index: %s", e.what());
+            return false;
+        }
+    }
+
+    std::map<uint32_t, std::unique_ptr<CBootstrapFile>> mapFiles;
+    auto getBlockData = [&](const CBootstrapIndexEntry& entry) -> const unsigned char* {
+        auto& file = mapFiles[entry.nFile];
+        if (!file) {
+            file.reset(new CBootstrapFile(GetBootstrapFilename(dir, entry.nFile)));
+        }
+        if (!file->GetData() || entry.nOffset + entry.nSize > file->GetSize()) {
+            return nullptr;
+        }
+        return file->GetData() + entry.nOffset;
+    };
+
+    const int nThreads = std::max(GetNumCores() - 1, 1);
+    ctpl::thread_pool workerPool(nThreads);
+    RenameThreadPool(workerPool, "raptoreum-bootstr");
+
+    // Keep enough blocks in flight to hide the PoW computation behind ProcessNewBlock
+    const size_t nMaxInFlight = nThreads * 8;
+    std::deque<std::future<CPreVerifiedBlock>> queueInFlight;
+
+    const int64_t nStart = GetTimeMillis();
+    size_t nNext = 0;
+    while (true) {
+        while (nNext < vecEntries.size() && queueInFlight.size() < nMaxInFlight) {
+            const CBootstrapIndexEntry& entry = vecEntries[nNext++];
+            {
+                LOCK(cs_main);
+                const CBlockIndex* pindex = LookupBlockIndex(entry.hash);
+                if (pindex && chainActive.Contains(pindex)) {
+                    continue;
+                }
+            }
+            const unsigned char* pData = getBlockData(entry);
+            if (!pData) {
+                strError = strprintf("Block %s is outside of its bootstrap file", entry.hash.ToString());
+                return false;
+            }
+            const Consensus::Params& params = chainparams.GetConsensus();
+            queueInFlight.emplace_back(workerPool.push([&entry, pData, &params](int) {
+                return PreVerifyBlock(entry, pData, params);
+            }));
+        }
+        if (queueInFlight.empty()) {
+            break;
+        }
+
+        CPreVerifiedBlock result = queueInFlight.front().get();
+        queueInFlight.pop_front();
+        if (!result.pblock) {
+            strError = result.strError;
+            return false;
+        }
+        {
+            LOCK(cs_pow);
+            CPowCache::Instance().erase(result.pblock->GetHash());
+            CPowCache::Instance().insert(result.pblock->GetHash(), result.powHash);
+        }
+        if (!ProcessNewBlock(chainparams, result.pblock, true, nullptr)) {
+            strError = strprintf("Failed to process block %s", result.pblock->GetHash().ToString());
+            return false;
+        }
+        nImported++;
+        if (nImported % 10000 == 0) {
+            LogPrintf("%s: imported %d blocks\n", __func__, nImported);
+        }
+        if (ShutdownRequested()) {
+            strError = "Shutdown requested";
+            return false;
+        }
+    }
+
+    LogPrintf("%s: imported %d blocks from %s in %dms\n", __func__, nImported, dir.string(), GetTimeMillis() - nStart);
+    return true;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BOOTSTRAP_H
+#define BITCOIN_BOOTSTRAP_H
+
+#include <fs.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <string>
+
+class CChainParams;
+
+/**
+ * Height ordered block export ("exportchain") and its importer (-loadbootstrap).
+ *
+ * A bootstrap directory holds
+ *   blocksNNNNN.dat  the serialized blocks back to back, a new file is started once
+ *                    BOOTSTRAP_MAX_FILE_SIZE is reached
+ *   index.dat        a CBootstrapIndexHeader followed by one CBootstrapIndexEntry per block,
+ *                    in height order
+ *
+ * Unlike a linearized bootstrap.dat, the importer doesn't have to scan for the network magic.
+ * It maps the block files, checks the PoW and merkle root of the next blocks on a pool of
+ * worker threads and feeds them to ProcessNewBlock in order, with the PoW hashes it computed
+ * already in the PoW cache. The PoW hashes stored in the index are only compared against the
+ * computed ones, never trusted.
+ */
+
+static const uint32_t BOOTSTRAP_MAGIC = 0x42545452; // "RTTB"
+static const uint32_t BOOTSTRAP_VERSION = 1;
+static const uint64_t BOOTSTRAP_MAX_FILE_SIZE = 0x40000000; // 1 GiB
+
+struct CBootstrapIndexHeader {
+    uint32_t nMagic{BOOTSTRAP_MAGIC};
+    uint32_t nVersion{BOOTSTRAP_VERSION};
+    uint32_t nNetworkMagic{0};  //!< the chain's message start
+    int32_t nStartHeight{0};
+    uint32_t nBlocks{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nMagic);
+        READWRITE(nVersion);
+        READWRITE(nNetworkMagic);
+        READWRITE(nStartHeight);
+        READWRITE(nBlocks);
+    }
+};
+
+struct CBootstrapIndexEntry {
+    uint256 hash;
+    uint256 powHash;
+    uint32_t nFile{0};
+    uint64_t nOffset{0};
+    uint32_t nSize{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(hash);
+        READWRITE(powHash);
+        READWRITE(nFile);
+        READWRITE(nOffset);
+        READWRITE(nSize);
+    }
+};
+
+/** Write the active chain blocks from nStartHeight to nEndHeight (inclusive) to dir */
+bool ExportBootstrap(const fs::path& dir, int nStartHeight, int nEndHeight, std::string& strError);
+
+/** Import a bootstrap directory written by ExportBootstrap, returns the number of blocks processed */
+bool ImportBootstrap(const CChainParams& chainparams, const fs::path& dir, int& nImported, std::string& strError);
+
+#endif // BITCOIN_BOOTSTRAP_H
@@ -24,13 +24,24 @@
 
 extern CChain& chainActive;
 
-static bool checkSpecialTxFee(const CTransaction &tx, CAmount& nFeeTotal, CAmount& specialTxFee, bool fFeeVerify = false) {
+CTxCheckContext::CTxCheckContext(const CBlockIndex* pindexPrev) :
+    CTxCheckContext(pindexPrev ? pindexPrev->nHeight : 0)
+{
+}
+
+CTxCheckContext::CTxCheckContext(int nHeightIn) :
+    nHeight(nHeightIn),
+    fFutureActive(nHeightIn >= Params().GetConsensus().nFutureForkBlock)
+{
+}
+
+static bool checkSpecialTxFee(const CTransaction &tx, CAmount& nFeeTotal, CAmount& specialTxFee, bool isV17active, bool fFeeVerify = false) {
 	if(tx.nVersion >= 3) {
 		switch(tx.nType){
 		case TRANSACTION_FUTURE:
 			CFutureTx ftx;
 			if(GetTxPayload(tx.vExtraPayload, ftx)) {
-                if(!Params().IsFutureActive(chainActive.Tip())) {
+                if(!isV17active) {
                     return false;
                 }
                 bool futureEnabled = sporkManager.IsSporkActive(SPORK_22_SPECIAL_TX_FEE);
@@ -206,7 +217,7 @@ unsigned int GetTransactionSigOpCount(const CTransaction& tx, const CCoinsViewCa
     return nSigOps;
 }
 
-bool CheckTransaction(const CTransaction& tx, CValidationState &state, int nHeight, CAmount blockReward)
+bool CheckTransaction(const CTransaction& tx, CValidationState &state, const CTxCheckContext& ctx, CAmount blockReward)
 {
     bool allowEmptyTxInOut = false;
     if (tx.nType == TRANSACTION_QUORUM_COMMITMENT) {
@@ -219,13 +230,13 @@ bool CheckTransaction(const CTransaction& tx, CValidationState &state, int nHeig
     if (!allowEmptyTxInOut && tx.vout.empty())
         return state.DoS(10, false, REJECT_INVALID, "bad-txns-vout-empty");
     // Size limits
-    if (::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION) > MAX_LEGACY_BLOCK_SIZE)
+    if (tx.GetTotalSize() > MAX_LEGACY_BLOCK_SIZE)
         return state.DoS(100, false, REJECT_INVALID, "bad-txns-oversize");
     if (tx.vExtraPayload.size() > MAX_TX_EXTRA_PAYLOAD)
         return state.DoS(100, false, REJECT_INVALID, "bad-txns-payload-oversize");
 
     // Check for negative or overflow output values
-    bool isV17active = Params().IsFutureActive(chainActive.Tip());
+    const bool isV17active = ctx.fFutureActive;
     CAmount nValueOut = 0;
     for (const auto& txout : tx.vout)
     {
@@ -261,9 +272,9 @@ bool CheckTransaction(const CTransaction& tx, CValidationState &state, int nHeig
         if (tx.vin[0].scriptSig.size() < minCbSize || tx.vin[0].scriptSig.size() > 100)
             return state.DoS(100, false, REJECT_INVALID, "bad-cb-length");
 		FounderPayment founderPayment = Params().GetConsensus().nFounderPayment;
-		CAmount founderReward = founderPayment.getFounderPaymentAmount(nHeight, blockReward);
+		CAmount founderReward = founderPayment.getFounderPaymentAmount(ctx.nHeight, blockReward);
 		int founderStartHeight = founderPayment.getStartBlock();
-		if(nHeight > founderStartHeight && founderReward && !founderPayment.IsBlockPayeeValid(tx,nHeight,blockReward)) {
+		if(ctx.nHeight > founderStartHeight && founderReward && !founderPayment.IsBlockPayeeValid(tx,ctx.nHeight,blockReward)) {
 			return state.DoS(100, false, REJECT_INVALID, "bad-cb-founder-payment-not-found");
 		}
     }
@@ -277,8 +288,10 @@ bool CheckTransaction(const CTransaction& tx, CValidationState &state, int nHeig
     return true;
 }
 
-bool Consensus::CheckTxInputs(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, int nSpendHeight, CAmount& txfee, CAmount& specialTxFee, bool isV17active, bool fFeeVerify)
+bool Consensus::CheckTxInputs(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, int nSpendHeight, CAmount& txfee, CAmount& specialTxFee, const CTxCheckContext& ctx, bool fFeeVerify)
 {
+    const bool isV17active = ctx.fFutureActive;
+
     // are the actual inputs available?
     if (!inputs.HaveInputs(tx)) {
         return state.DoS(100, false, REJECT_INVALID, "bad-txns-inputs-missingorspent", false,
@@ -323,7 +336,7 @@ bool Consensus::CheckTxInputs(const CTransaction& tx, CValidationState& state, c
     }
     txfee = txfee_aux;
 
-	if(!checkSpecialTxFee(tx, txfee, specialTxFee, fFeeVerify)) {
+	if(!checkSpecialTxFee(tx, txfee, specialTxFee, isV17active, fFeeVerify)) {
         return state.DoS(100, false, REJECT_INVALID, "bad-txns-wrong-future-fee-or-not-enable");
 
     }
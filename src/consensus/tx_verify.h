@@ -15,10 +15,31 @@ class CCoinsViewCache;
 class CTransaction;
 class CValidationState;
 
+/**
+ * The chain state transaction checks depend on. It is built once per block or
+ * mempool batch from the block the transactions build on, so the checks don't
+ * read the active chain and don't need cs_main.
+ *
+ * The special tx fee is still read from the global spork manager, which is
+ * guarded by its own lock. The median time past is not part of the context:
+ * CheckTransaction and CheckTxInputs don't look at time, lock time finality is
+ * checked separately by ContextualCheckBlock and CheckFinalTx.
+ */
+struct CTxCheckContext
+{
+    //! Height of the block the transactions build on (the tip for the mempool)
+    int nHeight;
+    //! Whether future transactions and the raised MAX_MONEY are active
+    bool fFutureActive;
+
+    explicit CTxCheckContext(const CBlockIndex* pindexPrev);
+    explicit CTxCheckContext(int nHeightIn);
+};
+
 /** Transaction validation functions */
 
 /** Context-independent validity checks */
-bool CheckTransaction(const CTransaction& tx, CValidationState& state, int nHeight, CAmount blockReward);
+bool CheckTransaction(const CTransaction& tx, CValidationState& state, const CTxCheckContext& ctx, CAmount blockReward);
 
 namespace Consensus {
 /**
@@ -27,7 +48,7 @@ namespace Consensus {
  * @param[out] txfee Set to the transaction fee if successful.
  * Preconditions: tx.IsCoinBase() is false.
  */
-  bool CheckTxInputs(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, int nSpendHeight, CAmount& txfee, CAmount& specialTxFee, bool isV17active, bool fFeeVerify = false);
+  bool CheckTxInputs(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& inputs, int nSpendHeight, CAmount& txfee, CAmount& specialTxFee, const CTxCheckContext& ctx, bool fFeeVerify = false);
 } // namespace Consensus
 
 /** Auxiliary functions for transaction validation (ideally should not be exposed) */
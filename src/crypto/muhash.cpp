@@ -0,0 +1,176 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/muhash.h>
+
+#include <crypto/chacha20.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+
+#include <limits>
+#include <string.h>
+
+namespace {
+
+typedef Num3072::limb_t limb_t;
+typedef Num3072::double_limb_t double_limb_t;
+constexpr int LIMB_SIZE = Num3072::LIMB_SIZE;
+constexpr int LIMBS = Num3072::LIMBS;
+constexpr int LIMB_BYTES = LIMB_SIZE / 8;
+/** 2^3072 - 1103717, the largest 3072-bit safe prime, is used as the modulus */
+constexpr limb_t MAX_PRIME_DIFF = 1103717;
+
+} // namespace
+
+Num3072::Num3072(const unsigned char (&data)[BYTE_SIZE])
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        limb_t limb = 0;
+        for (int j = LIMB_BYTES - 1; j >= 0; --j) {
+            limb = (limb << 8) | data[i * LIMB_BYTES + j];
+        }
+        limbs[i] = limb;
+    }
+    if (IsOverflow()) FullReduce();
+}
+
+void Num3072::ToBytes(unsigned char (&out)[BYTE_SIZE]) const
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        limb_t limb = limbs[i];
+        for (int j = 0; j < LIMB_BYTES; ++j) {
+            out[i * LIMB_BYTES + j] = (unsigned char)limb;
+            limb >>= 8;
+        }
+    }
+}
+
+void Num3072::SetToOne()
+{
+    limbs[0] = 1;
+    for (int i = 1; i < LIMBS; ++i) limbs[i] = 0;
+}
+
+/** Whether the number is at least the modulus */
+bool Num3072::IsOverflow() const
+{
+    if (limbs[0] <= std::numeric_limits<limb_t>::max() - MAX_PRIME_DIFF) return false;
+    for (int i = 1; i < LIMBS; ++i) {
+        if (limbs[i] != std::numeric_limits<limb_t>::max()) return false;
+    }
+    return true;
+}
+
+/** Subtract the modulus, i.e. add MAX_PRIME_DIFF and drop 2^3072 */
+void Num3072::FullReduce()
+{
+    double_limb_t carry = MAX_PRIME_DIFF;
+    for (int i = 0; i < LIMBS && carry; ++i) {
+        carry += limbs[i];
+        limbs[i] = (limb_t)carry;
+        carry >>= LIMB_SIZE;
+    }
+}
+
+void Num3072::Multiply(const Num3072& a)
+{
+    // Schoolbook multiplication into a 6144-bit product
+    limb_t prod[2 * LIMBS] = {0};
+    for (int i = 0; i < LIMBS; ++i) {
+        double_limb_t carry = 0;
+        for (int j = 0; j < LIMBS; ++j) {
+            carry += (double_limb_t)limbs[i] * a.limbs[j] + prod[i + j];
+            prod[i + j] = (limb_t)carry;
+            carry >>= LIMB_SIZE;
+        }
+        prod[i + LIMBS] = (limb_t)carry;
+    }
+
+    // Reduce using 2^3072 = MAX_PRIME_DIFF (mod p): low + high * MAX_PRIME_DIFF
+    double_limb_t carry = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        carry += (double_limb_t)prod[i + LIMBS] * MAX_PRIME_DIFF + prod[i];
+        limbs[i] = (limb_t)carry;
+        carry >>= LIMB_SIZE;
+    }
+
+    // Fold what is left above 2^3072 back in, this can only overflow again
+    // if the result is tiny, in which case one more fold can't overflow.
+    while (carry) {
+        carry *= MAX_PRIME_DIFF;
+        for (int i = 0; i < LIMBS && carry; ++i) {
+            carry += limbs[i];
+            limbs[i] = (limb_t)carry;
+            carry >>= LIMB_SIZE;
+        }
+    }
+
+    if (IsOverflow()) FullReduce();
+}
+
+Num3072 Num3072::GetInverse() const
+{
+    // Fermat's little theorem: a^-1 = a^(p-2) (mod p). The exponent
+    // 2^3072 - 1103719 has all bits set except in its lowest limb.
+    const limb_t lowest = std::numeric_limits<limb_t>::max() - (MAX_PRIME_DIFF + 1);
+    Num3072 out;
+    for (int i = LIMBS - 1; i >= 0; --i) {
+        const limb_t exp = i == 0 ? lowest : std::numeric_limits<limb_t>::max();
+        for (int bit = LIMB_SIZE - 1; bit >= 0; --bit) {
+            out.Multiply(out);
+            if ((exp >> bit) & 1) out.Multiply(*this);
+        }
+    }
+    return out;
+}
+
+void Num3072::Divide(const Num3072& a)
+{
+    Multiply(a.GetInverse());
+}
+
+Num3072 MuHash3072::ToNum3072(const unsigned char* data, size_t len)
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(data, len).Finalize(hash);
+    unsigned char tmp[Num3072::BYTE_SIZE];
+    ChaCha20(hash, sizeof(hash)).Keystream(tmp, sizeof(tmp));
+    return Num3072(tmp);
+}
+
+MuHash3072& MuHash3072::Insert(const unsigned char* data, size_t len)
+{
+    numerator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::Remove(const unsigned char* data, size_t len)
+{
+    denominator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator*=(const MuHash3072& mul)
+{
+    numerator.Multiply(mul.numerator);
+    denominator.Multiply(mul.denominator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator/=(const MuHash3072& div)
+{
+    numerator.Multiply(div.denominator);
+    denominator.Multiply(div.numerator);
+    return *this;
+}
+
+void MuHash3072::Finalize(unsigned char (&out)[32])
+{
+    numerator.Divide(denominator);
+    denominator.SetToOne();
+
+    unsigned char data[Num3072::BYTE_SIZE];
+    numerator.ToBytes(data);
+    CSHA256().Write(data, sizeof(data)).Finalize(out);
+}
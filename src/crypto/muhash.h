@@ -0,0 +1,105 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_MUHASH_H
+#define BITCOIN_CRYPTO_MUHASH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** An element of the multiplicative group of integers modulo 2^3072 - 1103717 */
+class Num3072
+{
+public:
+    static constexpr size_t BYTE_SIZE = 384;
+
+#ifdef __SIZEOF_INT128__
+    typedef unsigned __int128 double_limb_t;
+    typedef uint64_t limb_t;
+    static constexpr int LIMBS = 48;
+    static constexpr int LIMB_SIZE = 64;
+#else
+    typedef uint64_t double_limb_t;
+    typedef uint32_t limb_t;
+    static constexpr int LIMBS = 96;
+    static constexpr int LIMB_SIZE = 32;
+#endif
+    limb_t limbs[LIMBS];
+
+    Num3072() { SetToOne(); }
+    /** Read a little-endian number, the result is reduced modulo the prime */
+    explicit Num3072(const unsigned char (&data)[BYTE_SIZE]);
+
+    void SetToOne();
+    void Multiply(const Num3072& a);
+    void Divide(const Num3072& a);
+    /** Write the (fully reduced) number in little-endian byte order */
+    void ToBytes(unsigned char (&out)[BYTE_SIZE]) const;
+
+private:
+    bool IsOverflow() const;
+    void FullReduce();
+    Num3072 GetInverse() const;
+};
+
+/**
+ * A rolling hash of a set of byte strings (MuHash, see
+ * https://cseweb.ucsd.edu/~mihir/papers/inchash.pdf).
+ *
+ * Every element is hashed to a number modulo a 3072-bit prime, the set hash
+ * is the product of all its elements. Adding and removing elements works in
+ * any order, and two MuHash3072 objects can be combined, so the hash of a set
+ * can be maintained incrementally while the set changes. Removals are kept
+ * in a separate denominator so that the expensive modular inverse is only
+ * computed once in Finalize().
+ */
+class MuHash3072
+{
+private:
+    Num3072 numerator;
+    Num3072 denominator;
+
+    static Num3072 ToNum3072(const unsigned char* data, size_t len);
+
+public:
+    static constexpr size_t SERIALIZED_SIZE = 2 * Num3072::BYTE_SIZE;
+
+    /** Hash of the empty set */
+    MuHash3072() noexcept {}
+
+    /** Add an element to the set */
+    MuHash3072& Insert(const unsigned char* data, size_t len);
+    /** Remove an element from the set */
+    MuHash3072& Remove(const unsigned char* data, size_t len);
+
+    /** Add all elements of another set hash */
+    MuHash3072& operator*=(const MuHash3072& mul);
+    /** Remove all elements of another set hash */
+    MuHash3072& operator/=(const MuHash3072& div);
+
+    /** Compute the 32-byte hash of the set. The state is kept equivalent. */
+    void Finalize(unsigned char (&out)[32]);
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        unsigned char data[Num3072::BYTE_SIZE];
+        numerator.ToBytes(data);
+        s.write((const char*)data, sizeof(data));
+        denominator.ToBytes(data);
+        s.write((const char*)data, sizeof(data));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        unsigned char data[Num3072::BYTE_SIZE];
+        s.read((char*)data, sizeof(data));
+        numerator = Num3072(data);
+        s.read((char*)data, sizeof(data));
+        denominator = Num3072(data);
+    }
+};
+
+#endif // BITCOIN_CRYPTO_MUHASH_H
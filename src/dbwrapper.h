@@ -188,6 +188,13 @@ public:
         return true;
     }
 
+    CDataStream GetValue() {
+        leveldb::Slice slValue = piter->value();
+        CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
+        return ssValue;
+    }
+
     unsigned int GetValueSize() {
         return piter->value().size();
     }
@@ -592,6 +592,118 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
     mnInternalIdMap = mnInternalIdMap.erase(dmn->GetInternalId());
 }
 
+bool CDeterministicMNPayeeIndex::CompareByLastPaid::operator()(const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) const
+{
+    return ::CompareByLastPaid(a, b);
+}
+
+void CDeterministicMNPayeeIndex::Add(const CDeterministicMNCPtr& dmn)
+{
+    if (!dmn) {
+        return;
+    }
+    setPayees.emplace(dmn);
+    mapByInternalId.emplace(dmn->GetInternalId(), dmn);
+}
+
+void CDeterministicMNPayeeIndex::Remove(uint64_t internalId)
+{
+    auto it = mapByInternalId.find(internalId);
+    if (it == mapByInternalId.end()) {
+        return;
+    }
+    setPayees.erase(it->second);
+    mapByInternalId.erase(it);
+}
+
+void CDeterministicMNPayeeIndex::Build(const CDeterministicMNList& mnList)
+{
+    setPayees.clear();
+    mapByInternalId.clear();
+    mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+        Add(dmn);
+    });
+    blockHash = mnList.GetBlockHash();
+    nHeight = mnList.GetHeight();
+    mapPositions.clear();
+    nPositionsChainHeight = -1;
+}
+
+void CDeterministicMNPayeeIndex::ApplyDiff(const CDeterministicMNList& newList, const CDeterministicMNListDiff& diff)
+{
+    // Only the changed MNs move, the relative order of all others stays the same
+    for (const auto& id : diff.removedMns) {
+        Remove(id);
+    }
+    for (const auto& p : diff.updatedMNs) {
+        Remove(p.first);
+        Add(newList.GetMNByInternalId(p.first));
+    }
+    for (const auto& dmn : diff.addedMNs) {
+        Add(newList.GetMN(dmn->proTxHash));
+    }
+    blockHash = newList.GetBlockHash();
+    nHeight = newList.GetHeight();
+    mapPositions.clear();
+    nPositionsChainHeight = -1;
+}
+
+CDeterministicMNCPtr CDeterministicMNPayeeIndex::GetMNPayee() const
+{
+    if (setPayees.size() <= 10 && Params().NetworkIDString().compare("main") == 0) {
+        return nullptr;
+    }
+
+    for (const auto& dmn : setPayees) {
+        if (CDeterministicMNList::IsMNValid(dmn)) {
+            return dmn;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<CDeterministicMNCPtr> CDeterministicMNPayeeIndex::GetProjectedMNPayees(int nCount) const
+{
+    const bool fMainNet = Params().NetworkIDString().compare("main") == 0;
+    // on main there is no projection with less than 10 valid MNs, so look at least that far
+    const size_t nWalk = std::max(nCount, fMainNet ? 10 : 0);
+
+    std::vector<CDeterministicMNCPtr> result;
+    result.reserve(nWalk);
+    for (const auto& dmn : setPayees) {
+        if (result.size() >= nWalk) {
+            break;
+        }
+        if (CDeterministicMNList::IsMNValid(dmn)) {
+            result.emplace_back(dmn);
+        }
+    }
+
+    if (fMainNet && result.size() < 10) {
+        result.clear();
+    } else if (result.size() > (size_t)std::max(nCount, 0)) {
+        result.resize(std::max(nCount, 0));
+    }
+    return result;
+}
+
+int CDeterministicMNPayeeIndex::GetPayeePosition(const uint256& proTxHash) const
+{
+    const int nChainHeight = chainActive.Tip() == nullptr ? 0 : chainActive.Tip()->nHeight;
+    if (nPositionsChainHeight != nChainHeight) {
+        mapPositions.clear();
+        for (const auto& dmn : setPayees) {
+            if (CDeterministicMNList::IsMNValid(dmn, nChainHeight)) {
+                mapPositions.emplace(dmn->proTxHash, (int)mapPositions.size() + 1);
+            }
+        }
+        nPositionsChainHeight = nChainHeight;
+    }
+
+    auto it = mapPositions.find(proTxHash);
+    return it == mapPositions.end() ? -1 : it->second;
+}
+
 CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
     evoDb(_evoDb)
 {
@@ -708,6 +820,80 @@ void CDeterministicMNManager::UpdatedBlockTip(const CBlockIndex* pindex)
     LOCK(cs);
 
     tipIndex = pindex;
+    if (pindex && Params().GetConsensus().DIP0003Enabled) {
+        UpdatePayeeIndex(pindex, GetListForBlock(pindex), true);
+    }
+}
+
+bool CDeterministicMNManager::UpdatePayeeIndex(const CBlockIndex* pindex, const CDeterministicMNList& mnList, bool fRebuild)
+{
+    AssertLockHeld(cs);
+
+    if (payeeIndex.GetBlockHash() == pindex->GetBlockHash()) {
+        return true;
+    }
+
+    if (pindex->pprev && !payeeIndex.GetBlockHash().IsNull() && payeeIndex.GetBlockHash() == pindex->pprev->GetBlockHash()) {
+        auto itDiff = mnListDiffsCache.find(pindex->GetBlockHash());
+        if (itDiff != mnListDiffsCache.end()) {
+            payeeIndex.ApplyDiff(mnList, itDiff->second);
+            return true;
+        }
+        CDeterministicMNListDiff diff;
+        if (evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
+            payeeIndex.ApplyDiff(mnList, diff);
+            return true;
+        }
+    }
+
+    if (!fRebuild) {
+        // don't throw away the tip index for a query about some older block
+        return false;
+    }
+
+    payeeIndex.Build(mnList);
+    return true;
+}
+
+CDeterministicMNCPtr CDeterministicMNManager::GetMNPayee(const CBlockIndex* pindex)
+{
+    LOCK(cs);
+
+    if (payeeIndex.GetBlockHash() == pindex->GetBlockHash()) {
+        return payeeIndex.GetMNPayee();
+    }
+    auto mnList = GetListForBlock(pindex);
+    if (UpdatePayeeIndex(pindex, mnList, pindex == tipIndex)) {
+        return payeeIndex.GetMNPayee();
+    }
+    return mnList.GetMNPayee();
+}
+
+std::vector<CDeterministicMNCPtr> CDeterministicMNManager::GetProjectedMNPayees(const CBlockIndex* pindex, int nCount)
+{
+    LOCK(cs);
+
+    if (payeeIndex.GetBlockHash() == pindex->GetBlockHash()) {
+        return payeeIndex.GetProjectedMNPayees(nCount);
+    }
+    auto mnList = GetListForBlock(pindex);
+    if (UpdatePayeeIndex(pindex, mnList, pindex == tipIndex)) {
+        return payeeIndex.GetProjectedMNPayees(nCount);
+    }
+    return mnList.GetProjectedMNPayees(nCount);
+}
+
+int CDeterministicMNManager::GetProjectedPayeePosition(const uint256& proTxHash)
+{
+    LOCK(cs);
+
+    if (!tipIndex) {
+        return -1;
+    }
+    if (payeeIndex.GetBlockHash() != tipIndex->GetBlockHash()) {
+        UpdatePayeeIndex(tipIndex, GetListForBlock(tipIndex), true);
+    }
+    return payeeIndex.GetPayeePosition(proTxHash);
 }
 
 bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const CBlockIndex* pindexPrev, CValidationState& _state, const CCoinsViewCache& view, CDeterministicMNList& mnListRet, bool debugLogs)
@@ -719,7 +905,9 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
     newList.SetBlockHash(uint256()); // we can't know the final block hash, so better not return a (invalid) block hash
     newList.SetHeight(nHeight);
 
-    auto payee = oldList.GetMNPayee();
+    // pindexPrev is normally the block after the payee index, so this only applies the last diff to it
+    UpdatePayeeIndex(pindexPrev, oldList, true);
+    auto payee = payeeIndex.GetMNPayee();
     // we iterate the oldList here and update the newList
     // this is only valid as long these have not diverged at this point, which is the case as long as we don't add
     // code above this loop that modifies newList
@@ -18,6 +18,7 @@
 #include <immer/map.hpp>
 #include <immer/map_transient.hpp>
 
+#include <set>
 #include <unordered_map>
 
 class CBlock;
@@ -680,6 +681,48 @@ public:
     }
 };
 
+/**
+ * All MNs of a list kept in payment order (last paid first), so that the next payees can be read off the front
+ * instead of sorting the whole list. CDeterministicMNManager keeps one for the chain tip and moves it forward with
+ * the list diff of each connected block.
+ */
+class CDeterministicMNPayeeIndex
+{
+public:
+    struct CompareByLastPaid {
+        bool operator()(const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) const;
+    };
+
+private:
+    uint256 blockHash;
+    int nHeight{-1};
+    std::set<CDeterministicMNCPtr, CompareByLastPaid> setPayees;
+    std::unordered_map<uint64_t, CDeterministicMNCPtr> mapByInternalId;
+
+    // 1 based position of each valid MN in the payment order. Built on first use, validity depends on the chain height
+    mutable std::unordered_map<uint256, int, StaticSaltedHasher> mapPositions;
+    mutable int nPositionsChainHeight{-1};
+
+    void Add(const CDeterministicMNCPtr& dmn);
+    void Remove(uint64_t internalId);
+
+public:
+    const uint256& GetBlockHash() const { return blockHash; }
+    int GetHeight() const { return nHeight; }
+
+    void Build(const CDeterministicMNList& mnList);
+    void ApplyDiff(const CDeterministicMNList& newList, const CDeterministicMNListDiff& diff);
+
+    // Same results as the CDeterministicMNList methods of the same name
+    CDeterministicMNCPtr GetMNPayee() const;
+    std::vector<CDeterministicMNCPtr> GetProjectedMNPayees(int nCount) const;
+
+    /**
+     * Returns in how many blocks after this list the MN is expected to be paid, or -1 if it is not valid
+     */
+    int GetPayeePosition(const uint256& proTxHash) const;
+};
+
 class CDeterministicMNManager
 {
     static const int DISK_SNAPSHOT_PERIOD = 576; // once per day
@@ -696,6 +739,8 @@ private:
     std::unordered_map<uint256, CDeterministicMNListDiff, StaticSaltedHasher> mnListDiffsCache;
     const CBlockIndex* tipIndex{nullptr};
 
+    CDeterministicMNPayeeIndex payeeIndex;
+
 public:
     explicit CDeterministicMNManager(CEvoDB& _evoDb);
 
@@ -712,6 +757,12 @@ public:
     CDeterministicMNList GetListForBlock(const CBlockIndex* pindex);
     CDeterministicMNList GetListAtChainTip();
 
+    // Payees of the list at pindex, served from the payee index when pindex is (about to become) the tip
+    CDeterministicMNCPtr GetMNPayee(const CBlockIndex* pindex);
+    std::vector<CDeterministicMNCPtr> GetProjectedMNPayees(const CBlockIndex* pindex, int nCount);
+    // See CDeterministicMNPayeeIndex::GetPayeePosition, relative to the chain tip
+    int GetProjectedPayeePosition(const uint256& proTxHash);
+
     // Test if given TX is a ProRegTx which also contains the collateral at index n
     static bool IsProTxWithCollateral(const CTransactionRef& tx, uint32_t n);
 
@@ -724,6 +775,8 @@ public:
 
 private:
     void CleanupCache(int nHeight);
+
+    bool UpdatePayeeIndex(const CBlockIndex* pindex, const CDeterministicMNList& mnList, bool fRebuild);
 };
 
 extern std::unique_ptr<CDeterministicMNManager> deterministicMNManager;
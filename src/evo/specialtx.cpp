@@ -174,12 +174,3 @@ bool UndoSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex)
 
     return true;
 }
-
-uint256 CalcTxInputsHash(const CTransaction& tx)
-{
-    CHashWriter hw(CLIENT_VERSION, SER_GETHASH);
-    for (const auto& in : tx.vin) {
-        hw << in.prevout;
-    }
-    return hw.GetHash();
-}
@@ -6,6 +6,8 @@
 #ifndef BITCOIN_EVO_SPECIALTX_H
 #define BITCOIN_EVO_SPECIALTX_H
 
+#include <clientversion.h>
+#include <hash.h>
 #include <primitives/transaction.h>
 #include <streams.h>
 #include <version.h>
@@ -51,6 +53,15 @@ void SetTxPayload(CMutableTransaction& tx, const T& payload)
     tx.vExtraPayload.assign(ds.begin(), ds.end());
 }
 
-uint256 CalcTxInputsHash(const CTransaction& tx);
+// Inline so raptoreum-tx, which doesn't link the server library, shares it
+template <typename TxType>
+inline uint256 CalcTxInputsHash(const TxType& tx)
+{
+    CHashWriter hw(CLIENT_VERSION, SER_GETHASH);
+    for (const auto& in : tx.vin) {
+        hw << in.prevout;
+    }
+    return hw.GetHash();
+}
 
 #endif // BITCOIN_EVO_SPECIALTX_H
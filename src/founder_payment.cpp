@@ -66,5 +66,12 @@ bool FounderPayment::IsBlockPayeeValid(const CTransaction& txNew, const int heig
 	return false;
 }
 
-
-
+CAmount FounderPayment::getPaidAmount(const CTransaction& txNew) {
+	CScript payee = GetScriptForDestination(DecodeDestination(founderAddress));
+	for (const CTxOut& out : txNew.vout) {
+		if (out.scriptPubKey == payee) {
+			return out.nValue;
+		}
+	}
+	return 0;
+}
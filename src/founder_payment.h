@@ -35,6 +35,7 @@ public:
 	CAmount getFounderPaymentAmount(int blockHeight, CAmount blockReward);
 	void FillFounderPayment(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutFounderRet);
 	bool IsBlockPayeeValid(const CTransaction& txNew, const int height, const CAmount blockReward);
+	CAmount getPaidAmount(const CTransaction& txNew);
 	int getStartBlock() {return this->startBlock;}
 private:
 	string founderAddress;
@@ -5,6 +5,7 @@
 
 #include <governance/governance-classes.h>
 #include <core_io.h>
+#include <evo/deterministicmns.h>
 #include <init.h>
 #include <utilstrencodings.h>
 #include <validation.h>
@@ -215,6 +216,50 @@ std::vector<CSuperblock_sptr> CGovernanceTriggerManager::GetActiveTriggers()
     return vecResults;
 }
 
+std::map<int, CSuperblockManager::CEvaluation> CSuperblockManager::mapEvaluationCache;
+
+/**
+*   Get Evaluation
+*
+*   - Evaluate the triggers for this height once per governance state version and smartnode list,
+*     block validation and block templates ask for the same height several times
+*/
+
+const CSuperblockManager::CEvaluation& CSuperblockManager::GetEvaluation(int nBlockHeight)
+{
+    AssertLockHeld(governance.cs);
+
+    const uint64_t nStateVersion = governance.GetStateVersion();
+    const uint256 mnListBlockHash = deterministicMNManager->GetListAtChainTip().GetBlockHash();
+
+    auto it = mapEvaluationCache.find(nBlockHeight);
+    if (it != mapEvaluationCache.end() && it->second.nStateVersion == nStateVersion && it->second.mnListBlockHash == mnListBlockHash) {
+        return it->second;
+    }
+
+    CEvaluation evaluation;
+    evaluation.nStateVersion = nStateVersion;
+    evaluation.mnListBlockHash = mnListBlockHash;
+    evaluation.fTriggered = EvaluateTriggered(nBlockHeight);
+    if (EvaluateBestSuperblock(evaluation.pBestSuperblock, nBlockHeight)) {
+        EvaluatePayments(evaluation.pBestSuperblock, evaluation.voutPayments);
+    } else {
+        evaluation.pBestSuperblock = nullptr;
+    }
+
+    if (it == mapEvaluationCache.end()) {
+        // Only a few heights around the tip are ever asked for, forget the lowest one
+        if (mapEvaluationCache.size() >= MAX_CACHED_EVALUATIONS) {
+            mapEvaluationCache.erase(mapEvaluationCache.begin());
+        }
+        it = mapEvaluationCache.emplace(nBlockHeight, std::move(evaluation)).first;
+    } else {
+        it->second = std::move(evaluation);
+    }
+
+    return it->second;
+}
+
 /**
 *   Is Superblock Triggered
 *
@@ -229,30 +274,37 @@ bool CSuperblockManager::IsSuperblockTriggered(int nBlockHeight)
     }
 
     LOCK(governance.cs);
+    return GetEvaluation(nBlockHeight).fTriggered;
+}
+
+bool CSuperblockManager::EvaluateTriggered(int nBlockHeight)
+{
+    AssertLockHeld(governance.cs);
+
     // GET ALL ACTIVE TRIGGERS
     std::vector<CSuperblock_sptr> vecTriggers = triggerman.GetActiveTriggers();
 
-    LogPrint(BCLog::GOBJECT, "CSuperblockManager::IsSuperblockTriggered -- vecTriggers.size() = %d\n", vecTriggers.size());
+    LogPrint(BCLog::GOBJECT, "CSuperblockManager::EvaluateTriggered -- vecTriggers.size() = %d\n", vecTriggers.size());
 
     for (const auto& pSuperblock : vecTriggers) {
         if (!pSuperblock) {
-            LogPrintf("CSuperblockManager::IsSuperblockTriggered -- Non-superblock found, continuing\n");
+            LogPrintf("CSuperblockManager::EvaluateTriggered -- Non-superblock found, continuing\n");
             continue;
         }
 
         CGovernanceObject* pObj = pSuperblock->GetGovernanceObject();
 
         if (!pObj) {
-            LogPrintf("CSuperblockManager::IsSuperblockTriggered -- pObj == nullptr, continuing\n");
+            LogPrintf("CSuperblockManager::EvaluateTriggered -- pObj == nullptr, continuing\n");
             continue;
         }
 
-        LogPrint(BCLog::GOBJECT, "CSuperblockManager::IsSuperblockTriggered -- data = %s\n", pObj->GetDataAsPlainString());
+        LogPrint(BCLog::GOBJECT, "CSuperblockManager::EvaluateTriggered -- data = %s\n", pObj->GetDataAsPlainString());
 
         // note : 12.1 - is epoch calculation correct?
 
         if (nBlockHeight != pSuperblock->GetBlockHeight()) {
-            LogPrint(BCLog::GOBJECT, "CSuperblockManager::IsSuperblockTriggered -- block height doesn't match nBlockHeight = %d, blockStart = %d, continuing\n",
+            LogPrint(BCLog::GOBJECT, "CSuperblockManager::EvaluateTriggered -- block height doesn't match nBlockHeight = %d, blockStart = %d, continuing\n",
                 nBlockHeight,
                 pSuperblock->GetBlockHeight());
             continue;
@@ -263,10 +315,10 @@ bool CSuperblockManager::IsSuperblockTriggered(int nBlockHeight)
         pObj->UpdateSentinelVariables();
 
         if (pObj->IsSetCachedFunding()) {
-            LogPrint(BCLog::GOBJECT, "CSuperblockManager::IsSuperblockTriggered -- fCacheFunding = true, returning true\n");
+            LogPrint(BCLog::GOBJECT, "CSuperblockManager::EvaluateTriggered -- fCacheFunding = true, returning true\n");
             return true;
         } else {
-            LogPrint(BCLog::GOBJECT, "CSuperblockManager::IsSuperblockTriggered -- fCacheFunding = false, continuing\n");
+            LogPrint(BCLog::GOBJECT, "CSuperblockManager::EvaluateTriggered -- fCacheFunding = false, continuing\n");
         }
     }
 
@@ -280,6 +332,17 @@ bool CSuperblockManager::GetBestSuperblock(CSuperblock_sptr& pSuperblockRet, int
         return false;
     }
 
+    AssertLockHeld(governance.cs);
+    const CEvaluation& evaluation = GetEvaluation(nBlockHeight);
+    if (!evaluation.pBestSuperblock) {
+        return false;
+    }
+    pSuperblockRet = evaluation.pBestSuperblock;
+    return true;
+}
+
+bool CSuperblockManager::EvaluateBestSuperblock(CSuperblock_sptr& pSuperblockRet, int nBlockHeight)
+{
     AssertLockHeld(governance.cs);
     std::vector<CSuperblock_sptr> vecTriggers = triggerman.GetActiveTriggers();
     int nYesCount = 0;
@@ -325,6 +388,14 @@ bool CSuperblockManager::GetSuperblockPayments(int nBlockHeight, std::vector<CTx
         return false;
     }
 
+    // GET SUPERBLOCK OUTPUTS, evaluated together with the best superblock
+
+    voutSuperblockRet = GetEvaluation(nBlockHeight).voutPayments;
+    return true;
+}
+
+void CSuperblockManager::EvaluatePayments(const CSuperblock_sptr& pSuperblock, std::vector<CTxOut>& voutSuperblockRet)
+{
     // make sure it's empty, just in case
     voutSuperblockRet.clear();
 
@@ -351,14 +422,12 @@ bool CSuperblockManager::GetSuperblockPayments(int nBlockHeight, std::vector<CTx
 
             // TODO: PRINT NICE N.N RAPTOREUM OUTPUT
 
-            LogPrint(BCLog::GOBJECT, "CSuperblockManager::GetSuperblockPayments -- NEW Superblock: output %d (addr %s, amount %lld)\n",
+            LogPrint(BCLog::GOBJECT, "CSuperblockManager::EvaluatePayments -- NEW Superblock: output %d (addr %s, amount %lld)\n",
                         i, EncodeDestination(dest), payment.nAmount);
         } else {
-            LogPrint(BCLog::GOBJECT, "CSuperblockManager::GetSuperblockPayments -- Payment not found\n");
+            LogPrint(BCLog::GOBJECT, "CSuperblockManager::EvaluatePayments -- Payment not found\n");
         }
     }
-
-    return true;
 }
 
 bool CSuperblockManager::IsValid(const CTransaction& txNew, int nBlockHeight, CAmount blockReward)
@@ -53,6 +53,29 @@ public:
 class CSuperblockManager
 {
 private:
+    /**
+     * Result of evaluating the active triggers for one height. It stays valid as long as
+     * neither the governance state version nor the smartnode list at the tip change.
+     */
+    struct CEvaluation {
+        uint64_t nStateVersion;
+        uint256 mnListBlockHash;
+        bool fTriggered;
+        CSuperblock_sptr pBestSuperblock;
+        std::vector<CTxOut> voutPayments;
+    };
+
+    static const size_t MAX_CACHED_EVALUATIONS = 8;
+
+    // Protected by governance.cs
+    static std::map<int, CEvaluation> mapEvaluationCache;
+
+    static const CEvaluation& GetEvaluation(int nBlockHeight);
+
+    static bool EvaluateTriggered(int nBlockHeight);
+    static bool EvaluateBestSuperblock(CSuperblock_sptr& pSuperblockRet, int nBlockHeight);
+    static void EvaluatePayments(const CSuperblock_sptr& pSuperblock, std::vector<CTxOut>& voutSuperblockRet);
+
     static bool GetBestSuperblock(CSuperblock_sptr& pSuperblockRet, int nBlockHeight);
 
 public:
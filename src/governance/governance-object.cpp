@@ -37,6 +37,7 @@ CGovernanceObject::CGovernanceObject() :
     fExpired(false),
     fUnparsable(false),
     mapCurrentMNVotes(),
+    mapVoteTally(),
     fileVotes()
 {
     // PARSE JSON DATA STORAGE (VCHDATA)
@@ -64,6 +65,7 @@ CGovernanceObject::CGovernanceObject(const uint256& nHashParentIn, int nRevision
     fExpired(false),
     fUnparsable(false),
     mapCurrentMNVotes(),
+    mapVoteTally(),
     fileVotes()
 {
     // PARSE JSON DATA STORAGE (VCHDATA)
@@ -91,6 +93,7 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other) :
     fExpired(other.fExpired),
     fUnparsable(other.fUnparsable),
     mapCurrentMNVotes(other.mapCurrentMNVotes),
+    mapVoteTally(other.mapVoteTally),
     fileVotes(other.fileVotes)
 {
 }
@@ -98,7 +101,8 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other) :
 bool CGovernanceObject::ProcessVote(CNode* pfrom,
     const CGovernanceVote& vote,
     CGovernanceException& exception,
-    CConnman& connman)
+    CConnman& connman,
+    const uint256& hashVerifiedKey)
 {
     LOCK(cs);
 
@@ -139,8 +143,11 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         exception = CGovernanceException(ostr.str(), GOVERNANCE_EXCEPTION_PERMANENT_ERROR, 20);
         return false;
     }
-    auto it2 = voteRecordRef.mapInstances.emplace(vote_instance_m_t::value_type(int(eSignal), vote_instance_t())).first;
-    vote_instance_t& voteInstanceRef = it2->second;
+    auto ret = voteRecordRef.mapInstances.emplace(vote_instance_m_t::value_type(int(eSignal), vote_instance_t()));
+    vote_instance_t& voteInstanceRef = ret.first->second;
+    if (ret.second) {
+        UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, 1);
+    }
 
     // Reject obsolete votes
     if (vote.GetTimestamp() < voteInstanceRef.nCreationTime) {
@@ -186,7 +193,7 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
     bool onlyVotingKeyAllowed = nObjectType == GOVERNANCE_OBJECT_PROPOSAL && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
 
     // Finally check that the vote is actually valid (done last because of cost of signature verification)
-    if (!vote.IsValid(onlyVotingKeyAllowed)) {
+    if (!vote.IsValid(onlyVotingKeyAllowed, hashVerifiedKey)) {
         std::ostringstream ostr;
         ostr << "CGovernanceObject::ProcessVote -- Invalid vote"
              << ", MN outpoint = " << vote.GetSmartnodeOutpoint().ToStringShort()
@@ -208,7 +215,9 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         return false;
     }
 
+    UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, -1);
     voteInstanceRef = vote_instance_t(vote.GetOutcome(), nVoteTimeUpdate, vote.GetTimestamp());
+    UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, 1);
     fileVotes.AddVote(vote);
     fDirtyCache = true;
     // SEND NOTIFICATION TO SCRIPT/ZMQ
@@ -225,6 +234,9 @@ void CGovernanceObject::ClearSmartnodeVotes()
     auto it = mapCurrentMNVotes.begin();
     while (it != mapCurrentMNVotes.end()) {
         if (!mnList.HasMNByCollateral(it->first)) {
+            for (const auto& instancePair : it->second.mapInstances) {
+                UpdateVoteTally(instancePair.first, instancePair.second.eOutcome, -1);
+            }
             fileVotes.RemoveVotesFromSmartnode(it->first);
             mapCurrentMNVotes.erase(it++);
             fDirtyCache = true;
@@ -254,6 +266,7 @@ std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpo
         CGovernanceVote tmpVote(mnOutpoint, nParentHash, (vote_signal_enum_t)jt->first, jt->second.eOutcome);
         tmpVote.SetTime(jt->second.nCreationTime);
         if (removedVotes.count(tmpVote.GetHash())) {
+            UpdateVoteTally(jt->first, jt->second.eOutcome, -1);
             jt = it->second.mapInstances.erase(jt);
         } else {
             ++jt;
@@ -607,19 +620,35 @@ bool CGovernanceObject::IsCollateralValid(std::string& strError, bool& fMissingC
     return true;
 }
 
-int CGovernanceObject::CountMatchingVotes(vote_signal_enum_t eVoteSignalIn, vote_outcome_enum_t eVoteOutcomeIn) const
+void CGovernanceObject::UpdateVoteTally(int nSignal, vote_outcome_enum_t eOutcome, int nDelta)
+{
+    AssertLockHeld(cs);
+
+    auto it = mapVoteTally.emplace(std::make_pair(nSignal, int(eOutcome)), 0).first;
+    it->second += nDelta;
+    if (it->second <= 0) {
+        mapVoteTally.erase(it);
+    }
+}
+
+void CGovernanceObject::RebuildVoteTally()
 {
     LOCK(cs);
 
-    int nCount = 0;
+    mapVoteTally.clear();
     for (const auto& votepair : mapCurrentMNVotes) {
-        const vote_rec_t& recVote = votepair.second;
-        auto it2 = recVote.mapInstances.find(eVoteSignalIn);
-        if (it2 != recVote.mapInstances.end() && it2->second.eOutcome == eVoteOutcomeIn) {
-            ++nCount;
+        for (const auto& instancePair : votepair.second.mapInstances) {
+            UpdateVoteTally(instancePair.first, instancePair.second.eOutcome, 1);
         }
     }
-    return nCount;
+}
+
+int CGovernanceObject::CountMatchingVotes(vote_signal_enum_t eVoteSignalIn, vote_outcome_enum_t eVoteOutcomeIn) const
+{
+    LOCK(cs);
+
+    auto it = mapVoteTally.find(std::make_pair(int(eVoteSignalIn), int(eVoteOutcomeIn)));
+    return it == mapVoteTally.end() ? 0 : it->second;
 }
 
 /**
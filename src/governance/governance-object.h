@@ -162,8 +162,14 @@ private:
 
     vote_m_t mapCurrentMNVotes;
 
+    /// Number of entries in mapCurrentMNVotes per (signal, outcome), so vote counts don't need a scan
+    std::map<std::pair<int, int>, int> mapVoteTally;
+
     CGovernanceObjectVoteFile fileVotes;
 
+    void UpdateVoteTally(int nSignal, vote_outcome_enum_t eOutcome, int nDelta);
+    void RebuildVoteTally();
+
 public:
     CGovernanceObject();
 
@@ -317,6 +323,9 @@ public:
             READWRITE(fExpired);
             READWRITE(mapCurrentMNVotes);
             READWRITE(fileVotes);
+            if (ser_action.ForRead()) {
+                RebuildVoteTally();
+            }
             LogPrint(BCLog::GOBJECT, "CGovernanceObject::SerializationOp hash = %s, vote count = %d\n", GetHash().ToString(), fileVotes.GetVoteCount());
         }
 
@@ -332,7 +341,8 @@ public:
     bool ProcessVote(CNode* pfrom,
         const CGovernanceVote& vote,
         CGovernanceException& exception,
-        CConnman& connman);
+        CConnman& connman,
+        const uint256& hashVerifiedKey = uint256());
 
     /// Called when MN's which have voted on this object have been removed
     void ClearSmartnodeVotes();
@@ -239,7 +239,7 @@ bool CGovernanceVote::CheckSignature(const CBLSPublicKey& pubKey) const
     return true;
 }
 
-bool CGovernanceVote::IsValid(bool useVotingKey) const
+bool CGovernanceVote::IsValid(bool useVotingKey, const uint256& hashVerifiedKey) const
 {
     if (nTime > GetAdjustedTime() + (60 * 60)) {
         LogPrint(BCLog::GOBJECT, "CGovernanceVote::IsValid -- vote is too far ahead of current time - %s - nTime %lli - Max Time %lli\n", GetHash().ToString(), nTime, GetAdjustedTime() + (60 * 60));
@@ -265,9 +265,11 @@ bool CGovernanceVote::IsValid(bool useVotingKey) const
     }
 
     if (useVotingKey) {
-        return CheckSignature(dmn->pdmnState->keyIDVoting);
+        const CKeyID& keyIDVoting = dmn->pdmnState->keyIDVoting;
+        return (!hashVerifiedKey.IsNull() && hashVerifiedKey == GetVerifiedKeyHash(keyIDVoting)) || CheckSignature(keyIDVoting);
     } else {
-        return CheckSignature(dmn->pdmnState->pubKeyOperator.Get());
+        const CBLSPublicKey& pubKeyOperator = dmn->pdmnState->pubKeyOperator.Get();
+        return (!hashVerifiedKey.IsNull() && hashVerifiedKey == GetVerifiedKeyHash(pubKeyOperator)) || CheckSignature(pubKeyOperator);
     }
 }
 
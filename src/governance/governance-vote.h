@@ -6,6 +6,7 @@
 #ifndef BITCOIN_GOVERNANCE_GOVERNANCE_VOTE_H
 #define BITCOIN_GOVERNANCE_GOVERNANCE_VOTE_H
 
+#include <hash.h>
 #include <key.h>
 #include <primitives/transaction.h>
 #include <bls/bls.h>
@@ -58,6 +59,8 @@ class CGovernanceVote
 
     friend bool operator<(const CGovernanceVote& vote1, const CGovernanceVote& vote2);
 
+    friend class CGovernanceObjectVoteFile;
+
 private:
     bool fValid;     //if the vote is currently valid / counted
     bool fSynced;    //if we've sent this to our peers
@@ -95,12 +98,17 @@ public:
     }
 
     void SetSignature(const std::vector<unsigned char>& vchSigIn) { vchSig = vchSigIn; }
+    const std::vector<unsigned char>& GetSignature() const { return vchSig; }
 
     bool Sign(const CKey& key, const CKeyID& keyID);
     bool CheckSignature(const CKeyID& keyID) const;
     bool Sign(const CBLSSecretKey& key);
     bool CheckSignature(const CBLSPublicKey& pubKey) const;
-    bool IsValid(bool useVotingKey) const;
+    /// The signature check is skipped if hashVerifiedKey is the key the current smartnode list
+    /// expects, meaning the signature was already verified with that key
+    bool IsValid(bool useVotingKey, const uint256& hashVerifiedKey = uint256()) const;
+    static uint256 GetVerifiedKeyHash(const CKeyID& keyID) { return ::SerializeHash(keyID); }
+    static uint256 GetVerifiedKeyHash(const CBLSPublicKey& pubKey) { return ::SerializeHash(pubKey); }
     void Relay(CConnman& connman) const;
 
     const COutPoint& GetSmartnodeOutpoint() const { return smartnodeOutpoint; }
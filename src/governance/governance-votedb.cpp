@@ -5,125 +5,269 @@
 
 #include <governance/governance-votedb.h>
 
+#include <memusage.h>
+#include <saltedhasher.h>
+
+#include <algorithm>
+#include <limits>
+
+const uint32_t CGovernanceObjectVoteFile::SLOT_EMPTY;
+const uint32_t CGovernanceObjectVoteFile::SLOT_DELETED;
+
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
     nMemoryVotes(0),
-    listVotes(),
-    mapVoteIndex()
+    nIndexUsed(0)
 {
 }
 
-CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other) :
-    nMemoryVotes(other.nMemoryVotes),
-    listVotes(other.listVotes),
-    mapVoteIndex()
+void CGovernanceObjectVoteFile::Clear()
 {
-    RebuildIndex();
+    nMemoryVotes = 0;
+    vecHash.clear();
+    vecSmartnodeOutpoint.clear();
+    vecParentIndex.clear();
+    vecSignal.clear();
+    vecOutcome.clear();
+    vecTime.clear();
+    vecSigOffset.clear();
+    vecSigSize.clear();
+    vecDead.clear();
+    vchSigData.clear();
+    vecParentHash.clear();
+    vecIndex.clear();
+    nIndexUsed = 0;
 }
 
 void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
 {
-    uint256 nHash = vote.GetHash();
     // make sure to never add/update already known votes
-    if (HasVote(nHash))
+    if (HasVote(vote.GetHash()))
         return;
-    listVotes.push_front(vote);
-    mapVoteIndex.emplace(nHash, listVotes.begin());
-    ++nMemoryVotes;
+    Append(vote);
     RemoveOldVotes(vote);
+    CompactIfNeeded();
 }
 
 bool CGovernanceObjectVoteFile::HasVote(const uint256& nHash) const
 {
-    return mapVoteIndex.find(nHash) != mapVoteIndex.end();
+    if (vecIndex.empty()) {
+        return false;
+    }
+    uint32_t nSlot = vecIndex[FindSlot(nHash)];
+    return nSlot != SLOT_EMPTY;
 }
 
 bool CGovernanceObjectVoteFile::SerializeVoteToStream(const uint256& nHash, CDataStream& ss) const
 {
-    auto it = mapVoteIndex.find(nHash);
-    if (it == mapVoteIndex.end()) {
+    if (vecIndex.empty()) {
+        return false;
+    }
+    uint32_t nSlot = vecIndex[FindSlot(nHash)];
+    if (nSlot == SLOT_EMPTY) {
         return false;
     }
-    ss << *(it->second);
+    ss << GetVote(nSlot - 1);
     return true;
 }
 
 std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
 {
     std::vector<CGovernanceVote> vecResult;
-    for (auto it = listVotes.begin(); it != listVotes.end(); ++it) {
-        vecResult.push_back(*it);
+    vecResult.reserve(nMemoryVotes);
+    for (size_t i = vecHash.size(); i-- > 0; ) {
+        if (!vecDead[i]) {
+            vecResult.push_back(GetVote(i));
+        }
     }
     return vecResult;
 }
 
 void CGovernanceObjectVoteFile::RemoveVotesFromSmartnode(const COutPoint& outpointSmartnode)
 {
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetSmartnodeOutpoint() == outpointSmartnode) {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
+    for (size_t i = 0; i < vecHash.size(); i++) {
+        if (!vecDead[i] && vecSmartnodeOutpoint[i] == outpointSmartnode) {
+            MarkDead(i);
         }
     }
+    CompactIfNeeded();
 }
 
 std::set<uint256> CGovernanceObjectVoteFile::RemoveInvalidVotes(const COutPoint& outpointSmartnode, bool fProposal)
 {
     std::set<uint256> removedVotes;
 
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetSmartnodeOutpoint() == outpointSmartnode) {
-            bool useVotingKey = fProposal && (it->GetSignal() == VOTE_SIGNAL_FUNDING);
-            if (!it->IsValid(useVotingKey)) {
-                removedVotes.emplace(it->GetHash());
-                --nMemoryVotes;
-                mapVoteIndex.erase(it->GetHash());
-                listVotes.erase(it++);
-                continue;
+    for (size_t i = 0; i < vecHash.size(); i++) {
+        if (!vecDead[i] && vecSmartnodeOutpoint[i] == outpointSmartnode) {
+            bool useVotingKey = fProposal && (vecSignal[i] == VOTE_SIGNAL_FUNDING);
+            if (!GetVote(i).IsValid(useVotingKey)) {
+                removedVotes.emplace(vecHash[i]);
+                MarkDead(i);
             }
         }
-        ++it;
     }
+    CompactIfNeeded();
 
     return removedVotes;
 }
 
+size_t CGovernanceObjectVoteFile::GetMemoryUsage() const
+{
+    return memusage::DynamicUsage(vecHash) +
+           memusage::DynamicUsage(vecSmartnodeOutpoint) +
+           memusage::DynamicUsage(vecParentIndex) +
+           memusage::DynamicUsage(vecSignal) +
+           memusage::DynamicUsage(vecOutcome) +
+           memusage::DynamicUsage(vecTime) +
+           memusage::DynamicUsage(vecSigOffset) +
+           memusage::DynamicUsage(vecSigSize) +
+           memusage::MallocUsage((vecDead.capacity() + 7) / 8) +
+           memusage::DynamicUsage(vchSigData) +
+           memusage::DynamicUsage(vecParentHash) +
+           memusage::DynamicUsage(vecIndex);
+}
+
+CGovernanceVote CGovernanceObjectVoteFile::GetVote(size_t nPos) const
+{
+    CGovernanceVote vote;
+    vote.smartnodeOutpoint = vecSmartnodeOutpoint[nPos];
+    vote.nParentHash = vecParentHash[vecParentIndex[nPos]];
+    vote.nVoteSignal = vecSignal[nPos];
+    vote.nVoteOutcome = vecOutcome[nPos];
+    vote.nTime = vecTime[nPos];
+    vote.vchSig.assign(vchSigData.begin() + vecSigOffset[nPos], vchSigData.begin() + vecSigOffset[nPos] + vecSigSize[nPos]);
+    *const_cast<uint256*>(&vote.hash) = vecHash[nPos];
+    return vote;
+}
+
+void CGovernanceObjectVoteFile::Append(const CGovernanceVote& vote)
+{
+    // keep the load factor (including deleted slots) at or below one half
+    if ((nIndexUsed + 1) * 2 > vecIndex.size()) {
+        RebuildIndex((nMemoryVotes + 1) * 4);
+    }
+
+    auto itParent = std::find(vecParentHash.begin(), vecParentHash.end(), vote.GetParentHash());
+    if (itParent == vecParentHash.end()) {
+        itParent = vecParentHash.insert(vecParentHash.end(), vote.GetParentHash());
+    }
+
+    // Signatures are 65 (ECDSA) or 96 (BLS) bytes, anything longer isn't valid anyway
+    const std::vector<unsigned char>& vchSig = vote.GetSignature();
+    const size_t nSigSize = std::min<size_t>(vchSig.size(), std::numeric_limits<uint16_t>::max());
+
+    vecHash.push_back(vote.GetHash());
+    vecSmartnodeOutpoint.push_back(vote.GetSmartnodeOutpoint());
+    vecParentIndex.push_back(itParent - vecParentHash.begin());
+    vecSignal.push_back(vote.nVoteSignal);
+    vecOutcome.push_back(vote.nVoteOutcome);
+    vecTime.push_back(vote.GetTimestamp());
+    vecSigOffset.push_back(vchSigData.size());
+    vecSigSize.push_back(nSigSize);
+    vecDead.push_back(false);
+    vchSigData.insert(vchSigData.end(), vchSig.begin(), vchSig.begin() + nSigSize);
+    ++nMemoryVotes;
+
+    vecIndex[FindSlot(vote.GetHash())] = vecHash.size();
+    ++nIndexUsed;
+}
+
+void CGovernanceObjectVoteFile::MarkDead(size_t nPos)
+{
+    // deleted slots keep the probe chains intact, they are dropped on the next rebuild
+    vecIndex[FindSlot(vecHash[nPos])] = SLOT_DELETED;
+    vecDead[nPos] = true;
+    --nMemoryVotes;
+}
+
 void CGovernanceObjectVoteFile::RemoveOldVotes(const CGovernanceVote& vote)
 {
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetSmartnodeOutpoint() == vote.GetSmartnodeOutpoint() // same smartnode
-            && it->GetParentHash() == vote.GetParentHash() // same governance object (e.g. same proposal)
-            && it->GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
-            && it->GetTimestamp() < vote.GetTimestamp()) // older than new vote
+    auto itParent = std::find(vecParentHash.begin(), vecParentHash.end(), vote.GetParentHash());
+    const uint32_t nParentIndex = itParent - vecParentHash.begin();
+    for (size_t i = 0; i < vecHash.size(); i++) {
+        if (!vecDead[i]
+            && vecSmartnodeOutpoint[i] == vote.GetSmartnodeOutpoint() // same smartnode
+            && vecParentIndex[i] == nParentIndex // same governance object (e.g. same proposal)
+            && vecSignal[i] == vote.nVoteSignal // same signal (e.g. "funding", "delete", etc.)
+            && vecTime[i] < vote.GetTimestamp()) // older than new vote
         {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
+            MarkDead(i);
         }
     }
 }
 
-void CGovernanceObjectVoteFile::RebuildIndex()
+size_t CGovernanceObjectVoteFile::FindSlot(const uint256& nHash) const
 {
-    mapVoteIndex.clear();
-    nMemoryVotes = 0;
-    auto it = listVotes.begin();
-    while (it != listVotes.end()) {
-        CGovernanceVote& vote = *it;
-        uint256 nHash = vote.GetHash();
-        if (mapVoteIndex.find(nHash) == mapVoteIndex.end()) {
-            mapVoteIndex[nHash] = it;
-            ++nMemoryVotes;
-            ++it;
-        } else {
-            listVotes.erase(it++);
+    // Returns the slot holding nHash, or the empty slot where it would be inserted
+    const size_t nMask = vecIndex.size() - 1;
+    size_t nSlot = StaticSaltedHasher()(nHash) & nMask;
+    while (true) {
+        uint32_t nEntry = vecIndex[nSlot];
+        if (nEntry == SLOT_EMPTY) {
+            return nSlot;
+        }
+        if (nEntry != SLOT_DELETED && vecHash[nEntry - 1] == nHash) {
+            return nSlot;
+        }
+        nSlot = (nSlot + 1) & nMask;
+    }
+}
+
+void CGovernanceObjectVoteFile::RebuildIndex(size_t nCapacity)
+{
+    size_t nSize = 16;
+    while (nSize < nCapacity) {
+        nSize *= 2;
+    }
+    vecIndex.assign(nSize, SLOT_EMPTY);
+    nIndexUsed = 0;
+    for (size_t i = 0; i < vecHash.size(); i++) {
+        if (!vecDead[i]) {
+            vecIndex[FindSlot(vecHash[i])] = i + 1;
+            ++nIndexUsed;
+        }
+    }
+}
+
+void CGovernanceObjectVoteFile::CompactIfNeeded()
+{
+    const size_t nDead = vecHash.size() - nMemoryVotes;
+    if (nDead < 64 || nDead < (size_t)nMemoryVotes) {
+        return;
+    }
+
+    // Move the live votes to the front of every column, keeping their order
+    size_t nTo = 0;
+    size_t nSigTo = 0;
+    for (size_t i = 0; i < vecHash.size(); i++) {
+        if (vecDead[i]) {
+            continue;
         }
+        if (nTo != i) {
+            vecHash[nTo] = vecHash[i];
+            vecSmartnodeOutpoint[nTo] = vecSmartnodeOutpoint[i];
+            vecParentIndex[nTo] = vecParentIndex[i];
+            vecSignal[nTo] = vecSignal[i];
+            vecOutcome[nTo] = vecOutcome[i];
+            vecTime[nTo] = vecTime[i];
+            vecSigSize[nTo] = vecSigSize[i];
+            vecDead[nTo] = false;
+        }
+        std::copy(vchSigData.begin() + vecSigOffset[i], vchSigData.begin() + vecSigOffset[i] + vecSigSize[i], vchSigData.begin() + nSigTo);
+        vecSigOffset[nTo] = nSigTo;
+        nSigTo += vecSigSize[nTo];
+        ++nTo;
     }
+
+    vecHash.resize(nTo);
+    vecSmartnodeOutpoint.resize(nTo);
+    vecParentIndex.resize(nTo);
+    vecSignal.resize(nTo);
+    vecOutcome.resize(nTo);
+    vecTime.resize(nTo);
+    vecSigOffset.resize(nTo);
+    vecSigSize.resize(nTo);
+    vecDead.resize(nTo);
+    vchSigData.resize(nSigTo);
+
+    RebuildIndex(nTo * 2);
 }
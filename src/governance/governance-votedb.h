@@ -6,8 +6,8 @@
 #ifndef BITCOIN_GOVERNANCE_GOVERNANCE_VOTEDB_H
 #define BITCOIN_GOVERNANCE_GOVERNANCE_VOTEDB_H
 
-#include <list>
-#include <map>
+#include <set>
+#include <vector>
 
 #include <governance/governance-vote.h>
 #include <serialize.h>
@@ -19,27 +19,48 @@
  * Recently received votes are held in memory until a maximum size is reached after
  * which older votes a flushed to a disk file.
  *
+ * Votes are stored column wise in contiguous vectors (all signatures share one byte
+ * buffer) and looked up through a flat open addressing hash table on the vote hash,
+ * instead of one heap allocated CGovernanceVote plus map node per vote. Removed
+ * votes are only marked dead and compacted away in place once they make up half of
+ * the store. The serialized format is the same as the old list of votes.
+ *
  * Note: This is a stub implementation that doesn't limit the number of votes held
  * in memory and doesn't flush to disk.
  */
 class CGovernanceObjectVoteFile
 {
-public: // Types
-    typedef std::list<CGovernanceVote> vote_l_t;
-
-    typedef std::map<uint256, vote_l_t::iterator> vote_m_t;
-
 private:
+    static const uint32_t SLOT_EMPTY = 0;
+    static const uint32_t SLOT_DELETED = 0xffffffff;
+
     int nMemoryVotes;
 
-    vote_l_t listVotes;
+    // Columns, one entry per stored vote (live or dead), in the order the votes were added
+    std::vector<uint256> vecHash;
+    std::vector<COutPoint> vecSmartnodeOutpoint;
+    std::vector<uint32_t> vecParentIndex;
+    std::vector<int32_t> vecSignal;
+    std::vector<int32_t> vecOutcome;
+    std::vector<int64_t> vecTime;
+    std::vector<uint32_t> vecSigOffset;
+    std::vector<uint16_t> vecSigSize;
+    std::vector<bool> vecDead;
+
+    // Signatures of all votes, back to back
+    std::vector<unsigned char> vchSigData;
+
+    // Distinct parent hashes, normally just the one of the owning object
+    std::vector<uint256> vecParentHash;
 
-    vote_m_t mapVoteIndex;
+    // Open addressing hash table with linear probing, holds vote position + 1 (SLOT_EMPTY if unused)
+    std::vector<uint32_t> vecIndex;
+    size_t nIndexUsed;
 
 public:
     CGovernanceObjectVoteFile();
 
-    CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other);
+    CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other) = default;
 
     /**
      * Add a vote to the file
@@ -61,28 +82,69 @@ public:
         return nMemoryVotes;
     }
 
+    /**
+     * Votes, most recently added first
+     */
     std::vector<CGovernanceVote> GetVotes() const;
 
     void RemoveVotesFromSmartnode(const COutPoint& outpointSmartnode);
     std::set<uint256> RemoveInvalidVotes(const COutPoint& outpointSmartnode, bool fProposal);
 
-    ADD_SERIALIZE_METHODS;
+    /**
+     * Exact heap memory used by the stored votes and the index
+     */
+    size_t GetMemoryUsage() const;
 
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action)
+    template <typename Stream>
+    void Serialize(Stream& s) const
     {
-        READWRITE(nMemoryVotes);
-        READWRITE(listVotes);
-        if (ser_action.ForRead()) {
-            RebuildIndex();
+        s << nMemoryVotes;
+        WriteCompactSize(s, nMemoryVotes);
+        for (size_t i = vecHash.size(); i-- > 0; ) {
+            if (!vecDead[i]) {
+                s << GetVote(i);
+            }
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        Clear();
+        s >> nMemoryVotes;
+        uint64_t nCount = ReadCompactSize(s);
+        // Stored newest first, add them back oldest first
+        std::vector<CGovernanceVote> vecVotes;
+        vecVotes.reserve(std::min<uint64_t>(nCount, 1024 * 1024));
+        for (uint64_t i = 0; i < nCount; i++) {
+            vecVotes.emplace_back();
+            s >> vecVotes.back();
+        }
+        nMemoryVotes = 0;
+        for (auto it = vecVotes.rbegin(); it != vecVotes.rend(); ++it) {
+            if (!HasVote(it->GetHash())) {
+                Append(*it);
+            }
         }
     }
 
 private:
+    void Clear();
+
+    CGovernanceVote GetVote(size_t nPos) const;
+
+    void Append(const CGovernanceVote& vote);
+
+    void MarkDead(size_t nPos);
+
     // Drop older votes for the same gobject from the same smartnode
     void RemoveOldVotes(const CGovernanceVote& vote);
 
-    void RebuildIndex();
+    size_t FindSlot(const uint256& nHash) const;
+
+    void RebuildIndex(size_t nCapacity);
+
+    void CompactIfNeeded();
 };
 
 #endif // BITCOIN_GOVERNANCE_GOVERNANCE_VOTEDB_H
@@ -7,6 +7,7 @@
 #include <consensus/validation.h>
 #include <governance/governance-classes.h>
 #include <governance/governance-validators.h>
+#include <bls/bls_batchverifier.h>
 #include <init.h>
 #include <smartnode/smartnode-meta.h>
 #include <smartnode/smartnode-sync.h>
@@ -28,6 +29,7 @@ const int CGovernanceManager::RELIABLE_PROPAGATION_TIME = 60;
 CGovernanceManager::CGovernanceManager() :
     nTimeLastDiff(0),
     nCachedBlockHeight(0),
+    nStateVersion(0),
     mapObjects(),
     mapErasedGovernanceObjects(),
     cmapVoteToObject(MAX_CACHE_SIZE),
@@ -36,8 +38,11 @@ CGovernanceManager::CGovernanceManager() :
     mapLastSmartnodeObject(),
     setRequestedObjects(),
     fRateChecksEnabled(true),
+    fVoteWorkerRunning(false),
+    pconnmanVotes(nullptr),
     cs()
 {
+    voteWorkInterrupt.reset();
 }
 
 // Accessors for thread-safe access to maps
@@ -238,22 +243,238 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
             return;
         }
 
-        CGovernanceException exception;
-        if (ProcessVote(pfrom, vote, exception, connman)) {
-            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- %s new\n", strHash);
-            smartnodeSync.BumpAssetLastTime("MNGOVERNANCEOBJECTVOTE");
-            vote.Relay(connman);
+        {
+            LOCK(cs_pendingVotes);
+            if (fVoteWorkerRunning) {
+                // Verified in batches by the vote worker thread
+                if (!setPendingVotes.insert(nHash).second) {
+                    voteQueueStats.nDuplicates++;
+                } else if (dequePendingVotes.size() >= MAX_PENDING_VOTES) {
+                    // it will be requested again by the next vote sync
+                    setPendingVotes.erase(nHash);
+                    voteQueueStats.nDropped++;
+                } else {
+                    dequePendingVotes.emplace_back(pfrom->AddRef(), vote);
+                    voteQueueStats.nQueued++;
+                }
+                return;
+            }
+        }
+
+        ProcessVoteMessage(pfrom, vote, connman, uint256());
+    }
+}
+
+bool CGovernanceManager::ProcessVoteMessage(CNode* pfrom, const CGovernanceVote& vote, CConnman& connman, const uint256& hashVerifiedKey)
+{
+    CGovernanceException exception;
+    if (ProcessVote(pfrom, vote, exception, connman, hashVerifiedKey)) {
+        LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- %s new\n", vote.GetHash().ToString());
+        smartnodeSync.BumpAssetLastTime("MNGOVERNANCEOBJECTVOTE");
+        vote.Relay(connman);
+        return true;
+    }
+
+    LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- Rejected vote, error = %s\n", exception.what());
+    if ((exception.GetNodePenalty() != 0) && smartnodeSync.IsSynced()) {
+        LOCK(cs_main);
+        Misbehaving(pfrom->GetId(), exception.GetNodePenalty());
+    }
+    return false;
+}
+
+std::vector<uint256> VerifyVoteSignatures(const std::vector<CGovernanceVoteToVerify>& vecVotes, const CDeterministicMNList& mnList, ctpl::thread_pool& pool)
+{
+    std::vector<uint256> vecVerifiedKeys(vecVotes.size());
+    std::vector<std::pair<size_t, CKeyID>> vecECDSA;
+    std::vector<std::pair<size_t, uint256>> vecBLS;
+    // Secure aggregation, the vote hash doesn't cover the signature so we must not accept
+    // signatures which only verify when aggregated with others
+    CBLSBatchVerifier<NodeId, uint256> batchVerifier(true, true);
+    for (size_t i = 0; i < vecVotes.size(); i++) {
+        const CGovernanceVote& vote = *vecVotes[i].pvote;
+        auto dmn = mnList.GetMNByCollateral(vote.GetSmartnodeOutpoint());
+        if (!dmn) {
+            continue;
+        }
+        if (vecVotes[i].useVotingKey) {
+            vecECDSA.emplace_back(i, dmn->pdmnState->keyIDVoting);
         } else {
-            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- Rejected vote, error = %s\n", exception.what());
-            if ((exception.GetNodePenalty() != 0) && smartnodeSync.IsSynced()) {
-                LOCK(cs_main);
-                Misbehaving(pfrom->GetId(), exception.GetNodePenalty());
+            CBLSSignature sig(vote.GetSignature());
+            const CBLSPublicKey& pubKey = dmn->pdmnState->pubKeyOperator.Get();
+            if (sig.IsValid() && pubKey.IsValid()) {
+                batchVerifier.PushMessage(vecVotes[i].nodeId, vote.GetHash(), vote.GetSignatureHash(), sig, pubKey);
+                vecBLS.emplace_back(i, CGovernanceVote::GetVerifiedKeyHash(pubKey));
+            }
+        }
+    }
+
+    // ECDSA signatures are checked on the pool while this thread verifies the BLS batch
+    std::vector<std::future<void>> vecFutures;
+    const size_t nThreads = std::max(1, pool.size());
+    const size_t nChunkSize = std::max<size_t>(1, (vecECDSA.size() + nThreads - 1) / nThreads);
+    for (size_t nStart = 0; nStart < vecECDSA.size(); nStart += nChunkSize) {
+        const size_t nEnd = std::min(vecECDSA.size(), nStart + nChunkSize);
+        vecFutures.emplace_back(pool.push([&vecVotes, &vecECDSA, &vecVerifiedKeys, nStart, nEnd](int threadId) {
+            for (size_t j = nStart; j < nEnd; j++) {
+                const size_t i = vecECDSA[j].first;
+                if (vecVotes[i].pvote->CheckSignature(vecECDSA[j].second)) {
+                    vecVerifiedKeys[i] = CGovernanceVote::GetVerifiedKeyHash(vecECDSA[j].second);
+                }
             }
+        }));
+    }
+
+    batchVerifier.Verify();
+    for (const auto& p : vecBLS) {
+        if (batchVerifier.badMessages.count(vecVotes[p.first].pvote->GetHash()) == 0) {
+            vecVerifiedKeys[p.first] = p.second;
+        }
+    }
+
+    for (auto& f : vecFutures) {
+        f.get();
+    }
+    return vecVerifiedKeys;
+}
+
+void CGovernanceManager::StartVoteWorkerThread(CConnman& connman)
+{
+    // can't start new thread if we have one running already
+    if (voteWorkThread.joinable()) {
+        assert(false);
+    }
+
+    pconnmanVotes = &connman;
+    voteVerifyPool.resize(std::max(1, std::min(4, GetNumCores() / 2)));
+    RenameThreadPool(voteVerifyPool, "raptoreum-govvote");
+    voteWorkThread = std::thread(&TraceThread<std::function<void()> >, "govvote", std::function<void()>(std::bind(&CGovernanceManager::VoteWorkThreadMain, this)));
+
+    LOCK(cs_pendingVotes);
+    fVoteWorkerRunning = true;
+}
+
+void CGovernanceManager::InterruptVoteWorkerThread()
+{
+    voteWorkInterrupt();
+}
+
+void CGovernanceManager::StopVoteWorkerThread()
+{
+    if (!voteWorkThread.joinable()) {
+        return;
+    }
+
+    // make sure to call InterruptVoteWorkerThread() first
+    if (!voteWorkInterrupt) {
+        assert(false);
+    }
+
+    {
+        LOCK(cs_pendingVotes);
+        fVoteWorkerRunning = false;
+    }
+    voteWorkThread.join();
+    voteVerifyPool.clear_queue();
+    voteVerifyPool.stop(true);
+
+    // drop what is left, the peers are going away too
+    LOCK(cs_pendingVotes);
+    for (auto& p : dequePendingVotes) {
+        p.first->Release();
+    }
+    dequePendingVotes.clear();
+    setPendingVotes.clear();
+}
+
+CGovernanceVoteQueueStats CGovernanceManager::GetVoteQueueStats()
+{
+    LOCK(cs_pendingVotes);
+    CGovernanceVoteQueueStats stats = voteQueueStats;
+    stats.nPending = dequePendingVotes.size();
+    return stats;
+}
+
+void CGovernanceManager::VoteWorkThreadMain()
+{
+    while (!voteWorkInterrupt) {
+        bool fMoreWork = ProcessPendingVotes();
+
+        if (!fMoreWork && !voteWorkInterrupt.sleep_for(std::chrono::milliseconds(100))) {
             return;
         }
     }
 }
 
+bool CGovernanceManager::ProcessPendingVotes()
+{
+    std::vector<std::pair<CNode*, CGovernanceVote>> vecVotes;
+    bool fMoreWork;
+    {
+        LOCK(cs_pendingVotes);
+        while (!dequePendingVotes.empty() && vecVotes.size() < MAX_VOTE_BATCH_SIZE) {
+            vecVotes.emplace_back(std::move(dequePendingVotes.front()));
+            dequePendingVotes.pop_front();
+        }
+        fMoreWork = !dequePendingVotes.empty();
+    }
+    if (vecVotes.empty()) {
+        return false;
+    }
+
+    // Find out which key each vote has to be signed with, the same way CGovernanceObject::ProcessVote does.
+    // Votes for unknown objects are left to ProcessVote, which deals with them as usual.
+    std::vector<CGovernanceVoteToVerify> vecToVerify;
+    std::vector<size_t> vecToVerifyIndex;
+    {
+        LOCK(cs);
+        for (size_t i = 0; i < vecVotes.size(); i++) {
+            const CGovernanceVote& vote = vecVotes[i].second;
+            auto it = mapObjects.find(vote.GetParentHash());
+            if (it == mapObjects.end()) {
+                continue;
+            }
+            bool useVotingKey = it->second.GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
+            vecToVerify.push_back({vecVotes[i].first->GetId(), &vote, useVotingKey});
+            vecToVerifyIndex.push_back(i);
+        }
+    }
+    std::vector<uint256> vecVerifiedKeys(vecVotes.size());
+    std::vector<uint256> vecResults = VerifyVoteSignatures(vecToVerify, deterministicMNManager->GetListAtChainTip(), voteVerifyPool);
+    for (size_t j = 0; j < vecResults.size(); j++) {
+        vecVerifiedKeys[vecToVerifyIndex[j]] = vecResults[j];
+    }
+
+    uint64_t nBatchVerified = 0, nAccepted = 0, nRejected = 0;
+    for (size_t i = 0; i < vecVotes.size(); i++) {
+        CNode* pnode = vecVotes[i].first;
+        const CGovernanceVote& vote = vecVotes[i].second;
+        // Failed or skipped verifications go through the full check again, so the peer is
+        // treated exactly as if the vote was checked on arrival. So do votes whose key was
+        // changed by a ProTx connected since the batch was verified.
+        if (!vecVerifiedKeys[i].IsNull()) {
+            nBatchVerified++;
+        }
+        if (ProcessVoteMessage(pnode, vote, *pconnmanVotes, vecVerifiedKeys[i])) {
+            nAccepted++;
+        } else {
+            nRejected++;
+        }
+        pnode->Release();
+    }
+
+    LOCK(cs_pendingVotes);
+    for (const auto& p : vecVotes) {
+        setPendingVotes.erase(p.second.GetHash());
+    }
+    voteQueueStats.nBatches++;
+    voteQueueStats.nBatchVerified += nBatchVerified;
+    voteQueueStats.nAccepted += nAccepted;
+    voteQueueStats.nRejected += nRejected;
+
+    return fMoreWork;
+}
+
 void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CGovernanceException& exception, CConnman& connman)
 {
     uint256 nHash = govobj.GetHash();
@@ -309,6 +530,8 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
         return;
     }
 
+    BumpStateVersion();
+
     // SHOULD WE ADD THIS OBJECT TO ANY OTHER MANAGERS?
 
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::AddGovernanceObject -- Before trigger block, GetDataAsPlainString = %s, nObjectType = %d\n",
@@ -352,6 +575,8 @@ void CGovernanceManager::UpdateCachesAndClean()
 
     LOCK2(cs_main, cs);
 
+    BumpStateVersion();
+
     for (const uint256& nHash : vecDirtyHashes) {
         auto it = mapObjects.find(nHash);
         if (it == mapObjects.end()) {
@@ -791,7 +1016,7 @@ bool CGovernanceManager::SmartnodeRateCheck(const CGovernanceObject& govobj, boo
     return false;
 }
 
-bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman)
+bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman, const uint256& hashVerifiedKey)
 {
     ENTER_CRITICAL_SECTION(cs);
     uint256 nHashVote = vote.GetHash();
@@ -840,7 +1065,11 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
         return false;
     }
 
-    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman) && cmapVoteToObject.Insert(nHashVote, &govobj);
+    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman, hashVerifiedKey) && cmapVoteToObject.Insert(nHashVote, &govobj);
+    if (fOk && govobj.GetObjectType() == GOVERNANCE_OBJECT_TRIGGER) {
+        // only trigger votes change which superblock wins
+        BumpStateVersion();
+    }
     LEAVE_CRITICAL_SECTION(cs);
     return fOk;
 }
@@ -1116,6 +1345,7 @@ void CGovernanceManager::InitOnLoad()
     LogPrintf("Preparing smartnode indexes and governance triggers...\n");
     RebuildIndexes();
     AddCachedTriggers();
+    BumpStateVersion();
     LogPrintf("Smartnode indexes and governance triggers prepared  %dms\n", GetTimeMillis() - nStart);
     LogPrintf("     %s\n", ToString());
 }
@@ -1127,8 +1357,10 @@ std::string CGovernanceManager::ToString() const
     int nProposalCount = 0;
     int nTriggerCount = 0;
     int nOtherCount = 0;
+    size_t nVotesMemory = 0;
 
     for (const auto& objPair : mapObjects) {
+        nVotesMemory += objPair.second.GetVoteFile().GetMemoryUsage();
         switch (objPair.second.GetObjectType()) {
         case GOVERNANCE_OBJECT_PROPOSAL:
             nProposalCount++;
@@ -1142,10 +1374,10 @@ std::string CGovernanceManager::ToString() const
         }
     }
 
-    return strprintf("Governance Objects: %d (Proposals: %d, Triggers: %d, Other: %d; Erased: %d), Votes: %d",
+    return strprintf("Governance Objects: %d (Proposals: %d, Triggers: %d, Other: %d; Erased: %d), Votes: %d (%d bytes)",
         (int)mapObjects.size(),
         nProposalCount, nTriggerCount, nOtherCount, (int)mapErasedGovernanceObjects.size(),
-        (int)cmapVoteToObject.GetSize());
+        (int)cmapVoteToObject.GetSize(), nVotesMemory);
 }
 
 UniValue CGovernanceManager::ToJson() const
@@ -1155,8 +1387,10 @@ UniValue CGovernanceManager::ToJson() const
     int nProposalCount = 0;
     int nTriggerCount = 0;
     int nOtherCount = 0;
+    size_t nVotesMemory = 0;
 
     for (const auto& objpair : mapObjects) {
+        nVotesMemory += objpair.second.GetVoteFile().GetMemoryUsage();
         switch (objpair.second.GetObjectType()) {
         case GOVERNANCE_OBJECT_PROPOSAL:
             nProposalCount++;
@@ -1177,6 +1411,7 @@ UniValue CGovernanceManager::ToJson() const
     jsonObj.pushKV("other", nOtherCount);
     jsonObj.pushKV("erased", (int)mapErasedGovernanceObjects.size());
     jsonObj.pushKV("votes", (int)cmapVoteToObject.GetSize());
+    jsonObj.pushKV("votes_memory", (uint64_t)nVotesMemory);
     return jsonObj;
 }
 
@@ -1275,6 +1510,10 @@ void CGovernanceManager::RemoveInvalidVotes()
         changedKeyMNs.emplace_back(oldDmn->collateralOutpoint);
     }
 
+    if (!changedKeyMNs.empty()) {
+        BumpStateVersion();
+    }
+
     for (const auto& outpoint : changedKeyMNs) {
         for (auto& p : mapObjects) {
             auto removed = p.second.RemoveInvalidVotes(outpoint);
@@ -15,6 +15,7 @@
 #include <governance/governance-vote.h>
 #include <net.h>
 #include <sync.h>
+#include <threadinterrupt.h>
 #include <timedata.h>
 #include <util.h>
 
@@ -22,6 +23,11 @@
 
 #include <univalue.h>
 
+#include <ctpl.h>
+
+#include <deque>
+#include <thread>
+
 class CGovernanceManager;
 class CGovernanceTriggerManager;
 class CGovernanceObject;
@@ -135,6 +141,33 @@ public:
 //
 // Governance Manager : Contains all proposals for the budget
 //
+/** Counters of the asynchronous vote verification, reported by mnsync status */
+struct CGovernanceVoteQueueStats {
+    size_t nPending{0};
+    uint64_t nQueued{0};
+    uint64_t nDuplicates{0};
+    uint64_t nDropped{0};
+    uint64_t nBatches{0};
+    uint64_t nBatchVerified{0};
+    uint64_t nAccepted{0};
+    uint64_t nRejected{0};
+};
+
+/** A received vote waiting for its signature check */
+struct CGovernanceVoteToVerify {
+    NodeId nodeId;
+    const CGovernanceVote* pvote;
+    bool useVotingKey; //!< as for CGovernanceVote::IsValid
+};
+
+/**
+ * Verify the signatures of votes against mnList, BLS signatures in one batch and ECDSA
+ * signatures on pool. Returns the key each vote verified with (see
+ * CGovernanceVote::GetVerifiedKeyHash), or a null hash if it didn't verify or its smartnode
+ * is unknown.
+ */
+std::vector<uint256> VerifyVoteSignatures(const std::vector<CGovernanceVoteToVerify>& vecVotes, const CDeterministicMNList& mnList, ctpl::thread_pool& pool);
+
 class CGovernanceManager
 {
     friend class CGovernanceObject;
@@ -182,6 +215,9 @@ private:
     // keep track of current block height
     int nCachedBlockHeight;
 
+    // bumped whenever triggers, their votes or the smartnode list change, see CSuperblockManager
+    uint64_t nStateVersion;
+
     // keep track of the scanning errors
     std::map<uint256, CGovernanceObject> mapObjects;
 
@@ -210,6 +246,22 @@ private:
     // used to check for changed voting keys
     CDeterministicMNList lastMNListForVotingKeys;
 
+    static const size_t MAX_PENDING_VOTES = 200000;
+    static const size_t MAX_VOTE_BATCH_SIZE = 1000;
+
+    // Votes received from peers which still have to be verified, in arrival order. The nodes are
+    // referenced (AddRef) until the vote is processed.
+    CCriticalSection cs_pendingVotes;
+    std::deque<std::pair<CNode*, CGovernanceVote>> dequePendingVotes;
+    hash_s_t setPendingVotes;
+    CGovernanceVoteQueueStats voteQueueStats;
+    bool fVoteWorkerRunning;
+
+    std::thread voteWorkThread;
+    CThreadInterrupt voteWorkInterrupt;
+    ctpl::thread_pool voteVerifyPool;
+    CConnman* pconnmanVotes;
+
     class ScopedLockBool
     {
         bool& ref;
@@ -250,6 +302,13 @@ public:
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman, bool enable_bip61);
 
+    /// Start verifying incoming votes asynchronously, before that they are verified on the message handler thread
+    void StartVoteWorkerThread(CConnman& connman);
+    void InterruptVoteWorkerThread();
+    void StopVoteWorkerThread();
+
+    CGovernanceVoteQueueStats GetVoteQueueStats();
+
     void DoMaintenance(CConnman& connman);
 
     CGovernanceObject* FindGovernanceObject(const uint256& nHash);
@@ -275,6 +334,7 @@ public:
         cmapInvalidVotes.Clear();
         cmmapOrphanVotes.Clear();
         mapLastSmartnodeObject.clear();
+        BumpStateVersion();
     }
 
     std::string ToString() const;
@@ -312,6 +372,18 @@ public:
 
     int GetCachedBlockHeight() const { return nCachedBlockHeight; }
 
+    uint64_t GetStateVersion() const
+    {
+        AssertLockHeld(cs);
+        return nStateVersion;
+    }
+
+    void BumpStateVersion()
+    {
+        AssertLockHeld(cs);
+        ++nStateVersion;
+    }
+
     // Accessors for thread-safe access to maps
     bool HaveObjectForHash(const uint256& nHash) const;
 
@@ -365,7 +437,13 @@ private:
         cmapInvalidVotes.Insert(vote.GetHash(), vote);
     }
 
-    bool ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman);
+    bool ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman, const uint256& hashVerifiedKey = uint256());
+
+    /// Process a vote received from a peer, relay it when accepted and punish the peer otherwise
+    bool ProcessVoteMessage(CNode* pfrom, const CGovernanceVote& vote, CConnman& connman, const uint256& hashVerifiedKey);
+
+    void VoteWorkThreadMain();
+    bool ProcessPendingVotes();
 
     /// Called to indicate a requested object has been received
     bool AcceptObjectMessage(const uint256& nHash);
@@ -0,0 +1,207 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKSTATSINDEX_H
+#define BITCOIN_BLOCKSTATSINDEX_H
+
+#include <amount.h>
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <algorithm>
+#include <vector>
+
+//! Outpoint (needed for the utxo index) + nHeight + fCoinBase
+static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+
+/** Per block statistics, as reported by getblockstats, recorded while connecting the block */
+struct CBlockStatsIndexValue {
+    // Plain transaction statistics, excluding the coinbase unless noted
+    int64_t txs;                //!< including the coinbase
+    int64_t ins;
+    int64_t outs;               //!< including the coinbase
+    CAmount totalOut;
+    int64_t totalSize;
+    CAmount totalFee;
+    CAmount minFee;
+    CAmount maxFee;
+    CAmount medianFee;
+    CAmount minFeeRate;
+    CAmount maxFeeRate;
+    CAmount medianFeeRate;
+    int64_t minTxSize;
+    int64_t maxTxSize;
+    int64_t medianTxSize;
+    int64_t utxoSizeInc;
+
+    // Raptoreum specific
+    CAmount subsidy;
+    CAmount specialTxFee;
+    int32_t proTxs;
+    int32_t quorumCommitments;
+    int32_t futureTxs;
+    int32_t futureLocked;
+    CAmount futureLockedAmount;
+    int32_t futureMatured;
+    CAmount futureMaturedAmount;
+    CAmount smartnodePayment;
+    CAmount founderPayment;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(txs);
+        READWRITE(ins);
+        READWRITE(outs);
+        READWRITE(totalOut);
+        READWRITE(totalSize);
+        READWRITE(totalFee);
+        READWRITE(minFee);
+        READWRITE(maxFee);
+        READWRITE(medianFee);
+        READWRITE(minFeeRate);
+        READWRITE(maxFeeRate);
+        READWRITE(medianFeeRate);
+        READWRITE(minTxSize);
+        READWRITE(maxTxSize);
+        READWRITE(medianTxSize);
+        READWRITE(utxoSizeInc);
+        READWRITE(subsidy);
+        READWRITE(specialTxFee);
+        READWRITE(proTxs);
+        READWRITE(quorumCommitments);
+        READWRITE(futureTxs);
+        READWRITE(futureLocked);
+        READWRITE(futureLockedAmount);
+        READWRITE(futureMatured);
+        READWRITE(futureMaturedAmount);
+        READWRITE(smartnodePayment);
+        READWRITE(founderPayment);
+    }
+
+    CBlockStatsIndexValue()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        txs = ins = outs = 0;
+        totalOut = totalSize = totalFee = 0;
+        minFee = maxFee = medianFee = 0;
+        minFeeRate = maxFeeRate = medianFeeRate = 0;
+        minTxSize = maxTxSize = medianTxSize = 0;
+        utxoSizeInc = 0;
+        subsidy = specialTxFee = 0;
+        proTxs = quorumCommitments = futureTxs = 0;
+        futureLocked = futureMatured = 0;
+        futureLockedAmount = futureMaturedAmount = 0;
+        smartnodePayment = founderPayment = 0;
+    }
+};
+
+/** Accumulates the per transaction numbers of a block into a CBlockStatsIndexValue */
+class CBlockStatsIndexBuilder
+{
+private:
+    std::vector<CAmount> fees;
+    std::vector<CAmount> feeRates;
+    std::vector<int64_t> txSizes;
+
+    template <typename T>
+    static T TruncatedMedian(std::vector<T>& v)
+    {
+        if (v.empty()) return 0;
+        const size_t mid = v.size() / 2;
+        std::nth_element(v.begin(), v.begin() + mid, v.end());
+        if (v.size() % 2) return v[mid];
+        const T upper = v[mid];
+        return (*std::max_element(v.begin(), v.begin() + mid) + upper) / 2;
+    }
+
+public:
+    CBlockStatsIndexValue value;
+
+    /** Record a non-coinbase transaction with its fee (including the special tx fee) and size */
+    void AddTx(CAmount fee, int64_t size)
+    {
+        const CAmount feeRate = size ? fee / size : 0;
+        if (fees.empty()) {
+            value.minFee = value.maxFee = fee;
+            value.minFeeRate = value.maxFeeRate = feeRate;
+            value.minTxSize = value.maxTxSize = size;
+        } else {
+            value.minFee = std::min(value.minFee, fee);
+            value.maxFee = std::max(value.maxFee, fee);
+            value.minFeeRate = std::min(value.minFeeRate, feeRate);
+            value.maxFeeRate = std::max(value.maxFeeRate, feeRate);
+            value.minTxSize = std::min(value.minTxSize, size);
+            value.maxTxSize = std::max(value.maxTxSize, size);
+        }
+        value.totalFee += fee;
+        value.totalSize += size;
+        fees.push_back(fee);
+        feeRates.push_back(feeRate);
+        txSizes.push_back(size);
+    }
+
+    const CBlockStatsIndexValue& Finalize()
+    {
+        value.medianFee = TruncatedMedian(fees);
+        value.medianFeeRate = TruncatedMedian(feeRates);
+        value.medianTxSize = TruncatedMedian(txSizes);
+        return value;
+    }
+};
+
+/** Future transaction locks indexed by the height at which they mature */
+struct CFutureMaturityKey {
+    int32_t maturityHeight;
+    uint256 txid;
+    uint32_t outputIndex;
+
+    size_t GetSerializeSize(int nType, int nVersion) const
+    {
+        return 40;
+    }
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        // Big endian so all locks maturing at a height are adjacent in the database
+        ser_writedata32be(s, maturityHeight);
+        txid.Serialize(s);
+        ser_writedata32be(s, outputIndex);
+    }
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        maturityHeight = ser_readdata32be(s);
+        txid.Unserialize(s);
+        outputIndex = ser_readdata32be(s);
+    }
+
+    CFutureMaturityKey(int32_t height, const uint256& hash, uint32_t n) :
+        maturityHeight(height),
+        txid(hash),
+        outputIndex(n)
+    {
+    }
+
+    CFutureMaturityKey()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        maturityHeight = 0;
+        txid.SetNull();
+        outputIndex = 0;
+    }
+};
+
+#endif // BITCOIN_BLOCKSTATSINDEX_H
@@ -14,10 +14,12 @@
 #include <addrman.h>
 #include <amount.h>
 #include <base58.h>
+#include <bootstrap.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <node/coinstats.h>
+#include <node/utxo_snapshot.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
 #include <fs.h>
@@ -138,6 +140,35 @@ static CDSNotificationInterface* pdsNotificationInterface = nullptr;
 #endif
 
 static const char* FEE_ESTIMATES_FILENAME="fee_estimates.dat";
+/** How often the fee estimator state is written to disk while running */
+static const int64_t FEE_FLUSH_INTERVAL = 60 * 60;
+
+/**
+ * Write fee estimates to a temporary file and move it over the previous one,
+ * so a crash while writing leaves the last complete snapshot in place.
+ */
+static void FlushFeeEstimates()
+{
+    fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
+    fs::path est_path_new = GetDataDir() / (std::string(FEE_ESTIMATES_FILENAME) + ".new");
+    {
+        CAutoFile est_fileout(fsbridge::fopen(est_path_new, "wb"), SER_DISK, CLIENT_VERSION);
+        if (est_fileout.IsNull()) {
+            LogPrintf("%s: Failed to write fee estimates to %s\n", __func__, est_path_new.string());
+            return;
+        }
+        if (!::feeEstimator.Write(est_fileout)) {
+            return;
+        }
+        if (!FileCommit(est_fileout.Get())) {
+            LogPrintf("%s: Failed to commit fee estimates to %s\n", __func__, est_path_new.string());
+            return;
+        }
+    }
+    if (!RenameOver(est_path_new, est_path)) {
+        LogPrintf("%s: Failed to rename %s to %s\n", __func__, est_path_new.string(), est_path.string());
+    }
+}
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -219,6 +250,7 @@ void Interrupt()
     InterruptREST();
     InterruptTorControl();
     llmq::InterruptLLMQSystem();
+    governance.InterruptVoteWorkerThread();
     InterruptMapPort();
     if (g_connman)
         g_connman->Interrupt();
@@ -244,6 +276,7 @@ void PrepareShutdown()
     StopRPC();
     StopHTTPServer();
     llmq::StopLLMQSystem();
+    governance.StopVoteWorkerThread();
 
     // fRPCInWarmup should be `false` if we completed the loading sequence
     // before a shutdown request was received
@@ -299,12 +332,7 @@ void PrepareShutdown()
     if (fFeeEstimatesInitialized)
     {
         ::feeEstimator.FlushUnconfirmed();
-        fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
-        CAutoFile est_fileout(fsbridge::fopen(est_path, "wb"), SER_DISK, CLIENT_VERSION);
-        if (!est_fileout.IsNull())
-            ::feeEstimator.Write(est_fileout);
-        else
-            LogPrintf("%s: Failed to write fee estimates to %s\n", __func__, est_path.string());
+        FlushFeeEstimates();
         fFeeEstimatesInitialized = false;
     }
 
@@ -477,6 +505,9 @@ void SetupServerArgs()
     gArgs.AddArg("-dbcache=<n>", strprintf("Set database cache size in megabytes (%d to %d, default: %d)", nMinDbCache, nMaxDbCache, nDefaultDbCache), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-debuglogfile=<file>", strprintf("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (0 to disable; default: %s)", DEFAULT_DEBUGLOGFILE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-loadblock=<file>", "Imports blocks from external blk000??.dat file on startup", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-loadtxoutset=<file>", "Start a new datadir from a UTXO snapshot written by the dumptxoutset RPC. The blocks below the snapshot are not available, like on a pruned node, so it is incompatible with -txindex and the other transaction indexes and implies -disablegovernance. Ignored once the datadir has a block index", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-loadtxoutsethash=<hash>", "The snapshot hash the -loadtxoutset snapshot must have, as reported by dumptxoutset on a node you trust. Required with -loadtxoutset", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-loadbootstrap=<dir>", "Imports blocks from a bootstrap directory written by the exportchain RPC on startup", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxmempool=<n>", strprintf("Keep the transaction memory pool below <n> megabytes (default: %u)", DEFAULT_MAX_MEMPOOL_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxorphantxsize=<n>", strprintf("Maximum total size of all orphan transactions in megabytes (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxrecsigsage=<n>", strprintf("Number of seconds to keep LLMQ recovery sigs (default: %u)", llmq::DEFAULT_MAX_RECOVERED_SIGS_AGE), false, OptionsCategory::OPTIONS);
@@ -501,6 +532,8 @@ void SetupServerArgs()
     gArgs.AddArg("-powcachevalidate", "Enable validation of pow hashes from the cache (default: %true). Use of this option will significantly slow down wallet synchronization.", false, OptionsCategory::OPTIONS);
 
     gArgs.AddArg("-addressindex", strprintf("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)", DEFAULT_ADDRESSINDEX), false, OptionsCategory::INDEXING);
+    gArgs.AddArg("-coinstatsindex", strprintf("Maintain the UTXO set statistics and MuHash per block while connecting blocks, used by the gettxoutsetinfo rpc call to answer without scanning the UTXO set and for earlier blocks (default: %u)", DEFAULT_COINSTATSINDEX), false, OptionsCategory::INDEXING);
+    gArgs.AddArg("-blockstatsindex", strprintf("Maintain per block statistics, used by the getblockstats rpc call to answer height ranges without -txindex (default: %u)", DEFAULT_BLOCKSTATSINDEX), false, OptionsCategory::INDEXING);
     gArgs.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk", false, OptionsCategory::INDEXING);
     gArgs.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks", false, OptionsCategory::INDEXING);
     gArgs.AddArg("-spentindex", strprintf("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)", DEFAULT_SPENTINDEX), false, OptionsCategory::INDEXING);
@@ -811,6 +844,20 @@ void ThreadImport(std::vector<fs::path> vImportFiles)
         }
     }
 
+    // -loadbootstrap=
+    for (const std::string& strDir : gArgs.GetArgs("-loadbootstrap")) {
+        int nImported;
+        std::string strError;
+        LogPrintf("Importing bootstrap directory %s...\n", strDir);
+        if (!ImportBootstrap(chainparams, strDir, nImported, strError)) {
+            LogPrintf("Warning: Bootstrap import from %s stopped after %d blocks: %s\n", strDir, nImported, strError);
+        }
+        if (ShutdownRequested()) {
+            LogPrintf("Shutdown requested. Exit %s\n", __func__);
+            return;
+        }
+    }
+
     // scan for better chains in the block chain database, that are not yet connected in the active best chain
     CValidationState state;
     if (!ActivateBestChain(state, chainparams)) {
@@ -867,16 +914,19 @@ void PeriodicStats()
 {
     assert(gArgs.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE));
     CCoinsStats stats;
-    FlushStateToDisk();
-    if (GetUTXOStats(pcoinsdbview.get(), stats)) {
-        statsClient.gauge("utxoset.tx", stats.nTransactions, 1.0f);
+    bool fFullScan;
+    if (GetTipUTXOStats(pcoinsdbview.get(), stats, false, fFullScan)) {
+        // Only known after walking the whole set
+        if (fFullScan) {
+            statsClient.gauge("utxoset.tx", stats.nTransactions, 1.0f);
+        }
         statsClient.gauge("utxoset.txOutputs", stats.nTransactionOutputs, 1.0f);
         statsClient.gauge("utxoset.dbSizeBytes", stats.nDiskSize, 1.0f);
         statsClient.gauge("utxoset.blockHeight", stats.nHeight, 1.0f);
         statsClient.gauge("utxoset.totalAmount", (double)stats.nTotalAmount / (double)COIN, 1.0f);
     } else {
         // something went wrong
-        LogPrintf("%s: GetUTXOStats failed\n", __func__);
+        LogPrintf("%s: GetTipUTXOStats failed\n", __func__);
     }
 
     // short version of GetNetworkHashPS(120, -1);
@@ -1037,13 +1087,24 @@ void InitParameterInteraction()
         }
     }
 
+    // A snapshot has no transaction history, indexes over it would never be complete
+    if (gArgs.IsArgSet("-loadtxoutset")) {
+        if (gArgs.SoftSetBoolArg("-disablegovernance", true)) {
+            LogPrintf("%s: parameter interaction: -loadtxoutset set -> setting -disablegovernance=true\n", __func__);
+        }
+        if (gArgs.SoftSetBoolArg("-txindex", false)) {
+            LogPrintf("%s: parameter interaction: -loadtxoutset set -> setting -txindex=false\n", __func__);
+        }
+    }
+
     // Make sure additional indexes are recalculated correctly in VerifyDB
     // (we must reconnect blocks whenever we disconnect them for these indexes to work)
     bool fAdditionalIndexes =
         gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
         gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
         gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX) ||
-        gArgs.GetBoolArg("-futureindex", DEFAULT_FUTUREINDEX);
+        gArgs.GetBoolArg("-futureindex", DEFAULT_FUTUREINDEX) ||
+        gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX);
 
     if (fAdditionalIndexes && gArgs.GetArg("-checklevel", DEFAULT_CHECKLEVEL) < 4) {
         gArgs.ForceSetArg("-checklevel", "4");
@@ -1177,6 +1238,21 @@ bool AppInitParameterInteraction()
         }
     }
 
+    // The history below a UTXO snapshot is never downloaded, so the transaction based indexes can't be built
+    if (gArgs.IsArgSet("-loadtxoutset")) {
+        if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ||
+            gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
+            gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
+            gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX) ||
+            gArgs.GetBoolArg("-futureindex", DEFAULT_FUTUREINDEX) ||
+            gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)) {
+            return InitError(_("-loadtxoutset is incompatible with -txindex, -addressindex, -spentindex, -timestampindex, -futureindex and -blockstatsindex."));
+        }
+        if (!gArgs.GetBoolArg("-disablegovernance", false)) {
+            return InitError(_("-loadtxoutset is incompatible with -disablegovernance=false."));
+        }
+    }
+
     if (gArgs.IsArgSet("-devnet")) {
         // Require setting of ports when running devnet
         if (gArgs.GetArg("-listen", DEFAULT_LISTEN) && !gArgs.IsArgSet("-port")) {
@@ -1663,8 +1739,10 @@ bool AppInitMain()
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i=0; i<nScriptCheckThreads-1; i++)
+        for (int i=0; i<nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadBlockCheck);
+        }
     }
 
     std::vector<std::string> vSporkAddresses;
@@ -1738,7 +1816,7 @@ bool AppInitMain()
     CConnman& connman = *g_connman;
 
     peerLogic.reset(new PeerLogicValidation(&connman, scheduler, gArgs.GetBoolArg("-enablebip61", DEFAULT_ENABLE_BIP61)));
-    RegisterValidationInterface(peerLogic.get());
+    RegisterValidationInterface(peerLogic.get(), "peerlogic");
 
     // sanitize comments per BIP-0014, format user agent and check total size
     std::vector<std::string> uacomments;
@@ -1836,12 +1914,12 @@ bool AppInitMain()
     g_zmq_notification_interface = CZMQNotificationInterface::Create();
 
     if (g_zmq_notification_interface) {
-        RegisterValidationInterface(g_zmq_notification_interface);
+        RegisterValidationInterface(g_zmq_notification_interface, "zmq", false);
     }
 #endif
 
     pdsNotificationInterface = new CDSNotificationInterface(connman);
-    RegisterValidationInterface(pdsNotificationInterface);
+    RegisterValidationInterface(pdsNotificationInterface, "dsnotification");
 
     uint64_t nMaxOutboundLimit = 0; //unlimited unless -maxuploadtarget is set
     uint64_t nMaxOutboundTimeframe = MAX_UPLOAD_TIMEFRAME;
@@ -1931,6 +2009,25 @@ bool AppInitMain()
                     break;
                 }
 
+                // -loadtxoutset seeds a new datadir, after which the block index is loaded again
+                if (!fReindex && mapBlockIndex.empty() && gArgs.IsArgSet("-loadtxoutset")) {
+                    uiInterface.InitMessage(_("Loading UTXO snapshot..."));
+                    const std::string strHash = gArgs.GetArg("-loadtxoutsethash", "");
+                    if (!IsHex(strHash) || strHash.size() != 64) {
+                        return InitError(_("-loadtxoutset requires -loadtxoutsethash, the snapshot hash reported by dumptxoutset on a node you trust"));
+                    }
+                    std::string strError;
+                    if (!LoadUTXOSnapshot(chainparams, gArgs.GetArg("-loadtxoutset", ""), uint256S(strHash), nCoinDBCache, strError)) {
+                        strLoadError = strprintf(_("Unable to load the UTXO snapshot: %s"), strError);
+                        break;
+                    }
+                    UnloadBlockIndex();
+                    if (!LoadBlockIndex(chainparams)) {
+                        strLoadError = _("Error loading block database");
+                        break;
+                    }
+                }
+
                 if (!fDisableGovernance && !fTxIndex
                    && chainparams.NetworkIDString() != CBaseChainParams::REGTEST) { // TODO remove this when pruning is fixed. See https://github.com/dashpay/dash/pull/1817 and https://github.com/dashpay/dash/pull/1743
                     return InitError(_("Transaction index can't be disabled with governance validation enabled. Either start with -disablegovernance command line switch or enable transaction index."));
@@ -1945,6 +2042,12 @@ bool AppInitMain()
                 if (!chainparams.GetConsensus().hashDevnetGenesisBlock.IsNull() && !mapBlockIndex.empty() && mapBlockIndex.count(chainparams.GetConsensus().hashDevnetGenesisBlock) == 0)
                     return InitError(_("Incorrect or no devnet genesis block found. Wrong datadir for devnet specified?"));
 
+                // The indexes stay disabled for good on a chainstate loaded from a UTXO snapshot
+                if (fSnapshotChainstate && !fTxIndex && gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
+                    strLoadError = _("The chainstate was loaded from a UTXO snapshot, which doesn't support -txindex. Start with -txindex=0");
+                    break;
+                }
+
                 // Check for changed -txindex state
                 if (fTxIndex != gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
                     strLoadError = _("You need to rebuild the database using -reindex to change -txindex");
@@ -1975,9 +2078,15 @@ bool AppInitMain()
                     break;
                 }
 
+                // Check for changed -blockstatsindex state
+                if (fBlockStatsIndex != gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -blockstatsindex");
+                    break;
+                }
+
                 // Check for changed -prune state.  What we are concerned about is a user who has pruned blocks
                 // in the past, but is now trying to run unpruned.
-                if (fHavePruned && !fPruneMode) {
+                if (fHavePruned && !fPruneMode && !fSnapshotChainstate) {
                     strLoadError = _("You need to rebuild the database using -reindex to go back to unpruned mode.  This will redownload the entire blockchain");
                     break;
                 }
@@ -2012,6 +2121,11 @@ bool AppInitMain()
 
                 // The on-disk coinsdb is now in a good state, create the cache
                 pcoinsTip.reset(new CCoinsViewCache(pcoinscatcher.get()));
+                fCoinStatsIndex = gArgs.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX);
+                if (fCoinStatsIndex) {
+                    g_coins_stats_tracker.Load(*pcoinsdbview);
+                    pcoinsdbview->SetCoinsStatsTracker(&g_coins_stats_tracker);
+                }
 
                 // flush evodb
                 if (!evoDb->CommitRootTransaction()) {
@@ -2154,6 +2268,11 @@ bool AppInitMain()
         }
     }
 
+    if (fSnapshotChainstate) {
+        LogPrintf("Unsetting NODE_NETWORK, the blocks below the UTXO snapshot are not available\n");
+        nLocalServices = ServiceFlags(nLocalServices & ~NODE_NETWORK);
+    }
+
     // As PruneAndFlush can take several minutes, it's possible the user
     // requested to kill the GUI during the last operation. If so, exit.
     if (fRequestShutdown)
@@ -2184,7 +2303,7 @@ bool AppInitMain()
     if(fSmartnodeMode) {
         // Create and register activeSmartnodeManager, will init later in ThreadImport
         activeSmartnodeManager = new CActiveSmartnodeManager();
-        RegisterValidationInterface(activeSmartnodeManager);
+        RegisterValidationInterface(activeSmartnodeManager, "activesmartnode");
     }
 
     {
@@ -2268,12 +2387,16 @@ bool AppInitMain()
 
     if (!fDisableGovernance) {
         scheduler.scheduleEvery(std::bind(&CGovernanceManager::DoMaintenance, std::ref(governance), std::ref(*g_connman)), 60 * 5 * 1000);
+        governance.StartVoteWorkerThread(*g_connman);
     }
 
     if (fSmartnodeMode) {
         scheduler.scheduleEvery(std::bind(&CCoinJoinServer::DoMaintenance, std::ref(coinJoinServer), std::ref(*g_connman)), 1 * 1000);
     }
 
+    // Periodic flush of fee estimates, so a crash doesn't discard the collected history
+    scheduler.scheduleEvery(FlushFeeEstimates, FEE_FLUSH_INTERVAL * 1000);
+
     // Periodic flush of POW Cache if cache has grown enough
     scheduler.scheduleEvery(std::bind(&CPowCache::DoMaintenance, &CPowCache::Instance()), 60 * 1000);
 
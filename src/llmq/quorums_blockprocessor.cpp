@@ -297,7 +297,7 @@ bool CQuorumBlockProcessor::UpgradeDB()
     if (chainActive.Height() >= 1) {
            auto pindex = chainActive[1];
         while (pindex) {
-            if (fPruneMode && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            if ((fPruneMode || fSnapshotChainstate) && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
                 // Too late, we already pruned blocks we needed to reprocess commitments
                 return false;
             }
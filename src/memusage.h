@@ -117,6 +117,12 @@ static inline size_t IncrementalDynamicUsage(const std::map<X, Y, Z>& m)
     return MallocUsage(sizeof(stl_tree_node<std::pair<const X, Y> >));
 }
 
+template<typename X, typename Y, typename Z>
+static inline size_t DynamicUsage(const std::multimap<X, Y, Z>& m)
+{
+    return MallocUsage(sizeof(stl_tree_node<std::pair<const X, Y> >)) * m.size();
+}
+
 // indirectmap has underlying map with pointer as key
 
 template<typename X, typename Y>
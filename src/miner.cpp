@@ -41,6 +41,8 @@
 
 #include <boost/thread.hpp>
 #include <algorithm>
+#include <limits>
+#include <map>
 #include <memory>
 #include <queue>
 #include <utility>
@@ -255,15 +257,23 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     return std::move(pblocktemplate);
 }
 
-void BlockAssembler::onlyUnconfirmed(CTxMemPool::setEntries& testSet)
+void BlockAssembler::CalculateUnconfirmedAncestors(CTxMemPool::txiter iter, CTxMemPool::setEntries& ancestors)
 {
-    for (CTxMemPool::setEntries::iterator iit = testSet.begin(); iit != testSet.end(); ) {
-        // Only test txs not already in the block
-        if (inBlock.count(*iit)) {
-            testSet.erase(iit++);
-        }
-        else {
-            iit++;
+    // Every ancestor of an inBlock entry is inBlock as well, so the walk can
+    // stop at the first confirmed parent instead of visiting the whole
+    // in-mempool ancestry and filtering it afterwards. With deep chains this
+    // keeps the cost per package proportional to the not-yet-included part.
+    ancestors.clear();
+    vAncestorWalk.clear();
+    vAncestorWalk.push_back(iter);
+    while (!vAncestorWalk.empty()) {
+        CTxMemPool::txiter it = vAncestorWalk.back();
+        vAncestorWalk.pop_back();
+        for (CTxMemPool::txiter parent : mempool.GetMemPoolParents(it)) {
+            if (inBlock.count(parent) || !ancestors.insert(parent).second) {
+                continue;
+            }
+            vAncestorWalk.push_back(parent);
         }
     }
 }
@@ -316,25 +326,111 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
 int BlockAssembler::UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded,
         indexed_modified_transaction_set &mapModifiedTx)
 {
-    int nDescendantsUpdated = 0;
+    // Each descendant has to drop the added transactions among its ancestors
+    // from its package. Walking the descendants of every added transaction on
+    // its own visits a descendant once per added ancestor, which is quadratic
+    // along a chain. Instead walk their union once in topological order and
+    // track which added transactions every entry descends from as a bitset.
+    // An entry with the same bitset as one of its parents shares the parent's
+    // totals, so along a chain they are only summed up once.
+    CTxMemPool::setEntries setDescendants;
     for (CTxMemPool::txiter it : alreadyAdded) {
-        CTxMemPool::setEntries descendants;
-        mempool.CalculateDescendants(it, descendants);
-        // Insert all descendants (not yet in block) into the modified set
-        for (CTxMemPool::txiter desc : descendants) {
-            if (alreadyAdded.count(desc))
-                continue;
-            ++nDescendantsUpdated;
-            modtxiter mit = mapModifiedTx.find(desc);
-            if (mit == mapModifiedTx.end()) {
-                CTxMemPoolModifiedEntry modEntry(desc);
-                modEntry.nSizeWithAncestors -= it->GetTxSize();
-                modEntry.nModFeesWithAncestors -= it->GetModifiedFee();
-                modEntry.nSigOpCountWithAncestors -= it->GetSigOpCount();
-                mapModifiedTx.insert(modEntry);
+        mempool.CalculateDescendants(it, setDescendants);
+    }
+    std::vector<CTxMemPool::txiter> vAdded(alreadyAdded.begin(), alreadyAdded.end());
+    std::vector<CTxMemPool::txiter> vDescendants;
+    vDescendants.reserve(setDescendants.size() - alreadyAdded.size());
+    for (CTxMemPool::txiter it : setDescendants) {
+        if (!alreadyAdded.count(it)) {
+            vDescendants.push_back(it);
+        }
+    }
+    if (vDescendants.empty()) {
+        return 0;
+    }
+    // A child always has more ancestors than its parents
+    std::sort(vAdded.begin(), vAdded.end(), CompareTxIterByAncestorCount());
+    std::sort(vDescendants.begin(), vDescendants.end(), CompareTxIterByAncestorCount());
+
+    // Added transactions an entry descends from and what they sum up to
+    struct AddedAncestors {
+        std::vector<uint64_t> vBits;
+        int64_t nSize{0};
+        CAmount nModFee{0};
+        int64_t nSigOpCount{0};
+    };
+    struct EntryState {
+        size_t nAncestors;
+        //! Bit of an added transaction, -1 for descendants
+        int nBit;
+    };
+    const size_t nWords = (vAdded.size() + 63) / 64;
+    std::vector<AddedAncestors> vAncestors;
+    std::map<CTxMemPool::txiter, EntryState, CompareCTxMemPoolIter> mapState;
+
+    // Collect the bits of an entry's parents, returns a parent of the entry
+    // that has exactly these bits if there is one
+    auto collect = [&](CTxMemPool::txiter entry, std::vector<uint64_t>& vBits) {
+        vBits.assign(nWords, 0);
+        std::vector<size_t> vCandidates;
+        for (CTxMemPool::txiter parent : mempool.GetMemPoolParents(entry)) {
+            auto it = mapState.find(parent);
+            if (it == mapState.end()) continue;
+            const std::vector<uint64_t>& vParentBits = vAncestors[it->second.nAncestors].vBits;
+            for (size_t i = 0; i < nWords; i++) {
+                vBits[i] |= vParentBits[i];
+            }
+            if (it->second.nBit >= 0) {
+                vBits[it->second.nBit / 64] |= uint64_t{1} << (it->second.nBit % 64);
             } else {
-                mapModifiedTx.modify(mit, update_for_parent_inclusion(it));
+                vCandidates.push_back(it->second.nAncestors);
+            }
+        }
+        for (size_t nCandidate : vCandidates) {
+            if (vAncestors[nCandidate].vBits == vBits) return nCandidate;
+        }
+        return std::numeric_limits<size_t>::max();
+    };
+
+    // The added transactions only need their bits, they aren't updated
+    std::vector<uint64_t> vBits;
+    for (size_t i = 0; i < vAdded.size(); i++) {
+        collect(vAdded[i], vBits);
+        vAncestors.emplace_back();
+        vAncestors.back().vBits = vBits;
+        mapState.emplace(vAdded[i], EntryState{vAncestors.size() - 1, (int)i});
+    }
+
+    int nDescendantsUpdated = 0;
+    for (CTxMemPool::txiter desc : vDescendants) {
+        size_t nAncestors = collect(desc, vBits);
+        if (nAncestors == std::numeric_limits<size_t>::max()) {
+            AddedAncestors ancestors;
+            for (size_t i = 0; i < vAdded.size(); i++) {
+                if (vBits[i / 64] & (uint64_t{1} << (i % 64))) {
+                    ancestors.nSize += vAdded[i]->GetTxSize();
+                    ancestors.nModFee += vAdded[i]->GetModifiedFee();
+                    ancestors.nSigOpCount += vAdded[i]->GetSigOpCount();
+                }
             }
+            ancestors.vBits = vBits;
+            vAncestors.emplace_back(std::move(ancestors));
+            nAncestors = vAncestors.size() - 1;
+        }
+        mapState.emplace(desc, EntryState{nAncestors, -1});
+
+        // Insert all descendants (not yet in block) into the modified set
+        const AddedAncestors& ancestors = vAncestors[nAncestors];
+        ++nDescendantsUpdated;
+        modtxiter mit = mapModifiedTx.find(desc);
+        if (mit == mapModifiedTx.end()) {
+            CTxMemPoolModifiedEntry modEntry(desc);
+            modEntry.nSizeWithAncestors -= ancestors.nSize;
+            modEntry.nModFeesWithAncestors -= ancestors.nModFee;
+            modEntry.nSigOpCountWithAncestors -= ancestors.nSigOpCount;
+            mapModifiedTx.insert(modEntry);
+        } else {
+            mapModifiedTx.modify(mit, update_for_parent_inclusion(ancestors.nSize, ancestors.nModFee, ancestors.nSigOpCount));
         }
     }
     return nDescendantsUpdated;
@@ -397,6 +493,10 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     const int64_t MAX_CONSECUTIVE_FAILURES = 1000;
     int64_t nConsecutiveFailed = 0;
 
+    // Declared outside the loop so the sort buffer keeps its allocation
+    CTxMemPool::setEntries ancestors;
+    std::vector<CTxMemPool::txiter> sortedEntries;
+
     while (mi != mempool.mapTx.get<ancestor_score>().end() || !mapModifiedTx.empty())
     {
         // First try to find a new transaction in mapTx to evaluate.
@@ -468,12 +568,7 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
             continue;
         }
 
-        CTxMemPool::setEntries ancestors;
-        uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
-        std::string dummy;
-        mempool.CalculateMemPoolAncestors(*iter, ancestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
-
-        onlyUnconfirmed(ancestors);
+        CalculateUnconfirmedAncestors(iter, ancestors);
         ancestors.insert(iter);
 
         // Test if all tx's are Final and safe
@@ -489,7 +584,6 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
         nConsecutiveFailed = 0;
 
         // Package can be added. Sort the entries in a valid order.
-        std::vector<CTxMemPool::txiter> sortedEntries;
         SortForBlock(ancestors, sortedEntries);
 
         for (size_t i=0; i<sortedEntries.size(); ++i) {
@@ -112,16 +112,19 @@ typedef indexed_modified_transaction_set::index<ancestor_score>::type::iterator
 
 struct update_for_parent_inclusion
 {
-    explicit update_for_parent_inclusion(CTxMemPool::txiter it) : iter(it) {}
+    update_for_parent_inclusion(int64_t nSizeIn, CAmount nModFeeIn, int64_t nSigOpCountIn) :
+        nSize(nSizeIn), nModFee(nModFeeIn), nSigOpCount(nSigOpCountIn) {}
 
     void operator() (CTxMemPoolModifiedEntry &e)
     {
-        e.nModFeesWithAncestors -= iter->GetFee();
-        e.nSizeWithAncestors -= iter->GetTxSize();
-        e.nSigOpCountWithAncestors -= iter->GetSigOpCount();
+        e.nModFeesWithAncestors -= nModFee;
+        e.nSizeWithAncestors -= nSize;
+        e.nSigOpCountWithAncestors -= nSigOpCount;
     }
 
-    CTxMemPool::txiter iter;
+    int64_t nSize;
+    CAmount nModFee;
+    int64_t nSigOpCount;
 };
 
 /** Generate a new block, without valid proof-of-work */
@@ -144,6 +147,8 @@ private:
     CAmount nFees;
     CAmount nSpecialTxFees;
     CTxMemPool::setEntries inBlock;
+    // Work list of CalculateUnconfirmedAncestors, kept to reuse its allocation
+    std::vector<CTxMemPool::txiter> vAncestorWalk;
 
     // Chain context for the block
     int nHeight;
@@ -177,8 +182,8 @@ private:
     void addPackageTxs(int &nPackagesSelected, int &nDescendantsUpdated) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 
     // helper functions for addPackageTxs()
-    /** Remove confirmed (inBlock) entries from given set */
-    void onlyUnconfirmed(CTxMemPool::setEntries& testSet);
+    /** Collect the in-mempool ancestors of iter that are not yet inBlock */
+    void CalculateUnconfirmedAncestors(CTxMemPool::txiter iter, CTxMemPool::setEntries& ancestors) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
     /** Test if a new package would "fit" in the block */
     bool TestPackage(uint64_t packageSize, unsigned int packageSigOps) const;
     /** Perform checks on each transaction in a package:
@@ -192,8 +197,9 @@ private:
     /** Sort the package in an order that is valid to appear in a block */
     void SortForBlock(const CTxMemPool::setEntries& package, std::vector<CTxMemPool::txiter>& sortedEntries);
     /** Add descendants of given transactions to mapModifiedTx with ancestor
-      * state updated assuming given transactions are inBlock. Returns number
-      * of updated descendants. */
+      * state updated assuming given transactions are inBlock. Every descendant
+      * is visited once, however many of the given transactions it descends
+      * from. Returns number of updated descendants. */
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 };
 
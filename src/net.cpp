@@ -117,6 +117,7 @@ constexpr const CConnman::CAllNodes CConnman::AllNodes;
 
 static const uint64_t RANDOMIZER_ID_NETGROUP = 0x6c0edd8036ef4036ULL; // SHA256("netgroup")[0:8]
 static const uint64_t RANDOMIZER_ID_LOCALHOSTNONCE = 0xd93e69e2bbfa5735ULL; // SHA256("localhostnonce")[0:8]
+static const uint64_t RANDOMIZER_ID_ADDRCACHE = 0x1cf2e4ddd306dda9ULL; // SHA256("addrcache")[0:8]
 //
 // Global state variables
 //
@@ -3482,6 +3483,24 @@ std::vector<CAddress> CConnman::GetAddresses()
     return addrman.GetAddr();
 }
 
+std::vector<CAddress> CConnman::GetAddresses(const CNode& requestor)
+{
+    std::vector<unsigned char> vchLocal = requestor.addrBind.GetAddrBytes();
+    uint64_t cacheId = GetDeterministicRandomizer(RANDOMIZER_ID_ADDRCACHE)
+        .Write(requestor.addr.GetNetwork())
+        .Write(vchLocal.data(), vchLocal.size())
+        .Finalize();
+    int64_t nNow = GetTime();
+
+    LOCK(cs_mapAddrResponseCache);
+    CachedAddrResponse& cacheEntry = mapAddrResponseCache[cacheId];
+    if (cacheEntry.nExpiration < nNow) {
+        cacheEntry.vAddr = addrman.GetAddr();
+        cacheEntry.nExpiration = nNow + ADDR_RESPONSE_CACHE_LIFETIME + GetRand(ADDR_RESPONSE_CACHE_JITTER);
+    }
+    return cacheEntry.vAddr;
+}
+
 bool CConnman::AddNode(const std::string& strNode)
 {
     LOCK(cs_vAddedNodes);
@@ -64,6 +64,10 @@ static const unsigned int MAX_INV_SZ = 50000;
 static const unsigned int MAX_LOCATOR_SZ = 101;
 /** The maximum number of new addresses to accumulate before announcing. */
 static const unsigned int MAX_ADDR_TO_SEND = 1000;
+/** Minimum lifetime of a cached getaddr response, a random extra of up to ADDR_RESPONSE_CACHE_JITTER is added */
+static const int64_t ADDR_RESPONSE_CACHE_LIFETIME = 21 * 60 * 60;
+/** Maximum random extra lifetime of a cached getaddr response */
+static const int64_t ADDR_RESPONSE_CACHE_JITTER = 6 * 60 * 60;
 /** The maximum rate of address records we're willing to process on average. Can be bypassed using
  *  the NetPermissionFlags::Addr permission. */
 static constexpr double MAX_ADDR_RATE_PER_SECOND = 0.1;
@@ -385,6 +389,12 @@ public:
     void MarkAddressGood(const CAddress& addr);
     void AddNewAddresses(const std::vector<CAddress>& vAddr, const CAddress& addrFrom, int64_t nTimePenalty = 0);
     std::vector<CAddress> GetAddresses();
+    /**
+     * Addresses to answer a getaddr from requestor with. The response is computed once per
+     * requestor network and local bind address and then served from a cache until it expires,
+     * so that repeated getaddr requests neither cost an addrman walk nor reveal its contents.
+     */
+    std::vector<CAddress> GetAddresses(const CNode& requestor);
 
     // Denial-of-service detection/prevention
     // The idea is to detect peers that are behaving
@@ -592,6 +602,14 @@ private:
     bool setBannedIsDirty GUARDED_BY(cs_setBanned);
     bool fAddressesInitialized;
     CAddrMan addrman;
+
+    struct CachedAddrResponse {
+        std::vector<CAddress> vAddr;
+        int64_t nExpiration{0};
+    };
+    /** getaddr responses, keyed by a salted hash of the requestor network and local bind address */
+    std::map<uint64_t, CachedAddrResponse> mapAddrResponseCache GUARDED_BY(cs_mapAddrResponseCache);
+    CCriticalSection cs_mapAddrResponseCache;
     std::deque<std::string> vOneShots GUARDED_BY(cs_vOneShots);
     CCriticalSection cs_vOneShots;
     std::vector<std::string> vAddedNodes GUARDED_BY(cs_vAddedNodes);
@@ -104,6 +104,19 @@ static constexpr int STALE_RELAY_AGE_LIMIT = 30 * 24 * 60 * 60;
 /// Age after which a block is considered historical for purposes of rate
 /// limiting block relay. Set to one week, denominated in seconds.
 static constexpr int HISTORICAL_BLOCK_AGE = 7 * 24 * 60 * 60;
+/** Smallest block download window, used while blocks take long to validate */
+static constexpr int MIN_BLOCK_DOWNLOAD_WINDOW = 128;
+/** Size the block download window to hold about this much block validation time, in microseconds */
+static constexpr int64_t BLOCK_DOWNLOAD_WINDOW_VALIDATION_TIME = 60 * 1000000; // 1 minute
+/** How often to re-estimate the time it takes to validate a block, in microseconds */
+static constexpr int64_t BLOCK_VALIDATION_SAMPLE_INTERVAL = 10 * 1000000;
+/** Weight of a new sample in the moving averages of block download and validation times, in percent */
+static constexpr int64_t BLOCK_DOWNLOAD_AVG_WEIGHT = 20;
+/** Request the block holding up the download window from a faster peer once it took this many
+ *  times longer than expected from the peer it is in flight from... */
+static constexpr int64_t BLOCK_REREQUEST_FACTOR = 4;
+/** ...and at least this long, in microseconds */
+static constexpr int64_t BLOCK_REREQUEST_MIN_WAIT = 500000;
 
 struct COrphanTx {
     // When modifying, adapt the copy of this definition in tests/DoS_tests.
@@ -173,6 +186,8 @@ namespace {
         const CBlockIndex* pindex;                               //!< Optional.
         bool fValidatedHeaders;                                  //!< Whether this block has validated headers at the time of request.
         std::unique_ptr<PartiallyDownloadedBlock> partialBlock;  //!< Optional, used for CMPCTBLOCK downloads
+        int64_t nTimeRequested;                                  //!< When the block was requested (in microseconds).
+        bool fRerequested;                                       //!< Whether this block was taken over from a slower peer.
     };
     std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> > mapBlocksInFlight GUARDED_BY(cs_main);
 
@@ -260,6 +275,19 @@ struct CNodeState {
     int64_t nDownloadingSince;
     int nBlocksInFlight;
     int nBlocksInFlightValidHeaders;
+    //! Number and total size of the requested blocks this peer delivered.
+    int nBlocksDownloaded;
+    int64_t nBlockBytesDownloaded;
+    //! When the last requested block from this peer arrived (in microseconds), or 0.
+    int64_t nLastBlockReceived;
+    //! Moving average of the time this peer took per requested block (in microseconds), or 0.
+    int64_t nAvgBlockTime;
+    //! Moving average of this peer's block download speed (in bytes per second), or 0.
+    int64_t nAvgBlockBytesPerSec;
+    //! Blocks that were in flight from this peer for too long and were requested from a faster peer.
+    int nBlocksRerequestedAway;
+    //! Blocks that were taken over from a slower peer and requested from this peer.
+    int nBlocksRerequestedHere;
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload;
     //! Whether this peer wants invs or headers (when possible) for block announcements.
@@ -382,6 +410,13 @@ struct CNodeState {
         nDownloadingSince = 0;
         nBlocksInFlight = 0;
         nBlocksInFlightValidHeaders = 0;
+        nBlocksDownloaded = 0;
+        nBlockBytesDownloaded = 0;
+        nLastBlockReceived = 0;
+        nAvgBlockTime = 0;
+        nAvgBlockBytesPerSec = 0;
+        nBlocksRerequestedAway = 0;
+        nBlocksRerequestedHere = 0;
         fPreferredDownload = false;
         fPreferHeaders = false;
         fPreferHeaderAndIDs = false;
@@ -492,7 +527,7 @@ bool MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const CBlockIndex *
     MarkBlockAsReceived(hash);
 
     std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(),
-            {hash, pindex, pindex != nullptr, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&mempool) : nullptr)});
+            {hash, pindex, pindex != nullptr, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&mempool) : nullptr), GetTimeMicros(), false});
     state->nBlocksInFlight++;
     state->nBlocksInFlightValidHeaders += it->fValidatedHeaders;
     if (state->nBlocksInFlight == 1) {
@@ -508,6 +543,117 @@ bool MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const CBlockIndex *
     return true;
 }
 
+/** Update the moving average avg with sample, or start it */
+int64_t UpdateBlockDownloadAvg(int64_t avg, int64_t sample)
+{
+    if (avg == 0) {
+        return sample;
+    }
+    return (avg * (100 - BLOCK_DOWNLOAD_AVG_WEIGHT) + sample * BLOCK_DOWNLOAD_AVG_WEIGHT) / 100;
+}
+
+/** Update the download statistics of a peer that delivered a block we requested from it. Must be
+ *  called before MarkBlockAsReceived. */
+void RecordBlockDownload(NodeId nodeid, const uint256& hash, size_t nSize) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    auto itInFlight = mapBlocksInFlight.find(hash);
+    if (itInFlight == mapBlocksInFlight.end() || itInFlight->second.first != nodeid) {
+        return;
+    }
+    CNodeState *state = State(nodeid);
+    assert(state != nullptr);
+
+    const int64_t nNow = GetTimeMicros();
+    // With several blocks in flight the peer sends them back to back, so a block took the time
+    // since the previous one arrived rather than the time since it was requested.
+    const int64_t nTime = std::max<int64_t>(nNow - std::max(itInFlight->second.second->nTimeRequested, state->nLastBlockReceived), 1);
+    state->nAvgBlockTime = UpdateBlockDownloadAvg(state->nAvgBlockTime, nTime);
+    state->nAvgBlockBytesPerSec = UpdateBlockDownloadAvg(state->nAvgBlockBytesPerSec, (int64_t)nSize * 1000000 / nTime);
+    state->nLastBlockReceived = nNow;
+    state->nBlocksDownloaded++;
+    state->nBlockBytesDownloaded += nSize;
+}
+
+/**
+ * Whether to request the in-flight block hash from nodeid instead: it took much longer than its
+ * peer's pace lets expect, and nodeid has been faster. A block is taken over only once, after that
+ * the stalling and timeout logic in SendMessages applies.
+ */
+bool ShouldRerequestBlock(NodeId nodeid, const uint256& hash, int64_t nNow) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    auto itInFlight = mapBlocksInFlight.find(hash);
+    if (itInFlight == mapBlocksInFlight.end() || itInFlight->second.first == nodeid || itInFlight->second.second->fRerequested) {
+        return false;
+    }
+    CNodeState *state = State(nodeid);
+    CNodeState *stateSlow = State(itInFlight->second.first);
+    assert(state != nullptr && stateSlow != nullptr);
+    if (state->nAvgBlockTime == 0 || (stateSlow->nAvgBlockTime != 0 && stateSlow->nAvgBlockTime <= state->nAvgBlockTime)) {
+        // No track record yet, or not faster
+        return false;
+    }
+
+    // The peer sends the blocks in the order we requested them
+    const int64_t nQueuePos = std::distance(stateSlow->vBlocksInFlight.begin(), itInFlight->second.second) + 1;
+    const int64_t nExpected = nQueuePos * (stateSlow->nAvgBlockTime != 0 ? stateSlow->nAvgBlockTime : state->nAvgBlockTime);
+    const int64_t nWaiting = nNow - std::max(itInFlight->second.second->nTimeRequested, stateSlow->nLastBlockReceived);
+    return nWaiting > std::max(BLOCK_REREQUEST_MIN_WAIT, BLOCK_REREQUEST_FACTOR * nExpected);
+}
+
+/** Request the in-flight block pindex from nodeid instead of the slower peer it is in flight from */
+void RerequestBlock(NodeId nodeid, const CBlockIndex* pindex, int64_t nNow) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    const uint256& hash = pindex->GetBlockHash();
+    auto itInFlight = mapBlocksInFlight.find(hash);
+    assert(itInFlight != mapBlocksInFlight.end());
+    const NodeId nodeSlow = itInFlight->second.first;
+    CNodeState *stateSlow = State(nodeSlow);
+    assert(stateSlow != nullptr);
+
+    // Account for the wait in the slow peer's pace, so it doesn't look fast just because it never delivered
+    const int64_t nQueuePos = std::distance(stateSlow->vBlocksInFlight.begin(), itInFlight->second.second) + 1;
+    const int64_t nWaiting = nNow - std::max(itInFlight->second.second->nTimeRequested, stateSlow->nLastBlockReceived);
+    stateSlow->nAvgBlockTime = UpdateBlockDownloadAvg(stateSlow->nAvgBlockTime, std::max<int64_t>(nWaiting / nQueuePos, 1));
+    stateSlow->nBlocksRerequestedAway++;
+    State(nodeid)->nBlocksRerequestedHere++;
+
+    MarkBlockAsInFlight(nodeid, hash, pindex);
+    mapBlocksInFlight[hash].second->fRerequested = true;
+    LogPrint(BCLog::NET, "Re-requesting block %s (%d) from peer=%d, in flight from peer=%d for %dms\n", hash.ToString(),
+        pindex->nHeight, nodeid, nodeSlow, nWaiting / 1000);
+    statsClient.inc("blocks.download.rerequested", 1.0f);
+}
+
+/** Moving average of the time a block takes to connect (in microseconds), or 0 before the first sample. */
+int64_t g_avg_block_validation_time GUARDED_BY(cs_main) = 0;
+/** The validation timings when they were last sampled, and when that was (in microseconds). */
+CBlockValidationTimings g_last_validation_timings GUARDED_BY(cs_main);
+int64_t g_last_validation_sample_time GUARDED_BY(cs_main) = 0;
+
+/**
+ * The number of blocks beyond the last block we have in common with a peer that we download. It
+ * covers about BLOCK_DOWNLOAD_WINDOW_VALIDATION_TIME of block validation, so peers fill up the
+ * window while validation is fast and we don't buffer far ahead while it is slow.
+ */
+int GetBlockDownloadWindow() EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    const int64_t nNow = GetTimeMicros();
+    if (nNow - g_last_validation_sample_time >= BLOCK_VALIDATION_SAMPLE_INTERVAL) {
+        const CBlockValidationTimings timings = GetBlockValidationTimings();
+        const int64_t nBlocks = timings.nBlocks - g_last_validation_timings.nBlocks;
+        if (g_last_validation_sample_time != 0 && nBlocks > 0) {
+            const int64_t nTime = std::max<int64_t>((timings.nTotal - g_last_validation_timings.nTotal) / nBlocks, 1);
+            g_avg_block_validation_time = UpdateBlockDownloadAvg(g_avg_block_validation_time, nTime);
+        }
+        g_last_validation_timings = timings;
+        g_last_validation_sample_time = nNow;
+    }
+    if (g_avg_block_validation_time == 0) {
+        return BLOCK_DOWNLOAD_WINDOW;
+    }
+    return std::max<int64_t>(MIN_BLOCK_DOWNLOAD_WINDOW, std::min<int64_t>(BLOCK_DOWNLOAD_WINDOW, BLOCK_DOWNLOAD_WINDOW_VALIDATION_TIME / g_avg_block_validation_time));
+}
+
 /** Check whether the last unknown block a peer advertised is not yet known. */
 void ProcessBlockAvailability(NodeId nodeid) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     CNodeState *state = State(nodeid);
@@ -609,8 +755,9 @@ bool PeerHasHeader(CNodeState *state, const CBlockIndex *pindex) EXCLUSIVE_LOCKS
 }
 
 /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
- *  at most count entries. */
-void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+ *  at most count entries. pindexWaitingFor is set to the first missing block that is in flight from
+ *  another peer, the block that holds up the download window. */
+void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const CBlockIndex*& pindexWaitingFor, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     if (count == 0)
         return;
@@ -641,10 +788,10 @@ void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<con
 
     std::vector<const CBlockIndex*> vToFetch;
     const CBlockIndex *pindexWalk = state->pindexLastCommonBlock;
-    // Never fetch further than the best block we know the peer has, or more than BLOCK_DOWNLOAD_WINDOW + 1 beyond the last
+    // Never fetch further than the best block we know the peer has, or more than the download window + 1 beyond the last
     // linked block we have in common with this peer. The +1 is so we can detect stalling, namely if we would be able to
     // download that next block if the window were 1 larger.
-    int nWindowEnd = state->pindexLastCommonBlock->nHeight + BLOCK_DOWNLOAD_WINDOW;
+    int nWindowEnd = state->pindexLastCommonBlock->nHeight + GetBlockDownloadWindow();
     int nMaxHeight = std::min<int>(state->pindexBestKnownBlock->nHeight, nWindowEnd + 1);
     NodeId waitingfor = -1;
     while (pindexWalk->nHeight < nMaxHeight) {
@@ -688,6 +835,9 @@ void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<con
             } else if (waitingfor == -1) {
                 // This is the first already-in-flight block.
                 waitingfor = mapBlocksInFlight[pindex->GetBlockHash()].first;
+                if (waitingfor != nodeid) {
+                    pindexWaitingFor = pindex;
+                }
             }
         }
     }
@@ -910,6 +1060,12 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
         if (queue.pindex)
             stats.vHeightInFlight.push_back(queue.pindex->nHeight);
     }
+    stats.nBlocksDownloaded = state->nBlocksDownloaded;
+    stats.nBlockBytesDownloaded = state->nBlockBytesDownloaded;
+    stats.nAvgBlockTime = state->nAvgBlockTime;
+    stats.nAvgBlockBytesPerSec = state->nAvgBlockBytesPerSec;
+    stats.nBlocksRerequestedAway = state->nBlocksRerequestedAway;
+    stats.nBlocksRerequestedHere = state->nBlocksRerequestedHere;
     return true;
 }
 
@@ -942,7 +1098,7 @@ bool AddOrphanTx(const CTransactionRef& tx, NodeId peer) EXCLUSIVE_LOCKS_REQUIRE
     // have been mined or received.
     // 100 orphans, each of which is at most 99,999 bytes big is
     // at most 10 megabytes of orphans and somewhat more byprev index (in the worst case):
-    unsigned int sz = GetSerializeSize(*tx, SER_NETWORK, CTransaction::CURRENT_VERSION);
+    unsigned int sz = tx->GetTotalSize();
     if (sz > MAX_STANDARD_TX_SIZE)
     {
         LogPrint(BCLog::MEMPOOL, "ignoring large orphan tx (size: %u, hash: %s)\n", sz, hash.ToString());
@@ -2686,7 +2842,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             // If pruning, don't inv blocks unless we have on disk and are likely to still have
             // for some reasonable time window (1 hour) that block relay might require.
             const int nPrunedBlocksLikelyToHave = MIN_BLOCKS_TO_KEEP - 3600 / chainparams.GetConsensus().nPowTargetSpacing;
-            if (fPruneMode && (!(pindex->nStatus & BLOCK_HAVE_DATA) || pindex->nHeight <= chainActive.Tip()->nHeight - nPrunedBlocksLikelyToHave))
+            if ((fPruneMode && (!(pindex->nStatus & BLOCK_HAVE_DATA) || pindex->nHeight <= chainActive.Tip()->nHeight - nPrunedBlocksLikelyToHave)) ||
+                (fSnapshotChainstate && !(pindex->nStatus & BLOCK_HAVE_DATA)))
             {
                 LogPrint(BCLog::NET, " getblocks stopping, pruned or too old block at %d %s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
                 break;
@@ -3340,6 +3497,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     if (strCommand == NetMsgType::BLOCK && !fImporting && !fReindex) // Ignore blocks received while importing
     {
         std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+        const size_t nBlockSize = vRecv.size();
         vRecv >> *pblock;
 
         LogPrint(BCLog::NET, "received block %s peer=%d\n", pblock->GetHash().ToString(), pfrom->GetId());
@@ -3348,6 +3506,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         const uint256 hash(pblock->GetHash());
         {
             LOCK(cs_main);
+            RecordBlockDownload(pfrom->GetId(), hash, nBlockSize);
             // Also always process if we requested the block explicitly, as we may
             // need it even though it is not a candidate for a new best tip.
             forceProcessing |= MarkBlockAsReceived(hash);
@@ -3386,7 +3545,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         pfrom->fSentAddr = true;
 
         pfrom->vAddrToSend.clear();
-        std::vector<CAddress> vAddr = connman->GetAddresses();
+        std::vector<CAddress> vAddr = connman->GetAddresses(*pfrom);
         FastRandomContext insecure_rand;
         for (const CAddress &addr : vAddr)
             pfrom->PushAddress(addr, insecure_rand);
@@ -4429,13 +4588,20 @@ bool PeerLogicValidation::SendMessages(CNode* pto)
         if (!pto->fClient && pto->CanRelay() && ((fFetch && !pto->m_limited_node) || !IsInitialBlockDownload()) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller, consensusParams);
+            const CBlockIndex* pindexWaitingFor = nullptr;
+            FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller, pindexWaitingFor, consensusParams);
             for (const CBlockIndex *pindex : vToDownload) {
                 vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
                 MarkBlockAsInFlight(pto->GetId(), pindex->GetBlockHash(), pindex);
                 LogPrint(BCLog::NET, "Requesting block %s (%d) peer=%d\n", pindex->GetBlockHash().ToString(),
                     pindex->nHeight, pto->GetId());
             }
+            // Don't wait for a slow peer to stall the window before fetching the block holding it up
+            if (pindexWaitingFor != nullptr && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER &&
+                ShouldRerequestBlock(pto->GetId(), pindexWaitingFor->GetBlockHash(), nNow)) {
+                vGetData.push_back(CInv(MSG_BLOCK, pindexWaitingFor->GetBlockHash()));
+                RerequestBlock(pto->GetId(), pindexWaitingFor, nNow);
+            }
             if (state.nBlocksInFlight == 0 && staller != -1) {
                 if (State(staller)->nStallingSince == 0) {
                     State(staller)->nStallingSince = nNow;
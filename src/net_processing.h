@@ -83,6 +83,12 @@ struct CNodeStateStats {
     int nSyncHeight = -1;
     int nCommonHeight = -1;
     std::vector<int> vHeightInFlight;
+    int nBlocksDownloaded = 0;
+    int64_t nBlockBytesDownloaded = 0;
+    int64_t nAvgBlockTime = 0;          //!< in microseconds
+    int64_t nAvgBlockBytesPerSec = 0;
+    int nBlocksRerequestedAway = 0;
+    int nBlocksRerequestedHere = 0;
 };
 
 /** Get statistics from node state */
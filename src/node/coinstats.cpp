@@ -9,18 +9,47 @@
 #include <coins.h>
 #include <chain.h>
 #include <hash.h>
+#include <primitives/block.h>
 #include <serialize.h>
+#include <streams.h>
+#include <txdb.h>
+#include <undo.h>
 #include <validation.h>
+#include <version.h>
 #include <uint256.h>
 // #include <util/system.h>
 #include <util.h>
 
 #include <map>
+#include <vector>
 
 #include <boost/thread.hpp>
 
+CCoinsStatsTracker g_coins_stats_tracker;
 
-static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+static uint64_t GetBogoSize(const CScript& scriptPubKey)
+{
+    return 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
+           2 /* scriptPubKey len */ + scriptPubKey.size() /* scriptPubKey */;
+}
+
+//! The element of the rolling set hash representing a single coin
+static void SerializeCoinForHash(CDataStream& ss, const COutPoint& outpoint, const CTxOut& out, int nHeight, bool fCoinBase)
+{
+    ss.clear();
+    ss << outpoint;
+    ss << (uint32_t)(nHeight * 2 + (fCoinBase ? 1u : 0u));
+    ss << out;
+}
+
+static void MuHashAddCoin(MuHash3072& muhash, CDataStream& ss, const COutPoint& outpoint, const Coin& coin)
+{
+    SerializeCoinForHash(ss, outpoint, coin.out, coin.nHeight, coin.fCoinBase);
+    muhash.Insert((const unsigned char*)ss.data(), ss.size());
+}
+
+
+static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs, MuHash3072* pmuhash, CDataStream& muss)
 {
     assert(!outputs.empty());
     ss << hash;
@@ -32,19 +61,29 @@ static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash,
         ss << VARINT(output.second.out.nValue, VarIntMode::NONNEGATIVE_SIGNED);
         stats.nTransactionOutputs++;
         stats.nTotalAmount += output.second.out.nValue;
-        stats.nBogoSize += 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
-                           2 /* scriptPubKey len */ + output.second.out.scriptPubKey.size() /* scriptPubKey */;
+        stats.nBogoSize += GetBogoSize(output.second.out.scriptPubKey);
+        if (pmuhash) {
+            MuHashAddCoin(*pmuhash, muss, COutPoint(hash, output.first), output.second);
+        }
     }
     ss << VARINT(0u);
 }
 
+static void FinalizeMuHash(MuHash3072 muhash, uint256& hashOut)
+{
+    unsigned char out[32];
+    muhash.Finalize(out);
+    memcpy(hashOut.begin(), out, sizeof(out));
+}
+
 //! Calculate statistics about the unspent transaction output set
-bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
+bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats, MuHash3072* pmuhash)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
     assert(pcursor);
 
     CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    CDataStream muss(SER_DISK, PROTOCOL_VERSION);
     stats.hashBlock = pcursor->GetBestBlock();
     {
         LOCK(cs_main);
@@ -59,7 +98,7 @@ bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
         Coin coin;
         if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
             if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
+                ApplyStats(stats, ss, prevkey, outputs, pmuhash, muss);
                 outputs.clear();
             }
             prevkey = key.hash;
@@ -70,9 +109,246 @@ bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
         pcursor->Next();
     }
     if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
+        ApplyStats(stats, ss, prevkey, outputs, pmuhash, muss);
     }
     stats.hashSerialized = ss.GetHash();
+    if (pmuhash) {
+        FinalizeMuHash(*pmuhash, stats.hashMuHash);
+    }
     stats.nDiskSize = view->EstimateSize();
     return true;
 }
+
+void CCoinsStatsDelta::Update(const COutPoint& outpoint, const CTxOut& out, int nHeight, bool fCoinBase, bool fAdd)
+{
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    SerializeCoinForHash(ss, outpoint, out, nHeight, fCoinBase);
+    const int sign = fAdd ? 1 : -1;
+    if (fAdd) {
+        muhash.Insert((const unsigned char*)ss.data(), ss.size());
+    } else {
+        muhash.Remove((const unsigned char*)ss.data(), ss.size());
+    }
+    nTransactionOutputs += sign;
+    nTotalAmount += sign * out.nValue;
+    nBogoSize += sign * (int64_t)GetBogoSize(out.scriptPubKey);
+}
+
+void CCoinsStatsDelta::AddCoin(const COutPoint& outpoint, const Coin& coin)
+{
+    Update(outpoint, coin.out, coin.nHeight, coin.fCoinBase, true);
+}
+
+void CCoinsStatsDelta::SpendCoin(const COutPoint& outpoint, const Coin& coin)
+{
+    Update(outpoint, coin.out, coin.nHeight, coin.fCoinBase, false);
+}
+
+//! Replay the UTXO set changes of a block, in reverse when disconnecting
+static void ApplyBlock(CCoinsStatsDelta& delta, const CBlock& block, const CBlockUndo& blockundo, int nHeight, bool fConnect)
+{
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+        for (size_t j = 0; j < tx.vout.size(); j++) {
+            // Mirrors AddCoins(), unspendable outputs never enter the UTXO set
+            if (tx.vout[j].scriptPubKey.IsUnspendable()) continue;
+            delta.Update(COutPoint(txid, j), tx.vout[j], nHeight, i == 0, fConnect);
+        }
+        if (i == 0) continue;
+        const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+        for (size_t j = 0; j < tx.vin.size(); j++) {
+            if (fConnect) {
+                delta.SpendCoin(tx.vin[j].prevout, txundo.vprevout[j]);
+            } else {
+                delta.AddCoin(tx.vin[j].prevout, txundo.vprevout[j]);
+            }
+        }
+    }
+}
+
+void CCoinsStatsDelta::ConnectBlock(const CBlock& block, const CBlockUndo& blockundo, int nHeight)
+{
+    ApplyBlock(*this, block, blockundo, nHeight, true);
+}
+
+void CCoinsStatsDelta::DisconnectBlock(const CBlock& block, const CBlockUndo& blockundo, int nHeight)
+{
+    ApplyBlock(*this, block, blockundo, nHeight, false);
+}
+
+CCoinsStatsEntry::CCoinsStatsEntry(const CCoinsStatsState& state) :
+    hashBlock(state.hashBlock),
+    nHeight(state.nHeight),
+    nTransactionOutputs(state.nTransactionOutputs),
+    nBogoSize(state.nBogoSize),
+    nTotalAmount(state.nTotalAmount)
+{
+    FinalizeMuHash(state.muhash, hashMuHash);
+}
+
+void CCoinsStatsTracker::Load(const CCoinsViewDB& db)
+{
+    LOCK(cs);
+    const uint256 hashBest = db.GetBestBlock();
+    CCoinsStatsState stored;
+    fDirty = false;
+    mapUnflushed.clear();
+    if (db.ReadCoinsStats(stored) && stored.hashBlock == hashBest) {
+        state = stored;
+        fValid = true;
+    } else if (hashBest.IsNull() && db.GetHeadBlocks().empty()) {
+        // Fresh chainstate, the UTXO set is empty
+        state = CCoinsStatsState();
+        fValid = true;
+    } else {
+        fValid = false;
+    }
+    LogPrintf("%s: UTXO set statistics %s\n", __func__, fValid ? "loaded" : "unavailable until next full scan");
+}
+
+bool CCoinsStatsTracker::GetUnflushed(const uint256& hashBlock, CCoinsStatsState& tip, std::vector<CCoinsStatsEntry>& vEntries) const
+{
+    LOCK(cs);
+    vEntries.clear();
+    vEntries.reserve(mapUnflushed.size());
+    for (const auto& entry : mapUnflushed) {
+        vEntries.push_back(entry.second);
+    }
+    if (!fValid || !fDirty || state.hashBlock != hashBlock) return false;
+    tip = state;
+    return true;
+}
+
+void CCoinsStatsTracker::MarkFlushed(const uint256& hashBlock, const std::vector<CCoinsStatsEntry>& vEntries)
+{
+    LOCK(cs);
+    for (const auto& entry : vEntries) {
+        auto it = mapUnflushed.find(entry.nHeight);
+        if (it != mapUnflushed.end() && it->second.hashBlock == entry.hashBlock) {
+            mapUnflushed.erase(it);
+        }
+    }
+    if (state.hashBlock == hashBlock) fDirty = false;
+}
+
+void CCoinsStatsTracker::AddEntry()
+{
+    // Entries of disconnected blocks are dropped, or overwritten once a
+    // block is connected at their height again
+    mapUnflushed.erase(mapUnflushed.upper_bound(state.nHeight), mapUnflushed.end());
+    mapUnflushed[state.nHeight] = CCoinsStatsEntry(state);
+}
+
+void CCoinsStatsTracker::Apply(const CCoinsStatsDelta& delta, const uint256& hashPrev, const CBlockIndex* pindexNew)
+{
+    LOCK(cs);
+    if (!fValid) return;
+    if (state.hashBlock != hashPrev) {
+        LogPrintf("%s: UTXO set statistics are at %s, not %s, discarding\n", __func__, state.hashBlock.ToString(), hashPrev.ToString());
+        fValid = false;
+        return;
+    }
+    state.hashBlock = pindexNew->GetBlockHash();
+    state.nHeight = pindexNew->nHeight;
+    state.nTransactionOutputs += delta.nTransactionOutputs;
+    state.nBogoSize += delta.nBogoSize;
+    state.nTotalAmount += delta.nTotalAmount;
+    state.muhash *= delta.muhash;
+    fDirty = true;
+    AddEntry();
+}
+
+void CCoinsStatsTracker::Reset(const CCoinsStats& stats, const MuHash3072& muhash)
+{
+    LOCK(cs);
+    state.hashBlock = stats.hashBlock;
+    state.nHeight = stats.nHeight;
+    state.nTransactionOutputs = stats.nTransactionOutputs;
+    state.nBogoSize = stats.nBogoSize;
+    state.nTotalAmount = stats.nTotalAmount;
+    state.muhash = muhash;
+    fValid = true;
+    fDirty = true;
+    AddEntry();
+}
+
+bool CCoinsStatsTracker::IsValid() const
+{
+    LOCK(cs);
+    return fValid;
+}
+
+static void FillStats(const CCoinsStatsState& entry, CCoinsStats& stats, bool fMuHash)
+{
+    stats.hashBlock = entry.hashBlock;
+    stats.nHeight = entry.nHeight;
+    stats.nTransactionOutputs = entry.nTransactionOutputs;
+    stats.nBogoSize = entry.nBogoSize;
+    stats.nTotalAmount = entry.nTotalAmount;
+    if (fMuHash) {
+        FinalizeMuHash(entry.muhash, stats.hashMuHash);
+    }
+}
+
+bool CCoinsStatsTracker::GetStats(CCoinsStats& stats, bool fMuHash) const
+{
+    CCoinsStatsState entry;
+    {
+        LOCK(cs);
+        if (!fValid) return false;
+        entry = state;
+    }
+    // The modular inversion takes a few milliseconds, keep it outside the lock
+    FillStats(entry, stats, fMuHash);
+    return true;
+}
+
+bool CCoinsStatsTracker::GetStats(const CCoinsViewDB& db, const CBlockIndex* pindex, CCoinsStats& stats, bool fMuHash) const
+{
+    CCoinsStatsEntry entry;
+    {
+        // Held across the database read so a concurrent Flush can't move the entry
+        LOCK(cs);
+        auto it = mapUnflushed.find(pindex->nHeight);
+        if (it != mapUnflushed.end()) {
+            entry = it->second;
+        } else if (!db.ReadCoinsStats(pindex->nHeight, entry)) {
+            return false;
+        }
+    }
+    if (entry.hashBlock != pindex->GetBlockHash()) return false;
+    stats.hashBlock = entry.hashBlock;
+    stats.nHeight = entry.nHeight;
+    stats.nTransactionOutputs = entry.nTransactionOutputs;
+    stats.nBogoSize = entry.nBogoSize;
+    stats.nTotalAmount = entry.nTotalAmount;
+    if (fMuHash) {
+        stats.hashMuHash = entry.hashMuHash;
+    }
+    return true;
+}
+
+bool GetTipUTXOStats(CCoinsViewDB* view, CCoinsStats& stats, bool fMuHash, bool& fFullScan)
+{
+    fFullScan = false;
+    if (fCoinStatsIndex && g_coins_stats_tracker.GetStats(stats, fMuHash)) {
+        stats.nDiskSize = view->EstimateSize();
+        return true;
+    }
+
+    fFullScan = true;
+    FlushStateToDisk();
+    MuHash3072 muhash;
+    // The set hash is only needed if asked for or to seed the tracker
+    if (!GetUTXOStats(view, stats, (fMuHash || fCoinStatsIndex) ? &muhash : nullptr)) {
+        return false;
+    }
+    if (!fCoinStatsIndex) return true;
+    LOCK(cs_main);
+    // Only seed the tracker if no block was (dis)connected during the scan
+    if (pcoinsTip->GetBestBlock() == stats.hashBlock) {
+        g_coins_stats_tracker.Reset(stats, muhash);
+    }
+    return true;
+}
@@ -7,11 +7,23 @@
 #define BITCOIN_NODE_COINSTATS_H
 
 #include <amount.h>
+#include <crypto/muhash.h>
+#include <serialize.h>
+#include <sync.h>
 #include <uint256.h>
 
 #include <cstdint>
+#include <map>
+#include <vector>
 
+class CBlock;
+class CBlockIndex;
+class CBlockUndo;
 class CCoinsView;
+class CCoinsViewDB;
+class COutPoint;
+class Coin;
+class CTxOut;
 
 struct CCoinsStats
 {
@@ -21,13 +33,139 @@ struct CCoinsStats
     uint64_t nTransactionOutputs;
     uint64_t nBogoSize;
     uint256 hashSerialized;
+    uint256 hashMuHash;
     uint64_t nDiskSize;
     CAmount nTotalAmount;
 
     CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
 };
 
-//! Calculate statistics about the unspent transaction output set
-bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats);
+//! Calculate statistics about the unspent transaction output set,
+//! optionally also adding every coin to a rolling set hash
+bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, MuHash3072* pmuhash = nullptr);
+
+/** Change of the UTXO set statistics caused by (dis)connecting blocks */
+struct CCoinsStatsDelta
+{
+    int64_t nTransactionOutputs{0};
+    int64_t nBogoSize{0};
+    CAmount nTotalAmount{0};
+    MuHash3072 muhash;
+
+    void Update(const COutPoint& outpoint, const CTxOut& out, int nHeight, bool fCoinBase, bool fAdd);
+    void AddCoin(const COutPoint& outpoint, const Coin& coin);
+    void SpendCoin(const COutPoint& outpoint, const Coin& coin);
+    /** Account for all outputs created and spent by a block */
+    void ConnectBlock(const CBlock& block, const CBlockUndo& blockundo, int nHeight);
+    void DisconnectBlock(const CBlock& block, const CBlockUndo& blockundo, int nHeight);
+};
+
+/** UTXO set statistics at the chainstate tip, as persisted in the chainstate.
+ *  Keeps the full MuHash state so later blocks can be applied to it. */
+struct CCoinsStatsState
+{
+    uint256 hashBlock;
+    int nHeight{0};
+    uint64_t nTransactionOutputs{0};
+    uint64_t nBogoSize{0};
+    CAmount nTotalAmount{0};
+    MuHash3072 muhash;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(nHeight);
+        READWRITE(nTransactionOutputs);
+        READWRITE(nBogoSize);
+        READWRITE(nTotalAmount);
+        READWRITE(muhash);
+    }
+};
+
+/** UTXO set statistics after a block, as persisted per height. Only the
+ *  finalized 32-byte set hash is kept instead of the 768-byte MuHash state. */
+struct CCoinsStatsEntry
+{
+    uint256 hashBlock;
+    int nHeight{0};
+    uint64_t nTransactionOutputs{0};
+    uint64_t nBogoSize{0};
+    CAmount nTotalAmount{0};
+    uint256 hashMuHash;
+
+    CCoinsStatsEntry() {}
+    explicit CCoinsStatsEntry(const CCoinsStatsState& state);
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(nHeight);
+        READWRITE(nTransactionOutputs);
+        READWRITE(nBogoSize);
+        READWRITE(nTotalAmount);
+        READWRITE(hashMuHash);
+    }
+};
+
+/**
+ * Keeps the UTXO set statistics of the chainstate tip up to date as blocks
+ * are connected and disconnected, so they can be reported without walking
+ * the whole coins database. The statistics after every connected block are
+ * kept as well, indexed by height. The number of transactions with unspent
+ * outputs can't be maintained this way and is only available from a full
+ * scan. Only used with -coinstatsindex.
+ *
+ * The statistics are written by CCoinsViewDB::BatchWrite in the same batch
+ * as the best block they describe, see CCoinsViewDB::SetCoinsStatsTracker.
+ */
+class CCoinsStatsTracker
+{
+private:
+    mutable CCriticalSection cs;
+    bool fValid GUARDED_BY(cs){false};
+    bool fDirty GUARDED_BY(cs){false};
+    CCoinsStatsState state GUARDED_BY(cs);
+    //! Per block entries not written to the chainstate database yet
+    std::map<int, CCoinsStatsEntry> mapUnflushed GUARDED_BY(cs);
+
+    //! Finalizes the set hash, which needs a modular inversion
+    void AddEntry() EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+public:
+    /** Restore the persisted statistics if they match the coins database */
+    void Load(const CCoinsViewDB& db);
+    /** What a flush of the coins database to hashBlock has to write: the per
+     *  block entries, and the tip statistics if they describe hashBlock.
+     *  Returns whether the tip statistics were filled in. */
+    bool GetUnflushed(const uint256& hashBlock, CCoinsStatsState& tip, std::vector<CCoinsStatsEntry>& vEntries) const;
+    /** Forget what GetUnflushed returned, once it is written */
+    void MarkFlushed(const uint256& hashBlock, const std::vector<CCoinsStatsEntry>& vEntries);
+    /** Apply the changes of a block moving the tip from hashPrev to pindexNew */
+    void Apply(const CCoinsStatsDelta& delta, const uint256& hashPrev, const CBlockIndex* pindexNew);
+    /** Start over from the result of a full scan */
+    void Reset(const CCoinsStats& stats, const MuHash3072& muhash);
+    bool IsValid() const;
+    /** Fill in everything but nTransactions and hashSerialized, computing
+     *  hashMuHash only if requested as that needs a modular inversion */
+    bool GetStats(CCoinsStats& stats, bool fMuHash) const;
+    /** Same for an earlier block, from its per block entry. Entries are keyed
+     *  by height, one left behind by a reorg is detected by its block hash.
+     *  Their set hash is already finalized. */
+    bool GetStats(const CCoinsViewDB& db, const CBlockIndex* pindex, CCoinsStats& stats, bool fMuHash) const;
+};
+
+extern CCoinsStatsTracker g_coins_stats_tracker;
+
+/**
+ * Statistics of the UTXO set at the chain tip, from g_coins_stats_tracker if
+ * -coinstatsindex is enabled and it is up to date. Otherwise the coins
+ * database is flushed and scanned, which also re-seeds the tracker when it is
+ * in use; fFullScan tells which path was taken.
+ */
+bool GetTipUTXOStats(CCoinsViewDB* view, CCoinsStats& stats, bool fMuHash, bool& fFullScan);
 
 #endif // BITCOIN_NODE_COINSTATS_H
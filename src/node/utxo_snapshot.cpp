@@ -0,0 +1,432 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/utxo_snapshot.h>
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <coins.h>
+#include <consensus/validation.h>
+#include <dbwrapper.h>
+#include <evo/evodb.h>
+#include <hash.h>
+#include <init.h>
+#include <node/coinstats.h>
+#include <pow.h>
+#include <streams.h>
+#include <timedata.h>
+#include <txdb.h>
+#include <util.h>
+#include <validation.h>
+
+#include <ctpl.h>
+
+#include <future>
+#include <memory>
+
+//! Coins and block index entries written to the databases per batch when loading
+static const size_t SNAPSHOT_LOAD_BATCH = 100000;
+
+namespace {
+
+struct SnapshotHeader {
+    CBlockHeader header;
+    uint32_t nTx{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(header);
+        READWRITE(nTx);
+    }
+};
+
+uint256 FinalizeMuHash(MuHash3072 muhash)
+{
+    unsigned char out[32];
+    muhash.Finalize(out);
+    uint256 hash;
+    memcpy(hash.begin(), out, sizeof(out));
+    return hash;
+}
+
+} // namespace
+
+uint256 GetSnapshotHash(const SnapshotMetadata& metadata, const uint256& hashContents)
+{
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << metadata << hashContents;
+    return hasher.GetHash();
+}
+
+bool DumpUTXOSnapshot(const fs::path& path, SnapshotMetadata& metadata, uint256& hashSnapshot, std::string& strError)
+{
+    const CChainParams& chainparams = Params();
+
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::unique_ptr<CDBIterator> pevoIt;
+    std::vector<SnapshotHeader> vHeaders;
+    {
+        LOCK(cs_main);
+        // Bring the chainstate and the evo database on disk to the tip, the cursors then keep
+        // seeing that state while new blocks are connected
+        FlushStateToDisk();
+        pcursor.reset(pcoinsdbview->Cursor());
+        pevoIt.reset(evoDb->GetRawDB().NewIterator());
+
+        const CBlockIndex* pindexBase = LookupBlockIndex(pcursor->GetBestBlock());
+        if (!pindexBase || !chainActive.Contains(pindexBase)) {
+            strError = "The chainstate is not at a block of the active chain";
+            return false;
+        }
+        if (!evoDb->VerifyBestBlock(pindexBase->GetBlockHash())) {
+            strError = "The evo database is not at the chainstate's block";
+            return false;
+        }
+
+        memcpy(&metadata.m_network_magic, chainparams.MessageStart(), sizeof(metadata.m_network_magic));
+        metadata.m_base_blockhash = pindexBase->GetBlockHash();
+        metadata.m_base_height = pindexBase->nHeight;
+
+        vHeaders.resize(pindexBase->nHeight + 1);
+        for (const CBlockIndex* pindex = pindexBase; pindex; pindex = pindex->pprev) {
+            vHeaders[pindex->nHeight].header = pindex->GetBlockHeader();
+            vHeaders[pindex->nHeight].nTx = pindex->nTx;
+        }
+    }
+
+    fs::path pathTmp = path;
+    pathTmp += ".incomplete";
+    std::unique_ptr<CAutoFile> fileout(new CAutoFile(fsbridge::fopen(pathTmp, "wb"), SER_DISK, CLIENT_VERSION));
+    if (fileout->IsNull()) {
+        strError = strprintf("Failed to open %s", pathTmp.string());
+        return false;
+    }
+
+    // The counts are only known at the end, the metadata is written again then. Everything
+    // after it goes into the snapshot hash as well.
+    *fileout << metadata;
+    CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+    for (const auto& header : vHeaders) {
+        *fileout << header;
+        hasher << header;
+    }
+
+    CCoinsStatsDelta stats;
+    while (pcursor->Valid()) {
+        if (ShutdownRequested()) {
+            strError = "Shutdown requested";
+            return false;
+        }
+        COutPoint outpoint;
+        Coin coin;
+        if (!pcursor->GetKey(outpoint) || !pcursor->GetValue(coin)) {
+            strError = "Unable to read the coins database";
+            return false;
+        }
+        *fileout << outpoint << coin;
+        hasher << outpoint << coin;
+        stats.AddCoin(outpoint, coin);
+        metadata.m_coins_count++;
+        pcursor->Next();
+    }
+    metadata.m_coins_muhash = FinalizeMuHash(stats.muhash);
+    metadata.m_total_amount = stats.nTotalAmount;
+
+    for (pevoIt->SeekToFirst(); pevoIt->Valid(); pevoIt->Next()) {
+        CDataStream ssKey = pevoIt->GetKey();
+        CDataStream ssValue = pevoIt->GetValue();
+        const std::vector<unsigned char> vchKey(ssKey.begin(), ssKey.end());
+        const std::vector<unsigned char> vchValue(ssValue.begin(), ssValue.end());
+        *fileout << vchKey << vchValue;
+        hasher << vchKey << vchValue;
+        metadata.m_evo_entries_count++;
+    }
+
+    if (fseek(fileout->Get(), 0, SEEK_SET) != 0) {
+        strError = "Failed to rewind the snapshot file";
+        return false;
+    }
+    *fileout << metadata;
+    hashSnapshot = GetSnapshotHash(metadata, hasher.GetHash());
+    FileCommit(fileout->Get());
+    fileout.reset();
+
+    if (!RenameOver(pathTmp, path)) {
+        strError = "Failed to rename the snapshot file";
+        return false;
+    }
+
+    LogPrintf("%s: wrote %u coins and %u evo entries at block %s (height %d) to %s, snapshot hash %s\n", __func__,
+              metadata.m_coins_count, metadata.m_evo_entries_count, metadata.m_base_blockhash.ToString(), metadata.m_base_height, path.string(),
+              hashSnapshot.ToString());
+    return true;
+}
+
+namespace {
+
+/** Check the proof of work of the headers on all cores, the hashes are expensive */
+bool CheckSnapshotHeadersPoW(const std::vector<CBlockHeader>& vHeaders, const Consensus::Params& params, std::string& strError)
+{
+    const int nThreads = std::max(GetNumCores(), 1);
+    ctpl::thread_pool workerPool(nThreads);
+    RenameThreadPool(workerPool, "raptoreum-snapshot");
+
+    const size_t nChunkSize = std::max<size_t>(1, (vHeaders.size() + nThreads - 1) / nThreads);
+    std::vector<std::future<int>> vFutures;
+    // The genesis block is checked against the chain params instead
+    for (size_t nStart = 1; nStart < vHeaders.size(); nStart += nChunkSize) {
+        const size_t nEnd = std::min(vHeaders.size(), nStart + nChunkSize);
+        vFutures.emplace_back(workerPool.push([&vHeaders, &params, nStart, nEnd](int) {
+            for (size_t nHeight = nStart; nHeight < nEnd; nHeight++) {
+                if (ShutdownRequested() || !CheckProofOfWork(vHeaders[nHeight].ComputeHash(), vHeaders[nHeight].nBits, params)) {
+                    return (int)nHeight;
+                }
+            }
+            return -1;
+        }));
+    }
+    int nFailedHeight = -1;
+    for (auto& f : vFutures) {
+        int nHeight = f.get();
+        if (nFailedHeight == -1) {
+            nFailedHeight = nHeight;
+        }
+    }
+    if (nFailedHeight != -1) {
+        strError = ShutdownRequested() ? "Shutdown requested" : strprintf("Proof of work failed for the header at height %d", nFailedHeight);
+        return false;
+    }
+    return true;
+}
+
+/** Erase everything from db */
+void WipeDB(CDBWrapper& db)
+{
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    CDBBatch batch(db);
+    for (pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()) {
+        batch.Erase(pcursor->GetKey());
+        if (batch.SizeEstimate() > (1 << 24)) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    db.WriteBatch(batch, true);
+}
+
+/** Everything of LoadUTXOSnapshot but the cleanup, fWritten is set once the databases were touched */
+bool LoadSnapshotData(const CChainParams& chainparams, const fs::path& path, const uint256& hashExpected, size_t nCoinDBCache, bool& fWritten, std::string& strError)
+{
+    const int64_t nStart = GetTimeMillis();
+
+    CAutoFile filein(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        strError = strprintf("Failed to open %s", path.string());
+        return false;
+    }
+
+    CCoinsViewDB coinsdb(nCoinDBCache, false, false);
+    if (!coinsdb.GetBestBlock().IsNull() || !coinsdb.GetHeadBlocks().empty() || !evoDb->IsEmpty()) {
+        strError = "The datadir already contains a chainstate, a snapshot can only be loaded into an empty datadir";
+        return false;
+    }
+
+    try {
+        SnapshotMetadata metadata;
+        filein >> metadata;
+        if (metadata.m_magic != SNAPSHOT_MAGIC || metadata.m_version != SNAPSHOT_VERSION) {
+            strError = "Unknown snapshot format";
+            return false;
+        }
+        if (memcmp(&metadata.m_network_magic, chainparams.MessageStart(), sizeof(metadata.m_network_magic)) != 0) {
+            strError = "The snapshot is for a different network";
+            return false;
+        }
+        if (metadata.m_base_height < 1) {
+            strError = "The snapshot has no blocks";
+            return false;
+        }
+
+        // Everything after the metadata is hashed while reading, the result has to match the
+        // trusted snapshot hash before the loaded data may be used
+        CHashVerifier<CAutoFile> verifier(&filein);
+
+        // Build the block index of the snapshot chain in memory, it's only written once
+        // everything else checked out
+        std::vector<uint256> vHashes(metadata.m_base_height + 1);
+        std::vector<CBlockHeader> vHeaders(metadata.m_base_height + 1);
+        std::vector<CBlockIndex> vIndex;
+        vIndex.reserve(metadata.m_base_height + 1);
+        arith_uint256 nChainWork;
+        for (int nHeight = 0; nHeight <= metadata.m_base_height; nHeight++) {
+            SnapshotHeader header;
+            verifier >> header;
+            vHeaders[nHeight] = header.header;
+            vHashes[nHeight] = header.header.GetHash();
+            if (nHeight == 0 ? vHashes[0] != chainparams.GetConsensus().hashGenesisBlock : header.header.hashPrevBlock != vHashes[nHeight - 1]) {
+                strError = strprintf("Header at height %d doesn't connect", nHeight);
+                return false;
+            }
+            if (nHeight > 0 && header.nTx == 0) {
+                strError = strprintf("Header at height %d has no transactions", nHeight);
+                return false;
+            }
+            vIndex.emplace_back(header.header);
+            CBlockIndex& index = vIndex.back();
+            index.phashBlock = &vHashes[nHeight];
+            index.pprev = nHeight > 0 ? &vIndex[nHeight - 1] : nullptr;
+            index.nHeight = nHeight;
+            index.nTx = header.nTx;
+            index.nStatus = BLOCK_VALID_SCRIPTS;
+            index.BuildSkip();
+            nChainWork += GetBlockProof(index);
+        }
+        if (vHashes.back() != metadata.m_base_blockhash) {
+            strError = "The headers don't lead to the snapshot's base block";
+            return false;
+        }
+        for (const auto& checkpoint : chainparams.Checkpoints().mapCheckpoints) {
+            if (checkpoint.first <= metadata.m_base_height && vHashes[checkpoint.first] != checkpoint.second) {
+                strError = strprintf("The headers conflict with the checkpoint at height %d", checkpoint.first);
+                return false;
+            }
+        }
+        // The same header checks as on sync, so the chain work below is real
+        for (int nHeight = 1; nHeight <= metadata.m_base_height; nHeight++) {
+            CValidationState state;
+            if (!ContextualCheckBlockHeader(vHeaders[nHeight], state, chainparams, &vIndex[nHeight - 1], GetAdjustedTime())) {
+                strError = strprintf("Header at height %d is invalid: %s", nHeight, FormatStateMessage(state));
+                return false;
+            }
+        }
+        if (!CheckSnapshotHeadersPoW(vHeaders, chainparams.GetConsensus(), strError)) {
+            return false;
+        }
+        if (nChainWork < nMinimumChainWork) {
+            strError = "The snapshot chain has less work than -minimumchainwork";
+            return false;
+        }
+
+        // Coins, checked against the muhash of the metadata once all are written
+        fWritten = true;
+        CCoinsStatsDelta stats;
+        CCoinsMap mapCoins;
+        for (uint64_t i = 0; i < metadata.m_coins_count; i++) {
+            COutPoint outpoint;
+            Coin coin;
+            verifier >> outpoint >> coin;
+            if (coin.IsSpent() || coin.nHeight > (uint32_t)metadata.m_base_height) {
+                strError = strprintf("Bad coin %s in the snapshot", outpoint.ToString());
+                return false;
+            }
+            stats.AddCoin(outpoint, coin);
+            CCoinsCacheEntry& entry = mapCoins[outpoint];
+            entry.coin = std::move(coin);
+            entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+            if (mapCoins.size() >= SNAPSHOT_LOAD_BATCH) {
+                if (!coinsdb.BatchWrite(mapCoins, metadata.m_base_blockhash)) {
+                    strError = "Failed to write to the coins database";
+                    return false;
+                }
+                if (ShutdownRequested()) {
+                    strError = "Shutdown requested";
+                    return false;
+                }
+            }
+        }
+        if (!coinsdb.BatchWrite(mapCoins, metadata.m_base_blockhash)) {
+            strError = "Failed to write to the coins database";
+            return false;
+        }
+        if (FinalizeMuHash(stats.muhash) != metadata.m_coins_muhash) {
+            strError = "The coins don't match the snapshot's muhash";
+            return false;
+        }
+        CCoinsStatsState statsState;
+        statsState.hashBlock = metadata.m_base_blockhash;
+        statsState.nHeight = metadata.m_base_height;
+        statsState.nTransactionOutputs = stats.nTransactionOutputs;
+        statsState.nBogoSize = stats.nBogoSize;
+        statsState.nTotalAmount = stats.nTotalAmount;
+        statsState.muhash = stats.muhash;
+        coinsdb.WriteCoinsStats(&statsState, {CCoinsStatsEntry(statsState)});
+
+        // The evo database as it was at the base block
+        {
+            CDBWrapper& evoRawDB = evoDb->GetRawDB();
+            CDBBatch batch(evoRawDB);
+            for (uint64_t i = 0; i < metadata.m_evo_entries_count; i++) {
+                std::vector<unsigned char> vchKey, vchValue;
+                verifier >> vchKey >> vchValue;
+                batch.Write(CDataStream(vchKey, SER_DISK, CLIENT_VERSION), CDataStream(vchValue, SER_DISK, CLIENT_VERSION));
+                if (batch.SizeEstimate() > (1 << 24)) {
+                    evoRawDB.WriteBatch(batch);
+                    batch.Clear();
+                }
+            }
+            evoRawDB.WriteBatch(batch, true);
+        }
+        if (!evoDb->VerifyBestBlock(metadata.m_base_blockhash)) {
+            strError = "The evo database of the snapshot isn't at its base block";
+            return false;
+        }
+
+        const uint256 hashSnapshot = GetSnapshotHash(metadata, verifier.GetHash());
+        if (hashSnapshot != hashExpected) {
+            strError = strprintf("The snapshot hash %s doesn't match the expected %s", hashSnapshot.ToString(), hashExpected.ToString());
+            return false;
+        }
+
+        // The block index goes last, it's what makes the datadir no longer look empty
+        std::vector<const CBlockIndex*> vBatch;
+        for (const CBlockIndex& index : vIndex) {
+            vBatch.push_back(&index);
+            if (vBatch.size() >= SNAPSHOT_LOAD_BATCH || &index == &vIndex.back()) {
+                if (!pblocktree->WriteBatchSync({}, 0, vBatch)) {
+                    strError = "Failed to write to the block index database";
+                    return false;
+                }
+                vBatch.clear();
+            }
+        }
+        // The blocks below the base are missing just like pruned ones
+        pblocktree->WriteFlag("prunedblockfiles", true);
+        pblocktree->WriteFlag("snapshotchainstate", true);
+
+        LogPrintf("%s: loaded %u coins and %u evo entries at block %s (height %d), snapshot hash %s, in %dms\n", "LoadUTXOSnapshot",
+                  metadata.m_coins_count, metadata.m_evo_entries_count, metadata.m_base_blockhash.ToString(), metadata.m_base_height,
+                  hashSnapshot.ToString(), GetTimeMillis() - nStart);
+    } catch (const std::exception& e) {
+        strError = strprintf("Failed to read the snapshot: %s", e.what());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool LoadUTXOSnapshot(const CChainParams& chainparams, const fs::path& path, const uint256& hashExpected, size_t nCoinDBCache, std::string& strError)
+{
+    AssertLockHeld(cs_main);
+    assert(mapBlockIndex.empty() && !pcoinsdbview);
+
+    bool fWritten = false;
+    if (LoadSnapshotData(chainparams, path, hashExpected, nCoinDBCache, fWritten, strError)) {
+        return true;
+    }
+    if (fWritten) {
+        // Don't leave a half loaded chainstate behind, the next start would refuse it
+        LogPrintf("%s: %s, wiping the partially loaded chainstate\n", __func__, strError);
+        {
+            CCoinsViewDB coinsdbWipe(nCoinDBCache, false, true);
+        }
+        WipeDB(evoDb->GetRawDB());
+    }
+    return false;
+}
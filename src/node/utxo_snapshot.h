@@ -0,0 +1,83 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_UTXO_SNAPSHOT_H
+#define BITCOIN_NODE_UTXO_SNAPSHOT_H
+
+#include <amount.h>
+#include <fs.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <string>
+
+class CChainParams;
+
+/**
+ * UTXO snapshots ("dumptxoutset" and -loadtxoutset) for provisioning new nodes without
+ * replaying the chain.
+ *
+ * A snapshot file holds
+ *   SnapshotMetadata
+ *   the header and transaction count of every block from the genesis block to the base block
+ *   m_coins_count (COutPoint, Coin) pairs, including the future tx fields of the coins
+ *   m_evo_entries_count raw key/value pairs of the evo database, which covers the deterministic
+ *   smartnode lists and the mined quorum commitments
+ *
+ * The snapshot hash commits to the metadata and everything after it. The loader only accepts
+ * a snapshot whose hash was supplied by the operator (-loadtxoutsethash), taken from the
+ * dumptxoutset output of a node they trust. The headers get the same checks as on sync.
+ *
+ * The loader only works on an empty datadir. It writes the block index, chainstate and evo
+ * database directly, after which the node starts at the base block as if it had validated
+ * the chain up to there. The block data below the base block is treated like pruned data and
+ * is never downloaded, there is no background validation of the history. If loading fails
+ * after the chainstate was written to, the chainstate and evo database are wiped again.
+ */
+
+static const uint32_t SNAPSHOT_MAGIC = 0x6f787472; // "rtxo"
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotMetadata {
+    uint32_t m_magic{SNAPSHOT_MAGIC};
+    uint32_t m_version{SNAPSHOT_VERSION};
+    uint32_t m_network_magic{0};  //!< the chain's message start
+    uint256 m_base_blockhash;
+    int32_t m_base_height{0};
+    uint64_t m_coins_count{0};
+    uint256 m_coins_muhash;       //!< same as the muhash reported by gettxoutsetinfo
+    CAmount m_total_amount{0};
+    uint64_t m_evo_entries_count{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(m_magic);
+        READWRITE(m_version);
+        READWRITE(m_network_magic);
+        READWRITE(m_base_blockhash);
+        READWRITE(m_base_height);
+        READWRITE(m_coins_count);
+        READWRITE(m_coins_muhash);
+        READWRITE(m_total_amount);
+        READWRITE(m_evo_entries_count);
+    }
+};
+
+/** The snapshot hash of a snapshot with the given metadata, hashContents covers the rest of the file */
+uint256 GetSnapshotHash(const SnapshotMetadata& metadata, const uint256& hashContents);
+
+/** Write a snapshot of the chain tip's UTXO set and evo database to path */
+bool DumpUTXOSnapshot(const fs::path& path, SnapshotMetadata& metadata, uint256& hashSnapshot, std::string& strError);
+
+/**
+ * Seed an empty datadir from the snapshot at path. Must be called with cs_main held, after
+ * LoadBlockIndex found no block index and before the coins database is opened; the block
+ * index has to be reloaded afterwards. Fails unless the snapshot hash is hashExpected.
+ */
+bool LoadUTXOSnapshot(const CChainParams& chainparams, const fs::path& path, const uint256& hashExpected, size_t nCoinDBCache, std::string& strError);
+
+#endif // BITCOIN_NODE_UTXO_SNAPSHOT_H
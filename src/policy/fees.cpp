@@ -13,6 +13,8 @@
 #include <util.h>
 
 static constexpr double INF_FEERATE = 1e99;
+/** Smallest accumulated decay before TxConfirmStats rescales its averages */
+static constexpr double MIN_DECAY_FACTOR = 1e-30;
 
 std::string StringForFeeEstimateHorizon(FeeEstimateHorizon horizon) {
     static const std::map<FeeEstimateHorizon, std::string> horizon_strings = {
@@ -98,6 +100,11 @@ private:
 
     double decay;
 
+    // Decay is applied lazily: the averages above are stored divided by the
+    // product of all decays since the last rescale, so processing a block
+    // only has to update this single factor instead of every bucket.
+    double decayFactor;
+
     // Resolution (# of blocks) with which confirmations are tracked
     unsigned int scale;
 
@@ -109,6 +116,8 @@ private:
     std::vector<int> oldUnconfTxs;
 
     void resizeInMemoryCounters(size_t newbuckets);
+    /** Fold decayFactor into the stored averages and reset it to 1 */
+    void ApplyDecay();
 
 public:
     /**
@@ -161,7 +170,7 @@ public:
     /** Return the max number of confirms we're tracking */
     unsigned int GetMaxConfirms() const { return scale * confAvg.size(); }
 
-    /** Write state of estimation data to a file*/
+    /** Write state of estimation data to a file, with the pending decay applied to the written averages */
     void Write(CAutoFile& fileout) const;
 
     /**
@@ -175,7 +184,7 @@ public:
 TxConfirmStats::TxConfirmStats(const std::vector<double>& defaultBuckets,
                                 const std::map<double, unsigned int>& defaultBucketMap,
                                unsigned int maxPeriods, double _decay, unsigned int _scale)
-    : buckets(defaultBuckets), bucketMap(defaultBucketMap)
+    : buckets(defaultBuckets), bucketMap(defaultBucketMap), decayFactor(1)
 {
     decay = _decay;
     assert(_scale != 0 && "_scale must be non-zero");
@@ -221,23 +230,35 @@ void TxConfirmStats::Record(int blocksToConfirm, double val)
         return;
     int periodsToConfirm = (blocksToConfirm + scale - 1)/scale;
     unsigned int bucketindex = bucketMap.lower_bound(val)->second;
+    const double weight = 1 / decayFactor;
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += weight;
     }
-    txCtAvg[bucketindex]++;
-    avg[bucketindex] += val;
+    txCtAvg[bucketindex] += weight;
+    avg[bucketindex] += val * weight;
 }
 
 void TxConfirmStats::UpdateMovingAverages()
+{
+    decayFactor *= decay;
+    // Rescale well before the stored values could lose precision or overflow.
+    // With the shortest half-life this happens roughly once every 1800 blocks.
+    if (decayFactor < MIN_DECAY_FACTOR) {
+        ApplyDecay();
+    }
+}
+
+void TxConfirmStats::ApplyDecay()
 {
     for (unsigned int j = 0; j < buckets.size(); j++) {
         for (unsigned int i = 0; i < confAvg.size(); i++)
-            confAvg[i][j] = confAvg[i][j] * decay;
+            confAvg[i][j] = confAvg[i][j] * decayFactor;
         for (unsigned int i = 0; i < failAvg.size(); i++)
-            failAvg[i][j] = failAvg[i][j] * decay;
-        avg[j] = avg[j] * decay;
-        txCtAvg[j] = txCtAvg[j] * decay;
+            failAvg[i][j] = failAvg[i][j] * decayFactor;
+        avg[j] = avg[j] * decayFactor;
+        txCtAvg[j] = txCtAvg[j] * decayFactor;
     }
+    decayFactor = 1;
 }
 
 // returns -1 on error conditions
@@ -285,9 +306,9 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * decayFactor;
+        totalNum += txCtAvg[bucket] * decayFactor;
+        failNum += failAvg[periodTarget - 1][bucket] * decayFactor;
         for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
             extraNum += unconfTxs[(nBlockHeight - confct)%bins][bucket];
         extraNum += oldUnconfTxs[bucket];
@@ -393,14 +414,34 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     return median;
 }
 
+static std::vector<double> Decayed(const std::vector<double>& v, double factor)
+{
+    std::vector<double> ret(v);
+    for (double& d : ret) {
+        d *= factor;
+    }
+    return ret;
+}
+
+static std::vector<std::vector<double>> Decayed(const std::vector<std::vector<double>>& v, double factor)
+{
+    std::vector<std::vector<double>> ret;
+    ret.reserve(v.size());
+    for (const auto& inner : v) {
+        ret.push_back(Decayed(inner, factor));
+    }
+    return ret;
+}
+
 void TxConfirmStats::Write(CAutoFile& fileout) const
 {
+    // The file format has no decay factor, write decayed copies so flushing doesn't touch the live state
     fileout << decay;
     fileout << scale;
-    fileout << avg;
-    fileout << txCtAvg;
-    fileout << confAvg;
-    fileout << failAvg;
+    fileout << Decayed(avg, decayFactor);
+    fileout << Decayed(txCtAvg, decayFactor);
+    fileout << Decayed(confAvg, decayFactor);
+    fileout << Decayed(failAvg, decayFactor);
 }
 
 void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets)
@@ -442,6 +483,7 @@ void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets
     }
 
     filein >> failAvg;
+    decayFactor = 1;
     if (maxPeriods != failAvg.size()) {
         throw std::runtime_error("Corrupt estimates file. Mismatch in confirms tracked for failures");
     }
@@ -499,7 +541,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += 1 / decayFactor;
         }
     }
 }
@@ -658,6 +700,9 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
 
     trackedTxs = 0;
     untrackedTxs = 0;
+
+    // Estimates only change meaningfully with new block data
+    mapSmartFeeCache.clear();
 }
 
 CFeeRate CBlockPolicyEstimator::estimateFee(int confTarget) const
@@ -820,6 +865,26 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
 {
     LOCK(cs_feeEstimator);
 
+    // Out of range targets are cheap to answer and must not grow the cache
+    if (confTarget <= 0 || (unsigned int)confTarget > longStats->GetMaxConfirms()) {
+        return estimateSmartFeeUncached(confTarget, feeCalc, conservative);
+    }
+
+    const auto key = std::make_pair(confTarget, conservative);
+    auto it = mapSmartFeeCache.find(key);
+    if (it == mapSmartFeeCache.end()) {
+        SmartFeeCacheEntry entry;
+        entry.feeRate = estimateSmartFeeUncached(confTarget, &entry.feeCalc, conservative);
+        it = mapSmartFeeCache.emplace(key, entry).first;
+    }
+    if (feeCalc) *feeCalc = it->second.feeCalc;
+    return it->second.feeRate;
+}
+
+CFeeRate CBlockPolicyEstimator::estimateSmartFeeUncached(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
+    AssertLockHeld(cs_feeEstimator);
+
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
@@ -971,6 +1036,7 @@ bool CBlockPolicyEstimator::Read(CAutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            mapSmartFeeCache.clear();
         }
     }
     catch (const std::exception& e) {
@@ -989,6 +1055,7 @@ void CBlockPolicyEstimator::FlushUnconfirmed() {
         auto mi = mapMemPoolTxs.begin();
         removeTx(mi->first, false); // this calls erase() on mapMemPoolTxs
     }
+    mapSmartFeeCache.clear();
     int64_t endclear = GetTimeMicros();
     LogPrint(BCLog::ESTIMATEFEE, "Recorded %u unconfirmed txs from mempool in %ld micros\n", num_entries, endclear - startclear);
 }
@@ -208,6 +208,8 @@ public:
      *  blocks. If no answer can be given at confTarget, return an estimate at
      *  the closest target where one can be given.  'conservative' estimates are
      *  valid over longer time horizons also.
+     *  Results are cached per target until the next block is processed, so
+     *  transactions entering the mempool in between are not reflected.
      */
     CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const;
 
@@ -258,9 +260,19 @@ private:
 
     mutable CCriticalSection cs_feeEstimator;
 
+    struct SmartFeeCacheEntry
+    {
+        CFeeRate feeRate;
+        FeeCalculation feeCalc;
+    };
+    /** estimateSmartFee results keyed by (confTarget, conservative) */
+    mutable std::map<std::pair<int, bool>, SmartFeeCacheEntry> mapSmartFeeCache;
+
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry);
 
+    /** estimateSmartFee without the per-target cache, requires cs_feeEstimator */
+    CFeeRate estimateSmartFeeUncached(int confTarget, FeeCalculation *feeCalc, bool conservative) const;
     /** Helper for estimateSmartFee */
     double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const;
     /** Helper for estimateSmartFee */
@@ -90,11 +90,16 @@ uint256 CTransaction::ComputeHash() const
     return SerializeHash(*this);
 }
 
+unsigned int CTransaction::ComputeTotalSize() const
+{
+    return ::GetSerializeSize(*this, SER_NETWORK, PROTOCOL_VERSION);
+}
+
 /* For backward compatibility, the hash is initialized to 0. TODO: remove the need for this default constructor entirely. */
-CTransaction::CTransaction() : nVersion(CTransaction::CURRENT_VERSION), nType(TRANSACTION_NORMAL), vin(), vout(), nLockTime(0), hash() {}
-CTransaction::CTransaction(uint16_t version, uint16_t type) : nVersion(version), nType(type), vin(), vout(), nLockTime(0), hash() {}
-CTransaction::CTransaction(const CMutableTransaction &tx) : nVersion(tx.nVersion), nType(tx.nType), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash(ComputeHash()) {}
-CTransaction::CTransaction(CMutableTransaction &&tx) : nVersion(tx.nVersion), nType(tx.nType), vin(std::move(tx.vin)), vout(std::move(tx.vout)), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash(ComputeHash()) {}
+CTransaction::CTransaction() : nVersion(CTransaction::CURRENT_VERSION), nType(TRANSACTION_NORMAL), vin(), vout(), nLockTime(0), hash(), nTotalSize(ComputeTotalSize()) {}
+CTransaction::CTransaction(uint16_t version, uint16_t type) : nVersion(version), nType(type), vin(), vout(), nLockTime(0), hash(), nTotalSize(ComputeTotalSize()) {}
+CTransaction::CTransaction(const CMutableTransaction &tx) : nVersion(tx.nVersion), nType(tx.nType), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash(ComputeHash()), nTotalSize(ComputeTotalSize()) {}
+CTransaction::CTransaction(CMutableTransaction &&tx) : nVersion(tx.nVersion), nType(tx.nType), vin(std::move(tx.vin)), vout(std::move(tx.vout)), nLockTime(tx.nLockTime), vExtraPayload(tx.vExtraPayload), hash(ComputeHash()), nTotalSize(ComputeTotalSize()) {}
 
 CAmount CTransaction::GetValueOut() const
 {
@@ -107,11 +112,6 @@ CAmount CTransaction::GetValueOut() const
     return nValueOut;
 }
 
-unsigned int CTransaction::GetTotalSize() const
-{
-    return ::GetSerializeSize(*this, SER_NETWORK, PROTOCOL_VERSION);
-}
-
 std::string CTransaction::ToString() const
 {
     std::string str;
@@ -220,8 +220,10 @@ public:
 private:
     /** Memory only. */
     const uint256 hash;
+    const unsigned int nTotalSize;
 
     uint256 ComputeHash() const;
+    unsigned int ComputeTotalSize() const;
 
 public:
     /** Construct a CTransaction that qualifies as IsNull() */
@@ -264,9 +266,12 @@ public:
     /**
      * Get the total transaction size in bytes, including witness data.
      * "Total Size" defined in BIP141 and BIP144.
+     * Computed once on construction, like the hash.
      * @return Total transaction size in bytes
      */
-    unsigned int GetTotalSize() const;
+    unsigned int GetTotalSize() const {
+        return nTotalSize;
+    }
 
     bool IsCoinBase() const
     {
@@ -30,6 +30,8 @@
 static const char DEFAULT_RPCCONNECT[] = "127.0.0.1";
 static const int DEFAULT_HTTP_CLIENT_TIMEOUT=900;
 static const bool DEFAULT_NAMED=false;
+static const int DEFAULT_BATCH_SIZE=1;
+static const int DEFAULT_BATCH_CONNECTIONS=1;
 static const int CONTINUE_EXECUTION=-1;
 
 static void SetupCliArgs()
@@ -50,6 +52,9 @@ static void SetupCliArgs()
     gArgs.AddArg("-rpcwait", "Wait for RPC server to start", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-rpcwallet=<walletname>", "Send RPC for non-default wallet on RPC server (needs to exactly match corresponding -wallet option passed to raptoreumd)", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-stdin", "Read extra arguments from standard input, one per line until EOF/Ctrl-D (recommended for sensitive information such as passphrases).  When combined with -stdinrpcpass, the first line from standard input is used for the RPC password.", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-stdinbatch", "Read commands from standard input, one per line with the arguments separated by whitespace (quote arguments containing whitespace), until EOF/Ctrl-D. They are sent over persistent connections and every reply is written to standard output as a single line JSON-RPC reply object as soon as it arrives, with the line number of the command as id", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-stdinbatchconnections=<n>", strprintf("Number of connections -stdinbatch spreads the commands over. With more than one, replies can arrive out of order (default: %d)", DEFAULT_BATCH_CONNECTIONS), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-stdinbatchsize=<n>", strprintf("Number of -stdinbatch commands sent together as one JSON-RPC batch request (default: %d)", DEFAULT_BATCH_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-stdinrpcpass", strprintf("Read RPC password from standard input as a single line.  When combined with -stdin, the first line from standard input is used for the RPC password."), false, OptionsCategory::OPTIONS);
 
     SetupChainParamsBaseOptions();
@@ -98,7 +103,8 @@ static int AppInitRPC(int argc, char* argv[])
                   "  raptoreum-cli [options] <command> [params]  " + strprintf("Send command to %s", PACKAGE_NAME) + "\n" +
                   "  raptoreum-cli [options] -named <command> [name=value] ... " + strprintf("Send command to %s (with named arguments)", PACKAGE_NAME) + "\n" +
                   "  raptoreum-cli [options] help                List commands\n" +
-                  "  raptoreum-cli [options] help <command>      Get help for a command\n";
+                  "  raptoreum-cli [options] help <command>      Get help for a command\n" +
+                  "  raptoreum-cli [options] -stdinbatch         " + strprintf("Send the commands read from standard input to %s", PACKAGE_NAME) + "\n";
 
             strUsage += "\n" + gArgs.GetHelpMessage();
         }
@@ -285,13 +291,15 @@ class DefaultRequestHandler: public BaseRequestHandler {
 public:
     UniValue PrepareRequest(const std::string& method, const std::vector<std::string>& args) override
     {
-        UniValue params;
+        return JSONRPCRequestObj(method, ConvertParams(method, args), 1);
+    }
+
+    static UniValue ConvertParams(const std::string& method, const std::vector<std::string>& args)
+    {
         if(gArgs.GetBoolArg("-named", DEFAULT_NAMED)) {
-            params = RPCConvertNamedValues(method, args);
-        } else {
-            params = RPCConvertValues(method, args);
+            return RPCConvertNamedValues(method, args);
         }
-        return JSONRPCRequestObj(method, params, 1);
+        return RPCConvertValues(method, args);
     }
 
     UniValue ProcessReply(const UniValue &reply) override
@@ -300,57 +308,31 @@ public:
     }
 };
 
-static UniValue CallRPC(BaseRequestHandler *rh, const std::string& strMethod, const std::vector<std::string>& args)
+static void GetRPCHostPort(std::string& host, int& port)
 {
-    std::string host;
     // In preference order, we choose the following for the port:
     //     1. -rpcport
     //     2. port in -rpcconnect (ie following : in ipv4 or ]: in ipv6)
     //     3. default port for chain
-    int port = BaseParams().RPCPort();
+    port = BaseParams().RPCPort();
     SplitHostPort(gArgs.GetArg("-rpcconnect", DEFAULT_RPCCONNECT), port, host);
     port = gArgs.GetArg("-rpcport", port);
+}
 
-    // Obtain event base
-    raii_event_base base = obtain_event_base();
-
-    // Synchronously look up hostname
-    raii_evhttp_connection evcon = obtain_evhttp_connection_base(base.get(), host, port);
-    evhttp_connection_set_timeout(evcon.get(), gArgs.GetArg("-rpcclienttimeout", DEFAULT_HTTP_CLIENT_TIMEOUT));
-
-    HTTPReply response;
-    raii_evhttp_request req = obtain_evhttp_request(http_request_done, (void*)&response);
-    if (req == nullptr)
-        throw std::runtime_error("create http request failed");
-#if LIBEVENT_VERSION_NUMBER >= 0x02010300
-    evhttp_request_set_error_cb(req.get(), http_error_cb);
-#endif
-
-    // Get credentials
-    std::string strRPCUserColonPass;
-    bool failedToGetAuthCookie = false;
+/** Get the credentials, returns false if there is no password and no auth cookie either */
+static bool GetRPCUserColonPass(std::string& strRPCUserColonPass)
+{
     if (gArgs.GetArg("-rpcpassword", "") == "") {
         // Try fall back to cookie-based authentication if no password is provided
-        if (!GetAuthCookie(&strRPCUserColonPass)) {
-            failedToGetAuthCookie = true;
-        }
-    } else {
-        strRPCUserColonPass = gArgs.GetArg("-rpcuser", "") + ":" + gArgs.GetArg("-rpcpassword", "");
+        return GetAuthCookie(&strRPCUserColonPass);
     }
+    strRPCUserColonPass = gArgs.GetArg("-rpcuser", "") + ":" + gArgs.GetArg("-rpcpassword", "");
+    return true;
+}
 
-    struct evkeyvalq* output_headers = evhttp_request_get_output_headers(req.get());
-    assert(output_headers);
-    evhttp_add_header(output_headers, "Host", host.c_str());
-    evhttp_add_header(output_headers, "Connection", "close");
-    evhttp_add_header(output_headers, "Authorization", (std::string("Basic ") + EncodeBase64(strRPCUserColonPass)).c_str());
-
-    // Attach request data
-    std::string strRequest = rh->PrepareRequest(strMethod, args).write() + "\n";
-    struct evbuffer* output_buffer = evhttp_request_get_output_buffer(req.get());
-    assert(output_buffer);
-    evbuffer_add(output_buffer, strRequest.data(), strRequest.size());
-
-    // check if we should use a special wallet endpoint
+/** Check if we should use a special wallet endpoint */
+static std::string GetRPCEndpoint()
+{
     std::string endpoint = "/";
     if (!gArgs.GetArgs("-rpcwallet").empty()) {
         std::string walletName = gArgs.GetArg("-rpcwallet", "");
@@ -363,14 +345,12 @@ static UniValue CallRPC(BaseRequestHandler *rh, const std::string& strMethod, co
             throw CConnectionFailed("uri-encode failed");
         }
     }
-    int r = evhttp_make_request(evcon.get(), req.get(), EVHTTP_REQ_POST, endpoint.c_str());
-    req.release(); // ownership moved to evcon in above call
-    if (r != 0) {
-        throw CConnectionFailed("send http request failed");
-    }
-
-    event_base_dispatch(base.get());
+    return endpoint;
+}
 
+/** Throw for replies that don't carry a JSON-RPC reply, otherwise return the parsed body */
+static UniValue ParseHTTPReply(const HTTPReply& response, const std::string& host, int port, bool failedToGetAuthCookie)
+{
     if (response.status == 0) {
         std::string responseErrorMessage;
         if (response.error != -1) {
@@ -390,10 +370,60 @@ static UniValue CallRPC(BaseRequestHandler *rh, const std::string& strMethod, co
     else if (response.body.empty())
         throw std::runtime_error("no response from server");
 
-    // Parse reply
     UniValue valReply(UniValue::VSTR);
     if (!valReply.read(response.body))
         throw std::runtime_error("couldn't parse reply from server");
+    return valReply;
+}
+
+static UniValue CallRPC(BaseRequestHandler *rh, const std::string& strMethod, const std::vector<std::string>& args)
+{
+    std::string host;
+    int port;
+    GetRPCHostPort(host, port);
+
+    // Obtain event base
+    raii_event_base base = obtain_event_base();
+
+    // Synchronously look up hostname
+    raii_evhttp_connection evcon = obtain_evhttp_connection_base(base.get(), host, port);
+    evhttp_connection_set_timeout(evcon.get(), gArgs.GetArg("-rpcclienttimeout", DEFAULT_HTTP_CLIENT_TIMEOUT));
+
+    HTTPReply response;
+    raii_evhttp_request req = obtain_evhttp_request(http_request_done, (void*)&response);
+    if (req == nullptr)
+        throw std::runtime_error("create http request failed");
+#if LIBEVENT_VERSION_NUMBER >= 0x02010300
+    evhttp_request_set_error_cb(req.get(), http_error_cb);
+#endif
+
+    // Get credentials
+    std::string strRPCUserColonPass;
+    bool failedToGetAuthCookie = !GetRPCUserColonPass(strRPCUserColonPass);
+
+    struct evkeyvalq* output_headers = evhttp_request_get_output_headers(req.get());
+    assert(output_headers);
+    evhttp_add_header(output_headers, "Host", host.c_str());
+    evhttp_add_header(output_headers, "Connection", "close");
+    evhttp_add_header(output_headers, "Authorization", (std::string("Basic ") + EncodeBase64(strRPCUserColonPass)).c_str());
+
+    // Attach request data
+    std::string strRequest = rh->PrepareRequest(strMethod, args).write() + "\n";
+    struct evbuffer* output_buffer = evhttp_request_get_output_buffer(req.get());
+    assert(output_buffer);
+    evbuffer_add(output_buffer, strRequest.data(), strRequest.size());
+
+    std::string endpoint = GetRPCEndpoint();
+    int r = evhttp_make_request(evcon.get(), req.get(), EVHTTP_REQ_POST, endpoint.c_str());
+    req.release(); // ownership moved to evcon in above call
+    if (r != 0) {
+        throw CConnectionFailed("send http request failed");
+    }
+
+    event_base_dispatch(base.get());
+
+    // Parse reply
+    UniValue valReply = ParseHTTPReply(response, host, port, failedToGetAuthCookie);
     const UniValue reply = rh->ProcessReply(valReply);
     if (reply.empty())
         throw std::runtime_error("expected reply to have result, error and id properties");
@@ -401,6 +431,211 @@ static UniValue CallRPC(BaseRequestHandler *rh, const std::string& strMethod, co
     return reply;
 }
 
+/** Split a -stdinbatch line into arguments, honouring single and double quotes and backslash escapes */
+static std::vector<std::string> SplitBatchLine(const std::string& line)
+{
+    std::vector<std::string> args;
+    std::string arg;
+    bool fInArg = false;
+    char chQuote = 0;
+    for (size_t i = 0; i < line.size(); i++) {
+        char ch = line[i];
+        if (ch == '\\' && chQuote != '\'' && i + 1 < line.size()) {
+            arg += line[++i];
+            fInArg = true;
+        } else if (chQuote) {
+            if (ch == chQuote) {
+                chQuote = 0;
+            } else {
+                arg += ch;
+            }
+        } else if (ch == '"' || ch == '\'') {
+            chQuote = ch;
+            fInArg = true;
+        } else if (isspace((unsigned char)ch)) {
+            if (fInArg) {
+                args.push_back(arg);
+                arg.clear();
+                fInArg = false;
+            }
+        } else {
+            arg += ch;
+            fInArg = true;
+        }
+    }
+    if (chQuote) {
+        throw std::runtime_error("unterminated quote");
+    }
+    if (fInArg) {
+        args.push_back(arg);
+    }
+    return args;
+}
+
+/**
+ * Sends the commands read from standard input over a few keep-alive connections, one
+ * (batch) request per connection at a time, and writes the replies out as they arrive.
+ */
+class BatchRPCClient
+{
+private:
+    struct PendingRequest {
+        BatchRPCClient* client;
+        size_t nConnection;
+        HTTPReply reply;
+    };
+
+    std::istream& input;
+    std::string host;
+    int port;
+    std::string strAuthorization;
+    bool failedToGetAuthCookie;
+    std::string endpoint;
+    size_t nBatchSize;
+
+    raii_event_base base;
+    std::vector<raii_evhttp_connection> vConnections;
+
+    int nLine{0};
+    size_t nInFlight{0};
+    bool fErrors{false};
+    std::string strFatalError;
+
+    static void RequestDone(struct evhttp_request* req, void* ctx)
+    {
+        PendingRequest* pending = static_cast<PendingRequest*>(ctx);
+        http_request_done(req, &pending->reply);
+        pending->client->HandleReply(*pending);
+        delete pending;
+    }
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010300
+    static void RequestError(enum evhttp_request_error err, void* ctx)
+    {
+        static_cast<PendingRequest*>(ctx)->reply.error = err;
+    }
+#endif
+
+    void WriteReply(const UniValue& reply)
+    {
+        if (!reply["error"].isNull()) {
+            fErrors = true;
+        }
+        std::string strReply = reply.write() + "\n";
+        fwrite(strReply.data(), 1, strReply.size(), stdout);
+        fflush(stdout);
+    }
+
+    /** Send the next commands over the given connection, returns false once the input is exhausted */
+    bool SendNext(size_t nConnection)
+    {
+        UniValue batch(UniValue::VARR);
+        std::string line;
+        while (batch.size() < nBatchSize && std::getline(input, line)) {
+            nLine++;
+            try {
+                std::vector<std::string> args = SplitBatchLine(line);
+                if (args.empty()) {
+                    continue;
+                }
+                const std::string method = args[0];
+                args.erase(args.begin());
+                batch.push_back(JSONRPCRequestObj(method, DefaultRequestHandler::ConvertParams(method, args), nLine));
+            } catch (const std::exception& e) {
+                // Bad commands are answered locally, in the same format as the server's errors
+                WriteReply(JSONRPCReplyObj(NullUniValue, JSONRPCError(RPC_PARSE_ERROR, e.what()), nLine));
+            }
+        }
+        if (batch.empty()) {
+            return false;
+        }
+
+        PendingRequest* pending = new PendingRequest{this, nConnection, HTTPReply()};
+        raii_evhttp_request req = obtain_evhttp_request(RequestDone, (void*)pending);
+        if (req == nullptr) {
+            delete pending;
+            throw std::runtime_error("create http request failed");
+        }
+#if LIBEVENT_VERSION_NUMBER >= 0x02010300
+        evhttp_request_set_error_cb(req.get(), RequestError);
+#endif
+        struct evkeyvalq* output_headers = evhttp_request_get_output_headers(req.get());
+        assert(output_headers);
+        evhttp_add_header(output_headers, "Host", host.c_str());
+        evhttp_add_header(output_headers, "Authorization", strAuthorization.c_str());
+
+        // A batch of one is sent as a plain request
+        std::string strRequest = (batch.size() == 1 ? batch[0] : batch).write() + "\n";
+        struct evbuffer* output_buffer = evhttp_request_get_output_buffer(req.get());
+        assert(output_buffer);
+        evbuffer_add(output_buffer, strRequest.data(), strRequest.size());
+
+        int r = evhttp_make_request(vConnections[nConnection].get(), req.get(), EVHTTP_REQ_POST, endpoint.c_str());
+        req.release(); // ownership moved to evcon in above call
+        if (r != 0) {
+            throw CConnectionFailed("send http request failed");
+        }
+        nInFlight++;
+        return true;
+    }
+
+    void HandleReply(const PendingRequest& pending)
+    {
+        nInFlight--;
+        try {
+            UniValue valReply = ParseHTTPReply(pending.reply, host, port, failedToGetAuthCookie);
+            if (valReply.isArray()) {
+                for (size_t i = 0; i < valReply.size(); i++) {
+                    WriteReply(valReply[i]);
+                }
+            } else {
+                WriteReply(valReply);
+            }
+            SendNext(pending.nConnection);
+        } catch (const std::exception& e) {
+            strFatalError = e.what();
+        }
+        // The keep-alive connections would keep the event loop running forever
+        if (nInFlight == 0 || !strFatalError.empty()) {
+            event_base_loopbreak(base.get());
+        }
+    }
+
+public:
+    BatchRPCClient(std::istream& inputIn) : input(inputIn), base(obtain_event_base())
+    {
+        GetRPCHostPort(host, port);
+        std::string strRPCUserColonPass;
+        failedToGetAuthCookie = !GetRPCUserColonPass(strRPCUserColonPass);
+        strAuthorization = std::string("Basic ") + EncodeBase64(strRPCUserColonPass);
+        endpoint = GetRPCEndpoint();
+        nBatchSize = std::max<int64_t>(1, gArgs.GetArg("-stdinbatchsize", DEFAULT_BATCH_SIZE));
+
+        const int64_t nConnections = std::max<int64_t>(1, gArgs.GetArg("-stdinbatchconnections", DEFAULT_BATCH_CONNECTIONS));
+        for (int64_t i = 0; i < nConnections; i++) {
+            vConnections.push_back(obtain_evhttp_connection_base(base.get(), host, port));
+            evhttp_connection_set_timeout(vConnections.back().get(), gArgs.GetArg("-rpcclienttimeout", DEFAULT_HTTP_CLIENT_TIMEOUT));
+        }
+    }
+
+    /** Run until the input is exhausted, returns false if any command failed */
+    bool Run()
+    {
+        for (size_t i = 0; i < vConnections.size(); i++) {
+            if (!SendNext(i)) {
+                break;
+            }
+        }
+        if (nInFlight > 0) {
+            event_base_dispatch(base.get());
+        }
+        if (!strFatalError.empty()) {
+            throw std::runtime_error(strFatalError);
+        }
+        return !fErrors;
+    }
+};
+
 int CommandLineRPC(int argc, char *argv[])
 {
     std::string strPrint;
@@ -419,6 +654,12 @@ int CommandLineRPC(int argc, char *argv[])
             gArgs.ForceSetArg("-rpcpassword", rpcPass);
         }
         std::vector<std::string> args = std::vector<std::string>(&argv[1], &argv[argc]);
+        if (gArgs.GetBoolArg("-stdinbatch", false)) {
+            if (!args.empty() || gArgs.GetBoolArg("-stdin", false) || gArgs.GetBoolArg("-getinfo", false)) {
+                throw std::runtime_error("-stdinbatch takes the commands from standard input only");
+            }
+            return BatchRPCClient(std::cin).Run() ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
         if (gArgs.GetBoolArg("-stdin", false)) {
             // Read one arg per line from stdin and append
             std::string line;
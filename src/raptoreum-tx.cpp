@@ -10,6 +10,9 @@
 #include <coins.h>
 #include <consensus/consensus.h>
 #include <core_io.h>
+#include <evo/providertx.h>
+#include <evo/specialtx.h>
+#include <hash.h>
 #include <key_io.h>
 #include <keystore.h>
 #include <policy/policy.h>
@@ -23,6 +26,7 @@
 #include <future/utils.h>
 
 #include <memory>
+#include <set>
 #include <stdio.h>
 
 #include <boost/algorithm/string.hpp>
@@ -38,6 +42,9 @@ static void SetupBitcoinTxArgs()
     gArgs.AddArg("-?", "This help message", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-create", "Create new, empty TX.", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-json", "Select JSON output", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-bulk=<file>", "Build all transactions of the JSON or CSV template in <file> (\"-\" for stdin) and write one transaction per line. "
+        "Commands are ignored in this mode.", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-bulkkeys=<file>", "Sign the -bulk transactions with the private keys in <file>, one per line or as a JSON array", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-txid", "Output only the hex-encoded transaction id of the resultant transaction.", false, OptionsCategory::OPTIONS);
     SetupChainParamsBaseOptions();
 
@@ -98,6 +105,7 @@ static int AppInitRawTx(int argc, char* argv[])
             "Usage:\n"
               "  raptoreum-tx [options] <hex-tx> [commands]  Update hex-encoded raptoreum transaction\n" +
               "  raptoreum-tx [options] -create [commands]   Create hex-encoded raptoreum transaction\n" +
+              "  raptoreum-tx [options] -bulk=<file>         Create hex-encoded raptoreum transactions from a template\n" +
               "\n";
         strUsage += gArgs.GetHelpMessage();
 
@@ -138,18 +146,8 @@ static void RegisterSet(const std::string& strInput)
     RegisterSetJson(key, valStr);
 }
 
-static void RegisterLoad(const std::string& strInput)
+static std::string ReadFileContents(const std::string& filename)
 {
-    // separate NAME:FILENAME in string
-    size_t pos = strInput.find(':');
-    if ((pos == std::string::npos) ||
-        (pos == 0) ||
-        (pos == (strInput.size() - 1)))
-        throw std::runtime_error("Register load requires NAME:FILENAME");
-
-    std::string key = strInput.substr(0, pos);
-    std::string filename = strInput.substr(pos + 1, std::string::npos);
-
     FILE *f = fopen(filename.c_str(), "r");
     if (!f) {
         std::string strErr = "Cannot open file " + filename;
@@ -175,8 +173,23 @@ static void RegisterLoad(const std::string& strInput)
         throw std::runtime_error(strErr);
     }
 
+    return valStr;
+}
+
+static void RegisterLoad(const std::string& strInput)
+{
+    // separate NAME:FILENAME in string
+    size_t pos = strInput.find(':');
+    if ((pos == std::string::npos) ||
+        (pos == 0) ||
+        (pos == (strInput.size() - 1)))
+        throw std::runtime_error("Register load requires NAME:FILENAME");
+
+    std::string key = strInput.substr(0, pos);
+    std::string filename = strInput.substr(pos + 1, std::string::npos);
+
     // evaluate as JSON buffer register
-    RegisterSetJson(key, valStr);
+    RegisterSetJson(key, ReadFileContents(filename));
 }
 
 static CAmount ExtractAndValidateValue(const std::string& strValue)
@@ -492,96 +505,65 @@ static CAmount AmountFromValue(const UniValue& value)
     return amount;
 }
 
-static void MutateTxSign(CMutableTransaction& tx, const std::string& flagStr)
+static void AddPrevTxCoin(const UniValue& prevOut, const CMutableTransaction& tx, CCoinsViewCache& view, CBasicKeyStore& keystore)
 {
-    int nHashType = SIGHASH_ALL;
+    if (!prevOut.isObject())
+        throw std::runtime_error("expected prevtxs internal object");
 
-    if (flagStr.size() > 0)
-        if (!findSighashFlags(nHashType, flagStr))
-            throw std::runtime_error("unknown sighash flag/sign option");
+    std::map<std::string, UniValue::VType> types = {
+        {"txid", UniValue::VSTR},
+        {"vout", UniValue::VNUM},
+        {"scriptPubKey", UniValue::VSTR},
+    };
+    if (!prevOut.checkObject(types))
+        throw std::runtime_error("prevtxs internal object typecheck fail");
 
-    // mergedTx will end up with all the signatures; it
-    // starts as a clone of the raw tx:
-    CMutableTransaction mergedTx{tx};
-    const CTransaction txv{tx};
-    CCoinsView viewDummy;
-    CCoinsViewCache view(&viewDummy);
+    uint256 txid = ParseHashStr(prevOut["txid"].get_str(), "txid");
 
-    if (!registers.count("privatekeys"))
-        throw std::runtime_error("privatekeys register variable must be set.");
-    CBasicKeyStore tempKeystore;
-    UniValue keysObj = registers["privatekeys"];
+    const int nOut = prevOut["vout"].get_int();
+    if (nOut < 0)
+        throw std::runtime_error("vout must be positive");
 
-    for (unsigned int kidx = 0; kidx < keysObj.size(); kidx++) {
-        if (!keysObj[kidx].isStr())
-            throw std::runtime_error("privatekey not a std::string");
-        CKey key = DecodeSecret(keysObj[kidx].getValStr());
-        if (!key.IsValid()) {
-            throw std::runtime_error("privatekey not valid");
-        }
-        tempKeystore.AddKey(key);
-    }
+    COutPoint out(txid, nOut);
+    std::vector<unsigned char> pkData(ParseHexUV(prevOut["scriptPubKey"], "scriptPubKey"));
+    CScript scriptPubKey(pkData.begin(), pkData.end());
 
-    // Add previous txouts given in the RPC call:
-    if (!registers.count("prevtxs"))
-        throw std::runtime_error("prevtxs register variable must be set.");
-    UniValue prevtxsObj = registers["prevtxs"];
     {
-        for (unsigned int previdx = 0; previdx < prevtxsObj.size(); previdx++) {
-            UniValue prevOut = prevtxsObj[previdx];
-            if (!prevOut.isObject())
-                throw std::runtime_error("expected prevtxs internal object");
-
-            std::map<std::string, UniValue::VType> types = {
-                {"txid", UniValue::VSTR},
-                {"vout", UniValue::VNUM},
-                {"scriptPubKey", UniValue::VSTR},
-            };
-            if (!prevOut.checkObject(types))
-                throw std::runtime_error("prevtxs internal object typecheck fail");
-
-            uint256 txid = ParseHashStr(prevOut["txid"].get_str(), "txid");
-
-            const int nOut = prevOut["vout"].get_int();
-            if (nOut < 0)
-                throw std::runtime_error("vout must be positive");
-
-            COutPoint out(txid, nOut);
-            std::vector<unsigned char> pkData(ParseHexUV(prevOut["scriptPubKey"], "scriptPubKey"));
-            CScript scriptPubKey(pkData.begin(), pkData.end());
-
-            {
-                const Coin& coin = view.AccessCoin(out);
-                if (!coin.IsSpent() && coin.out.scriptPubKey != scriptPubKey) {
-                    std::string err("Previous output scriptPubKey mismatch:\n");
-                    err = err + ScriptToAsmStr(coin.out.scriptPubKey) + "\nvs:\n"+
-                        ScriptToAsmStr(scriptPubKey);
-                    throw std::runtime_error(err);
-                }
-                Coin newcoin;
-                newcoin.out.scriptPubKey = scriptPubKey;
-                newcoin.out.nValue = 0; // we don't know the actual output value
-                if (prevOut.exists("amount")) {
-                    newcoin.out.nValue = AmountFromValue(prevOut["amount"]);
-                }
-                newcoin.nHeight = 1;
-                maybeSetPayload(newcoin, out, tx.nType, tx.vExtraPayload);
-                view.AddCoin(out, std::move(newcoin), true);
-            }
-
-            // if redeemScript given and private keys given,
-            // add redeemScript to the tempKeystore so it can be signed:
-            if (scriptPubKey.IsPayToScriptHash() &&
-                prevOut.exists("redeemScript")) {
-                UniValue v = prevOut["redeemScript"];
-                std::vector<unsigned char> rsData(ParseHexUV(v, "redeemScript"));
-                CScript redeemScript(rsData.begin(), rsData.end());
-                tempKeystore.AddCScript(redeemScript);
-            }
+        const Coin& coin = view.AccessCoin(out);
+        if (!coin.IsSpent() && coin.out.scriptPubKey != scriptPubKey) {
+            std::string err("Previous output scriptPubKey mismatch:\n");
+            err = err + ScriptToAsmStr(coin.out.scriptPubKey) + "\nvs:\n"+
+                ScriptToAsmStr(scriptPubKey);
+            throw std::runtime_error(err);
+        }
+        Coin newcoin;
+        newcoin.out.scriptPubKey = scriptPubKey;
+        newcoin.out.nValue = 0; // we don't know the actual output value
+        if (prevOut.exists("amount")) {
+            newcoin.out.nValue = AmountFromValue(prevOut["amount"]);
         }
+        newcoin.nHeight = 1;
+        maybeSetPayload(newcoin, out, tx.nType, tx.vExtraPayload);
+        view.AddCoin(out, std::move(newcoin), true);
     }
 
-    const CKeyStore& keystore = tempKeystore;
+    // if redeemScript given and private keys given,
+    // add redeemScript to the keystore so it can be signed:
+    if (scriptPubKey.IsPayToScriptHash() &&
+        prevOut.exists("redeemScript")) {
+        UniValue v = prevOut["redeemScript"];
+        std::vector<unsigned char> rsData(ParseHexUV(v, "redeemScript"));
+        CScript redeemScript(rsData.begin(), rsData.end());
+        keystore.AddCScript(redeemScript);
+    }
+}
+
+static void SignTxInputs(CMutableTransaction& tx, const CKeyStore& keystore, CCoinsViewCache& view, int nHashType)
+{
+    // mergedTx will end up with all the signatures; it
+    // starts as a clone of the raw tx:
+    CMutableTransaction mergedTx{tx};
+    const CTransaction txv{tx};
 
     bool fHashSingle = ((nHashType & ~SIGHASH_ANYONECANPAY) == SIGHASH_SINGLE);
 
@@ -605,7 +587,44 @@ static void MutateTxSign(CMutableTransaction& tx, const std::string& flagStr)
         UpdateTransaction(mergedTx, i, sigdata);
     }
 
-    tx = mergedTx;
+    tx = std::move(mergedTx);
+}
+
+static void MutateTxSign(CMutableTransaction& tx, const std::string& flagStr)
+{
+    int nHashType = SIGHASH_ALL;
+
+    if (flagStr.size() > 0)
+        if (!findSighashFlags(nHashType, flagStr))
+            throw std::runtime_error("unknown sighash flag/sign option");
+
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+
+    if (!registers.count("privatekeys"))
+        throw std::runtime_error("privatekeys register variable must be set.");
+    CBasicKeyStore tempKeystore;
+    UniValue keysObj = registers["privatekeys"];
+
+    for (unsigned int kidx = 0; kidx < keysObj.size(); kidx++) {
+        if (!keysObj[kidx].isStr())
+            throw std::runtime_error("privatekey not a std::string");
+        CKey key = DecodeSecret(keysObj[kidx].getValStr());
+        if (!key.IsValid()) {
+            throw std::runtime_error("privatekey not valid");
+        }
+        tempKeystore.AddKey(key);
+    }
+
+    // Add previous txouts given in the RPC call:
+    if (!registers.count("prevtxs"))
+        throw std::runtime_error("prevtxs register variable must be set.");
+    UniValue prevtxsObj = registers["prevtxs"];
+    for (unsigned int previdx = 0; previdx < prevtxsObj.size(); previdx++) {
+        AddPrevTxCoin(prevtxsObj[previdx], tx, view, tempKeystore);
+    }
+
+    SignTxInputs(tx, tempKeystore, view, nHashType);
 }
 
 class Secp256k1Init
@@ -719,6 +738,356 @@ static std::string readStdin()
     return ret;
 }
 
+//
+// Bulk mode: -bulk=FILE builds every transaction of a template in one run
+//
+
+struct BulkContext {
+    CCoinsView viewDummy;
+    CCoinsViewCache view{&viewDummy};
+    CBasicKeyStore keystore;
+    bool fSign{false};
+    std::set<COutPoint> setAmountKnown;
+    std::set<COutPoint> setSpent;
+};
+
+static void LoadBulkKeys(const std::string& filename, CBasicKeyStore& keystore)
+{
+    std::string strKeys = ReadFileContents(filename);
+    boost::algorithm::trim(strKeys);
+
+    // Either a JSON array like the privatekeys register, or one key per line
+    std::vector<std::string> vKeys;
+    if (!strKeys.empty() && strKeys[0] == '[') {
+        UniValue keysObj;
+        if (!keysObj.read(strKeys) || !keysObj.isArray())
+            throw std::runtime_error("Cannot parse JSON in " + filename);
+        for (unsigned int kidx = 0; kidx < keysObj.size(); kidx++) {
+            if (!keysObj[kidx].isStr())
+                throw std::runtime_error("privatekey not a std::string");
+            vKeys.push_back(keysObj[kidx].get_str());
+        }
+    } else {
+        boost::split(vKeys, strKeys, boost::is_any_of("\n"));
+    }
+
+    for (std::string& strKey : vKeys) {
+        boost::algorithm::trim(strKey);
+        if (strKey.empty() || strKey[0] == '#')
+            continue;
+        CKey key = DecodeSecret(strKey);
+        if (!key.IsValid())
+            throw std::runtime_error("privatekey not valid");
+        keystore.AddKey(key);
+    }
+}
+
+/**
+ * Convert a CSV template to the JSON transaction list. Every line is one record, the
+ * LABEL column groups records into transactions, which keep the order their labels first
+ * appear in:
+ *   tx,LABEL,LOCKTIME[,FUTURE_FEE]
+ *   in,LABEL,TXID,VOUT[,SCRIPTPUBKEY,AMOUNT[,SEQUENCE]]
+ *   out,LABEL,ADDRESS,AMOUNT[,FUTURE_MATURITY,FUTURE_LOCKTIME]
+ *   data,LABEL,HEX
+ * A transaction with a future output needs a tx record with FUTURE_FEE.
+ * Empty lines and lines starting with '#' are skipped.
+ */
+static UniValue ParseBulkCSV(const std::string& strCSV)
+{
+    struct CSVTx {
+        UniValue tx{UniValue::VOBJ};
+        UniValue inputs{UniValue::VARR};
+        UniValue outputs{UniValue::VARR};
+    };
+    std::vector<CSVTx> vecTxs;
+    std::map<std::string, size_t> mapLabels;
+
+    std::vector<std::string> vLines;
+    boost::split(vLines, strCSV, boost::is_any_of("\n"));
+    for (size_t nLine = 0; nLine < vLines.size(); nLine++) {
+        std::string strLine = vLines[nLine];
+        boost::algorithm::trim(strLine);
+        if (strLine.empty() || strLine[0] == '#')
+            continue;
+
+        std::vector<std::string> vFields;
+        boost::split(vFields, strLine, boost::is_any_of(","));
+        for (std::string& strField : vFields) {
+            boost::algorithm::trim(strField);
+        }
+        auto fieldSet = [&](size_t i) { return vFields.size() > i && !vFields[i].empty(); };
+        auto parseInt = [&](size_t i) {
+            int64_t n;
+            if (!ParseInt64(vFields[i], &n) || n < 0 || n > 0xffffffffLL)
+                throw std::runtime_error(strprintf("line %u: invalid number '%s'", nLine + 1, vFields[i]));
+            return n;
+        };
+        if (vFields.size() < 3)
+            throw std::runtime_error(strprintf("line %u: too few fields", nLine + 1));
+
+        auto it = mapLabels.emplace(vFields[1], vecTxs.size()).first;
+        if (it->second == vecTxs.size())
+            vecTxs.emplace_back();
+        CSVTx& csvTx = vecTxs[it->second];
+
+        const std::string& strType = vFields[0];
+        if (strType == "tx") {
+            csvTx.tx.pushKV("locktime", parseInt(2));
+            if (fieldSet(3))
+                csvTx.tx.pushKV("future_fee", parseInt(3));
+        } else if (strType == "in") {
+            if (vFields.size() < 4)
+                throw std::runtime_error(strprintf("line %u: input requires TXID and VOUT", nLine + 1));
+            UniValue input(UniValue::VOBJ);
+            input.pushKV("txid", vFields[2]);
+            input.pushKV("vout", parseInt(3));
+            if (fieldSet(4) && fieldSet(5)) {
+                input.pushKV("scriptPubKey", vFields[4]);
+                input.pushKV("amount", vFields[5]);
+            }
+            if (fieldSet(6))
+                input.pushKV("sequence", parseInt(6));
+            csvTx.inputs.push_back(input);
+        } else if (strType == "out") {
+            if (vFields.size() < 4)
+                throw std::runtime_error(strprintf("line %u: output requires ADDRESS and AMOUNT", nLine + 1));
+            UniValue output(UniValue::VOBJ);
+            output.pushKV("address", vFields[2]);
+            output.pushKV("amount", vFields[3]);
+            if (fieldSet(4) || fieldSet(5)) {
+                if (!fieldSet(4) || !fieldSet(5))
+                    throw std::runtime_error(strprintf("line %u: future outputs require FUTURE_MATURITY and FUTURE_LOCKTIME", nLine + 1));
+                output.pushKV("future_maturity", parseInt(4));
+                output.pushKV("future_locktime", parseInt(5));
+            }
+            csvTx.outputs.push_back(output);
+        } else if (strType == "data") {
+            UniValue output(UniValue::VOBJ);
+            output.pushKV("data", vFields[2]);
+            csvTx.outputs.push_back(output);
+        } else {
+            throw std::runtime_error(strprintf("line %u: unknown record type '%s'", nLine + 1, strType));
+        }
+    }
+
+    UniValue txs(UniValue::VARR);
+    for (CSVTx& csvTx : vecTxs) {
+        csvTx.tx.pushKV("inputs", csvTx.inputs);
+        csvTx.tx.pushKV("outputs", csvTx.outputs);
+        txs.push_back(csvTx.tx);
+    }
+    return txs;
+}
+
+/**
+ * Build (and sign, with -bulkkeys) one transaction of a JSON template:
+ *   {"version": n, "locktime": n, "future_fee": n,
+ *    "inputs": [{"txid": "id", "vout": n, "sequence": n, "scriptPubKey": "hex", "amount": x}, ...],
+ *    "outputs": [{"address": "addr", "amount": x, "future_maturity": n, "future_locktime": n},
+ *                {"script": "hex", "amount": x}, {"data": "hex"}, ...]}
+ * Only inputs and outputs are required. The scriptPubKey and amount of an input can also come
+ * from the template's prevtxs list. An output with future_maturity and future_locktime makes
+ * this a future tx locking that output, and then future_fee is required and must match the
+ * network's special tx fee.
+ */
+static CMutableTransaction BuildBulkTx(const UniValue& txObj, BulkContext& ctx)
+{
+    if (!txObj.isObject())
+        throw std::runtime_error("expected transaction object");
+
+    CMutableTransaction tx;
+    if (txObj.exists("version")) {
+        const int64_t nVersion = txObj["version"].get_int64();
+        if (nVersion < 1 || nVersion > CTransaction::MAX_STANDARD_VERSION)
+            throw std::runtime_error("Invalid TX version requested");
+        tx.nVersion = (int) nVersion;
+    }
+    if (txObj.exists("locktime")) {
+        const int64_t nLockTime = txObj["locktime"].get_int64();
+        if (nLockTime < 0 || nLockTime > 0xffffffffLL)
+            throw std::runtime_error("Invalid TX locktime requested");
+        tx.nLockTime = (uint32_t) nLockTime;
+    }
+
+    const UniValue& inputs = txObj["inputs"];
+    const UniValue& outputs = txObj["outputs"];
+    if (!inputs.isArray() || !outputs.isArray())
+        throw std::runtime_error("inputs and outputs arrays must be set");
+
+    tx.vin.reserve(inputs.size());
+    for (unsigned int i = 0; i < inputs.size(); i++) {
+        const UniValue& input = inputs[i];
+        if (!input.isObject() || !input["txid"].isStr() || !input["vout"].isNum())
+            throw std::runtime_error("input requires txid and vout");
+        const int nOut = input["vout"].get_int();
+        if (nOut < 0)
+            throw std::runtime_error("vout must be positive");
+        COutPoint prevout(ParseHashStr(input["txid"].get_str(), "txid"), nOut);
+        if (!ctx.setSpent.insert(prevout).second)
+            throw std::runtime_error("input " + prevout.ToStringShort() + " is spent twice");
+
+        // Same default as createrawtransaction, so a non-zero locktime is enforced
+        uint32_t nSequence = tx.nLockTime ? std::numeric_limits<uint32_t>::max() - 1 : std::numeric_limits<uint32_t>::max();
+        if (input.exists("sequence")) {
+            const int64_t seqNr64 = input["sequence"].get_int64();
+            if (seqNr64 < 0 || seqNr64 > std::numeric_limits<uint32_t>::max())
+                throw std::runtime_error("Invalid sequence number");
+            nSequence = (uint32_t) seqNr64;
+        }
+        tx.vin.emplace_back(prevout, CScript(), nSequence);
+    }
+
+    CFutureTx ftx;
+    bool fFuture = false;
+    tx.vout.reserve(outputs.size());
+    for (unsigned int i = 0; i < outputs.size(); i++) {
+        const UniValue& output = outputs[i];
+        if (!output.isObject())
+            throw std::runtime_error("expected output object");
+
+        if (output.exists("data")) {
+            std::vector<unsigned char> data = ParseHexUV(output["data"], "data");
+            tx.vout.emplace_back(0, CScript() << OP_RETURN << data);
+            continue;
+        }
+
+        CScript scriptPubKey;
+        if (output.exists("address")) {
+            CTxDestination destination = DecodeDestination(output["address"].get_str());
+            if (!IsValidDestination(destination))
+                throw std::runtime_error("invalid TX output address " + output["address"].get_str());
+            scriptPubKey = GetScriptForDestination(destination);
+        } else if (output.exists("script")) {
+            std::vector<unsigned char> scriptData = ParseHexUV(output["script"], "script");
+            scriptPubKey = CScript(scriptData.begin(), scriptData.end());
+        } else {
+            throw std::runtime_error("output requires address, script or data");
+        }
+
+        if (output.exists("future_maturity") || output.exists("future_locktime")) {
+            if (fFuture)
+                throw std::runtime_error("can only send future to one output");
+            if (!output.exists("future_maturity") || !output.exists("future_locktime"))
+                throw std::runtime_error("future outputs require future_maturity and future_locktime");
+            if (tx.vout.size() > std::numeric_limits<uint16_t>::max())
+                throw std::runtime_error("future output index out of range");
+            fFuture = true;
+            ftx.lockOutputIndex = tx.vout.size();
+            ftx.nVersion = CFutureTx::CURRENT_VERSION;
+            ftx.maturity = output["future_maturity"].get_int();
+            ftx.lockTime = output["future_locktime"].get_int();
+            ftx.updatableByDestination = false;
+        }
+
+        tx.vout.emplace_back(AmountFromValue(output["amount"]), scriptPubKey);
+    }
+
+    if (fFuture) {
+        // The fee is set by a spork, which an offline tool can't look up
+        if (!txObj.exists("future_fee"))
+            throw std::runtime_error("future outputs require future_fee");
+        const int64_t nFee = txObj["future_fee"].get_int64();
+        if (nFee < 0 || nFee > std::numeric_limits<uint16_t>::max())
+            throw std::runtime_error("Invalid future_fee");
+        ftx.fee = (uint16_t) nFee;
+        tx.nVersion = 3;
+        tx.nType = TRANSACTION_FUTURE;
+        ftx.inputsHash = CalcTxInputsHash(tx);
+        SetTxPayload(tx, ftx);
+    }
+
+    // Inputs may carry their previous output instead of listing it in prevtxs
+    for (unsigned int i = 0; i < inputs.size(); i++) {
+        if (inputs[i].exists("scriptPubKey")) {
+            AddPrevTxCoin(inputs[i], tx, ctx.view, ctx.keystore);
+            if (inputs[i].exists("amount"))
+                ctx.setAmountKnown.insert(tx.vin[i].prevout);
+        }
+    }
+
+    CAmount nValueIn = 0;
+    bool fAllAmountsKnown = true;
+    for (const CTxIn& txin : tx.vin) {
+        if (!ctx.setAmountKnown.count(txin.prevout)) {
+            fAllAmountsKnown = false;
+            break;
+        }
+        nValueIn += ctx.view.AccessCoin(txin.prevout).out.nValue;
+    }
+    CAmount nValueOut = 0;
+    for (const CTxOut& txout : tx.vout) {
+        nValueOut += txout.nValue;
+        if (!MoneyRange(nValueOut))
+            throw std::runtime_error("total output value out of range");
+    }
+    if (fAllAmountsKnown && !tx.vin.empty() && nValueIn < nValueOut)
+        throw std::runtime_error("outputs exceed inputs");
+
+    if (ctx.fSign) {
+        for (const CTxIn& txin : tx.vin) {
+            if (!ctx.view.HaveCoin(txin.prevout))
+                throw std::runtime_error("no previous output for input " + txin.prevout.ToStringShort());
+        }
+        SignTxInputs(tx, ctx.keystore, ctx.view, SIGHASH_ALL);
+    }
+
+    return tx;
+}
+
+static void BulkRawTx()
+{
+    const std::string strFile = gArgs.GetArg("-bulk", "");
+    std::string strTemplate = strFile == "-" ? readStdin() : ReadFileContents(strFile);
+    boost::algorithm::trim(strTemplate);
+
+    UniValue templateObj;
+    if (!strTemplate.empty() && (strTemplate[0] == '{' || strTemplate[0] == '[')) {
+        if (!templateObj.read(strTemplate))
+            throw std::runtime_error("Cannot parse JSON template " + strFile);
+    } else {
+        templateObj = ParseBulkCSV(strTemplate);
+    }
+
+    std::unique_ptr<Secp256k1Init> ecc;
+    BulkContext ctx;
+    if (gArgs.IsArgSet("-bulkkeys")) {
+        ecc.reset(new Secp256k1Init());
+        LoadBulkKeys(gArgs.GetArg("-bulkkeys", ""), ctx.keystore);
+        ctx.fSign = true;
+    }
+
+    // Either a list of transactions, or {"prevtxs": [...], "transactions": [...]}
+    const UniValue& txs = templateObj.isArray() ? templateObj : templateObj["transactions"];
+    if (!txs.isArray())
+        throw std::runtime_error("template requires a transactions array");
+    if (templateObj.isObject() && templateObj.exists("prevtxs")) {
+        const UniValue& prevtxsObj = templateObj["prevtxs"];
+        for (unsigned int previdx = 0; previdx < prevtxsObj.size(); previdx++) {
+            AddPrevTxCoin(prevtxsObj[previdx], CMutableTransaction(), ctx.view, ctx.keystore);
+            if (prevtxsObj[previdx].exists("amount")) {
+                ctx.setAmountKnown.emplace(ParseHashStr(prevtxsObj[previdx]["txid"].get_str(), "txid"), prevtxsObj[previdx]["vout"].get_int());
+            }
+        }
+    }
+
+    // Build everything before writing anything, so a bad template doesn't leave half of
+    // the batch behind
+    std::vector<CMutableTransaction> vecTxs;
+    vecTxs.reserve(txs.size());
+    for (unsigned int i = 0; i < txs.size(); i++) {
+        try {
+            vecTxs.push_back(BuildBulkTx(txs[i], ctx));
+        } catch (const std::exception& e) {
+            throw std::runtime_error(strprintf("transaction %u: %s", i, e.what()));
+        }
+    }
+
+    for (const auto& tx : vecTxs) {
+        OutputTx(tx);
+    }
+}
+
 static int CommandLineRawTx(int argc, char* argv[])
 {
     std::string strPrint;
@@ -731,6 +1100,11 @@ static int CommandLineRawTx(int argc, char* argv[])
             argv++;
         }
 
+        if (gArgs.IsArgSet("-bulk")) {
+            BulkRawTx();
+            return 0;
+        }
+
         CMutableTransaction tx;
         int startArg;
 
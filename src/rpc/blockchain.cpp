@@ -8,12 +8,15 @@
 #include <rpc/blockchain.h>
 
 #include <amount.h>
+#include <bootstrap.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <coins.h>
 #include <node/coinstats.h>
+#include <node/utxo_snapshot.h>
 #include <core_io.h>
+#include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <validation.h>
 #include <core_io.h>
@@ -479,7 +482,7 @@ void entryToJSON(UniValue &info, const CTxMemPoolEntry &e) EXCLUSIVE_LOCKS_REQUI
 
     UniValue spent(UniValue::VARR);
     const CTxMemPool::txiter &it = mempool.mapTx.find(tx.GetHash());
-    const CTxMemPool::setEntries &setChildren = mempool.GetMemPoolChildren(it);
+    const CTxMemPool::linkEntries &setChildren = mempool.GetMemPoolChildren(it);
     for (const CTxMemPool::txiter &childiter : setChildren) {
         spent.push_back(childiter->GetTx().GetHash().ToString());
     }
@@ -1159,38 +1162,101 @@ UniValue pruneblockchain(const JSONRPCRequest& request)
 
 UniValue gettxoutsetinfo(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() != 0)
+    if (request.fHelp || request.params.size() > 2)
         throw std::runtime_error(
-            "gettxoutsetinfo\n"
+            "gettxoutsetinfo ( \"hash_type\" hash_or_height )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "Note this call may take some time with the default hash_type, which scans the whole set.\n"
+            "\nArguments:\n"
+            "1. \"hash_type\"   (string, optional, default=hash_serialized_2) Which UTXO set hash should be calculated.\n"
+            "                   \"hash_serialized_2\" scans the UTXO set, \"muhash\" and \"none\" use statistics\n"
+            "                   maintained while connecting blocks with -coinstatsindex and otherwise scan the set.\n"
+            "2. hash_or_height  (string or numeric, optional) The block hash or height to return the statistics for instead of\n"
+            "                   the chain tip. Requires -coinstatsindex, hash_type muhash or none, and a block connected while it was enabled.\n"
             "\nResult:\n"
             "{\n"
             "  \"height\":n,     (numeric) The current block height (index)\n"
             "  \"bestblock\": \"hex\",   (string) The hash of the block at the tip of the chain\n"
-            "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs\n"
+            "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs (only when the set was scanned)\n"
             "  \"txouts\": n,            (numeric) The number of unspent transaction outputs\n"
             "  \"bogosize\": n,          (numeric) A meaningless metric for UTXO set size\n"
-            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash\n"
+            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash (only for hash_type hash_serialized_2)\n"
+            "  \"muhash\": \"hash\",      (string) The rolling MuHash of the UTXO set (only for hash_type muhash)\n"
             "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk\n"
             "  \"total_amount\": x.xxx          (numeric) The total amount\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gettxoutsetinfo", "")
+            + HelpExampleCli("gettxoutsetinfo", "\"muhash\"")
+            + HelpExampleCli("gettxoutsetinfo", "\"none\" 1000")
             + HelpExampleRpc("gettxoutsetinfo", "")
         );
 
+    std::string strHashType = "hash_serialized_2";
+    if (!request.params[0].isNull()) {
+        strHashType = request.params[0].get_str();
+    }
+    if (strHashType != "hash_serialized_2" && strHashType != "muhash" && strHashType != "none") {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s is not a valid hash_type", strHashType));
+    }
+
+    const CBlockIndex* pindex = nullptr;
+    if (!request.params[1].isNull()) {
+        if (!fCoinStatsIndex) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Querying earlier blocks requires -coinstatsindex enabled");
+        }
+        if (strHashType == "hash_serialized_2") {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "hash_serialized_2 is only available for the chain tip");
+        }
+        LOCK(cs_main);
+        if (request.params[1].isNum()) {
+            const int height = request.params[1].get_int();
+            if (height < 0 || height > chainActive.Height()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d out of range", height));
+            }
+            pindex = chainActive[height];
+        } else {
+            pindex = LookupBlockIndex(ParseHashV(request.params[1], "hash_or_height"));
+            if (!pindex) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+            }
+            if (!chainActive.Contains(pindex)) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
+            }
+        }
+    }
+
     UniValue ret(UniValue::VOBJ);
 
     CCoinsStats stats;
-    FlushStateToDisk();
-    if (GetUTXOStats(pcoinsdbview.get(), stats)) {
+    bool fFullScan = true;
+    bool fOk;
+    if (pindex) {
+        fFullScan = false;
+        if (!g_coins_stats_tracker.GetStats(*pcoinsdbview, pindex, stats, strHashType == "muhash")) {
+            throw JSONRPCError(RPC_MISC_ERROR, strprintf("No UTXO set statistics for block %s, it was not connected with -coinstatsindex", pindex->GetBlockHash().GetHex()));
+        }
+        stats.nDiskSize = pcoinsdbview->EstimateSize();
+        fOk = true;
+    } else if (strHashType == "hash_serialized_2") {
+        FlushStateToDisk();
+        fOk = GetUTXOStats(pcoinsdbview.get(), stats);
+    } else {
+        fOk = GetTipUTXOStats(pcoinsdbview.get(), stats, strHashType == "muhash", fFullScan);
+    }
+    if (fOk) {
         ret.pushKV("height", (int64_t)stats.nHeight);
         ret.pushKV("bestblock", stats.hashBlock.GetHex());
-        ret.pushKV("transactions", (int64_t)stats.nTransactions);
+        if (fFullScan) {
+            ret.pushKV("transactions", (int64_t)stats.nTransactions);
+        }
         ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
         ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
-        ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
+        if (strHashType == "hash_serialized_2") {
+            ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
+        } else if (strHashType == "muhash") {
+            ret.pushKV("muhash", stats.hashMuHash.GetHex());
+        }
         ret.pushKV("disk_size", stats.nDiskSize);
         ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
     } else {
@@ -1425,6 +1491,19 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
             "        }\n"
             "     }\n"
             "  }\n"
+            "  \"reorgs\": {                   (object) reorgs handled since startup\n"
+            "     \"count\": xx,               (numeric) number of reorgs\n"
+            "     \"blocks_disconnected\": xx, (numeric) blocks disconnected by them\n"
+            "     \"max_depth\": xx,           (numeric) the deepest reorg\n"
+            "     \"last_depth\": xx,          (numeric) depth of the last reorg\n"
+            "     \"last_time_ms\": xx,        (numeric) time the last reorg took, including the mempool update\n"
+            "     \"total_time_ms\": xx,       (numeric) time all reorgs took\n"
+            "     \"mempool_time_ms\": xx,     (numeric) time spent returning disconnected transactions to the mempool\n"
+            "     \"txs_resurrected\": xx,     (numeric) transactions of disconnected blocks offered to the mempool\n"
+            "     \"txs_readmitted\": xx,      (numeric) of which the mempool accepted\n"
+            "     \"script_cache_warmed\": xx, (numeric) script execution cache entries restored for disconnected blocks\n"
+            "     \"blocks_scripts_skipped\": xx (numeric) reconnected blocks whose script checks were skipped\n"
+            "  }\n"
             "  \"warnings\" : \"...\",           (string) any network and blockchain warnings.\n"
             "}\n"
             "\nExamples:\n"
@@ -1487,6 +1566,21 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
     obj.pushKV("softforks",             softforks);
     obj.pushKV("bip9_softforks", bip9_softforks);
 
+    const CReorgStats reorgStats = GetReorgStats();
+    UniValue reorgs(UniValue::VOBJ);
+    reorgs.pushKV("count",                  reorgStats.nReorgs);
+    reorgs.pushKV("blocks_disconnected",    reorgStats.nBlocksDisconnected);
+    reorgs.pushKV("max_depth",              reorgStats.nMaxDepth);
+    reorgs.pushKV("last_depth",             reorgStats.nLastDepth);
+    reorgs.pushKV("last_time_ms",           reorgStats.nLastTime / 1000);
+    reorgs.pushKV("total_time_ms",          reorgStats.nTotalTime / 1000);
+    reorgs.pushKV("mempool_time_ms",        reorgStats.nMempoolTime / 1000);
+    reorgs.pushKV("txs_resurrected",        reorgStats.nTxResurrected);
+    reorgs.pushKV("txs_readmitted",         reorgStats.nTxReadmitted);
+    reorgs.pushKV("script_cache_warmed",    reorgStats.nTxCacheWarmed);
+    reorgs.pushKV("blocks_scripts_skipped", reorgStats.nBlocksScriptsSkipped);
+    obj.pushKV("reorgs", reorgs);
+
     obj.pushKV("warnings", GetWarnings("statusbar"));
     return obj;
 }
@@ -1676,6 +1770,50 @@ UniValue getmempoolinfo(const JSONRPCRequest& request)
     return mempoolInfoToJSON();
 }
 
+UniValue getmempoolmemoryinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getmempoolmemoryinfo\n"
+            "\nReturns an estimate of the memory used by the TX memory pool, broken down by data structure.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"size\": xxxxx,               (numeric) Current tx count\n"
+            "  \"usage\": xxxxx,              (numeric) Total memory usage counted against -maxmempool, as in getmempoolinfo\n"
+            "  \"entries\": xxxxx,            (numeric) Mempool entries and their multi-index nodes\n"
+            "  \"transactions\": xxxxx,       (numeric) The transactions referenced by the entries\n"
+            "  \"links\": xxxxx,              (numeric) In-mempool parent and child links\n"
+            "  \"nexttx\": xxxxx,             (numeric) Outpoint to spending tx map\n"
+            "  \"deltas\": xxxxx,             (numeric) Fee deltas set by prioritisetransaction\n"
+            "  \"txhashes\": xxxxx,           (numeric) Tx hash list used for compact blocks\n"
+            "  \"addressindex\": xxxxx,       (numeric) Mempool address index (not counted in usage)\n"
+            "  \"spentindex\": xxxxx,         (numeric) Mempool spent index (not counted in usage)\n"
+            "  \"futureindex\": xxxxx,        (numeric) Mempool future index (not counted in usage)\n"
+            "  \"protx\": xxxxx,              (numeric) ProTx conflict tracking (not counted in usage)\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getmempoolmemoryinfo", "")
+            + HelpExampleRpc("getmempoolmemoryinfo", "")
+        );
+
+    CTxMemPool::MemoryUsage usage = mempool.GetMemoryUsage();
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("size", (int64_t) mempool.size());
+    ret.pushKV("usage", (int64_t) mempool.DynamicMemoryUsage());
+    ret.pushKV("entries", (int64_t) usage.nEntries);
+    ret.pushKV("transactions", (int64_t) usage.nTransactions);
+    ret.pushKV("links", (int64_t) usage.nLinks);
+    ret.pushKV("nexttx", (int64_t) usage.nNextTx);
+    ret.pushKV("deltas", (int64_t) usage.nDeltas);
+    ret.pushKV("txhashes", (int64_t) usage.nTxHashes);
+    ret.pushKV("addressindex", (int64_t) usage.nAddressIndex);
+    ret.pushKV("spentindex", (int64_t) usage.nSpentIndex);
+    ret.pushKV("futureindex", (int64_t) usage.nFutureIndex);
+    ret.pushKV("protx", (int64_t) usage.nProTx);
+    return ret;
+}
+
 UniValue preciousblock(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -1889,17 +2027,76 @@ static inline bool SetHasKeys(const std::set<T>& set, const Tk& key, const Args&
     return (set.count(key) != 0) || SetHasKeys(set, args...);
 }
 
-// outpoint (needed for the utxo index) + nHeight + fCoinBase
-static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+static UniValue BlockStatsIndexToJSON(const CBlockIndex* pindex, const CBlockStatsIndexValue& value)
+{
+    const int64_t txs = value.txs - 1; // excluding coinbase
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("avgfee", txs > 0 ? value.totalFee / txs : 0);
+    ret.pushKV("avgfeerate", value.totalSize ? value.totalFee / value.totalSize : 0);
+    ret.pushKV("avgtxsize", txs > 0 ? value.totalSize / txs : 0);
+    ret.pushKV("blockhash", pindex->GetBlockHash().GetHex());
+    ret.pushKV("height", (int64_t)pindex->nHeight);
+    ret.pushKV("ins", value.ins);
+    ret.pushKV("maxfee", value.maxFee);
+    ret.pushKV("maxfeerate", value.maxFeeRate);
+    ret.pushKV("maxtxsize", value.maxTxSize);
+    ret.pushKV("medianfee", value.medianFee);
+    ret.pushKV("medianfeerate", value.medianFeeRate);
+    ret.pushKV("mediantime", pindex->GetMedianTimePast());
+    ret.pushKV("mediantxsize", value.medianTxSize);
+    ret.pushKV("minfee", value.minFee);
+    ret.pushKV("minfeerate", value.minFeeRate);
+    ret.pushKV("mintxsize", value.minTxSize);
+    ret.pushKV("outs", value.outs);
+    ret.pushKV("subsidy", value.subsidy);
+    ret.pushKV("time", pindex->GetBlockTime());
+    ret.pushKV("total_out", value.totalOut);
+    ret.pushKV("total_size", value.totalSize);
+    ret.pushKV("totalfee", value.totalFee);
+    ret.pushKV("txs", value.txs);
+    ret.pushKV("utxo_increase", value.outs - value.ins);
+    ret.pushKV("utxo_size_inc", value.utxoSizeInc);
+    ret.pushKV("specialtxfee", value.specialTxFee);
+    ret.pushKV("protxs", value.proTxs);
+    ret.pushKV("quorumcommitments", value.quorumCommitments);
+    ret.pushKV("futuretxs", value.futureTxs);
+    ret.pushKV("futurelocked", value.futureLocked);
+    ret.pushKV("futurelockedamount", value.futureLockedAmount);
+    ret.pushKV("futurematured", value.futureMatured);
+    ret.pushKV("futurematuredamount", value.futureMaturedAmount);
+    ret.pushKV("smartnodepayment", value.smartnodePayment);
+    ret.pushKV("founderpayment", value.founderPayment);
+    return ret;
+}
+
+static UniValue SelectBlockStats(const UniValue& ret_all, const std::set<std::string>& stats)
+{
+    if (stats.empty()) {
+        return ret_all;
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    for (const std::string& stat : stats) {
+        const UniValue& value = ret_all[stat];
+        if (value.isNull()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid selected statistic %s%s", stat,
+                fBlockStatsIndex ? "" : " (Raptoreum specific statistics require -blockstatsindex)"));
+        }
+        ret.pushKV(stat, value);
+    }
+    return ret;
+}
 
 static UniValue getblockstats(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 4) {
         throw std::runtime_error(
-            "getblockstats hash_or_height ( stats )\n"
+            "getblockstats hash_or_height ( stats end_height )\n"
             "\nCompute per block statistics for a given window. All amounts are in ruffs.\n"
-            "It won't work for some heights with pruning.\n"
-            "It won't work without -txindex for utxo_size_inc, *fee or *feerate stats.\n"
+            "With -blockstatsindex the statistics recorded when the block was connected are returned,\n"
+            "otherwise they are computed from the block, which won't work for some heights with pruning\n"
+            "and won't work without -txindex for utxo_size_inc, *fee or *feerate stats.\n"
             "\nArguments:\n"
             "1. \"hash_or_height\"     (string or numeric, required) The block hash or height of the target block\n"
             "2. \"stats\"              (array,  optional) Values to plot, by default all values (see result below)\n"
@@ -1908,6 +2105,8 @@ static UniValue getblockstats(const JSONRPCRequest& request)
             "      \"time\",           (string, optional) Selected statistic\n"
             "      ,...\n"
             "    ]\n"
+            "3. \"end_height\"         (numeric, optional) Return an array with the statistics of all blocks from\n"
+            "                         height hash_or_height up to and including end_height. Requires -blockstatsindex.\n"
             "\nResult:\n"
             "{                           (json object)\n"
             "  \"avgfee\": xxxxx,          (numeric) Average fee in the block\n"
@@ -1935,9 +2134,20 @@ static UniValue getblockstats(const JSONRPCRequest& request)
             "  \"txs\": xxxxx,             (numeric) The number of transactions (excluding coinbase)\n"
             "  \"utxo_increase\": xxxxx,   (numeric) The increase/decrease in the number of unspent outputs\n"
             "  \"utxo_size_inc\": xxxxx,   (numeric) The increase/decrease in size for the utxo index (not discounting op_return and similar)\n"
+            "  \"specialtxfee\": xxxxx,    (numeric) The special transaction fee total (-blockstatsindex only)\n"
+            "  \"protxs\": xxxxx,          (numeric) The number of ProTx transactions (-blockstatsindex only)\n"
+            "  \"quorumcommitments\": xxxxx, (numeric) The number of quorum commitments (-blockstatsindex only)\n"
+            "  \"futuretxs\": xxxxx,       (numeric) The number of future transactions (-blockstatsindex only)\n"
+            "  \"futurelocked\": xxxxx,    (numeric) The number of future locks created (-blockstatsindex only)\n"
+            "  \"futurelockedamount\": xxxxx, (numeric) The amount locked by future transactions (-blockstatsindex only)\n"
+            "  \"futurematured\": xxxxx,   (numeric) The number of future locks reaching their maturity height (-blockstatsindex only)\n"
+            "  \"futurematuredamount\": xxxxx, (numeric) The amount of those locks (-blockstatsindex only)\n"
+            "  \"smartnodepayment\": xxxxx, (numeric) The smartnode payments in the coinbase (-blockstatsindex only)\n"
+            "  \"founderpayment\": xxxxx,  (numeric) The founder payment in the coinbase (-blockstatsindex only)\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getblockstats", "1000 '[\"minfeerate\",\"avgfeerate\"]'")
+            + HelpExampleCli("getblockstats", "1000 '[\"totalfee\",\"smartnodepayment\"]' 2000")
             + HelpExampleRpc("getblockstats", "1000 '[\"minfeerate\",\"avgfeerate\"]'")
         );
     }
@@ -1981,6 +2191,36 @@ static UniValue getblockstats(const JSONRPCRequest& request)
         }
     }
 
+    if (!request.params[2].isNull()) {
+        if (!fBlockStatsIndex) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Height ranges require -blockstatsindex enabled");
+        }
+        // Genesis isn't connected, so it has no entry in the index
+        if (pindex->nHeight == 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Height ranges must start after the genesis block");
+        }
+        const int end_height = request.params[2].get_int();
+        if (end_height < pindex->nHeight || end_height > chainActive.Height()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("end_height %d must be between %d and the current tip %d", end_height, pindex->nHeight, chainActive.Height()));
+        }
+        UniValue ret(UniValue::VARR);
+        for (int height = pindex->nHeight; height <= end_height; height++) {
+            const CBlockIndex* pindexStats = chainActive[height];
+            CBlockStatsIndexValue value;
+            if (!pblocktree->ReadBlockStatsIndex(pindexStats->GetBlockHash(), value)) {
+                throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("No block stats for height %d", height));
+            }
+            ret.push_back(SelectBlockStats(BlockStatsIndexToJSON(pindexStats, value), stats));
+        }
+        return ret;
+    }
+
+    // Genesis isn't connected, so it has no entry in the index
+    CBlockStatsIndexValue value;
+    if (fBlockStatsIndex && pblocktree->ReadBlockStatsIndex(pindex->GetBlockHash(), value)) {
+        return SelectBlockStats(BlockStatsIndexToJSON(pindex, value), stats);
+    }
+
     const CBlock block = GetBlockChecked(pindex);
 
     const bool do_all = stats.size() == 0; // Calculate everything if nothing selected (default)
@@ -2008,7 +2248,8 @@ static UniValue getblockstats(const JSONRPCRequest& request)
     std::vector<CAmount> fee_array;
     std::vector<CAmount> feerate_array;
     std::vector<int64_t> txsize_array;
-    bool isV17active = Params().IsFutureActive(chainActive.Tip());
+    // The block's own context, not the tip's
+    const CTxCheckContext txCheckContext(pindex->pprev);
 
     for (const auto& tx : block.vtx) {
         outputs += tx->vout.size();
@@ -2060,7 +2301,7 @@ static UniValue getblockstats(const JSONRPCRequest& request)
             }
 
             CAmount txfee = tx_total_in - tx_total_out;
-            assert(MoneyRange(txfee, isV17active));
+            assert(MoneyRange(txfee, txCheckContext.fFutureActive));
             if (do_medianfee) {
                 fee_array.push_back(txfee);
             }
@@ -2104,19 +2345,7 @@ static UniValue getblockstats(const JSONRPCRequest& request)
     ret_all.pushKV("utxo_increase", outputs - inputs);
     ret_all.pushKV("utxo_size_inc", utxo_size_inc);
 
-    if (do_all) {
-        return ret_all;
-    }
-
-    UniValue ret(UniValue::VOBJ);
-    for (const std::string& stat : stats) {
-        const UniValue& value = ret_all[stat];
-        if (value.isNull()) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid selected statistic %s", stat));
-        }
-        ret.pushKV(stat, value);
-    }
-    return ret;
+    return SelectBlockStats(ret_all, stats);
 }
 
 UniValue getspecialtxes(const JSONRPCRequest& request)
@@ -2243,12 +2472,118 @@ UniValue savemempool(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
+UniValue exportchain(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3) {
+        throw std::runtime_error(
+            "exportchain \"directory\" ( start_height end_height )\n"
+            "\nWrites the blocks of the active chain to a bootstrap directory, together with a height ordered index.\n"
+            "The directory can be imported by starting a node with -loadbootstrap=<directory>.\n"
+            "\nArguments:\n"
+            "1. \"directory\"     (string, required) The directory to write to, created if missing. Existing files are overwritten\n"
+            "2. start_height    (numeric, optional, default=0) The first block to export\n"
+            "3. end_height      (numeric, optional, default=tip) The last block to export\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"directory\": \"xxx\",   (string) The absolute path of the bootstrap directory\n"
+            "  \"start_height\": n,    (numeric) The first exported block\n"
+            "  \"end_height\": n,      (numeric) The last exported block\n"
+            "  \"blocks\": n           (numeric) The number of exported blocks\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("exportchain", "\"/tmp/bootstrap\"")
+            + HelpExampleCli("exportchain", "\"/tmp/bootstrap\" 0 100000")
+            + HelpExampleRpc("exportchain", "\"/tmp/bootstrap\", 0, 100000")
+        );
+    }
+
+    if (fPruneMode) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Cannot export the chain in prune mode");
+    }
+
+    const fs::path dir = fs::absolute(request.params[0].get_str());
+
+    int nStartHeight = request.params[1].isNull() ? 0 : request.params[1].get_int();
+    int nEndHeight;
+    {
+        LOCK(cs_main);
+        nEndHeight = request.params[2].isNull() ? chainActive.Height() : request.params[2].get_int();
+        if (nStartHeight < 0 || nEndHeight > chainActive.Height() || nStartHeight > nEndHeight) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Block heights out of range");
+        }
+    }
+
+    std::string strError;
+    if (!ExportBootstrap(dir, nStartHeight, nEndHeight, strError)) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Unable to export the chain: %s", strError));
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("directory", dir.string());
+    ret.pushKV("start_height", nStartHeight);
+    ret.pushKV("end_height", nEndHeight);
+    ret.pushKV("blocks", nEndHeight - nStartHeight + 1);
+    return ret;
+}
+
+UniValue dumptxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        throw std::runtime_error(
+            "dumptxoutset \"path\"\n"
+            "\nWrites the UTXO set and the evo database (deterministic smartnode lists and quorum commitments) at the chain tip\n"
+            "to a snapshot file, together with the block headers up to there. A new node can be started from it with -loadtxoutset=<file>\n"
+            "and -loadtxoutsethash=<snapshot_hash>.\n"
+            "To snapshot an older block, roll the chain back with invalidateblock first.\n"
+            "\nArguments:\n"
+            "1. \"path\"    (string, required) The file to write to, relative to the data directory if not absolute. Must not exist yet\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"path\": \"xxx\",            (string) The absolute path of the snapshot\n"
+            "  \"base_hash\": \"hash\",      (string) The block the snapshot was taken at\n"
+            "  \"base_height\": n,         (numeric) The height of that block\n"
+            "  \"coins_written\": n,       (numeric) The number of coins written\n"
+            "  \"total_amount\": x.xxx,    (numeric) The total amount of the coins\n"
+            "  \"muhash\": \"hash\",         (string) The MuHash of the UTXO set, compare it with gettxoutsetinfo \"muhash\" on other nodes\n"
+            "  \"evo_entries_written\": n, (numeric) The number of evo database entries written\n"
+            "  \"snapshot_hash\": \"hash\"   (string) The hash of the whole snapshot, pass it to -loadtxoutsethash when loading the snapshot\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+    }
+
+    const fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    if (fs::exists(path)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists");
+    }
+
+    SnapshotMetadata metadata;
+    uint256 hashSnapshot;
+    std::string strError;
+    if (!DumpUTXOSnapshot(path, metadata, hashSnapshot, strError)) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Unable to write the snapshot: %s", strError));
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("path", path.string());
+    ret.pushKV("base_hash", metadata.m_base_blockhash.GetHex());
+    ret.pushKV("base_height", metadata.m_base_height);
+    ret.pushKV("coins_written", (uint64_t)metadata.m_coins_count);
+    ret.pushKV("total_amount", ValueFromAmount(metadata.m_total_amount));
+    ret.pushKV("muhash", metadata.m_coins_muhash.GetHex());
+    ret.pushKV("evo_entries_written", (uint64_t)metadata.m_evo_entries_count);
+    ret.pushKV("snapshot_hash", hashSnapshot.GetHex());
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
     { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {} },
     { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"} },
-    { "blockchain",         "getblockstats",          &getblockstats,          {"hash_or_height", "stats"} },
+    { "blockchain",         "getblockstats",          &getblockstats,          {"hash_or_height", "stats", "end_height"} },
     { "blockchain",         "getbestblockhash",       &getbestblockhash,       {} },
     { "blockchain",         "getbestchainlock",       &getbestchainlock,       {} },
     { "blockchain",         "getblockcount",          &getblockcount,          {} },
@@ -2264,12 +2599,15 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"} },
     { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"} },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {} },
+    { "blockchain",         "getmempoolmemoryinfo",   &getmempoolmemoryinfo,   {} },
     { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         {"blockhash", "type", "count", "skip", "verbosity"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {"hash_type", "hash_or_height"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
+    { "blockchain",         "exportchain",            &exportchain,            {"directory","start_height","end_height"} },
+    { "blockchain",         "dumptxoutset",           &dumptxoutset,           {"path"} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
 
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
@@ -148,7 +148,11 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "verifychain", 0, "checklevel" },
     { "verifychain", 1, "nblocks" },
     { "getblockstats", 0, "hash_or_height" },
+    { "gettxoutsetinfo", 1, "hash_or_height" },
     { "getblockstats", 1, "stats" },
+    { "getblockstats", 2, "end_height" },
+    { "exportchain", 1, "start_height" },
+    { "exportchain", 2, "end_height" },
     { "pruneblockchain", 0, "height" },
     { "keypoolrefill", 0, "newsize" },
     { "getrawmempool", 0, "verbose" },
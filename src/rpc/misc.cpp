@@ -23,6 +23,7 @@
 #include <util.h>
 #include <utilstrencodings.h>
 #include <validation.h>
+#include <validationinterface.h>
 #ifdef ENABLE_WALLET
 #include <wallet/rpcwallet.h>
 #include <wallet/wallet.h>
@@ -30,6 +31,7 @@
 #endif
 #include <warnings.h>
 
+#include <governance/governance.h>
 #include <smartnode/smartnode-sync.h>
 #include <spork.h>
 
@@ -100,6 +102,18 @@ UniValue mnsync(const JSONRPCRequest& request)
         objStatus.pushKV("Attempt", smartnodeSync.GetAttempt());
         objStatus.pushKV("IsBlockchainSynced", smartnodeSync.IsBlockchainSynced());
         objStatus.pushKV("IsSynced", smartnodeSync.IsSynced());
+
+        CGovernanceVoteQueueStats voteStats = governance.GetVoteQueueStats();
+        UniValue objVotes(UniValue::VOBJ);
+        objVotes.pushKV("Pending", (uint64_t)voteStats.nPending);
+        objVotes.pushKV("Queued", voteStats.nQueued);
+        objVotes.pushKV("Duplicates", voteStats.nDuplicates);
+        objVotes.pushKV("Dropped", voteStats.nDropped);
+        objVotes.pushKV("Batches", voteStats.nBatches);
+        objVotes.pushKV("BatchVerified", voteStats.nBatchVerified);
+        objVotes.pushKV("Accepted", voteStats.nAccepted);
+        objVotes.pushKV("Rejected", voteStats.nRejected);
+        objStatus.pushKV("GovernanceVotes", objVotes);
         return objStatus;
     }
 
@@ -1075,6 +1089,44 @@ uint64_t getCategoryMask(UniValue cats) {
     return mask;
 }
 
+UniValue getvalidationqueueinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getvalidationqueueinfo\n"
+            "Returns the background notification queue of each validation interface subscriber.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"name\": \"xxxx\",           (string) Name of the subscriber\n"
+            "    \"backpressure\": true|false, (boolean) Whether validation waits for this subscriber when it falls behind\n"
+            "    \"pending\": n,               (numeric) Number of queued notifications\n"
+            "    \"processed\": n,             (numeric) Number of notifications processed since registration\n"
+            "    \"dropped\": n,               (numeric) Number of notifications dropped because the queue was full, only without backpressure\n"
+            "    \"avglatency\": n,            (numeric) Average time in microseconds from queueing to completion\n"
+            "    \"maxlatency\": n             (numeric) Maximum time in microseconds from queueing to completion\n"
+            "  },...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getvalidationqueueinfo", "")
+            + HelpExampleRpc("getvalidationqueueinfo", "")
+        );
+
+    UniValue ret(UniValue::VARR);
+    for (const auto& stats : GetMainSignals().GetQueueStats()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("name", stats.name);
+        obj.pushKV("backpressure", stats.fBackpressure);
+        obj.pushKV("pending", (uint64_t)stats.nPending);
+        obj.pushKV("processed", stats.nProcessed);
+        obj.pushKV("dropped", stats.nDropped);
+        obj.pushKV("avglatency", stats.nProcessed ? stats.nTotalLatencyMicros / (int64_t)stats.nProcessed : 0);
+        obj.pushKV("maxlatency", stats.nMaxLatencyMicros);
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
 UniValue logging(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 2) {
@@ -1176,6 +1228,7 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------
     { "control",            "debug",                  &debug,                  {} },
     { "control",            "getmemoryinfo",          &getmemoryinfo,          {"mode"} },
+    { "control",            "getvalidationqueueinfo", &getvalidationqueueinfo, {} },
     { "control",            "logging",                &logging,                {"include", "exclude"}},
     { "util",               "validateaddress",        &validateaddress,        {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         {"nrequired","keys"} },
@@ -110,6 +110,14 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "       n,                        (numeric) The heights of blocks we're currently asking from this peer\n"
             "       ...\n"
             "    ],\n"
+            "    \"block_download\": {        (json object) Blocks we requested from this peer\n"
+            "       \"blocks\": n,            (numeric) The number of requested blocks received\n"
+            "       \"bytes\": n,             (numeric) Their total size in bytes\n"
+            "       \"avg_block_time\": n,    (numeric) Moving average of the seconds each block took\n"
+            "       \"bytes_per_sec\": n,     (numeric) Moving average of the download speed\n"
+            "       \"rerequested_away\": n,  (numeric) Blocks that took too long and were requested from a faster peer instead\n"
+            "       \"rerequested_here\": n   (numeric) Blocks that were taken over from a slower peer\n"
+            "    },\n"
             "    \"whitelisted\": true|false, (boolean) Whether the peer is whitelisted\n"
             "    \"bytessent_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes sent aggregated by message type\n"
@@ -183,6 +191,14 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
                 heights.push_back(height);
             }
             obj.pushKV("inflight", heights);
+            UniValue blockDownload(UniValue::VOBJ);
+            blockDownload.pushKV("blocks", statestats.nBlocksDownloaded);
+            blockDownload.pushKV("bytes", statestats.nBlockBytesDownloaded);
+            blockDownload.pushKV("avg_block_time", ((double)statestats.nAvgBlockTime) / 1e6);
+            blockDownload.pushKV("bytes_per_sec", statestats.nAvgBlockBytesPerSec);
+            blockDownload.pushKV("rerequested_away", statestats.nBlocksRerequestedAway);
+            blockDownload.pushKV("rerequested_here", statestats.nBlocksRerequestedHere);
+            obj.pushKV("block_download", blockDownload);
         }
         obj.pushKV("whitelisted", stats.fWhitelisted);
         obj.pushKV("addr_processed", stats.nAddrProcessed);
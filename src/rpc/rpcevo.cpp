@@ -42,6 +42,10 @@
 
 #include <smartnode/smartnode-meta.h>
 
+#include <saltedhasher.h>
+
+#include <unordered_map>
+
 #ifdef ENABLE_WALLET
 extern UniValue signrawtransaction(const JSONRPCRequest& request);
 extern UniValue sendrawtransaction(const JSONRPCRequest& request);
@@ -1216,7 +1220,7 @@ UniValue protx_quick_setup(const JSONRPCRequest& request) {
 void protx_list_help()
 {
   throw std::runtime_error(
-            "protx list (\"type\" \"detailed\" \"height\")\n"
+            "protx list (\"type\" \"detailed\" \"height\" \"filter\")\n"
             "\nLists all ProTxs in your wallet or on-chain, depending on the given type.\n"
             "If \"type\" is not specified, it defaults to \"registered\".\n"
             "If \"detailed\" is not specified, it defaults to \"false\" and only the hashes of the ProTx will be returned.\n"
@@ -1229,6 +1233,14 @@ void protx_list_help()
             "  wallet       - List only ProTx which are found in your wallet at the given chain height.\n"
             "                 This will also include ProTx which failed PoSe verfication.\n"
 #endif
+            "\nThe optional \"filter\" is a json object (or a string holding one) with any of these keys:\n"
+            "  \"owner\"        (string) Only ProTx with this owner address\n"
+            "  \"payout\"       (string) Only ProTx paying out to this address\n"
+            "  \"state\"        (string) Only ProTx in this state, \"valid\" or \"banned\"\n"
+            "  \"skip\"         (numeric) Skip this many matching ProTx\n"
+            "  \"count\"        (numeric) Return at most this many ProTx\n"
+            "\nExamples:\n"
+            + HelpExampleCli("protx", "list registered true 0 '{\"state\":\"banned\",\"count\":10}'")
   );
 }
 
@@ -1261,36 +1273,59 @@ static bool CheckWalletOwnsScript(CWallet* pwallet, const CScript& script) {
 #endif
 }
 
-UniValue BuildDMNListEntry(CWallet* pwallet, const CDeterministicMNCPtr& dmn, bool detailed)
-{
-    if (!detailed) {
-        return dmn->proTxHash.ToString();
+static bool CheckWalletOwnsCollateral(CWallet* pwallet, const COutPoint& outpoint, const CScript& utxoScript) {
+#ifndef ENABLE_WALLET
+    return false;
+#else
+    if (!pwallet) {
+        return false;
     }
 
-    UniValue o(UniValue::VOBJ);
+    // Ask the wallet's own transactions first and fall back to the UTXO set, never read the block files
+    LOCK(pwallet->cs_wallet);
+    const CWalletTx* wtx = pwallet->GetWalletTx(outpoint.hash);
+    if (wtx && outpoint.n < wtx->tx->vout.size()) {
+        return CheckWalletOwnsScript(pwallet, wtx->tx->vout[outpoint.n].scriptPubKey);
+    }
+    return CheckWalletOwnsScript(pwallet, utxoScript);
+#endif
+}
 
-    dmn->ToJson(o);
+/** The chain dependent part of a detailed list entry, which doesn't depend on the wallet */
+struct CDMNListEntryBase {
+    UniValue json;
+    CScript collateralScript;
+};
 
-    int confirmations = GetUTXOConfirmations(dmn->collateralOutpoint);
-    o.pushKV("confirmations", confirmations);
+static CDMNListEntryBase BuildDMNListEntryBase(const CDeterministicMNCPtr& dmn)
+{
+    AssertLockHeld(cs_main);
 
-#ifdef ENABLE_WALLET
-    bool hasOwnerKey = CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDOwner);
-    bool hasVotingKey = CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDVoting);
+    CDMNListEntryBase entry;
+    dmn->ToJson(entry.json);
 
-    bool ownsCollateral = false;
-    CTransactionRef collateralTx;
-    uint256 tmpHashBlock;
-    if (GetTransaction(dmn->collateralOutpoint.hash, collateralTx, Params().GetConsensus(), tmpHashBlock)) {
-        ownsCollateral = CheckWalletOwnsScript(pwallet, collateralTx->vout[dmn->collateralOutpoint.n].scriptPubKey);
+    Coin coin;
+    int confirmations = -1;
+    if (GetUTXOCoin(dmn->collateralOutpoint, coin)) {
+        entry.collateralScript = coin.out.scriptPubKey;
+        confirmations = chainActive.Height() - (int)coin.nHeight + 1;
     }
+    entry.json.pushKV("confirmations", confirmations);
+
+    return entry;
+}
+
+static UniValue BuildDMNListEntry(CWallet* pwallet, const CDeterministicMNCPtr& dmn, const CDMNListEntryBase& base)
+{
+    UniValue o = base.json;
 
+#ifdef ENABLE_WALLET
     if (pwallet) {
         UniValue walletObj(UniValue::VOBJ);
-        walletObj.pushKV("hasOwnerKey", hasOwnerKey);
+        walletObj.pushKV("hasOwnerKey", CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDOwner));
         walletObj.pushKV("hasOperatorKey", false);
-        walletObj.pushKV("hasVotingKey", hasVotingKey);
-        walletObj.pushKV("ownsCollateral", ownsCollateral);
+        walletObj.pushKV("hasVotingKey", CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDVoting));
+        walletObj.pushKV("ownsCollateral", CheckWalletOwnsCollateral(pwallet, dmn->collateralOutpoint, base.collateralScript));
         walletObj.pushKV("ownsPayeeScript", CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptPayout));
         walletObj.pushKV("ownsOperatorRewardScript", CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptOperatorPayout));
         o.pushKV("wallet", walletObj);
@@ -1303,9 +1338,142 @@ UniValue BuildDMNListEntry(CWallet* pwallet, const CDeterministicMNCPtr& dmn, bo
     return o;
 }
 
+UniValue BuildDMNListEntry(CWallet* pwallet, const CDeterministicMNCPtr& dmn, bool detailed)
+{
+    if (!detailed) {
+        return dmn->proTxHash.ToString();
+    }
+
+    LOCK(cs_main);
+    return BuildDMNListEntry(pwallet, dmn, BuildDMNListEntryBase(dmn));
+}
+
+/**
+ * Detailed entries of the most recently listed smartnode list. They only change when the list
+ * or the chain tip (confirmations, collateral upgrade state) changes, so repeated "protx list"
+ * calls only have to add the wallet and meta info.
+ */
+struct CDMNListJsonCache {
+    uint256 listBlockHash;
+    uint256 tipBlockHash;
+    std::unordered_map<uint256, CDMNListEntryBase, StaticSaltedHasher> mapEntries;
+};
+
+static CCriticalSection cs_dmnListJsonCache;
+static std::shared_ptr<const CDMNListJsonCache> dmnListJsonCache;
+
+static std::shared_ptr<const CDMNListJsonCache> GetDMNListJsonCache(const CDeterministicMNList& mnList)
+{
+    AssertLockHeld(cs_main);
+
+    const uint256 tipBlockHash = chainActive.Tip()->GetBlockHash();
+    LOCK(cs_dmnListJsonCache);
+    if (dmnListJsonCache && dmnListJsonCache->listBlockHash == mnList.GetBlockHash() && dmnListJsonCache->tipBlockHash == tipBlockHash) {
+        return dmnListJsonCache;
+    }
+
+    auto cache = std::make_shared<CDMNListJsonCache>();
+    cache->listBlockHash = mnList.GetBlockHash();
+    cache->tipBlockHash = tipBlockHash;
+    cache->mapEntries.reserve(mnList.GetAllMNsCount());
+    mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+        cache->mapEntries.emplace(dmn->proTxHash, BuildDMNListEntryBase(dmn));
+    });
+    dmnListJsonCache = cache;
+    return dmnListJsonCache;
+}
+
+/** Filter and pagination options of "protx list" */
+struct CDMNListFilter {
+    bool fOwner{false};
+    CKeyID keyIDOwner;
+    bool fPayout{false};
+    CScript scriptPayout;
+    std::string strState;
+    int nSkip{0};
+    int nCount{std::numeric_limits<int>::max()};
+
+    bool Matches(const CDeterministicMNCPtr& dmn) const
+    {
+        if (fOwner && dmn->pdmnState->keyIDOwner != keyIDOwner) {
+            return false;
+        }
+        if (fPayout && dmn->pdmnState->scriptPayout != scriptPayout) {
+            return false;
+        }
+        if (strState == "valid" && !CDeterministicMNList::IsMNValid(dmn)) {
+            return false;
+        }
+        if (strState == "banned" && !CDeterministicMNList::IsMNPoSeBanned(dmn)) {
+            return false;
+        }
+        return true;
+    }
+};
+
+static CDMNListFilter ParseDMNListFilter(const UniValue& param)
+{
+    CDMNListFilter filter;
+    if (param.isNull()) {
+        return filter;
+    }
+
+    UniValue obj = param;
+    if (param.isStr() && !obj.read(param.get_str())) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "filter must be a json object");
+    }
+    if (!obj.isObject()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "filter must be a json object");
+    }
+    RPCTypeCheckObj(obj, {
+            {"owner", UniValueType(UniValue::VSTR)},
+            {"payout", UniValueType(UniValue::VSTR)},
+            {"state", UniValueType(UniValue::VSTR)},
+            {"skip", UniValueType(UniValue::VNUM)},
+            {"count", UniValueType(UniValue::VNUM)},
+        }, true, true);
+
+    if (!obj["owner"].isNull()) {
+        CTxDestination dest = DecodeDestination(obj["owner"].get_str());
+        const CKeyID* keyID = boost::get<CKeyID>(&dest);
+        if (!keyID) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("invalid owner address: %s", obj["owner"].get_str()));
+        }
+        filter.fOwner = true;
+        filter.keyIDOwner = *keyID;
+    }
+    if (!obj["payout"].isNull()) {
+        CTxDestination dest = DecodeDestination(obj["payout"].get_str());
+        if (!IsValidDestination(dest)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("invalid payout address: %s", obj["payout"].get_str()));
+        }
+        filter.fPayout = true;
+        filter.scriptPayout = GetScriptForDestination(dest);
+    }
+    if (!obj["state"].isNull()) {
+        filter.strState = obj["state"].get_str();
+        if (filter.strState != "valid" && filter.strState != "banned") {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("invalid state: %s", filter.strState));
+        }
+    }
+    if (!obj["skip"].isNull()) {
+        filter.nSkip = obj["skip"].get_int();
+        if (filter.nSkip < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "skip must not be negative");
+        }
+    }
+    if (!obj["count"].isNull()) {
+        filter.nCount = obj["count"].get_int();
+        if (filter.nCount < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "count must not be negative");
+        }
+    }
+    return filter;
+}
+
 UniValue protx_list(const JSONRPCRequest& request)
 {
-    if (request.fHelp) {
+    if (request.fHelp || request.params.size() > 5) {
         protx_list_help();
     }
 
@@ -1320,70 +1488,80 @@ UniValue protx_list(const JSONRPCRequest& request)
     if (!request.params[1].isNull()) {
         type = request.params[1].get_str();
     }
+    if (type != "wallet" && type != "valid" && type != "registered") {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid type specified");
+    }
+    if (type == "wallet" && !pwallet) {
+        throw std::runtime_error("\"protx list wallet\" not supported when wallet is disabled");
+    }
 
-    UniValue ret(UniValue::VARR);
-
-    LOCK(cs_main);
+    bool detailed = !request.params[2].isNull() ? ParseBoolV(request.params[2], "detailed") : false;
+    CDMNListFilter filter = ParseDMNListFilter(request.params[4]);
 
-    if (type == "wallet") {
-        if (!pwallet) {
-            throw std::runtime_error("\"protx list wallet\" not supported when wallet is disabled");
-        }
-#ifdef ENABLE_WALLET
-        LOCK2(cs_main, pwallet->cs_wallet);
+    // Collect the matching smartnodes and, if needed, their cached chain dependent json while
+    // holding cs_main. The wallet and meta info is added afterwards without it.
+    std::vector<CDeterministicMNCPtr> vecDmns;
+    std::shared_ptr<const CDMNListJsonCache> cache;
+    {
+        LOCK(cs_main);
 
-        if (request.params.size() > 4) {
-            protx_list_help();
+        int height = chainActive.Height();
+        if (!request.params[3].isNull()) {
+            height = ParseInt32V(request.params[3], "height");
+            // 0 is accepted as an alias for the chain tip so that a filter can be given positionally
+            if (height == 0) {
+                height = chainActive.Height();
+            }
         }
-
-        bool detailed = !request.params[2].isNull() ? ParseBoolV(request.params[2], "detailed") : false;
-
-        int height = !request.params[3].isNull() ? ParseInt32V(request.params[3], "height") : chainActive.Height();
         if (height < 1 || height > chainActive.Height()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid height specified");
         }
 
-        std::vector<COutPoint> vOutpts;
-        pwallet->ListProTxCoins(height, vOutpts);
+        CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
+
         std::set<COutPoint> setOutpts;
-        for (const auto& outpt : vOutpts) {
-            setOutpts.emplace(outpt);
+#ifdef ENABLE_WALLET
+        if (type == "wallet") {
+            LOCK(pwallet->cs_wallet);
+            std::vector<COutPoint> vOutpts;
+            pwallet->ListProTxCoins(height, vOutpts);
+            setOutpts.insert(vOutpts.begin(), vOutpts.end());
         }
+#endif
 
-        CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
-        mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
-            if (setOutpts.count(dmn->collateralOutpoint) ||
-                CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDOwner) ||
-                CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDVoting) ||
-                CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptPayout) ||
-                CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptOperatorPayout)) {
-                ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
+        bool onlyValid = type == "valid";
+        int nSkipped = 0;
+        mnList.ForEachMN(onlyValid, height, [&](const CDeterministicMNCPtr& dmn) {
+            if ((int)vecDmns.size() >= filter.nCount || !filter.Matches(dmn)) {
+                return;
+            }
+            if (type == "wallet" &&
+                !setOutpts.count(dmn->collateralOutpoint) &&
+                !CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDOwner) &&
+                !CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDVoting) &&
+                !CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptPayout) &&
+                !CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptOperatorPayout)) {
+                return;
+            }
+            if (nSkipped < filter.nSkip) {
+                nSkipped++;
+                return;
             }
+            vecDmns.emplace_back(dmn);
         });
-#endif
-    } else if (type == "valid" || type == "registered") {
-        if (request.params.size() > 4) {
-            protx_list_help();
-        }
-
-        LOCK(cs_main);
 
-        bool detailed = !request.params[2].isNull() ? ParseBoolV(request.params[2], "detailed") : false;
-
-        int height = !request.params[3].isNull() ? ParseInt32V(request.params[3], "height") : chainActive.Height();
-        if (height < 1 || height > chainActive.Height()) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid height specified");
+        if (detailed) {
+            cache = GetDMNListJsonCache(mnList);
         }
+    }
 
-        cout << "protx_list: height" << height << ", chainActive.Height(): " << chainActive.Height() << endl;
-
-        CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
-        bool onlyValid = type == "valid";
-        mnList.ForEachMN(onlyValid, height, [&](const CDeterministicMNCPtr& dmn) {
-            ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
-        });
-    } else {
-        throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid type specified");
+    UniValue ret(UniValue::VARR);
+    for (const auto& dmn : vecDmns) {
+        if (!detailed) {
+            ret.push_back(dmn->proTxHash.ToString());
+        } else {
+            ret.push_back(BuildDMNListEntry(pwallet, dmn, cache->mapEntries.at(dmn->proTxHash)));
+        }
     }
 
     return ret;
@@ -1398,6 +1576,8 @@ void protx_info_help()
             + GetHelpString(1, "proTxHash") +
             "\nResult:\n"
             "{                             (json object) Details about a specific deterministic smartnode\n"
+            "  ...\n"
+            "  \"nextPaymentHeight\": n      (numeric) Projected height of the next payment, only present for valid smartnodes\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("protx", "info \"0123456701234567012345670123456701234567012345670123456701234567\"")
@@ -1423,7 +1603,12 @@ UniValue protx_info(const JSONRPCRequest& request)
     if (!dmn) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s not found", proTxHash.ToString()));
     }
-    return BuildDMNListEntry(pwallet, dmn, true);
+    UniValue ret = BuildDMNListEntry(pwallet, dmn, true);
+    int nPosition = deterministicMNManager->GetProjectedPayeePosition(proTxHash);
+    if (nPosition > 0) {
+        ret.pushKV("nextPaymentHeight", mnList.GetHeight() + nPosition);
+    }
+    return ret;
 }
 
 void protx_diff_help()
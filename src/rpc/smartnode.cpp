@@ -130,8 +130,13 @@ UniValue smartnode_count(const JSONRPCRequest& request)
 
 UniValue GetNextSmartnodeForPayment(int heightShift)
 {
-    auto mnList = deterministicMNManager->GetListAtChainTip();
-    auto payees = mnList.GetProjectedMNPayees(heightShift);
+    const CBlockIndex* pindexTip;
+    {
+        LOCK(cs_main);
+        pindexTip = chainActive.Tip();
+    }
+    if (!pindexTip) return "unknown";
+    auto payees = deterministicMNManager->GetProjectedMNPayees(pindexTip, heightShift);
     if (payees.empty())
         return "unknown";
     auto payee = payees.back();
@@ -142,7 +147,7 @@ UniValue GetNextSmartnodeForPayment(int heightShift)
 
     UniValue obj(UniValue::VOBJ);
 
-    obj.pushKV("height",        mnList.GetHeight() + heightShift);
+    obj.pushKV("height",        pindexTip->nHeight + heightShift);
     obj.pushKV("IP:port",       payee->pdmnState->addr.ToString());
     obj.pushKV("proTxHash",     payee->proTxHash.ToString());
     obj.pushKV("outpoint",      payee->collateralOutpoint.ToStringShort());
@@ -344,13 +349,13 @@ UniValue smartnode_winners(const JSONRPCRequest& request)
     int nStartHeight = std::max(nChainTipHeight - nCount, 1);
 
     for (int h = nStartHeight; h <= nChainTipHeight; h++) {
-        auto payee = deterministicMNManager->GetListForBlock(pindexTip->GetAncestor(h - 1)).GetMNPayee();
+        auto payee = deterministicMNManager->GetMNPayee(pindexTip->GetAncestor(h - 1));
         std::string strPayments = GetRequiredPaymentsString(h, payee);
         if (strFilter != "" && strPayments.find(strFilter) == std::string::npos) continue;
         obj.pushKV(strprintf("%d", h), strPayments);
     }
 
-    auto projection = deterministicMNManager->GetListForBlock(pindexTip).GetProjectedMNPayees(20);
+    auto projection = deterministicMNManager->GetProjectedMNPayees(pindexTip, 20);
     for (size_t i = 0; i < projection.size(); i++) {
         int h = nChainTipHeight + 1 + i;
         std::string strPayments = GetRequiredPaymentsString(h, projection[i]);
@@ -468,7 +473,7 @@ UniValue smartnode_payments(const JSONRPCRequest& request)
             payeesArr.push_back(obj);
         }
 
-        const auto dmnPayee = deterministicMNManager->GetListForBlock(pindex).GetMNPayee();
+        const auto dmnPayee = deterministicMNManager->GetMNPayee(pindex);
         protxObj.pushKV("proTxHash", dmnPayee == nullptr ? "" : dmnPayee->proTxHash.ToString());
         protxObj.pushKV("amount", payedPerSmartnode);
         protxObj.pushKV("payees", payeesArr);
@@ -10,6 +10,7 @@
 #include <crypto/sha256.h>
 #include <pubkey.h>
 #include <script/script.h>
+#include <streams.h>
 #include <uint256.h>
 
 typedef std::vector<unsigned char> valtype;
@@ -1379,37 +1380,44 @@ public:
     }
 };
 
-uint256 GetPrevoutHash(const CTransaction& txTo) {
-    CHashWriter ss(SER_GETHASH, 0);
-    for (const auto& txin : txTo.vin) {
-        ss << txin.prevout;
+//! prevout, empty script and nSequence of an input which isn't being signed
+static const size_t BLANK_INPUT_SIZE = 32 + 4 + 1 + 4;
+
+} // namespace
+
+PrecomputedTransactionData::PrecomputedTransactionData(const CTransaction& txTo)
+{
+    // A single input gains nothing from sharing
+    if (txTo.vin.size() < 2) {
+        return;
     }
-    return ss.GetHash();
-}
 
-uint256 GetSequenceHash(const CTransaction& txTo) {
-    CHashWriter ss(SER_GETHASH, 0);
+    txHash = txTo.GetHash();
+
+    CVectorWriter s(SER_GETHASH, 0, vchLegacyBlank, 0);
+    int32_t n32bitVersion = txTo.nVersion | (txTo.nType << 16);
+    s << n32bitVersion;
+    WriteCompactSize(s, txTo.vin.size());
+    nLegacyInputsOffset = vchLegacyBlank.size();
     for (const auto& txin : txTo.vin) {
-        ss << txin.nSequence;
+        s << txin.prevout << CScript() << txin.nSequence;
+    }
+    assert(vchLegacyBlank.size() == nLegacyInputsOffset + txTo.vin.size() * BLANK_INPUT_SIZE);
+    s << txTo.vout << txTo.nLockTime;
+    if (txTo.nVersion == 3 && txTo.nType != TRANSACTION_NORMAL) {
+        s << txTo.vExtraPayload;
     }
-    return ss.GetHash();
-}
 
-uint256 GetOutputsHash(const CTransaction& txTo) {
     CHashWriter ss(SER_GETHASH, 0);
-    for (const auto& txout : txTo.vout) {
-        ss << txout;
+    ss.write((const char*)vchLegacyBlank.data(), nLegacyInputsOffset);
+    vLegacyMidstates.reserve((txTo.vin.size() + MIDSTATE_INTERVAL - 1) / MIDSTATE_INTERVAL);
+    for (size_t i = 0; i < txTo.vin.size(); i += MIDSTATE_INTERVAL) {
+        if (i != 0) {
+            ss.write((const char*)vchLegacyBlank.data() + nLegacyInputsOffset + (i - MIDSTATE_INTERVAL) * BLANK_INPUT_SIZE, MIDSTATE_INTERVAL * BLANK_INPUT_SIZE);
+        }
+        vLegacyMidstates.push_back(ss);
     }
-    return ss.GetHash();
-}
-
-} // namespace
-
-PrecomputedTransactionData::PrecomputedTransactionData(const CTransaction& txTo)
-{
-    hashPrevouts = GetPrevoutHash(txTo);
-    hashSequence = GetSequenceHash(txTo);
-    hashOutputs = GetOutputsHash(txTo);
+    fLegacyReady = true;
 }
 
 uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, const CAmount& amount, SigVersion sigversion, const PrecomputedTransactionData* cache)
@@ -1429,6 +1437,24 @@ uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsig
     // Wrapper to serialize only the necessary parts of the transaction being signed
     CTransactionSignatureSerializer txTmp(txTo, scriptCode, nIn, nHashType);
 
+    const bool fSharedSerialization = !(nHashType & SIGHASH_ANYONECANPAY) && (nHashType & 0x1f) != SIGHASH_SINGLE && (nHashType & 0x1f) != SIGHASH_NONE;
+    if (cache && cache->fLegacyReady && fSharedSerialization && cache->txHash == txTo.GetHash()) {
+        // Continue from the closest midstate in front of this input, only this input's script differs
+        const size_t nMidstate = nIn / PrecomputedTransactionData::MIDSTATE_INTERVAL;
+        const size_t nFrom = cache->nLegacyInputsOffset + nMidstate * PrecomputedTransactionData::MIDSTATE_INTERVAL * BLANK_INPUT_SIZE;
+        const size_t nInputPos = cache->nLegacyInputsOffset + nIn * BLANK_INPUT_SIZE;
+        const char* pchBlank = (const char*)cache->vchLegacyBlank.data();
+
+        CHashWriter ss(cache->vLegacyMidstates[nMidstate]);
+        ss.write(pchBlank + nFrom, nInputPos - nFrom);
+        ss << txTo.vin[nIn].prevout;
+        txTmp.SerializeScriptCode(ss);
+        ss << txTo.vin[nIn].nSequence;
+        ss.write(pchBlank + nInputPos + BLANK_INPUT_SIZE, cache->vchLegacyBlank.size() - nInputPos - BLANK_INPUT_SIZE);
+        ss << nHashType;
+        return ss.GetHash();
+    }
+
     // Serialize and hash
     CHashWriter ss(SER_GETHASH, 0);
     ss << txTmp << nHashType;
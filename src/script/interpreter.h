@@ -6,6 +6,7 @@
 #ifndef BITCOIN_SCRIPT_INTERPRETER_H
 #define BITCOIN_SCRIPT_INTERPRETER_H
 
+#include <hash.h>
 #include <script/script_error.h>
 #include <primitives/transaction.h>
 
@@ -102,9 +103,27 @@ enum
 
 bool CheckSignatureEncoding(const std::vector<unsigned char> &vchSig, unsigned int flags, ScriptError* serror);
 
+/**
+ * Data shared by the signature hashes of all inputs of a transaction, for the legacy
+ * SIGHASH_ALL serialization (without SIGHASH_ANYONECANPAY).
+ *
+ * Apart from the scriptCode of the input being signed the serialization is the same for
+ * every input, so it is kept here as one byte buffer, with every other input serialized
+ * with an empty script. Hash midstates over that buffer are stored every few inputs, so
+ * each signature hash starts close to its own input instead of hashing the whole prefix.
+ */
 struct PrecomputedTransactionData
 {
-    uint256 hashPrevouts, hashSequence, hashOutputs;
+    static const size_t MIDSTATE_INTERVAL = 16;
+
+    uint256 txHash;
+    bool fLegacyReady{false};
+    //! Serialized transaction with all scripts blanked, followed by nothing (the hash type is appended per input)
+    std::vector<unsigned char> vchLegacyBlank;
+    //! Offset of the first input in vchLegacyBlank
+    size_t nLegacyInputsOffset{0};
+    //! Hash state at input 0, MIDSTATE_INTERVAL, 2 * MIDSTATE_INTERVAL, ...
+    std::vector<CHashWriter> vLegacyMidstates;
 
     explicit PrecomputedTransactionData(const CTransaction& tx);
 };
@@ -38,6 +38,15 @@ CSporkManager::CSporkManager()
         sporkDefsById.emplace(sporkDef.sporkId, &sporkDef);
         sporkDefsByName.emplace(sporkDef.name, &sporkDef);
     }
+
+    // No spork messages yet, start with the defaults. This runs during static initialization, so don't lock here.
+    for (const auto& sporkDef : sporkDefs) {
+        size_t nIndex;
+        if (CSporkValues::GetIndex(sporkDef.sporkId, nIndex)) {
+            sporkValues.fKnown[nIndex] = true;
+            sporkValues.nValues[nIndex].store(sporkDef.defaultValue, std::memory_order_relaxed);
+        }
+    }
 }
 
 bool CSporkManager::SporkValueIsActive(SporkId nSporkID, int64_t &nActiveValueRet) const
@@ -46,12 +55,6 @@ bool CSporkManager::SporkValueIsActive(SporkId nSporkID, int64_t &nActiveValueRe
 
     if (!mapSporksActive.count(nSporkID)) return false;
 
-    auto it = mapSporksCachedValues.find(nSporkID);
-    if (it != mapSporksCachedValues.end()) {
-        nActiveValueRet = it->second;
-        return true;
-    }
-
     // calc how many values we have and how many signers vote for every value
     std::unordered_map<int64_t, int> mapValueCounts;
     for (const auto& pair: mapSporksActive.at(nSporkID)) {
@@ -60,7 +63,6 @@ bool CSporkManager::SporkValueIsActive(SporkId nSporkID, int64_t &nActiveValueRe
             // nMinSporkKeys is always more than the half of the max spork keys number,
             // so there is only one such value and we can stop here
             nActiveValueRet = pair.second.nValue;
-            mapSporksCachedValues[nSporkID] = nActiveValueRet;
             return true;
         }
     }
@@ -68,11 +70,24 @@ bool CSporkManager::SporkValueIsActive(SporkId nSporkID, int64_t &nActiveValueRe
     return false;
 }
 
+void CSporkManager::UpdateSporkValues()
+{
+    AssertLockHeld(cs);
+
+    for (const auto& sporkDef : sporkDefs) {
+        size_t nIndex;
+        if (CSporkValues::GetIndex(sporkDef.sporkId, nIndex)) {
+            sporkValues.nValues[nIndex].store(GetSporkValueLocked(sporkDef.sporkId), std::memory_order_relaxed);
+        }
+    }
+}
+
 void CSporkManager::Clear()
 {
     LOCK(cs);
     mapSporksActive.clear();
     mapSporksByHash.clear();
+    UpdateSporkValues();
     // sporkPubKeyID and sporkPrivKey should be set in init.cpp,
     // we should not alter them here.
 }
@@ -102,6 +117,7 @@ void CSporkManager::CheckAndRemove()
         }
         ++itActive;
     }
+    UpdateSporkValues();
 
     auto itByHash = mapSporksByHash.begin();
     while (itByHash != mapSporksByHash.end()) {
@@ -177,9 +193,7 @@ void CSporkManager::ProcessSpork(CNode* pfrom, const std::string& strCommand, CD
             LOCK(cs); // make sure to not lock this together with cs_main
             mapSporksByHash[hash] = spork;
             mapSporksActive[spork.nSporkID][keyIDSigner] = spork;
-            // Clear cached values on new spork being processed
-            mapSporksCachedActive.erase(spork.nSporkID);
-            mapSporksCachedValues.erase(spork.nSporkID);
+            UpdateSporkValues();
         }
         spork.Relay(connman);
 
@@ -215,9 +229,7 @@ bool CSporkManager::UpdateSpork(SporkId nSporkID, int64_t nValue, CConnman& conn
         LOCK(cs);
         mapSporksByHash[spork.GetHash()] = spork;
         mapSporksActive[nSporkID][keyIDSigner] = spork;
-        // Clear cached values on new spork being processed
-        mapSporksCachedActive.erase(spork.nSporkID);
-        mapSporksCachedValues.erase(spork.nSporkID);
+        UpdateSporkValues();
     }
 
     spork.Relay(connman);
@@ -226,26 +238,40 @@ bool CSporkManager::UpdateSpork(SporkId nSporkID, int64_t nValue, CConnman& conn
 
 bool CSporkManager::IsSporkActive(SporkId nSporkID) const
 {
-    LOCK(cs);
-    // If nSporkID is cached, and the cached value is true, then return early true
-    auto it = mapSporksCachedActive.find(nSporkID);
-    if (it != mapSporksCachedActive.end() && it->second) {
+    size_t nIndex;
+    if (!CSporkValues::GetIndex(nSporkID, nIndex) || !sporkValues.fKnown[nIndex]) {
+        return GetSporkValue(nSporkID) < GetAdjustedTime();
+    }
+
+    const int64_t nValue = sporkValues.nValues[nIndex].load(std::memory_order_relaxed);
+    // If the spork is known to be active already with this value, then return early true
+    if (nValue != CSporkValues::NO_ACTIVE_VALUE && sporkValues.nActiveValues[nIndex].load(std::memory_order_relaxed) == nValue) {
         return true;
     }
 
-    int64_t nSporkValue = GetSporkValue(nSporkID);
     // Get time is somewhat costly it looks like
-    bool ret = nSporkValue < GetAdjustedTime();
-    // Only cache true values
+    bool ret = nValue < GetAdjustedTime();
+    // Only remember true values
     if (ret) {
-        mapSporksCachedActive[nSporkID] = ret;
+        sporkValues.nActiveValues[nIndex].store(nValue, std::memory_order_relaxed);
     }
     return ret;
 }
 
 int64_t CSporkManager::GetSporkValue(SporkId nSporkID) const
 {
+    size_t nIndex;
+    if (CSporkValues::GetIndex(nSporkID, nIndex) && sporkValues.fKnown[nIndex]) {
+        return sporkValues.nValues[nIndex].load(std::memory_order_relaxed);
+    }
+
     LOCK(cs);
+    return GetSporkValueLocked(nSporkID);
+}
+
+int64_t CSporkManager::GetSporkValueLocked(SporkId nSporkID) const
+{
+    AssertLockHeld(cs);
 
     int64_t nSporkValue = -1;
     if (SporkValueIsActive(nSporkID, nSporkValue)) {
@@ -314,7 +340,9 @@ bool CSporkManager::SetMinSporkKeys(int minSporkKeys)
         LogPrintf("CSporkManager::SetMinSporkKeys -- Invalid min spork signers number: %d\n", minSporkKeys);
         return false;
     }
+    LOCK(cs);
     nMinSporkKeys = minSporkKeys;
+    UpdateSporkValues();
     return true;
 }
 
@@ -11,6 +11,9 @@
 #include <utilstrencodings.h>
 #include <key.h>
 
+#include <array>
+#include <atomic>
+#include <limits>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -57,6 +60,46 @@ struct CSporkDef
 extern std::vector<CSporkDef> sporkDefs;
 extern CSporkManager sporkManager;
 
+/**
+ * CSporkValues holds the effective value of every known spork, indexed by
+ * spork ID. CSporkManager updates it in place whenever the spork state
+ * changes, so reading a spork value is a single atomic load and doesn't need
+ * to take CSporkManager::cs.
+ */
+struct CSporkValues
+{
+    static const int32_t FIRST_SPORK_ID = SPORK_2_INSTANTSEND_ENABLED;
+    static const int32_t LAST_SPORK_ID = SPORK_25_QUORUM_POSE;
+    static const size_t SPORK_COUNT = LAST_SPORK_ID - FIRST_SPORK_ID + 1;
+    //! Marks nActiveValues entries without a value known to be active, never an active value itself
+    static const int64_t NO_ACTIVE_VALUE = std::numeric_limits<int64_t>::max();
+
+    //! Whether the ID belongs to a defined spork, fixed after construction
+    std::array<bool, SPORK_COUNT> fKnown;
+    std::array<std::atomic<int64_t>, SPORK_COUNT> nValues;
+    // Time based sporks stay active once their time has passed. The value found to be active is
+    // remembered here to avoid GetAdjustedTime, a new value for the spork doesn't match it anymore.
+    mutable std::array<std::atomic<int64_t>, SPORK_COUNT> nActiveValues;
+
+    CSporkValues()
+    {
+        fKnown.fill(false);
+        for (size_t i = 0; i < SPORK_COUNT; i++) {
+            nValues[i].store(-1, std::memory_order_relaxed);
+            nActiveValues[i].store(NO_ACTIVE_VALUE, std::memory_order_relaxed);
+        }
+    }
+
+    static bool GetIndex(SporkId nSporkID, size_t& nIndexRet)
+    {
+        if (nSporkID < FIRST_SPORK_ID || nSporkID > LAST_SPORK_ID) {
+            return false;
+        }
+        nIndexRet = nSporkID - FIRST_SPORK_ID;
+        return true;
+    }
+};
+
 /**
  * Sporks are network parameters used primarily to prevent forking and turn
  * on/off certain features. They are a soft consensus mechanism.
@@ -159,10 +202,10 @@ private:
     std::unordered_map<SporkId, CSporkDef*> sporkDefsById;
     std::unordered_map<std::string, CSporkDef*> sporkDefsByName;
 
-    mutable std::unordered_map<SporkId, bool> mapSporksCachedActive;
-    mutable std::unordered_map<SporkId, int64_t> mapSporksCachedValues;
-
     mutable CCriticalSection cs;
+
+    // What readers use, written under cs only
+    CSporkValues sporkValues;
     std::unordered_map<uint256, CSporkMessage> mapSporksByHash;
     std::unordered_map<SporkId, std::map<CKeyID, CSporkMessage> > mapSporksActive;
 
@@ -176,6 +219,15 @@ private:
      */
     bool SporkValueIsActive(SporkId nSporkID, int64_t& nActiveValueRet) const;
 
+    /**
+     * UpdateSporkValues recalculates the value of every known spork and stores
+     * it in sporkValues. Must be called after every change of the active spork
+     * messages or the signer threshold.
+     */
+    void UpdateSporkValues();
+
+    int64_t GetSporkValueLocked(SporkId nSporkID) const;
+
 public:
 
     CSporkManager();
@@ -200,6 +252,9 @@ public:
         LOCK(cs);
         READWRITE(mapSporksByHash);
         READWRITE(mapSporksActive);
+        if (ser_action.ForRead()) {
+            UpdateSporkValues();
+        }
         // we don't serialize private key to prevent its leakage
     }
 
@@ -5,6 +5,7 @@
 #include <crypto/aes.h>
 #include <crypto/chacha20.h>
 #include <crypto/chacha_poly_aead.h>
+#include <crypto/muhash.h>
 #include <crypto/poly1305.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
@@ -13,6 +14,7 @@
 #include <crypto/hmac_sha256.h>
 #include <crypto/hmac_sha512.h>
 #include <random.h>
+#include <streams.h>
 #include <utilstrencodings.h>
 #include <test/test_raptoreum.h>
 
@@ -824,4 +826,53 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+static MuHash3072 FromInt(unsigned char i) {
+    unsigned char tmp[32] = {i, 0};
+    MuHash3072 muhash;
+    muhash.Insert(tmp, sizeof(tmp));
+    return muhash;
+}
+
+static uint256 MuHashResult(MuHash3072 muhash) {
+    unsigned char out[32];
+    muhash.Finalize(out);
+    return uint256(std::vector<unsigned char>(out, out + sizeof(out)));
+}
+
+BOOST_AUTO_TEST_CASE(muhash_tests)
+{
+    // Known answer, shared with other MuHash3072 implementations
+    MuHash3072 acc = FromInt(0);
+    acc *= FromInt(1);
+    acc /= FromInt(2);
+    BOOST_CHECK_EQUAL(MuHashResult(acc).GetHex(), "10d312b100cbd32ada024a6646e40d3482fcff103668d2625f10002a607d5863");
+
+    // The set hash is independent of the order of insertions and removals
+    for (int iter = 0; iter < 10; ++iter) {
+        MuHash3072 a, b;
+        std::vector<unsigned char> elems;
+        for (int i = 0; i < 8; ++i) elems.push_back(InsecureRandBits(8));
+        for (unsigned char e : elems) a *= FromInt(e);
+        for (auto it = elems.rbegin(); it != elems.rend(); ++it) b *= FromInt(*it);
+        BOOST_CHECK(MuHashResult(a) == MuHashResult(b));
+
+        // Adding and removing an element is a no-op
+        MuHash3072 c = a;
+        unsigned char extra[32] = {0xff, 0x01};
+        c.Insert(extra, sizeof(extra));
+        c.Remove(extra, sizeof(extra));
+        BOOST_CHECK(MuHashResult(a) == MuHashResult(c));
+        c.Insert(extra, sizeof(extra));
+        BOOST_CHECK(MuHashResult(a) != MuHashResult(c));
+    }
+
+    // The state survives a serialization roundtrip
+    CDataStream ss(SER_DISK, 0);
+    ss << acc;
+    BOOST_CHECK_EQUAL(ss.size(), MuHash3072::SERIALIZED_SIZE);
+    MuHash3072 acc2;
+    ss >> acc2;
+    BOOST_CHECK(MuHashResult(acc) == MuHashResult(acc2));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
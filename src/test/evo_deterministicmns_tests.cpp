@@ -20,6 +20,7 @@
 #include <evo/specialtx.h>
 #include <evo/providertx.h>
 #include <evo/deterministicmns.h>
+#include <governance/governance.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -319,6 +320,16 @@ BOOST_FIXTURE_TEST_CASE(dip3_protx, TestChainDIP3Setup)
     for (size_t i = 0; i < 24; i++) {
         auto dmnExpectedPayee = deterministicMNManager->GetListAtChainTip().GetMNPayee();
 
+        // the payee index must agree with the sorted list
+        auto projectedFromList = deterministicMNManager->GetListAtChainTip().GetProjectedMNPayees(12);
+        auto projectedFromIndex = deterministicMNManager->GetProjectedMNPayees(chainActive.Tip(), 12);
+        BOOST_REQUIRE_EQUAL(projectedFromList.size(), projectedFromIndex.size());
+        for (size_t j = 0; j < projectedFromList.size(); j++) {
+            BOOST_CHECK(projectedFromList[j]->proTxHash == projectedFromIndex[j]->proTxHash);
+            BOOST_CHECK_EQUAL(deterministicMNManager->GetProjectedPayeePosition(projectedFromList[j]->proTxHash), (int)j + 1);
+        }
+        BOOST_CHECK(deterministicMNManager->GetMNPayee(chainActive.Tip())->proTxHash == dmnExpectedPayee->proTxHash);
+
         CBlock block = CreateAndProcessBlock({}, coinbaseKey);
         deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
         BOOST_ASSERT(!block.vtx.empty());
@@ -652,4 +663,51 @@ BOOST_FIXTURE_TEST_CASE(dip3_verify_db, TestChainDIP3Setup)
     BOOST_ASSERT(CVerifyDB().VerifyDB(Params(), pcoinsTip.get(), 4, 2));
 }
 
+BOOST_FIXTURE_TEST_CASE(dip3_governance_vote_verified_key, TestChainDIP3Setup)
+{
+    auto utxos = BuildSimpleUtxoMap(coinbaseTxns);
+
+    CKey ownerKey;
+    CBLSSecretKey operatorKey;
+    auto tx = CreateProRegTx(utxos, 1, GenerateRandomAddress(), coinbaseKey, ownerKey, operatorKey);
+    CreateAndProcessBlock({tx}, coinbaseKey);
+    deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
+    auto dmn = deterministicMNManager->GetListAtChainTip().GetMN(tx.GetHash());
+    BOOST_REQUIRE(dmn != nullptr);
+
+    // Funding votes are signed with the voting key (the owner key here), the others with the operator key
+    CGovernanceVote fundingVote(dmn->collateralOutpoint, uint256S("01"), VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+    BOOST_REQUIRE(fundingVote.Sign(ownerKey, ownerKey.GetPubKey().GetID()));
+    CGovernanceVote validVote(dmn->collateralOutpoint, uint256S("02"), VOTE_SIGNAL_VALID, VOTE_OUTCOME_YES);
+    BOOST_REQUIRE(validVote.Sign(operatorKey));
+    CBLSSecretKey otherKey;
+    otherKey.MakeNewKey();
+    CGovernanceVote badVote(dmn->collateralOutpoint, uint256S("03"), VOTE_SIGNAL_VALID, VOTE_OUTCOME_NO);
+    BOOST_REQUIRE(badVote.Sign(otherKey));
+
+    ctpl::thread_pool pool(2);
+    std::vector<CGovernanceVoteToVerify> vecToVerify{{0, &fundingVote, true}, {0, &validVote, false}, {1, &badVote, false}};
+    std::vector<uint256> vecVerifiedKeys = VerifyVoteSignatures(vecToVerify, deterministicMNManager->GetListAtChainTip(), pool);
+    BOOST_REQUIRE_EQUAL(vecVerifiedKeys.size(), 3U);
+    BOOST_CHECK(vecVerifiedKeys[0] == CGovernanceVote::GetVerifiedKeyHash(ownerKey.GetPubKey().GetID()));
+    BOOST_CHECK(vecVerifiedKeys[1] == CGovernanceVote::GetVerifiedKeyHash(operatorKey.GetPublicKey()));
+    BOOST_CHECK(vecVerifiedKeys[2].IsNull());
+    BOOST_CHECK(fundingVote.IsValid(true, vecVerifiedKeys[0]));
+    BOOST_CHECK(validVote.IsValid(false, vecVerifiedKeys[1]));
+    BOOST_CHECK(!badVote.IsValid(false, vecVerifiedKeys[2]));
+
+    // Replace both keys between the batch verification and the processing of the votes
+    CKey newVotingKey;
+    newVotingKey.MakeNewKey(true);
+    CBLSSecretKey newOperatorKey;
+    newOperatorKey.MakeNewKey();
+    tx = CreateProUpRegTx(utxos, dmn->proTxHash, ownerKey, newOperatorKey.GetPublicKey(), newVotingKey.GetPubKey().GetID(), dmn->pdmnState->scriptPayout, coinbaseKey);
+    CreateAndProcessBlock({tx}, coinbaseKey);
+    deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
+
+    // The votes are checked against the new keys again, and fail
+    BOOST_CHECK(!fundingVote.IsValid(true, vecVerifiedKeys[0]));
+    BOOST_CHECK(!validVote.IsValid(false, vecVerifiedKeys[1]));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <governance/governance-votedb.h>
+#include <random.h>
+#include <streams.h>
+#include <version.h>
+
+#include <test/test_raptoreum.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(governance_votedb_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(votedb_add_remove_serialize)
+{
+    FastRandomContext rng(true);
+    const uint256 parent = rng.rand256();
+    CGovernanceObjectVoteFile voteFile;
+
+    std::vector<COutPoint> smartnodes;
+    for (int i = 0; i < 300; i++) {
+        smartnodes.emplace_back(rng.rand256(), i);
+    }
+
+    // Every round supersedes the votes of the previous one, so dead votes get compacted away
+    std::vector<CGovernanceVote> allVotes;
+    for (int round = 0; round < 6; round++) {
+        for (int i = 0; i < 300; i++) {
+            CGovernanceVote vote(smartnodes[i], parent, VOTE_SIGNAL_FUNDING, (vote_outcome_enum_t)(1 + rng.randrange(3)));
+            vote.SetTime(1000 + round);
+            vote.SetSignature(rng.randbytes(i % 2 ? 96 : 65));
+            voteFile.AddVote(vote);
+            allVotes.push_back(vote);
+        }
+    }
+    BOOST_CHECK_EQUAL(voteFile.GetVoteCount(), 300);
+    for (size_t i = 0; i < allVotes.size(); i++) {
+        BOOST_CHECK_EQUAL(voteFile.HasVote(allVotes[i].GetHash()), i >= allVotes.size() - 300);
+    }
+    BOOST_CHECK(voteFile.GetMemoryUsage() > 0);
+
+    // Round trip, votes come back newest first with their signatures
+    CDataStream ss(SER_DISK, 0);
+    ss << voteFile;
+    CGovernanceObjectVoteFile voteFile2;
+    ss >> voteFile2;
+    std::vector<CGovernanceVote> votes = voteFile.GetVotes();
+    std::vector<CGovernanceVote> votes2 = voteFile2.GetVotes();
+    BOOST_CHECK_EQUAL(voteFile2.GetVoteCount(), 300);
+    BOOST_REQUIRE_EQUAL(votes.size(), 300);
+    BOOST_REQUIRE_EQUAL(votes2.size(), 300);
+    for (size_t i = 0; i < votes.size(); i++) {
+        const CGovernanceVote& expected = allVotes[allVotes.size() - 1 - i];
+        BOOST_CHECK(votes[i] == expected);
+        BOOST_CHECK(votes[i].GetSignature() == expected.GetSignature());
+        BOOST_CHECK(votes2[i].GetHash() == expected.GetHash());
+        BOOST_CHECK(votes2[i].GetSignature() == expected.GetSignature());
+    }
+
+    CDataStream ssVote(SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK(voteFile.SerializeVoteToStream(allVotes.back().GetHash(), ssVote));
+    CGovernanceVote vote;
+    ssVote >> vote;
+    BOOST_CHECK(vote.GetHash() == allVotes.back().GetHash());
+    BOOST_CHECK(!voteFile.SerializeVoteToStream(allVotes.front().GetHash(), ssVote));
+
+    for (int i = 0; i < 100; i++) {
+        voteFile.RemoveVotesFromSmartnode(smartnodes[i]);
+    }
+    BOOST_CHECK_EQUAL(voteFile.GetVoteCount(), 200);
+    for (size_t i = allVotes.size() - 300; i < allVotes.size() - 200; i++) {
+        BOOST_CHECK(!voteFile.HasVote(allVotes[i].GetHash()));
+    }
+    for (size_t i = allVotes.size() - 200; i < allVotes.size(); i++) {
+        BOOST_CHECK(voteFile.HasVote(allVotes[i].GetHash()));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,7 +2,9 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <clientversion.h>
 #include <policy/fees.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <uint256.h>
 #include <util.h>
@@ -13,6 +15,53 @@
 
 BOOST_FIXTURE_TEST_SUITE(policyestimator_tests, BasicTestingSetup)
 
+static std::vector<unsigned char> WriteEstimates(const CBlockPolicyEstimator& feeEst)
+{
+    CAutoFile file(tmpfile(), SER_DISK, CLIENT_VERSION);
+    BOOST_REQUIRE(!file.IsNull());
+    BOOST_REQUIRE(feeEst.Write(file));
+    std::vector<unsigned char> data(ftell(file.Get()));
+    rewind(file.Get());
+    BOOST_REQUIRE_EQUAL(fread(data.data(), 1, data.size(), file.Get()), data.size());
+    return data;
+}
+
+static void ReadEstimates(CBlockPolicyEstimator& feeEst, const std::vector<unsigned char>& data)
+{
+    CAutoFile file(tmpfile(), SER_DISK, CLIENT_VERSION);
+    BOOST_REQUIRE(!file.IsNull());
+    BOOST_REQUIRE_EQUAL(fwrite(data.data(), 1, data.size(), file.Get()), data.size());
+    rewind(file.Get());
+    BOOST_REQUIRE(feeEst.Read(file));
+}
+
+/**
+ * Compare the estimates of feeEst, computed and cached, with those of a copy
+ * read back from its estimates file. The file holds the averages with every
+ * decay applied, so the copy is what decaying each block eagerly would give.
+ */
+static void CheckEstimatesMatch(const CBlockPolicyEstimator& feeEst)
+{
+    const std::vector<unsigned char> data = WriteEstimates(feeEst);
+    // Writing leaves the estimator as it was
+    BOOST_CHECK(WriteEstimates(feeEst) == data);
+
+    CBlockPolicyEstimator eager;
+    ReadEstimates(eager, data);
+    BOOST_CHECK(WriteEstimates(eager) == data);
+
+    for (int target : {1, 2, 3, 4, 6, 8, 12, 24, 48, 100, 500, 1000}) {
+        for (bool conservative : {false, true}) {
+            const CFeeRate lazy = feeEst.estimateSmartFee(target, nullptr, conservative);
+            BOOST_CHECK(feeEst.estimateSmartFee(target, nullptr, conservative) == lazy);
+            BOOST_CHECK(eager.estimateSmartFee(target, nullptr, conservative) == lazy);
+        }
+        for (FeeEstimateHorizon horizon : {FeeEstimateHorizon::SHORT_HALFLIFE, FeeEstimateHorizon::MED_HALFLIFE, FeeEstimateHorizon::LONG_HALFLIFE}) {
+            BOOST_CHECK(eager.estimateRawFee(target, 0.85, horizon) == feeEst.estimateRawFee(target, 0.85, horizon));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
 {
     CBlockPolicyEstimator feeEst;
@@ -179,4 +228,52 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     }
 }
 
+BOOST_AUTO_TEST_CASE(LazyDecayMatchesEager)
+{
+    CBlockPolicyEstimator feeEst;
+    CTxMemPool mpool(&feeEst);
+    LOCK(mpool.cs);
+    TestMemPoolEntryHelper entry;
+    CAmount basefee(2000);
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 0LL;
+
+    // The short horizon stats fold their decay into the averages after about
+    // 1800 blocks, go past that. Transactions stop after 200 blocks to keep the
+    // rest cheap, the long horizon stats still have data by then.
+    int blocknum = 0;
+    while (blocknum < 1850) {
+        std::vector<CTransactionRef> block;
+        std::vector<CTransactionRef> evicted;
+        if (blocknum < 200) {
+            for (int j = 0; j < 10; j++) {
+                for (int k = 0; k < 2; k++) {
+                    tx.vin[0].prevout.n = 10000 * blocknum + 100 * j + k;
+                    uint256 hash = tx.GetHash();
+                    mpool.addUnchecked(hash, entry.Fee(basefee * (j + 1)).Time(GetTime()).Height(blocknum).FromTx(tx));
+                    // Higher fees get into more blocks, the rest is evicted and counts as failed.
+                    // Nothing stays in the mempool, unconfirmed transactions aren't in the file.
+                    if (j >= 9 - blocknum % 10) {
+                        block.push_back(mpool.get(hash));
+                    } else {
+                        evicted.push_back(mpool.get(hash));
+                    }
+                }
+            }
+        }
+        mpool.removeForBlock(block, ++blocknum);
+        for (const auto& ptx : evicted) {
+            mpool.removeRecursive(*ptx);
+        }
+        if (blocknum % 50 == 0 || (blocknum >= 1775 && blocknum <= 1795)) {
+            CheckEstimatesMatch(feeEst);
+        }
+    }
+    // The long horizon still gives an answer
+    BOOST_CHECK(feeEst.estimateRawFee(500, 0.85, FeeEstimateHorizon::LONG_HALFLIFE) != CFeeRate(0));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
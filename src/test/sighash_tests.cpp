@@ -161,6 +161,45 @@ BOOST_AUTO_TEST_CASE(sighash_test)
     #endif
 }
 
+// Goal: check that the shared serialization in PrecomputedTransactionData gives the same hashes
+BOOST_AUTO_TEST_CASE(sighash_precomputed)
+{
+    SeedInsecureRand(false);
+
+    for (int i = 0; i < 200; i++) {
+        CMutableTransaction mtx;
+        RandomTransaction(mtx, false);
+        // enough inputs to use several midstates
+        int ins = InsecureRandRange(3 * PrecomputedTransactionData::MIDSTATE_INTERVAL) + 2;
+        mtx.vin.resize(ins);
+        for (auto& txin : mtx.vin) {
+            txin.prevout.hash = InsecureRand256();
+            txin.nSequence = InsecureRand32();
+        }
+        // SignatureHashOld doesn't know about special transactions
+        const bool fSpecial = InsecureRandBool();
+        if (fSpecial) {
+            mtx.nVersion = 3;
+            mtx.nType = TRANSACTION_PROVIDER_UPDATE_SERVICE;
+            mtx.vExtraPayload = insecure_rand_ctx.randbytes(InsecureRandRange(100));
+        }
+        const CTransaction tx(mtx);
+        PrecomputedTransactionData txdata(tx);
+
+        for (int nIn = 0; nIn < ins; nIn++) {
+            int nHashType = InsecureRandBool() ? SIGHASH_ALL : InsecureRand32();
+            CScript scriptCode;
+            RandomScript(scriptCode);
+            BOOST_CHECK(SignatureHash(scriptCode, tx, nIn, nHashType, 0, SigVersion::BASE, &txdata) ==
+                        SignatureHash(scriptCode, tx, nIn, nHashType, 0, SigVersion::BASE));
+            if (!fSpecial && ((nHashType & 0x1f) != SIGHASH_SINGLE || nIn < (int)tx.vout.size())) {
+                BOOST_CHECK(SignatureHash(scriptCode, tx, nIn, nHashType, 0, SigVersion::BASE, &txdata) ==
+                            SignatureHashOld(scriptCode, tx, nIn, nHashType));
+            }
+        }
+    }
+}
+
 // Goal: check that SignatureHash generates correct hash
 BOOST_AUTO_TEST_CASE(sighash_from_data)
 {
@@ -194,7 +233,7 @@ BOOST_AUTO_TEST_CASE(sighash_from_data)
           stream >> tx;
 
           CValidationState state;
-          BOOST_CHECK_MESSAGE(CheckTransaction(*tx, state, 0, 0), strTest);
+          BOOST_CHECK_MESSAGE(CheckTransaction(*tx, state, CTxCheckContext(nullptr), 0), strTest);
           BOOST_CHECK(state.IsValid());
 
           std::vector<unsigned char> raw = ParseHex(raw_script);
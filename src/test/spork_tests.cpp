@@ -0,0 +1,72 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/test_raptoreum.h>
+
+#include <key.h>
+#include <key_io.h>
+#include <spork.h>
+#include <timedata.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(spork_tests, TestingSetup)
+
+static void CheckSpork(const CSporkManager& sporks, SporkId nSporkID, int64_t nValue)
+{
+    BOOST_CHECK_EQUAL(sporks.GetSporkValue(nSporkID), nValue);
+    // Ask twice, the second answer may come from the active value cache
+    BOOST_CHECK_EQUAL(sporks.IsSporkActive(nSporkID), nValue < GetAdjustedTime());
+    BOOST_CHECK_EQUAL(sporks.IsSporkActive(nSporkID), nValue < GetAdjustedTime());
+}
+
+BOOST_AUTO_TEST_CASE(spork_values_follow_updates)
+{
+    CSporkManager sporks;
+
+    CKey sporkKey;
+    sporkKey.MakeNewKey(false);
+    BOOST_CHECK(sporks.SetSporkAddress(EncodeDestination(sporkKey.GetPubKey().GetID())));
+    BOOST_CHECK(sporks.SetMinSporkKeys(1));
+    BOOST_CHECK(sporks.SetPrivKey(EncodeSecret(sporkKey)));
+
+    for (const auto& sporkDef : sporkDefs) {
+        CheckSpork(sporks, sporkDef.sporkId, sporkDef.defaultValue);
+    }
+
+    // Turn a spork on, then off again. A cached active value must not outlive the value it was found for.
+    const int64_t nPast = GetAdjustedTime() - 60;
+    BOOST_CHECK(sporks.UpdateSpork(SPORK_19_CHAINLOCKS_ENABLED, nPast, *g_connman));
+    CheckSpork(sporks, SPORK_19_CHAINLOCKS_ENABLED, nPast);
+    BOOST_CHECK(sporks.IsSporkActive(SPORK_19_CHAINLOCKS_ENABLED));
+
+    BOOST_CHECK(sporks.UpdateSpork(SPORK_19_CHAINLOCKS_ENABLED, 4070908800ULL, *g_connman));
+    CheckSpork(sporks, SPORK_19_CHAINLOCKS_ENABLED, 4070908800ULL);
+    BOOST_CHECK(!sporks.IsSporkActive(SPORK_19_CHAINLOCKS_ENABLED));
+
+    // Values that aren't times
+    BOOST_CHECK(sporks.UpdateSpork(SPORK_22_SPECIAL_TX_FEE, 0, *g_connman));
+    CheckSpork(sporks, SPORK_22_SPECIAL_TX_FEE, 0);
+    BOOST_CHECK(sporks.UpdateSpork(SPORK_22_SPECIAL_TX_FEE, 1, *g_connman));
+    CheckSpork(sporks, SPORK_22_SPECIAL_TX_FEE, 1);
+
+    // Other sporks are untouched
+    for (const auto& sporkDef : sporkDefs) {
+        if (sporkDef.sporkId != SPORK_19_CHAINLOCKS_ENABLED && sporkDef.sporkId != SPORK_22_SPECIAL_TX_FEE) {
+            CheckSpork(sporks, sporkDef.sporkId, sporkDef.defaultValue);
+        }
+    }
+
+    // Clearing the spork messages brings the defaults back
+    sporks.Clear();
+    for (const auto& sporkDef : sporkDefs) {
+        CheckSpork(sporks, sporkDef.sporkId, sporkDef.defaultValue);
+    }
+
+    // An unknown spork ID goes through the locked path
+    BOOST_CHECK_EQUAL(sporks.GetSporkValue((SporkId)(CSporkValues::LAST_SPORK_ID + 1)), -1);
+    BOOST_CHECK(sporks.IsSporkActive((SporkId)(CSporkValues::LAST_SPORK_ID + 1)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include <test/test_raptoreum.h>
 
 #include <clientversion.h>
+#include <chainparams.h>
 #include <checkqueue.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
@@ -138,7 +139,7 @@ BOOST_AUTO_TEST_CASE(tx_valid)
             CTransaction tx(deserialize, stream);
 
             CValidationState state;
-            BOOST_CHECK_MESSAGE(CheckTransaction(tx, state, 0, 0), strTest);
+            BOOST_CHECK_MESSAGE(CheckTransaction(tx, state, CTxCheckContext(nullptr), 0), strTest);
             BOOST_CHECK(state.IsValid());
 
             PrecomputedTransactionData txdata(tx);
@@ -216,7 +217,7 @@ BOOST_AUTO_TEST_CASE(tx_invalid)
             CTransaction tx(deserialize, stream);
 
             CValidationState state;
-            fValid = CheckTransaction(tx, state, 0, 0) && state.IsValid();
+            fValid = CheckTransaction(tx, state, CTxCheckContext(nullptr), 0) && state.IsValid();
 
             PrecomputedTransactionData txdata(tx);
             for (unsigned int i = 0; i < tx.vin.size() && fValid; i++)
@@ -247,11 +248,28 @@ BOOST_AUTO_TEST_CASE(basic_transaction_tests)
     CMutableTransaction tx;
     stream >> tx;
     CValidationState state;
-    BOOST_CHECK_MESSAGE(CheckTransaction(tx, state, 0, 0) && state.IsValid(), "Simple deserialized transaction should be valid.");
+    BOOST_CHECK_MESSAGE(CheckTransaction(tx, state, CTxCheckContext(nullptr), 0) && state.IsValid(), "Simple deserialized transaction should be valid.");
 
     // Check that duplicate txins fail
     tx.vin.push_back(tx.vin[0]);
-    BOOST_CHECK_MESSAGE(!CheckTransaction(tx, state, 0 ,0) || !state.IsValid(), "Transaction with duplicate txins should be invalid.");
+    BOOST_CHECK_MESSAGE(!CheckTransaction(tx, state, CTxCheckContext(nullptr), 0) || !state.IsValid(), "Transaction with duplicate txins should be invalid.");
+}
+
+BOOST_AUTO_TEST_CASE(tx_check_context)
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    mtx.vout.resize(2);
+    mtx.vout[0].nValue = 1 * CENT;
+    mtx.vout[1].nValue = 2 * CENT;
+    const CTransaction tx(mtx);
+    BOOST_CHECK_EQUAL(tx.GetTotalSize(), ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION));
+
+    const int nFutureForkBlock = Params().GetConsensus().nFutureForkBlock;
+    BOOST_CHECK(!CTxCheckContext(nFutureForkBlock - 1).fFutureActive);
+    BOOST_CHECK(CTxCheckContext(nFutureForkBlock).fFutureActive);
+    BOOST_CHECK_EQUAL(CTxCheckContext(nullptr).nHeight, 0);
 }
 
 //
@@ -104,6 +104,55 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_block_doublespend, TestChain100Setup)
     BOOST_CHECK_EQUAL(mempool.size(), 0);
 }
 
+BOOST_FIXTURE_TEST_CASE(tx_reorg_script_cache, TestChain100Setup)
+{
+    // A block that is disconnected and connected again keeps its transactions in
+    // the script execution cache, and skips the script checks when it comes back.
+    CScript scriptPubKey = CScript() <<  ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout.hash = coinbaseTxns[0].GetHash();
+    spend.vin[0].prevout.n = 0;
+    spend.vout.resize(1);
+    spend.vout[0].nValue = 11*CENT;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    BOOST_CHECK(ToMemPool(spend));
+    CBlock block = CreateAndProcessBlock({spend}, scriptPubKey);
+    BOOST_CHECK_EQUAL(mempool.size(), 0);
+
+    const CReorgStats before = GetReorgStats();
+    CValidationState state;
+    {
+        LOCK(cs_main);
+        CBlockIndex* pindex = LookupBlockIndex(block.GetHash());
+        BOOST_CHECK(chainActive.Tip() == pindex);
+        BOOST_CHECK(InvalidateBlock(state, Params(), pindex));
+        BOOST_CHECK(chainActive.Tip() == pindex->pprev);
+
+        // The spend is back in the mempool
+        BOOST_CHECK(mempool.exists(spend.GetHash()));
+        BOOST_CHECK(ResetBlockFailureFlags(pindex));
+    }
+    BOOST_CHECK_EQUAL(GetReorgStats().nTxCacheWarmed, before.nTxCacheWarmed + 1);
+
+    BOOST_CHECK(ActivateBestChain(state, Params()));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    }
+    BOOST_CHECK_EQUAL(GetReorgStats().nBlocksScriptsSkipped, before.nBlocksScriptsSkipped + 1);
+    BOOST_CHECK_EQUAL(mempool.size(), 0);
+}
+
 // Run CheckInputs (using pcoinsTip) on the given transaction, for all script
 // flags.  Test that CheckInputs passes for all flags that don't overlap with
 // the failing_flags argument, but otherwise fails.
@@ -0,0 +1,210 @@
+// Copyright (c) 2020-2022 The Raptoreum developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/transaction.h>
+#include <scheduler.h>
+#include <validationinterface.h>
+
+#include <test/test_raptoreum.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+
+#include <boost/thread.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+/** Runs the background scheduler with a single thread like init does */
+struct ValidationInterfaceSetup : public BasicTestingSetup {
+    CScheduler scheduler;
+    boost::thread_group threads;
+
+    ValidationInterfaceSetup()
+    {
+        threads.create_thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+        GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+    }
+
+    ~ValidationInterfaceSetup()
+    {
+        threads.interrupt_all();
+        threads.join_all();
+        GetMainSignals().FlushBackgroundCallbacks();
+        GetMainSignals().UnregisterBackgroundSignalScheduler();
+    }
+};
+
+/** Subscriber that optionally blocks in its first callback until released */
+class TestSubscriber : public CValidationInterface
+{
+public:
+    std::atomic<int> nCalls{0};
+    std::atomic<bool> fFinished{false};
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> releaseFuture;
+
+    explicit TestSubscriber(bool fBlock)
+    {
+        if (fBlock) {
+            releaseFuture = release.get_future().share();
+        } else {
+            release.set_value();
+        }
+    }
+
+    bool WaitStarted()
+    {
+        return started.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+    }
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef& ptxn, int64_t nAcceptTime) override
+    {
+        if (nCalls++ == 0) {
+            started.set_value();
+            if (releaseFuture.valid()) {
+                releaseFuture.wait();
+            }
+        }
+        fFinished = true;
+    }
+};
+
+void NotifyTransactions(int nCount)
+{
+    CTransactionRef tx = MakeTransactionRef();
+    for (int i = 0; i < nCount; i++) {
+        GetMainSignals().TransactionAddedToMempool(tx, 0);
+    }
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, ValidationInterfaceSetup)
+
+BOOST_AUTO_TEST_CASE(per_subscriber_queues)
+{
+    TestSubscriber slow(true);
+    TestSubscriber fast(false);
+    RegisterValidationInterface(&slow, "slow");
+    RegisterValidationInterface(&fast, "fast");
+
+    NotifyTransactions(1);
+    BOOST_CHECK(slow.WaitStarted());
+    // The blocked subscriber doesn't hold up the other one
+    BOOST_CHECK(fast.WaitStarted());
+    BOOST_CHECK(!slow.fFinished);
+
+    slow.release.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(slow.nCalls, 1);
+    BOOST_CHECK_EQUAL(fast.nCalls, 1);
+
+    UnregisterAllValidationInterfaces();
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_CASE(backpressure)
+{
+    TestSubscriber unconstrained(true);
+    RegisterValidationInterface(&unconstrained, "unconstrained", false);
+
+    NotifyTransactions(20);
+    BOOST_CHECK(unconstrained.WaitStarted());
+    // Validation neither counts nor waits for a subscriber without backpressure
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 0U);
+    SyncWithBackpressureValidationInterfaceQueues();
+
+    TestSubscriber constrained(true);
+    RegisterValidationInterface(&constrained, "constrained");
+    NotifyTransactions(1);
+    BOOST_CHECK(constrained.WaitStarted());
+    NotifyTransactions(5);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 5U);
+
+    unconstrained.release.set_value();
+    constrained.release.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 0U);
+    BOOST_CHECK_EQUAL(unconstrained.nCalls, 26);
+    BOOST_CHECK_EQUAL(constrained.nCalls, 6);
+
+    UnregisterAllValidationInterfaces();
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_CASE(bounded_without_backpressure)
+{
+    TestSubscriber unconstrained(true);
+    RegisterValidationInterface(&unconstrained, "unconstrained", false);
+
+    NotifyTransactions(1);
+    BOOST_CHECK(unconstrained.WaitStarted());
+    NotifyTransactions(MAX_CALLBACKS_WITHOUT_BACKPRESSURE + 10);
+
+    std::vector<ValidationInterfaceQueueStats> stats = GetMainSignals().GetQueueStats();
+    BOOST_CHECK_EQUAL(stats.size(), 1U);
+    BOOST_CHECK_EQUAL(stats[0].nPending, MAX_CALLBACKS_WITHOUT_BACKPRESSURE);
+    BOOST_CHECK_EQUAL(stats[0].nDropped, 10U);
+
+    unconstrained.release.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(unconstrained.nCalls, (int)MAX_CALLBACKS_WITHOUT_BACKPRESSURE + 1);
+
+    UnregisterAllValidationInterfaces();
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_CASE(no_slot_reuse_while_running)
+{
+    TestSubscriber first(true);
+    RegisterValidationInterface(&first, "first");
+    NotifyTransactions(1);
+    BOOST_CHECK(first.WaitStarted());
+    UnregisterValidationInterface(&first);
+
+    // The queue of the first subscriber is empty but its callback still runs,
+    // a new registration must not end up waiting behind it
+    TestSubscriber second(false);
+    RegisterValidationInterface(&second, "second");
+    NotifyTransactions(1);
+    BOOST_CHECK(second.WaitStarted());
+    BOOST_CHECK(!first.fFinished);
+
+    first.release.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(first.nCalls, 1);
+    BOOST_CHECK_EQUAL(second.nCalls, 1);
+
+    UnregisterAllValidationInterfaces();
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_CASE(unregister_while_running)
+{
+    TestSubscriber sub(true);
+    RegisterValidationInterface(&sub, "sub");
+
+    NotifyTransactions(3);
+    BOOST_CHECK(sub.WaitStarted());
+    UnregisterValidationInterface(&sub);
+
+    // The barrier has to wait for the callback that is still running, or the
+    // caller could free the subscriber under it
+    std::future<void> synced = std::async(std::launch::async, SyncWithValidationInterfaceQueue);
+    BOOST_CHECK(synced.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+    sub.release.set_value();
+    synced.get();
+    BOOST_CHECK(sub.fFinished);
+
+    // Callbacks queued before the unregistration are dropped, as are new events
+    NotifyTransactions(1);
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(sub.nCalls, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
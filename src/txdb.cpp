@@ -8,6 +8,7 @@
 #include <chainparams.h>
 #include <hash.h>
 #include <key_io.h>
+#include <node/coinstats.h>
 #include <random.h>
 #include <pow.h>
 #include <uint256.h>
@@ -28,6 +29,8 @@ static const char DB_ADDRESSUNSPENTINDEX = 'u';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_FUTUREINDEX = 'n';
+static const char DB_BLOCKSTATSINDEX = 'k';
+static const char DB_FUTUREMATURITYINDEX = 'm';
 static const char DB_BLOCK_INDEX = 'b';
 
 static const char DB_BEST_BLOCK = 'B';
@@ -35,6 +38,8 @@ static const char DB_HEAD_BLOCKS = 'H';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_COINS_STATS = 'S';
+static const char DB_COINS_STATS_HEIGHT = 'h';
 
 namespace {
 
@@ -142,8 +147,20 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
     batch.Erase(DB_HEAD_BLOCKS);
     batch.Write(DB_BEST_BLOCK, hashBlock);
 
+    // The UTXO set statistics describing hashBlock go in the same batch, so
+    // they can't get ahead of or fall behind the coins after a crash
+    CCoinsStatsState statsTip;
+    std::vector<CCoinsStatsEntry> vStatsEntries;
+    if (m_stats_tracker) {
+        const bool fStatsTip = m_stats_tracker->GetUnflushed(hashBlock, statsTip, vStatsEntries);
+        WriteCoinsStats(batch, fStatsTip ? &statsTip : nullptr, vStatsEntries);
+    }
+
     LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
     bool ret = db.WriteBatch(batch);
+    if (ret && m_stats_tracker) {
+        m_stats_tracker->MarkFlushed(hashBlock, vStatsEntries);
+    }
     LogPrint(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
     return ret;
 }
@@ -153,6 +170,33 @@ size_t CCoinsViewDB::EstimateSize() const
     return db.EstimateSize(DB_COIN, (char)(DB_COIN+1));
 }
 
+bool CCoinsViewDB::ReadCoinsStats(CCoinsStatsState& state) const
+{
+    return db.Read(DB_COINS_STATS, state);
+}
+
+bool CCoinsViewDB::ReadCoinsStats(int nHeight, CCoinsStatsEntry& entry) const
+{
+    return db.Read(std::make_pair(DB_COINS_STATS_HEIGHT, nHeight), entry);
+}
+
+void CCoinsViewDB::WriteCoinsStats(CDBBatch& batch, const CCoinsStatsState* pstate, const std::vector<CCoinsStatsEntry>& vEntries)
+{
+    if (pstate) {
+        batch.Write(DB_COINS_STATS, *pstate);
+    }
+    for (const auto& entry : vEntries) {
+        batch.Write(std::make_pair(DB_COINS_STATS_HEIGHT, entry.nHeight), entry);
+    }
+}
+
+bool CCoinsViewDB::WriteCoinsStats(const CCoinsStatsState* pstate, const std::vector<CCoinsStatsEntry>& vEntries)
+{
+    CDBBatch batch(db);
+    WriteCoinsStats(batch, pstate, vEntries);
+    return db.WriteBatch(batch);
+}
+
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(gArgs.IsArgSet("-blocksdir") ? GetDataDir() / "blocks" / "index" : GetBlocksDir() / "index", nCacheSize, fMemory, fWipe), mapHasTxIndexCache(10000, 20000) {
 }
 
@@ -400,6 +444,51 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
+bool CBlockTreeDB::WriteBlockStatsIndex(const uint256 &blockHash, const CBlockStatsIndexValue &value) {
+    return Write(std::make_pair(DB_BLOCKSTATSINDEX, blockHash), value);
+}
+
+bool CBlockTreeDB::ReadBlockStatsIndex(const uint256 &blockHash, CBlockStatsIndexValue &value) {
+    return Read(std::make_pair(DB_BLOCKSTATSINDEX, blockHash), value);
+}
+
+bool CBlockTreeDB::WriteFutureMaturityIndex(const std::vector<std::pair<CFutureMaturityKey, CAmount> > &vect) {
+    CDBBatch batch(*this);
+    for (const auto& entry : vect)
+        batch.Write(std::make_pair(DB_FUTUREMATURITYINDEX, entry.first), entry.second);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseFutureMaturityIndex(const std::vector<CFutureMaturityKey> &vect) {
+    CDBBatch batch(*this);
+    for (const auto& key : vect)
+        batch.Erase(std::make_pair(DB_FUTUREMATURITYINDEX, key));
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadFutureMaturityIndex(int maturityHeight, std::vector<std::pair<CFutureMaturityKey, CAmount> > &vect) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_FUTUREMATURITYINDEX, CFutureMaturityKey(maturityHeight, uint256(), 0)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CFutureMaturityKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_FUTUREMATURITYINDEX && key.second.maturityHeight == maturityHeight) {
+            CAmount amount;
+            if (!pcursor->GetValue(amount)) {
+                return error("failed to get future maturity index value");
+            }
+            vect.push_back(std::make_pair(key.second, amount));
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
     batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
@@ -12,6 +12,7 @@
 #include <limitedmap.h>
 #include <indices/spent_index.h>
 #include <indices/future_index.h>
+#include <indices/block_stats_index.h>
 #include <sync.h>
 
 #include <map>
@@ -22,6 +23,9 @@
 
 class CBlockIndex;
 class CCoinsViewDBCursor;
+struct CCoinsStatsEntry;
+struct CCoinsStatsState;
+class CCoinsStatsTracker;
 class uint256;
 
 //! No need to periodic flush if at least this much space still available.
@@ -73,6 +77,10 @@ class CCoinsViewDB final : public CCoinsView
 {
 protected:
     CDBWrapper db;
+    //! Written in the final batch of every BatchWrite
+    CCoinsStatsTracker* m_stats_tracker{nullptr};
+
+    void WriteCoinsStats(CDBBatch& batch, const CCoinsStatsState* pstate, const std::vector<CCoinsStatsEntry>& vEntries);
 public:
     explicit CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
@@ -87,6 +95,13 @@ public:
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
+
+    //! Rolling UTXO set statistics of the tip and per height, see CCoinsStatsTracker
+    bool ReadCoinsStats(CCoinsStatsState& state) const;
+    bool ReadCoinsStats(int nHeight, CCoinsStatsEntry& entry) const;
+    bool WriteCoinsStats(const CCoinsStatsState* pstate, const std::vector<CCoinsStatsEntry>& vEntries);
+    //! Write the tracker's statistics together with the coins they describe
+    void SetCoinsStatsTracker(CCoinsStatsTracker* tracker) { m_stats_tracker = tracker; }
 };
 
 /** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
@@ -144,6 +159,11 @@ public:
     bool ReadAddressIndex(uint160 addressHash, int type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                           int start = 0, int end = 0);
+    bool WriteBlockStatsIndex(const uint256 &blockHash, const CBlockStatsIndexValue &value);
+    bool ReadBlockStatsIndex(const uint256 &blockHash, CBlockStatsIndexValue &value);
+    bool WriteFutureMaturityIndex(const std::vector<std::pair<CFutureMaturityKey, CAmount> > &vect);
+    bool EraseFutureMaturityIndex(const std::vector<CFutureMaturityKey> &vect);
+    bool ReadFutureMaturityIndex(int maturityHeight, std::vector<std::pair<CFutureMaturityKey, CAmount> > &vect);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
     bool WriteFlag(const std::string &name, bool fValue);
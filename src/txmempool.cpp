@@ -28,7 +28,7 @@
 
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee, const CAmount& _specialTxFee, int64_t _nTime, unsigned int _entryHeight, bool _spendsCoinbase, unsigned int _sigOps, LockPoints lp) :
-    tx(_tx), nFee(_nFee), specialTxFee(_specialTxFee) ,nTime(_nTime), entryHeight(_entryHeight), spendsCoinbase(_spendsCoinbase), sigOpCount(_sigOps), lockPoints(lp)
+    tx(_tx), nFee(_nFee), specialTxFee(_specialTxFee), nTime(_nTime), lockPoints(lp), entryHeight(_entryHeight), sigOpCount(_sigOps), spendsCoinbase(_spendsCoinbase)
 {
     nTxSize = ::GetSerializeSize(*_tx, SER_NETWORK, PROTOCOL_VERSION);
     nUsageSize = RecursiveDynamicUsage(tx);
@@ -63,13 +63,14 @@ void CTxMemPoolEntry::UpdateLockPoints(const LockPoints& lp)
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap &cachedDescendants, const std::set<uint256> &setExclude)
 {
     setEntries stageEntries, setAllDescendants;
-    stageEntries = GetMemPoolChildren(updateIt);
+    const linkEntries &setUpdateChildren = GetMemPoolChildren(updateIt);
+    stageEntries.insert(setUpdateChildren.begin(), setUpdateChildren.end());
 
     while (!stageEntries.empty()) {
         const txiter cit = *stageEntries.begin();
         setAllDescendants.insert(cit);
         stageEntries.erase(cit);
-        const setEntries &setChildren = GetMemPoolChildren(cit);
+        const linkEntries &setChildren = GetMemPoolChildren(cit);
         for (txiter childEntry : setChildren) {
             cacheMap::iterator cacheIt = cachedDescendants.find(childEntry);
             if (cacheIt != cachedDescendants.end()) {
@@ -173,7 +174,8 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
         // If we're not searching for parents, we require this to be an
         // entry in the mempool already.
         txiter it = mapTx.iterator_to(entry);
-        parentHashes = GetMemPoolParents(it);
+        const linkEntries &setMemPoolParents = GetMemPoolParents(it);
+        parentHashes.insert(setMemPoolParents.begin(), setMemPoolParents.end());
     }
 
     size_t totalSizeWithAncestors = entry.GetTxSize();
@@ -196,7 +198,7 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
             return false;
         }
 
-        const setEntries & setMemPoolParents = GetMemPoolParents(stageit);
+        const linkEntries & setMemPoolParents = GetMemPoolParents(stageit);
         for (const txiter &phash : setMemPoolParents) {
             // If this is a new ancestor, add it.
             if (setAncestors.count(phash) == 0) {
@@ -214,7 +216,7 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
 
 void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, setEntries &setAncestors)
 {
-    setEntries parentIters = GetMemPoolParents(it);
+    const linkEntries &parentIters = GetMemPoolParents(it);
     // add or remove this tx as a child of each parent
     for (txiter piter : parentIters) {
         UpdateChild(piter, it, add);
@@ -243,7 +245,7 @@ void CTxMemPool::UpdateEntryForAncestors(txiter it, const setEntries &setAncesto
 
 void CTxMemPool::UpdateChildrenForRemoval(txiter it)
 {
-    const setEntries &setMemPoolChildren = GetMemPoolChildren(it);
+    const linkEntries &setMemPoolChildren = GetMemPoolChildren(it);
     for (txiter updateIt : setMemPoolChildren) {
         UpdateParent(updateIt, it, false);
     }
@@ -258,7 +260,7 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // updateDescendants should be true whenever we're not recursively
         // removing a tx and all its descendants, eg when a transaction is
         // confirmed in a block.
-        // Here we only update statistics and not data in mapLinks (which
+        // Here we only update statistics and not data in vTxLinks (which
         // we need to preserve until we're finished with all operations that
         // need to traverse the mempool).
         for (txiter removeIt : entriesToRemove) {
@@ -283,16 +285,16 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // should be a bit faster.
         // However, if we happen to be in the middle of processing a reorg, then
         // the mempool can be in an inconsistent state.  In this case, the set
-        // of ancestors reachable via mapLinks will be the same as the set of
+        // of ancestors reachable via vTxLinks will be the same as the set of
         // ancestors whose packages include this transaction, because when we
         // add a new transaction to the mempool in addUnchecked(), we assume it
         // has no children, and in the case of a reorg where that assumption is
         // false, the in-mempool children aren't linked to the in-block tx's
         // until UpdateTransactionsFromBlock() is called.
         // So if we're being called during a reorg, ie before
-        // UpdateTransactionsFromBlock() has been called, then mapLinks[] will
+        // UpdateTransactionsFromBlock() has been called, then vTxLinks will
         // differ from the set of mempool parents we'd calculate by searching,
-        // and it's important that we use the mapLinks[] notion of ancestor
+        // and it's important that we use the vTxLinks notion of ancestor
         // transactions as the set of things to update for removal.
         CalculateMemPoolAncestors(entry, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
         // Note that UpdateAncestorsOf severs the child links that point to
@@ -363,7 +365,9 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     // Used by AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
     indexed_transaction_set::iterator newit = mapTx.insert(entry).first;
-    mapLinks.insert(make_pair(newit, TxLinks()));
+    vTxHashes.emplace_back(hash, newit);
+    vTxLinks.emplace_back();
+    newit->vTxHashesIdx = vTxHashes.size() - 1;
 
     // Update transaction for any feeDelta created by PrioritiseTransaction
     // TODO: refactor so that the fee delta is calculated before inserting
@@ -408,9 +412,6 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     totalTxSize += entry.GetTxSize();
     if (minerPolicyEstimator) {minerPolicyEstimator->processTransaction(entry, validFeeEstimate);}
 
-    vTxHashes.emplace_back(hash, newit);
-    newit->vTxHashesIdx = vTxHashes.size() - 1;
-
     // Invalid ProTxes should never get this far because transactions should be
     // fully checked by AcceptToMemoryPool() at this point, so we just assume that
     // everything is fine here.
@@ -443,10 +444,8 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
         mapProTxBlsPubKeyHashes.emplace(proTx.pubKeyOperator.GetHash(), tx.GetHash());
         auto dmn = deterministicMNManager->GetListAtChainTip().GetMN(proTx.proTxHash);
         assert(dmn);
-        newit->validForProTxKey = ::SerializeHash(dmn->pdmnState->pubKeyOperator);
-        if (dmn->pdmnState->pubKeyOperator.Get() != proTx.pubKeyOperator) {
-            newit->isKeyChangeProTx = true;
-        }
+        mapProTxKeyChanges.emplace(tx.GetHash(), std::make_pair(::SerializeHash(dmn->pdmnState->pubKeyOperator),
+                                                                dmn->pdmnState->pubKeyOperator.Get() != proTx.pubKeyOperator));
     } else if (tx.nType == TRANSACTION_PROVIDER_UPDATE_REVOKE) {
         CProUpRevTx proTx;
         bool ok = GetTxPayload(tx, proTx);
@@ -454,10 +453,8 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
         mapProTxRefs.emplace(proTx.proTxHash, tx.GetHash());
         auto dmn = deterministicMNManager->GetListAtChainTip().GetMN(proTx.proTxHash);
         assert(dmn);
-        newit->validForProTxKey = ::SerializeHash(dmn->pdmnState->pubKeyOperator);
-        if (dmn->pdmnState->pubKeyOperator.Get() != CBLSPublicKey()) {
-            newit->isKeyChangeProTx = true;
-        }
+        mapProTxKeyChanges.emplace(tx.GetHash(), std::make_pair(::SerializeHash(dmn->pdmnState->pubKeyOperator),
+                                                                dmn->pdmnState->pubKeyOperator.Get() != CBLSPublicKey()));
     }
 
     return true;
@@ -693,14 +690,21 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     for (const CTxIn& txin : it->GetTx().vin)
         mapNextTx.erase(txin.prevout);
 
+    cachedInnerUsage -= vTxLinks[it->vTxHashesIdx].parents.DynamicMemoryUsage() + vTxLinks[it->vTxHashesIdx].children.DynamicMemoryUsage();
     if (vTxHashes.size() > 1) {
         vTxHashes[it->vTxHashesIdx] = std::move(vTxHashes.back());
+        vTxLinks[it->vTxHashesIdx] = std::move(vTxLinks.back());
         vTxHashes[it->vTxHashesIdx].second->vTxHashesIdx = it->vTxHashesIdx;
         vTxHashes.pop_back();
-        if (vTxHashes.size() * 2 < vTxHashes.capacity())
+        vTxLinks.pop_back();
+        if (vTxHashes.size() * 2 < vTxHashes.capacity()) {
             vTxHashes.shrink_to_fit();
-    } else
+            vTxLinks.shrink_to_fit();
+        }
+    } else {
         vTxHashes.clear();
+        vTxLinks.clear();
+    }
 
     auto eraseProTxRef = [&](const uint256& proTxHash, const uint256& txHash) {
         auto its = mapProTxRefs.equal_range(proTxHash);
@@ -740,18 +744,18 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
         }
         eraseProTxRef(proTx.proTxHash, it->GetTx().GetHash());
         mapProTxBlsPubKeyHashes.erase(proTx.pubKeyOperator.GetHash());
+        mapProTxKeyChanges.erase(it->GetTx().GetHash());
     } else if (it->GetTx().nType == TRANSACTION_PROVIDER_UPDATE_REVOKE) {
         CProUpRevTx proTx;
         if (!GetTxPayload(it->GetTx(), proTx)) {
             assert(false);
         }
         eraseProTxRef(proTx.proTxHash, it->GetTx().GetHash());
+        mapProTxKeyChanges.erase(it->GetTx().GetHash());
     }
 
     totalTxSize -= it->GetTxSize();
     cachedInnerUsage -= it->DynamicMemoryUsage();
-    cachedInnerUsage -= memusage::DynamicUsage(mapLinks[it].parents) + memusage::DynamicUsage(mapLinks[it].children);
-    mapLinks.erase(it);
     mapTx.erase(it);
     nTransactionsUpdated++;
     if (minerPolicyEstimator) {minerPolicyEstimator->removeTx(hash, false);}
@@ -779,7 +783,7 @@ void CTxMemPool::CalculateDescendants(txiter entryit, setEntries &setDescendants
         setDescendants.insert(it);
         stage.erase(it);
 
-        const setEntries &setChildren = GetMemPoolChildren(it);
+        const linkEntries &setChildren = GetMemPoolChildren(it);
         for (const txiter &childiter : setChildren) {
             if (!setDescendants.count(childiter)) {
                 stage.insert(childiter);
@@ -965,7 +969,9 @@ void CTxMemPool::removeProTxKeyChangedConflicts(const CTransaction &tx, const ui
         if (txit == mapTx.end()) {
             continue;
         }
-        if (txit->validForProTxKey != newKeyHash) {
+        // Refs without a recorded key (e.g. ProUpServTx) never match the new key
+        auto keyIt = mapProTxKeyChanges.find(txit->GetTx().GetHash());
+        if (keyIt == mapProTxKeyChanges.end() || keyIt->second.first != newKeyHash) {
             conflictingTxs.emplace(txit->GetTx().GetHash());
         }
     }
@@ -1067,11 +1073,13 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
 
 void CTxMemPool::_clear()
 {
-    mapLinks.clear();
+    vTxLinks.clear();
+    vTxHashes.clear();
     mapTx.clear();
     mapNextTx.clear();
     mapProTxAddresses.clear();
     mapProTxPubKeyIDs.clear();
+    mapProTxKeyChanges.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
     lastRollingFeeUpdate = GetTime();
@@ -1086,13 +1094,12 @@ void CTxMemPool::clear()
     _clear();
 }
 
-static void CheckInputsAndUpdateCoins(const CTransaction& tx, CCoinsViewCache& mempoolDuplicate, const int64_t spendheight)
+static void CheckInputsAndUpdateCoins(const CTransaction& tx, CCoinsViewCache& mempoolDuplicate, const int64_t spendheight, const CTxCheckContext& ctx)
 {
     CValidationState state;
     CAmount txfee = 0;
     CAmount specialTxFee = 0;
-    bool isV17active = Params().IsFutureActive(chainActive.Tip());
-    bool fCheckResult = tx.IsCoinBase() || Consensus::CheckTxInputs(tx, state, mempoolDuplicate, spendheight, txfee, specialTxFee, isV17active, true);
+    bool fCheckResult = tx.IsCoinBase() || Consensus::CheckTxInputs(tx, state, mempoolDuplicate, spendheight, txfee, specialTxFee, ctx, true);
     assert(fCheckResult);
     UpdateCoins(tx, mempoolDuplicate, 1000000);
 }
@@ -1113,6 +1120,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
 
     CCoinsViewCache mempoolDuplicate(const_cast<CCoinsViewCache*>(pcoins));
     const int64_t spendheight = GetSpendHeight(mempoolDuplicate);
+    const CTxCheckContext txCheckContext(spendheight - 1);
 
     std::list<const CTxMemPoolEntry*> waitingOnDependants;
     for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
@@ -1120,10 +1128,9 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
         checkTotal += it->GetTxSize();
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
-        txlinksMap::const_iterator linksiter = mapLinks.find(it);
-        assert(linksiter != mapLinks.end());
-        const TxLinks &links = linksiter->second;
-        innerUsage += memusage::DynamicUsage(links.parents) + memusage::DynamicUsage(links.children);
+        assert(it->vTxHashesIdx < vTxLinks.size() && vTxHashes[it->vTxHashesIdx].second == it);
+        const TxLinks &links = vTxLinks[it->vTxHashesIdx];
+        innerUsage += links.parents.DynamicMemoryUsage() + links.children.DynamicMemoryUsage();
         bool fDependsWait = false;
         setEntries setParentCheck;
         int64_t parentSizes = 0;
@@ -1149,7 +1156,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
             assert(it3->second == &tx);
             i++;
         }
-        assert(setParentCheck == GetMemPoolParents(it));
+        assert(GetMemPoolParents(it) == setParentCheck);
         // Verify ancestor state is correct.
         setEntries setAncestors;
         uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
@@ -1182,7 +1189,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
                 childSizes += childit->GetTxSize();
             }
         }
-        assert(setChildrenCheck == GetMemPoolChildren(it));
+        assert(GetMemPoolChildren(it) == setChildrenCheck);
         // Also check to make sure size is greater than sum with immediate children.
         // just a sanity check, not definitive that this calc is correct...
         assert(it->GetSizeWithDescendants() >= childSizes + it->GetTxSize());
@@ -1190,7 +1197,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
         if (fDependsWait)
             waitingOnDependants.push_back(&(*it));
         else {
-            CheckInputsAndUpdateCoins(tx, mempoolDuplicate, spendheight);
+            CheckInputsAndUpdateCoins(tx, mempoolDuplicate, spendheight, txCheckContext);
         }
     }
     unsigned int stepsSinceLastRemove = 0;
@@ -1202,7 +1209,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
             stepsSinceLastRemove++;
             assert(stepsSinceLastRemove < waitingOnDependants.size());
         } else {
-            CheckInputsAndUpdateCoins(entry->GetTx(), mempoolDuplicate, spendheight);
+            CheckInputsAndUpdateCoins(entry->GetTx(), mempoolDuplicate, spendheight, txCheckContext);
             stepsSinceLastRemove = 0;
         }
     }
@@ -1317,11 +1324,8 @@ bool CTxMemPool::existsProviderTxConflict(const CTransaction &tx) const {
 
     auto hasKeyChangeInMempool = [&](const uint256& proTxHash) {
         for (auto its = mapProTxRefs.equal_range(proTxHash); its.first != its.second; ++its.first) {
-            auto txit = mapTx.find(its.first->second);
-            if (txit == mapTx.end()) {
-                continue;
-            }
-            if (txit->isKeyChangeProTx) {
+            auto keyIt = mapProTxKeyChanges.find(its.first->second);
+            if (keyIt != mapProTxKeyChanges.end() && keyIt->second.second) {
                 return true;
             }
         }
@@ -1476,7 +1480,36 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 12 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+}
+
+CTxMemPool::MemoryUsage CTxMemPool::GetMemoryUsage() const {
+    LOCK(cs);
+    MemoryUsage usage;
+    usage.nEntries = memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size();
+    for (const CTxMemPoolEntry& entry : mapTx) {
+        usage.nTransactions += entry.DynamicMemoryUsage();
+    }
+    usage.nLinks = memusage::DynamicUsage(vTxLinks);
+    for (const TxLinks& links : vTxLinks) {
+        usage.nLinks += links.parents.DynamicMemoryUsage() + links.children.DynamicMemoryUsage();
+    }
+    usage.nNextTx = memusage::DynamicUsage(mapNextTx);
+    usage.nDeltas = memusage::DynamicUsage(mapDeltas);
+    usage.nTxHashes = memusage::DynamicUsage(vTxHashes);
+    usage.nAddressIndex = memusage::DynamicUsage(mapAddress) + memusage::DynamicUsage(mapAddressInserted);
+    for (const auto& pair : mapAddressInserted) {
+        usage.nAddressIndex += memusage::DynamicUsage(pair.second);
+    }
+    usage.nSpentIndex = memusage::DynamicUsage(mapSpent) + memusage::DynamicUsage(mapSpentInserted);
+    for (const auto& pair : mapSpentInserted) {
+        usage.nSpentIndex += memusage::DynamicUsage(pair.second);
+    }
+    usage.nFutureIndex = memusage::DynamicUsage(mapFuture) + memusage::DynamicUsage(mapFutureInserted);
+    usage.nProTx = memusage::DynamicUsage(mapProTxRefs) + memusage::DynamicUsage(mapProTxAddresses) + memusage::DynamicUsage(mapProTxPubKeyIDs) +
+                   memusage::DynamicUsage(mapProTxBlsPubKeyHashes) + memusage::DynamicUsage(mapProTxCollaterals) +
+                   memusage::DynamicUsage(mapProTxKeyChanges);
+    return usage;
 }
 
 void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
@@ -1519,38 +1552,40 @@ bool CTxMemPool::addUnchecked(const uint256&hash, const CTxMemPoolEntry &entry,
 
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
-    setEntries s;
-    if (add && mapLinks[entry].children.insert(child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && mapLinks[entry].children.erase(child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    linkEntries &children = vTxLinks[entry->vTxHashesIdx].children;
+    cachedInnerUsage -= children.DynamicMemoryUsage();
+    if (add) {
+        children.insert(child);
+    } else {
+        children.erase(child);
     }
+    cachedInnerUsage += children.DynamicMemoryUsage();
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
-    setEntries s;
-    if (add && mapLinks[entry].parents.insert(parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && mapLinks[entry].parents.erase(parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    linkEntries &parents = vTxLinks[entry->vTxHashesIdx].parents;
+    cachedInnerUsage -= parents.DynamicMemoryUsage();
+    if (add) {
+        parents.insert(parent);
+    } else {
+        parents.erase(parent);
     }
+    cachedInnerUsage += parents.DynamicMemoryUsage();
 }
 
-const CTxMemPool::setEntries & CTxMemPool::GetMemPoolParents(txiter entry) const
+const CTxMemPool::linkEntries & CTxMemPool::GetMemPoolParents(txiter entry) const
 {
     assert (entry != mapTx.end());
-    txlinksMap::const_iterator it = mapLinks.find(entry);
-    assert(it != mapLinks.end());
-    return it->second.parents;
+    assert(entry->vTxHashesIdx < vTxLinks.size());
+    return vTxLinks[entry->vTxHashesIdx].parents;
 }
 
-const CTxMemPool::setEntries & CTxMemPool::GetMemPoolChildren(txiter entry) const
+const CTxMemPool::linkEntries & CTxMemPool::GetMemPoolChildren(txiter entry) const
 {
     assert (entry != mapTx.end());
-    txlinksMap::const_iterator it = mapLinks.find(entry);
-    assert(it != mapLinks.end());
-    return it->second.children;
+    assert(entry->vTxHashesIdx < vTxLinks.size());
+    return vTxLinks[entry->vTxHashesIdx].children;
 }
 
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
@@ -1638,7 +1673,7 @@ uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
         txiter candidate = candidates.back();
         candidates.pop_back();
         if (!counted.insert(candidate).second) continue;
-        const setEntries& parents = GetMemPoolParents(candidate);
+        const linkEntries& parents = GetMemPoolParents(candidate);
         if (parents.size() == 0) {
             maximum = std::max(maximum, candidate->GetCountWithDescendants());
         } else {
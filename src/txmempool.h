@@ -6,6 +6,7 @@
 #ifndef BITCOIN_TXMEMPOOL_H
 #define BITCOIN_TXMEMPOOL_H
 
+#include <algorithm>
 #include <memory>
 #include <set>
 #include <map>
@@ -19,6 +20,7 @@
 #include <amount.h>
 #include <coins.h>
 #include <indirectmap.h>
+#include <memusage.h>
 #include <policy/feerate.h>
 #include <primitives/transaction.h>
 #include <sync.h>
@@ -73,12 +75,7 @@ private:
     CTransactionRef tx;
     CAmount nFee;              //!< Cached to avoid expensive parent-transaction lookups
     CAmount specialTxFee;
-    size_t nTxSize;            //!< ... and avoid recomputing tx size
-    size_t nUsageSize;         //!< ... and total memory usage
     int64_t nTime;             //!< Local time when entering the mempool
-    unsigned int entryHeight;  //!< Chain height when entering the mempool
-    bool spendsCoinbase;       //!< keep track of transactions that spend a coinbase
-    unsigned int sigOpCount;   //!< Legacy sig ops plus P2SH sig op count
     int64_t feeDelta;          //!< Used for determining the priority of the transaction for mining in a block
     LockPoints lockPoints;     //!< Track the height and time at which tx was final
 
@@ -93,8 +90,17 @@ private:
     uint64_t nCountWithAncestors;
     uint64_t nSizeWithAncestors;
     CAmount nModFeesWithAncestors;
+
+    // The 4-byte fields are kept together so they pack without padding.
+    // Serialized size and memory usage of a single transaction fit easily.
+    uint32_t nTxSize;          //!< ... and avoid recomputing tx size
+    uint32_t nUsageSize;       //!< ... and total memory usage
+    unsigned int entryHeight;  //!< Chain height when entering the mempool
+    unsigned int sigOpCount;   //!< Legacy sig ops plus P2SH sig op count
     unsigned int nSigOpCountWithAncestors;
 
+    bool spendsCoinbase;       //!< keep track of transactions that spend a coinbase
+
 public:
     CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee, const CAmount& _specialTxFee, int64_t _nTime, unsigned int _entryHeight, bool spendsCoinbase, unsigned int nSigOps, LockPoints lp);
 
@@ -131,11 +137,7 @@ public:
     CAmount GetModFeesWithAncestors() const { return nModFeesWithAncestors; }
     unsigned int GetSigOpCountWithAncestors() const { return nSigOpCountWithAncestors; }
 
-    mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes
-
-    // If this is a proTx, this will be the hash of the key for which this ProTx was valid
-    mutable uint256 validForProTxKey;
-    mutable bool isKeyChangeProTx{false};
+    mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes and vTxLinks
 };
 
 // Helpers for modifying CTxMemPool::mapTx, which is a boost multi_index.
@@ -398,7 +400,7 @@ public:
  *
  * In order for the feerate sort to remain correct, we must update transactions
  * in the mempool when new descendants arrive.  To facilitate this, we track
- * the set of in-mempool direct parents and direct children in mapLinks.  Within
+ * the set of in-mempool direct parents and direct children in vTxLinks.  Within
  * each CTxMemPoolEntry, we track the size and fees of all descendants.
  *
  * Usually when a new transaction is added to the mempool, it has no in-mempool
@@ -431,7 +433,7 @@ public:
  * state, to account for in-mempool, out-of-block descendants for all the
  * in-block transactions by calling UpdateTransactionsFromBlock().  Note that
  * until this is called, the mempool state is not consistent, and in particular
- * mapLinks may not be correct (and therefore functions like
+ * vTxLinks may not be correct (and therefore functions like
  * CalculateMemPoolAncestors() and CalculateDescendants() that rely
  * on them to walk the mempool are not generally safe to use).
  *
@@ -502,19 +504,64 @@ public:
     };
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
 
-    const setEntries & GetMemPoolParents(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
-    const setEntries & GetMemPoolChildren(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /**
+     * Direct in-mempool parents or children of an entry. Iterates in the same
+     * order as setEntries, but keeps the handful of links a tx usually has in
+     * one flat vector instead of a tree node per link.
+     */
+    class linkEntries
+    {
+    private:
+        std::vector<txiter> vEntries;
+
+    public:
+        typedef std::vector<txiter>::const_iterator const_iterator;
+
+        const_iterator begin() const { return vEntries.begin(); }
+        const_iterator end() const { return vEntries.end(); }
+        size_t size() const { return vEntries.size(); }
+        bool empty() const { return vEntries.empty(); }
+
+        size_t count(txiter it) const
+        {
+            auto pos = std::lower_bound(vEntries.begin(), vEntries.end(), it, CompareIteratorByHash());
+            return pos != vEntries.end() && *pos == it;
+        }
+        bool insert(txiter it)
+        {
+            auto pos = std::lower_bound(vEntries.begin(), vEntries.end(), it, CompareIteratorByHash());
+            if (pos != vEntries.end() && *pos == it) return false;
+            vEntries.insert(pos, it);
+            return true;
+        }
+        bool erase(txiter it)
+        {
+            auto pos = std::lower_bound(vEntries.begin(), vEntries.end(), it, CompareIteratorByHash());
+            if (pos == vEntries.end() || *pos != it) return false;
+            vEntries.erase(pos);
+            if (vEntries.empty()) std::vector<txiter>().swap(vEntries);
+            return true;
+        }
+        bool operator==(const setEntries& s) const
+        {
+            return vEntries.size() == s.size() && std::equal(vEntries.begin(), vEntries.end(), s.begin());
+        }
+        size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(vEntries); }
+    };
+
+    const linkEntries & GetMemPoolParents(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    const linkEntries & GetMemPoolChildren(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 private:
     typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
 
     struct TxLinks {
-        setEntries parents;
-        setEntries children;
+        linkEntries parents;
+        linkEntries children;
     };
 
-    typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
-    txlinksMap mapLinks;
+    //! Links of all entries in mapTx, indexed by CTxMemPoolEntry::vTxHashesIdx like vTxHashes
+    std::vector<TxLinks> vTxLinks;
 
     typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> addressDeltaMap;
     addressDeltaMap mapAddress;
@@ -535,6 +582,8 @@ private:
     std::map<CKeyID, uint256> mapProTxPubKeyIDs;
     std::map<uint256, uint256> mapProTxBlsPubKeyHashes;
     std::map<COutPoint, uint256> mapProTxCollaterals;
+    // ProUpRegTx/ProUpRevTx -> hash of the operator key the tx was valid for, and whether it changes that key
+    std::map<uint256, std::pair<uint256, bool>> mapProTxKeyChanges;
 
     void UpdateParent(txiter entry, txiter parent, bool add);
     void UpdateChild(txiter entry, txiter child, bool add);
@@ -639,7 +688,7 @@ public:
      *  limitDescendantSize = max size of descendants any ancestor can have
      *  errString = populated with error reason if any limits are hit
      *  fSearchForParents = whether to search a tx's vin for in-mempool parents, or
-     *    look up parents from mapLinks. Must be true for entries not in the mempool
+     *    look up parents from vTxLinks. Must be true for entries not in the mempool
      */
     bool CalculateMemPoolAncestors(const CTxMemPoolEntry& entry, setEntries& setAncestors, uint64_t limitAncestorCount, uint64_t limitAncestorSize, uint64_t limitDescendantCount, uint64_t limitDescendantSize, std::string& errString, bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -697,6 +746,21 @@ public:
 
     size_t DynamicMemoryUsage() const;
 
+    /** Estimated memory usage of the mempool, broken down by data structure */
+    struct MemoryUsage {
+        size_t nEntries{0};      //!< mapTx nodes and their indices
+        size_t nTransactions{0}; //!< the transactions themselves
+        size_t nLinks{0};        //!< in-mempool parent/child links
+        size_t nNextTx{0};       //!< mapNextTx
+        size_t nDeltas{0};       //!< mapDeltas
+        size_t nTxHashes{0};     //!< vTxHashes
+        size_t nAddressIndex{0}; //!< mapAddress and mapAddressInserted
+        size_t nSpentIndex{0};   //!< mapSpent and mapSpentInserted
+        size_t nFutureIndex{0};  //!< mapFuture and mapFutureInserted
+        size_t nProTx{0};        //!< ProTx conflict tracking maps
+    };
+    MemoryUsage GetMemoryUsage() const;
+
     boost::signals2::signal<void (CTransactionRef)> NotifyEntryAdded;
     boost::signals2::signal<void (CTransactionRef, MemPoolRemovalReason)> NotifyEntryRemoved;
 
@@ -30,6 +30,7 @@
 #include <script/standard.h>
 #include <timedata.h>
 #include <tinyformat.h>
+#include <node/coinstats.h>
 #include <txdb.h>
 #include <txmempool.h>
 #include <ui_interface.h>
@@ -51,6 +52,7 @@
 
 #include <statsd_client.h>
 
+#include <deque>
 #include <future>
 #include <sstream>
 
@@ -169,9 +171,9 @@ public:
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock);
 
     // Block (dis)connection on a given view:
-    DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view);
+    DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CCoinsStatsDelta* pstatsDelta = nullptr);
     bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                    CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false);
+                    CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false, CCoinsStatsDelta* pstatsDelta = nullptr);
 
     // Block disconnection on our pcoinsTip:
     bool DisconnectTip(CValidationState& state, const CChainParams& chainparams, DisconnectedBlockTransactions *disconnectpool);
@@ -229,7 +231,10 @@ bool fAddressIndex = false;
 bool fTimestampIndex = false;
 bool fSpentIndex = false;
 bool fFutureIndex = false;
+bool fBlockStatsIndex = false;
+bool fCoinStatsIndex = DEFAULT_COINSTATSINDEX;
 bool fHavePruned = false;
+bool fSnapshotChainstate = false;
 bool fPruneMode = false;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
@@ -524,7 +529,7 @@ bool ContextualCheckTransaction(const CTransaction& tx, CValidationState &state,
     }
 
     // Size limits
-    if (fDIP0001Active_context && ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION) > MAX_STANDARD_TX_SIZE)
+    if (fDIP0001Active_context && tx.GetTotalSize() > MAX_STANDARD_TX_SIZE)
         return state.DoS(100, false, REJECT_INVALID, "bad-txns-oversize");
 
     return true;
@@ -566,6 +571,15 @@ static bool IsCurrentForFeeEstimation()
     return true;
 }
 
+// Protected by cs_main
+static CReorgStats reorgStats;
+
+CReorgStats GetReorgStats()
+{
+    LOCK(cs_main);
+    return reorgStats;
+}
+
 /* Make mempool consistent after a reorg, by re-adding or recursively erasing
  * disconnected block transactions from the mempool, and also removing any
  * other transactions from the mempool that are no longer valid given the new
@@ -582,6 +596,7 @@ static bool IsCurrentForFeeEstimation()
 void UpdateMempoolForReorg(DisconnectedBlockTransactions &disconnectpool, bool fAddToMempool)
 {
     AssertLockHeld(cs_main);
+    int64_t nStart = GetTimeMicros();
     std::vector<uint256> vHashUpdate;
     // disconnectpool's insertion_order index sorts the entries from
     // oldest to newest, but the oldest entry will be the last tx from the
@@ -604,6 +619,10 @@ void UpdateMempoolForReorg(DisconnectedBlockTransactions &disconnectpool, bool f
         }
         ++it;
     }
+    if (fAddToMempool) {
+        reorgStats.nTxResurrected += disconnectpool.queuedTx.size();
+        reorgStats.nTxReadmitted += vHashUpdate.size();
+    }
     disconnectpool.queuedTx.clear();
     // AcceptToMemoryPool/addUnchecked all assume that new mempool entries have
     // no in-mempool children, which is generally not true when adding
@@ -616,6 +635,11 @@ void UpdateMempoolForReorg(DisconnectedBlockTransactions &disconnectpool, bool f
     mempool.removeForReorg(pcoinsTip.get(), chainActive.Tip()->nHeight + 1, STANDARD_LOCKTIME_VERIFY_FLAGS);
     // Re-limit mempool size, in case we added any transactions
     LimitMempoolSize(mempool, gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60);
+
+    int64_t nTime = GetTimeMicros() - nStart;
+    reorgStats.nMempoolTime += nTime;
+    LogPrint(BCLog::BENCHMARK, "- Update mempool for reorg: %.2fms\n", nTime * MILLI);
+    statsClient.timing("UpdateMempoolForReorg_ms", nTime / 1000, 1.0f);
 }
 
 // Used to avoid mempool polluting consensus critical paths if CCoinsViewMempool
@@ -667,7 +691,8 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
         *pfMissingInputs = false;
     }
 
-    if (!CheckTransaction(tx, state, 0, 0))
+    const CTxCheckContext txCheckContext(chainActive.Tip());
+    if (!CheckTransaction(tx, state, txCheckContext, 0))
         return false; // state filled in by CheckTransaction
 
     if (!ContextualCheckTransaction(tx, state, chainparams.GetConsensus(), chainActive.Tip()))
@@ -768,8 +793,7 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
 
         CAmount nFees = 0;
         CAmount specialTxFees = 0;
-        bool isV17active = Params().IsFutureActive(chainActive.Tip());
-        if (!Consensus::CheckTxInputs(tx, state, view, GetSpendHeight(view), nFees, specialTxFees, isV17active, true)) {
+        if (!Consensus::CheckTxInputs(tx, state, view, GetSpendHeight(view), nFees, specialTxFees, txCheckContext, true)) {
             return error("%s: Consensus::CheckTxInputs: %s, %s", __func__, tx.GetHash().ToString(), FormatStateMessage(state));
         }
 
@@ -1107,14 +1131,19 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
     return true;
 }
 
+static std::atomic<int64_t> nTimePoW{0};
+
 bool CheckPOW(const CBlock& block, const Consensus::Params& consensusParams)
 {
-    if (!CheckProofOfWork(block.GetPOWHash(), block.nBits, consensusParams)) {
+    int64_t nTimeStart = GetTimeMicros();
+    bool fValid = CheckProofOfWork(block.GetPOWHash(), block.nBits, consensusParams);
+    if (!fValid) {
         LogPrintf("CheckPOW: CheckProofOfWork failed for %s, retesting without POW cache\n", block.GetHash().ToString());
         // Retest without POW cache in case cache was corrupted:
-        return CheckProofOfWork(block.GetPOWHash(false), block.nBits, consensusParams);
+        fValid = CheckProofOfWork(block.GetPOWHash(false), block.nBits, consensusParams);
     }
-    return true;
+    nTimePoW += GetTimeMicros() - nTimeStart;
+    return fValid;
 }
 
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
@@ -1445,6 +1474,62 @@ int GetSpendHeight(const CCoinsViewCache& inputs)
 static CuckooCache::cache<uint256, SignatureCacheHasher> scriptExecutionCache;
 static uint256 scriptExecutionCacheNonce(GetRandHash());
 
+static uint256 GetScriptExecutionCacheEntry(const CTransaction& tx, unsigned int flags)
+{
+    uint256 hashCacheEntry;
+    // We only use the first 19 bytes of nonce to avoid a second SHA
+    // round - giving us 19 + 32 + 4 = 55 bytes (+ 8 + 1 = 64)
+    static_assert(55 - sizeof(flags) - 32 >= 128/8, "Want at least 128 bits of nonce for script execution cache");
+    CSHA256().Write(scriptExecutionCacheNonce.begin(), 55 - sizeof(flags) - 32).Write(tx.GetHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+    return hashCacheEntry;
+}
+
+/**
+ * Record that all scripts of tx are valid under flags. Only for transactions whose scripts
+ * were executed with exactly these flags before, the spent coins are committed to by the
+ * prevouts so the result can't have changed since.
+ */
+static void AddToScriptExecutionCache(const CTransaction& tx, unsigned int flags)
+{
+    AssertLockHeld(cs_main);
+    scriptExecutionCache.insert(GetScriptExecutionCacheEntry(tx, flags));
+}
+
+/**
+ * Blocks recently connected with full script checks and the flags they were checked with,
+ * oldest first. Disconnecting one of them puts its transactions back into the script
+ * execution cache, reconnecting it skips the script checks. Protected by cs_main.
+ */
+static std::deque<std::pair<uint256, unsigned int>> recentScriptCheckedBlocks;
+static const size_t MAX_RECENT_SCRIPT_CHECKED_BLOCKS = 100;
+
+static bool GetRecentScriptCheckedFlags(const uint256& hash, unsigned int& flags)
+{
+    AssertLockHeld(cs_main);
+    for (const auto& entry : recentScriptCheckedBlocks) {
+        if (entry.first == hash) {
+            flags = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void AddRecentScriptCheckedBlock(const uint256& hash, unsigned int flags)
+{
+    AssertLockHeld(cs_main);
+    for (auto it = recentScriptCheckedBlocks.begin(); it != recentScriptCheckedBlocks.end(); ++it) {
+        if (it->first == hash) {
+            recentScriptCheckedBlocks.erase(it);
+            break;
+        }
+    }
+    recentScriptCheckedBlocks.emplace_back(hash, flags);
+    if (recentScriptCheckedBlocks.size() > MAX_RECENT_SCRIPT_CHECKED_BLOCKS) {
+        recentScriptCheckedBlocks.pop_front();
+    }
+}
+
 void InitScriptExecutionCache() {
     // nMaxCacheSize is unsigned. If -maxsigcachesize is set to zero,
     // setup_bytes creates the minimum possible cache (2 elements).
@@ -1491,11 +1576,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
             // correct (ie that the transaction hash which is in tx's prevouts
             // properly commits to the scriptPubKey in the inputs view of that
             // transaction).
-            uint256 hashCacheEntry;
-            // We only use the first 19 bytes of nonce to avoid a second SHA
-            // round - giving us 19 + 32 + 4 = 55 bytes (+ 8 + 1 = 64)
-            static_assert(55 - sizeof(flags) - 32 >= 128/8, "Want at least 128 bits of nonce for script execution cache");
-            CSHA256().Write(scriptExecutionCacheNonce.begin(), 55 - sizeof(flags) - 32).Write(tx.GetHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+            uint256 hashCacheEntry = GetScriptExecutionCacheEntry(tx, flags);
             AssertLockHeld(cs_main); //TODO: Remove this requirement by making CuckooCache not require external locks
             if (scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)) {
                 return true;
@@ -1675,7 +1756,7 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When FAILED is returned, view is left in an indeterminate state. */
-DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
+DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CCoinsStatsDelta* pstatsDelta)
 {
     bool fDIP0003Active = Params().GetConsensus().DIP0003Enabled;
 
@@ -1700,10 +1781,16 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         return DISCONNECT_FAILED;
     }
 
+    // Before the undo coins are moved into the view below
+    if (pstatsDelta) {
+        pstatsDelta->DisconnectBlock(block, blockUndo, pindex->nHeight);
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
     std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
     std::vector<std::pair<CFutureIndexKey, CFutureIndexValue> > futureIndex;
+    std::vector<CFutureMaturityKey> futureMaturityIndex;
 
     if (!UndoSpecialTxsInBlock(block, pindex)) {
         return DISCONNECT_FAILED;
@@ -1845,6 +1932,21 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
                 }
             }
         }
+
+        // Forget the locks of this block that haven't matured yet
+        if (fBlockStatsIndex && tx.nType == TRANSACTION_FUTURE) {
+            CFutureTx ftx;
+            if (GetTxPayload(tx, ftx) && ftx.maturity > 0) {
+                futureMaturityIndex.emplace_back(pindex->nHeight + ftx.maturity, hash, ftx.lockOutputIndex);
+            }
+        }
+    }
+
+    if (fBlockStatsIndex) {
+        if (!pblocktree->EraseFutureMaturityIndex(futureMaturityIndex)) {
+            AbortNode("Failed to delete future maturity index");
+            return DISCONNECT_FAILED;
+        }
     }
 
 
@@ -1960,6 +2062,48 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+/**
+ * Context-free checks of a single block transaction (CheckTransaction and
+ * the legacy sigop count), so that CheckBlock can spread them over threads.
+ */
+class CBlockTxCheck
+{
+private:
+    const CTransaction* ptx;
+    const CTxCheckContext* pctx;
+    CAmount blockReward;
+    unsigned int* pnSigOps;
+
+public:
+    CBlockTxCheck() : ptx(nullptr), pctx(nullptr), blockReward(0), pnSigOps(nullptr) {}
+    CBlockTxCheck(const CTransaction& tx, const CTxCheckContext& ctx, CAmount blockRewardIn, unsigned int* pnSigOpsIn) :
+        ptx(&tx), pctx(&ctx), blockReward(blockRewardIn), pnSigOps(pnSigOpsIn) {}
+
+    bool operator()()
+    {
+        CValidationState state;
+        if (!CheckTransaction(*ptx, state, *pctx, blockReward))
+            return false;
+        *pnSigOps = GetLegacySigOpCount(*ptx);
+        return true;
+    }
+
+    void swap(CBlockTxCheck& check)
+    {
+        std::swap(ptx, check.ptx);
+        std::swap(pctx, check.pctx);
+        std::swap(blockReward, check.blockReward);
+        std::swap(pnSigOps, check.pnSigOps);
+    }
+};
+
+static CCheckQueue<CBlockTxCheck> blockcheckqueue(16);
+
+void ThreadBlockCheck() {
+    RenameThread("raptoreum-blockch");
+    blockcheckqueue.Thread();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2091,11 +2235,59 @@ void getFutureMaturity(const CTransaction& tx, int& lockOutputIndex, CFutureTx&
         }
     }
 }
+/** Account for the outputs of a transaction in the block stats index, and remember
+ *  the height at which its future lock matures */
+static void AddBlockStatsOutputs(CBlockStatsIndexBuilder& blockStats, std::vector<std::pair<CFutureMaturityKey, CAmount> >& futureMaturityIndex,
+                                 const CTransaction& tx, int nHeight)
+{
+    CBlockStatsIndexValue& value = blockStats.value;
+    value.txs++;
+    value.outs += tx.vout.size();
+    for (const CTxOut& out : tx.vout) {
+        if (!tx.IsCoinBase()) {
+            value.totalOut += out.nValue;
+        }
+        value.utxoSizeInc += GetSerializeSize(out, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+    }
+
+    switch (tx.nType) {
+    case TRANSACTION_PROVIDER_REGISTER:
+    case TRANSACTION_PROVIDER_UPDATE_SERVICE:
+    case TRANSACTION_PROVIDER_UPDATE_REGISTRAR:
+    case TRANSACTION_PROVIDER_UPDATE_REVOKE:
+        value.proTxs++;
+        break;
+    case TRANSACTION_QUORUM_COMMITMENT:
+        value.quorumCommitments++;
+        break;
+    case TRANSACTION_FUTURE: {
+        value.futureTxs++;
+        CFutureTx ftx;
+        if (!GetTxPayload(tx, ftx) || ftx.lockOutputIndex >= tx.vout.size()) {
+            break;
+        }
+        const CAmount amount = tx.vout[ftx.lockOutputIndex].nValue;
+        value.futureLocked++;
+        value.futureLockedAmount += amount;
+        // Only maturity by height is tied to a block, time locks mature by the clock
+        if (ftx.maturity == 0) {
+            value.futureMatured++;
+            value.futureMaturedAmount += amount;
+        } else if (ftx.maturity > 0) {
+            futureMaturityIndex.emplace_back(CFutureMaturityKey(nHeight + ftx.maturity, tx.GetHash(), ftx.lockOutputIndex), amount);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
 bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                  CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck)
+                  CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck, CCoinsStatsDelta* pstatsDelta)
 {
     boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
     AssertLockHeld(cs_main);
@@ -2202,6 +2394,16 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // Get the script flags for this block
     unsigned int flags = GetBlockScriptFlags(pindex, chainparams.GetConsensus());
 
+    // A block that a reorg disconnected after it passed the script checks with the same flags
+    // can't fail them now, its hash commits to the transactions and to the coins they spend
+    unsigned int nCheckedFlags;
+    const bool fScriptsChecked = fScriptChecks && !fJustCheck && pindex->phashBlock &&
+                                 GetRecentScriptCheckedFlags(pindex->GetBlockHash(), nCheckedFlags) && nCheckedFlags == flags;
+    if (fScriptsChecked) {
+        reorgStats.nBlocksScriptsSkipped++;
+        LogPrint(BCLog::BENCHMARK, "    - Scripts of block %s checked before, skipping\n", pindex->GetBlockHash().ToString());
+    }
+
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
     LogPrint(BCLog::BENCHMARK, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
 
@@ -2219,6 +2421,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
     std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
     std::vector<std::pair<CFutureIndexKey, CFutureIndexValue> > futureIndex;
+    const bool fBlockStats = fBlockStatsIndex && !fJustCheck;
+    CBlockStatsIndexBuilder blockStats;
+    std::vector<std::pair<CFutureMaturityKey, CAmount> > futureMaturityIndex;
 
     std::vector<PrecomputedTransactionData> txdata;
     txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
@@ -2234,7 +2439,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     int64_t nTime2_1 = GetTimeMicros(); nTimeProcessSpecial += nTime2_1 - nTime2;
     LogPrint(BCLog::BENCHMARK, "      - ProcessSpecialTxsInBlock: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2_1 - nTime2), nTimeProcessSpecial * MICRO, nTimeProcessSpecial * MILLI / nBlocksTotal);
 
-    bool isV17active = Params().IsFutureActive(chainActive.Tip());
+    const CTxCheckContext txCheckContext(pindex->pprev);
+    const bool isV17active = txCheckContext.fFutureActive;
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
@@ -2242,14 +2448,27 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
         nInputs += tx.vin.size();
 
+        if (fBlockStats) {
+            AddBlockStatsOutputs(blockStats, futureMaturityIndex, tx, pindex->nHeight);
+        }
+
         if (!tx.IsCoinBase())
         {
             CAmount txfee = 0;
             CAmount specialTxFee = 0;
             bool isSyncing = IsInitialBlockDownload();
-            if (!Consensus::CheckTxInputs(tx, state, view, pindex->nHeight, txfee, specialTxFee, isV17active, !isSyncing)) {
+            if (!Consensus::CheckTxInputs(tx, state, view, pindex->nHeight, txfee, specialTxFee, txCheckContext, !isSyncing)) {
                 return error("%s: Consensus::CheckTxInputs: %s, %s", __func__, tx.GetHash().ToString(), FormatStateMessage(state));
             }
+            if (fBlockStats) {
+                // The coins being spent are still in the view at this point
+                blockStats.value.ins += tx.vin.size();
+                for (const CTxIn& txin : tx.vin) {
+                    const CTxOut& prevout = view.AccessCoin(txin.prevout).out;
+                    blockStats.value.utxoSizeInc -= GetSerializeSize(prevout, SER_NETWORK, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+                }
+                blockStats.AddTx(txfee + specialTxFee, tx.GetTotalSize());
+            }
             nFees += txfee;
             specialTxFees += specialTxFee;
             if (!MoneyRange(nFees, isV17active)) {
@@ -2331,7 +2550,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
-            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr))
+            if (!CheckInputs(tx, state, view, fScriptChecks && !fScriptsChecked, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                     tx.GetHash().ToString(), FormatStateMessage(state));
             control.Add(vChecks);
@@ -2471,6 +2690,19 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                                 REJECT_INVALID, "bad-cb-payee");
     }
 
+    if (fBlockStats) {
+        blockStats.value.subsidy = mintReward;
+        blockStats.value.specialTxFee = specialTxFees;
+        std::vector<CTxOut> voutSmartnodePayments;
+        if (CSmartnodePayments::GetSmartnodeTxOuts(pindex->nHeight, blockReward, voutSmartnodePayments, specialTxFees)) {
+            for (const CTxOut& txout : voutSmartnodePayments) {
+                blockStats.value.smartnodePayment += txout.nValue;
+            }
+        }
+        FounderPayment founderPayment = chainparams.GetConsensus().nFounderPayment;
+        blockStats.value.founderPayment = founderPayment.getPaidAmount(*block.vtx[0]);
+    }
+
     int64_t nTime5_4 = GetTimeMicros(); nTimePayeeValid += nTime5_4 - nTime5_3;
     LogPrint(BCLog::BENCHMARK, "      - IsBlockPayeeValid: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime5_4 - nTime5_3), nTimePayeeValid * MICRO, nTimePayeeValid * MILLI / nBlocksTotal);
 
@@ -2489,6 +2721,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
         setDirtyBlockIndex.insert(pindex);
     }
+    if (fScriptChecks) {
+        AddRecentScriptCheckedBlock(pindex->GetBlockHash(), flags);
+    }
 
     if (!WriteTxIndexDataForBlock(block, state, pindex))
         return false;
@@ -2515,6 +2750,20 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
             return AbortNode(state, "Failed to write timestamp index");
 
+    if (fBlockStats) {
+        std::vector<std::pair<CFutureMaturityKey, CAmount> > matured;
+        if (!pblocktree->ReadFutureMaturityIndex(pindex->nHeight, matured))
+            return AbortNode(state, "Failed to read future maturity index");
+        for (const auto& lock : matured) {
+            blockStats.value.futureMatured++;
+            blockStats.value.futureMaturedAmount += lock.second;
+        }
+        if (!pblocktree->WriteFutureMaturityIndex(futureMaturityIndex))
+            return AbortNode(state, "Failed to write future maturity index");
+        if (!pblocktree->WriteBlockStatsIndex(pindex->GetBlockHash(), blockStats.Finalize()))
+            return AbortNode(state, "Failed to write block stats index");
+    }
+
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2524,6 +2773,10 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     evoDb->WriteBestBlock(pindex->GetBlockHash());
 
+    if (pstatsDelta) {
+        pstatsDelta->ConnectBlock(block, blockundo, pindex->nHeight);
+    }
+
     int64_t nTime7 = GetTimeMicros(); nTimeCallbacks += nTime7 - nTime6;
     LogPrint(BCLog::BENCHMARK, "    - Callbacks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime7 - nTime6), nTimeCallbacks * MICRO, nTimeCallbacks * MILLI / nBlocksTotal);
 
@@ -2777,17 +3030,34 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
 
         CCoinsViewCache view(pcoinsTip.get());
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
-        if (DisconnectBlock(block, pindexDelete, view) != DISCONNECT_OK)
+        CCoinsStatsDelta statsDelta;
+        if (DisconnectBlock(block, pindexDelete, view, fCoinStatsIndex ? &statsDelta : nullptr) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
+        if (fCoinStatsIndex) {
+            g_coins_stats_tracker.Apply(statsDelta, pindexDelete->GetBlockHash(), pindexDelete->pprev);
+        }
     }
     LogPrint(BCLog::BENCHMARK, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * MILLI);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(chainparams, state, FlushStateMode::IF_NEEDED))
         return false;
 
+    // The transactions of the block are likely to come back, in the mempool or in a block of the
+    // competing chain. Connecting the block used up their script execution cache entries, so
+    // put them back.
+    unsigned int nScriptFlags;
+    if (GetRecentScriptCheckedFlags(pindexDelete->GetBlockHash(), nScriptFlags)) {
+        for (const auto& tx : block.vtx) {
+            if (!tx->IsCoinBase()) {
+                AddToScriptExecutionCache(*tx, nScriptFlags);
+                reorgStats.nTxCacheWarmed++;
+            }
+        }
+    }
+
     if (disconnectpool) {
         // Save transactions to re-add to mempool at end of reorg
         for (auto it = block.vtx.rbegin(); it != block.vtx.rend(); ++it) {
@@ -2816,6 +3086,29 @@ static int64_t nTimeFlush = 0;
 static int64_t nTimeChainState = 0;
 static int64_t nTimePostConnect = 0;
 
+CBlockValidationTimings GetBlockValidationTimings()
+{
+    LOCK(cs_main);
+    CBlockValidationTimings timings;
+    timings.nBlocks = nBlocksTotal;
+    timings.nPoW = nTimePoW;
+    timings.nCheck = nTimeCheck;
+    timings.nForks = nTimeForks;
+    timings.nProcessSpecial = nTimeProcessSpecial;
+    timings.nConnect = nTimeConnect;
+    timings.nVerify = nTimeVerify;
+    timings.nRaptoreumSpecific = nTimeRaptoreumSpecific;
+    timings.nIndex = nTimeIndex;
+    timings.nCallbacks = nTimeCallbacks;
+    timings.nReadFromDisk = nTimeReadFromDisk;
+    timings.nConnectTotal = nTimeConnectTotal;
+    timings.nFlush = nTimeFlush;
+    timings.nChainState = nTimeChainState;
+    timings.nPostConnect = nTimePostConnect;
+    timings.nTotal = nTimeTotal;
+    return timings;
+}
+
 struct PerBlockConnectTrace {
     CBlockIndex* pindex = nullptr;
     std::shared_ptr<const CBlock> pblock;
@@ -2908,7 +3201,8 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         auto dbTx = evoDb->BeginTransaction();
 
         CCoinsViewCache view(pcoinsTip.get());
-        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams);
+        CCoinsStatsDelta statsDelta;
+        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams, false, fCoinStatsIndex ? &statsDelta : nullptr);
         GetMainSignals().BlockChecked(blockConnecting, state);
         if (!rv) {
             if (state.IsInvalid())
@@ -2920,6 +3214,9 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
+        if (fCoinStatsIndex) {
+            g_coins_stats_tracker.Apply(statsDelta, pindexNew->pprev ? pindexNew->pprev->GetBlockHash() : uint256(), pindexNew);
+        }
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
     LogPrint(BCLog::BENCHMARK, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
@@ -2928,6 +3225,17 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         return false;
     int64_t nTime5 = GetTimeMicros(); nTimeChainState += nTime5 - nTime4;
     LogPrint(BCLog::BENCHMARK, "  - Writing chainstate: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime5 - nTime4) * MILLI, nTimeChainState * MICRO, nTimeChainState * MILLI / nBlocksTotal);
+    // Transactions leaving the mempool for this block passed the standard script checks on their
+    // way in, remember that in case a reorg returns them to the mempool. This takes about the
+    // cache space that connecting the block freed up.
+    {
+        LOCK(mempool.cs);
+        for (const auto& tx : blockConnecting.vtx) {
+            if (!tx->IsCoinBase() && mempool.exists(tx->GetHash())) {
+                AddToScriptExecutionCache(*tx, STANDARD_SCRIPT_VERIFY_FLAGS);
+            }
+        }
+    }
     // Remove conflicting transactions from the mempool.;
     mempool.removeForBlock(blockConnecting.vtx, pindexNew->nHeight);
     disconnectpool.removeForBlock(blockConnecting.vtx);
@@ -3033,6 +3341,8 @@ bool CChainState::ActivateBestChainStep(CValidationState& state, const CChainPar
 
     // Disconnect active blocks which are no longer in the best chain.
     bool fBlocksDisconnected = false;
+    int nReorgDepth = 0;
+    int64_t nReorgStart = GetTimeMicros();
     DisconnectedBlockTransactions disconnectpool;
     while (chainActive.Tip() && chainActive.Tip() != pindexFork) {
         if (!DisconnectTip(state, chainparams, &disconnectpool)) {
@@ -3042,6 +3352,7 @@ bool CChainState::ActivateBestChainStep(CValidationState& state, const CChainPar
             return false;
         }
         fBlocksDisconnected = true;
+        nReorgDepth++;
     }
 
     // Build list of new blocks to connect.
@@ -3095,6 +3406,18 @@ bool CChainState::ActivateBestChainStep(CValidationState& state, const CChainPar
         // If any blocks were disconnected, disconnectpool may be non empty.  Add
         // any disconnected transactions back to the mempool.
         UpdateMempoolForReorg(disconnectpool, true);
+
+        int64_t nReorgTime = GetTimeMicros() - nReorgStart;
+        reorgStats.nReorgs++;
+        reorgStats.nBlocksDisconnected += nReorgDepth;
+        reorgStats.nLastDepth = nReorgDepth;
+        reorgStats.nMaxDepth = std::max(reorgStats.nMaxDepth, nReorgDepth);
+        reorgStats.nLastTime = nReorgTime;
+        reorgStats.nTotalTime += nReorgTime;
+        LogPrint(BCLog::BENCHMARK, "- Reorg of %d blocks to %s: %.2fms\n", nReorgDepth, chainActive.Tip()->GetBlockHash().ToString(), nReorgTime * MILLI);
+        statsClient.inc("blocks.reorgs", 1.0f);
+        statsClient.gauge("blocks.reorg.Depth", nReorgDepth, 1.0f);
+        statsClient.timing("Reorg_ms", nReorgTime / 1000, 1.0f);
     }
     mempool.check(pcoinsTip.get());
 
@@ -3165,7 +3488,7 @@ bool CChainState::ActivateBestChain(CValidationState &state, const CChainParams&
             // Note that if a validationinterface callback ends up calling
             // ActivateBestChain this may lead to a deadlock! We should
             // probably have a DEBUG_LOCKORDER test for this in the future.
-            SyncWithValidationInterfaceQueue();
+            SyncWithBackpressureValidationInterfaceQueues();
         }
 
 
@@ -3705,6 +4028,25 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
     if (!CheckBlockHeader(block, state, consensusParams, fCheckPOW))
         return false;
 
+    // Hand the per transaction checks to the block check threads first, so
+    // they run while this thread computes the merkle root. The results are
+    // only looked at after the merkle and size checks, which keeps the
+    // reported reject reason the same as with a serial check.
+    CAmount blockReward = GetBlockSubsidy(1, nHeight - 1, Params().GetConsensus(), false);
+    // Check transactions against the block's parent, not whatever the tip happens to be
+    const CTxCheckContext txCheckContext(nHeight - 1);
+    std::vector<unsigned int> vSigOps(block.vtx.size(), 0);
+    const bool fParallel = nScriptCheckThreads && block.vtx.size() > 1 && block.vtx.size() <= MaxBlockSize();
+    CCheckQueueControl<CBlockTxCheck> control(fParallel ? &blockcheckqueue : nullptr);
+    if (fParallel) {
+        std::vector<CBlockTxCheck> vChecks;
+        vChecks.reserve(block.vtx.size());
+        for (size_t i = 0; i < block.vtx.size(); i++) {
+            vChecks.emplace_back(*block.vtx[i], txCheckContext, blockReward, &vSigOps[i]);
+        }
+        control.Add(vChecks);
+    }
+
     // Check the merkle root.
     if (fCheckMerkleRoot) {
         bool mutated;
@@ -3733,17 +4075,23 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
     for (unsigned int i = 1; i < block.vtx.size(); i++)
         if (block.vtx[i]->IsCoinBase())
             return state.DoS(100, false, REJECT_INVALID, "bad-cb-multiple", false, "more than one coinbase");
-    CAmount blockReward = GetBlockSubsidy(1, nHeight - 1, Params().GetConsensus(), false);
-    // Check transactions
-    for (const auto& tx : block.vtx)
-        if (!CheckTransaction(*tx, state, nHeight - 1, blockReward))
-            return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
-                                 strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), state.GetDebugMessage()));
+
+    // Without check threads, or if one of the transactions failed, go through
+    // them in order to find the first failure and its reject reason.
+    if (!fParallel || !control.Wait()) {
+        for (size_t i = 0; i < block.vtx.size(); i++) {
+            const auto& tx = block.vtx[i];
+            if (!CheckTransaction(*tx, state, txCheckContext, blockReward))
+                return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
+                                     strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(), state.GetDebugMessage()));
+            vSigOps[i] = GetLegacySigOpCount(*tx);
+        }
+    }
 
     unsigned int nSigOps = 0;
-    for (const auto& tx : block.vtx)
+    for (unsigned int nTxSigOps : vSigOps)
     {
-        nSigOps += GetLegacySigOpCount(*tx);
+        nSigOps += nTxSigOps;
     }
     // sigops limits (relaxed)
     if (nSigOps > MaxBlockSigOps())
@@ -3768,7 +4116,7 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
  *  in ConnectBlock().
  *  Note that -reindex-chainstate skips the validation that happens here!
  */
-static bool ContextualCheckBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& params, const CBlockIndex* pindexPrev, int64_t nAdjustedTime)
+bool ContextualCheckBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& params, const CBlockIndex* pindexPrev, int64_t nAdjustedTime)
 {
     assert(pindexPrev != nullptr);
     const int nHeight = pindexPrev->nHeight + 1;
@@ -4504,6 +4852,11 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams) EXCLUSIVE_LOCKS_RE
     if (fHavePruned)
         LogPrintf("LoadBlockIndexDB(): Block files have previously been pruned\n");
 
+    // Check whether the chainstate was loaded from a UTXO snapshot
+    pblocktree->ReadFlag("snapshotchainstate", fSnapshotChainstate);
+    if (fSnapshotChainstate)
+        LogPrintf("LoadBlockIndexDB(): Chainstate was loaded from a UTXO snapshot\n");
+
     // Check whether we need to continue reindexing
     bool fReindexing = false;
     pblocktree->ReadReindexing(fReindexing);
@@ -4529,6 +4882,10 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams) EXCLUSIVE_LOCKS_RE
     pblocktree->ReadFlag("futureindex", fFutureIndex);
     LogPrintf("%s: future index %s\n", __func__, fFutureIndex ? "enabled" : "disabled");
 
+    // Check whether we have a block stats index
+    pblocktree->ReadFlag("blockstatsindex", fBlockStatsIndex);
+    LogPrintf("%s: block stats index %s\n", __func__, fBlockStatsIndex ? "enabled" : "disabled");
+
     return true;
 }
 
@@ -4607,9 +4964,9 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
         uiInterface.ShowProgress(_("Verifying blocks..."), percentageDone, false);
         if (pindex->nHeight <= chainActive.Height()-nCheckDepth)
             break;
-        if (fPruneMode && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
-            // If pruning, only go back as far as we have data.
-            LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
+        if ((fPruneMode || fSnapshotChainstate) && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            // If pruning or started from a UTXO snapshot, only go back as far as we have data.
+            LogPrintf("VerifyDB(): block verification stopping at height %d (%s, no data)\n", pindex->nHeight, fPruneMode ? "pruning" : "UTXO snapshot");
             break;
         }
         CBlock block;
@@ -4809,6 +5166,8 @@ void UnloadBlockIndex()
     }
     mapBlockIndex.clear();
     fHavePruned = false;
+    fSnapshotChainstate = false;
+    recentScriptCheckedBlocks.clear();
 
     g_chainstate.UnloadBlockIndex();
 }
@@ -4850,6 +5209,10 @@ bool LoadBlockIndex(const CChainParams& chainparams)
         // Use the provided setting for -futureindex in the new database
         fFutureIndex = gArgs.GetBoolArg("-futureindex", DEFAULT_FUTUREINDEX);
         pblocktree->WriteFlag("futureindex", fFutureIndex);
+
+        // Use the provided setting for -blockstatsindex in the new database
+        fBlockStatsIndex = gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX);
+        pblocktree->WriteFlag("blockstatsindex", fBlockStatsIndex);
     }
     return true;
 }
@@ -99,8 +99,8 @@ static const int MAX_CMPCTBLOCK_DEPTH = 5;
 static const int MAX_BLOCKTXN_DEPTH = 10;
 /** Size of the "block download window": how far ahead of our current height do we fetch?
  *  Larger windows tolerate larger download speed differences between peer, but increase the potential
- *  degree of disordering of blocks on disk (which make reindexing and pruning harder). We'll probably
- *  want to make this a per-peer adaptive value at some point. */
+ *  degree of disordering of blocks on disk (which make reindexing and pruning harder). This is the
+ *  largest window, net_processing shrinks it while blocks are slow to validate. */
 static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
 /** Time to wait (in seconds) between writing blocks/block index to disk. */
 static const unsigned int DATABASE_WRITE_INTERVAL = 60 * 60;
@@ -126,6 +126,8 @@ static const bool DEFAULT_ADDRESSINDEX = false;
 static const bool DEFAULT_TIMESTAMPINDEX = false;
 static const bool DEFAULT_SPENTINDEX = false;
 static const bool DEFAULT_FUTUREINDEX = false;
+static const bool DEFAULT_BLOCKSTATSINDEX = false;
+static const bool DEFAULT_COINSTATSINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
@@ -172,6 +174,9 @@ extern bool fTxIndex;
 extern bool fAddressIndex;
 extern bool fTimestampIndex;
 extern bool fFutureIndex;
+extern bool fBlockStatsIndex;
+/** Maintain the UTXO set statistics while connecting blocks, see CCoinsStatsTracker */
+extern bool fCoinStatsIndex;
 extern bool fSpentIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
@@ -206,6 +211,8 @@ static const uint64_t nMinDiskSpace = 52428800;
 /** Pruning-related variables and constants */
 /** True if any block files have ever been pruned. */
 extern bool fHavePruned;
+/** True if the chainstate was loaded from a UTXO snapshot, the blocks below it are missing like pruned ones. */
+extern bool fSnapshotChainstate;
 /** True if we're running in -prune mode. */
 extern bool fPruneMode;
 /** Number of MiB of block files that we're trying to stay below. */
@@ -281,8 +288,50 @@ bool LoadBlockIndex(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs
 bool LoadChainTip(const CChainParams& chainparams);
 /** Unload database information */
 void UnloadBlockIndex();
+/**
+ * Cumulative time (in microseconds) spent in the stages of block validation since startup,
+ * the same numbers that are logged per block with -debug=bench.
+ */
+struct CBlockValidationTimings {
+    int64_t nBlocks;            //!< blocks connected
+    int64_t nPoW;               //!< proof of work checks, including headers and blocks read from disk
+    int64_t nCheck;             //!< CheckBlock inside ConnectBlock
+    int64_t nForks;
+    int64_t nProcessSpecial;    //!< ProcessSpecialTxsInBlock
+    int64_t nConnect;           //!< UTXO updates, excluding script verification
+    int64_t nVerify;            //!< nConnect plus waiting for the script checks
+    int64_t nRaptoreumSpecific; //!< InstantSend filter, subsidy, block value and payee checks
+    int64_t nIndex;
+    int64_t nCallbacks;
+    int64_t nReadFromDisk;
+    int64_t nConnectTotal;      //!< ConnectBlock
+    int64_t nFlush;
+    int64_t nChainState;
+    int64_t nPostConnect;
+    int64_t nTotal;             //!< ConnectTip
+};
+CBlockValidationTimings GetBlockValidationTimings();
+
+/** Reorg handling since startup. Times are in microseconds. */
+struct CReorgStats {
+    int64_t nReorgs{0};
+    int64_t nBlocksDisconnected{0};
+    int nMaxDepth{0};
+    int nLastDepth{0};
+    int64_t nLastTime{0};             //!< disconnecting, connecting and updating the mempool for the last reorg
+    int64_t nTotalTime{0};
+    int64_t nMempoolTime{0};          //!< UpdateMempoolForReorg, which invalidateblock runs as well
+    int64_t nTxResurrected{0};        //!< transactions of disconnected blocks offered to the mempool
+    int64_t nTxReadmitted{0};         //!< of which the mempool accepted
+    int64_t nTxCacheWarmed{0};        //!< script execution cache entries restored for disconnected blocks
+    int64_t nBlocksScriptsSkipped{0}; //!< reconnected blocks whose scripts were checked before
+};
+CReorgStats GetReorgStats();
+
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the context-free block transaction checking thread */
+void ThreadBlockCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -432,6 +481,9 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
 /** Context-independent validity checks */
 bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, int nHeight, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
+/** Header checks that depend on the previous block: difficulty, checkpoints and timestamps */
+bool ContextualCheckBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& params, const CBlockIndex* pindexPrev, int64_t nAdjustedTime);
+
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams, const CBlock& block, CBlockIndex* pindexPrev, bool fCheckPOW = true, bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
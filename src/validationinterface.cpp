@@ -21,62 +21,214 @@
 #include <list>
 #include <atomic>
 #include <future>
+#include <thread>
 
 #include <boost/signals2/signal.hpp>
 
-namespace pl = std::placeholders;
-
-struct ValidationInterfaceConnections {
-    boost::signals2::scoped_connection BlockChecked;
-    boost::signals2::scoped_connection Broadcast;
-    boost::signals2::scoped_connection SetBestChain;
-    boost::signals2::scoped_connection NotifyTransactionLock;
-    boost::signals2::scoped_connection NotifyChainLock;
-    boost::signals2::scoped_connection TransactionAddedToMempool;
-    boost::signals2::scoped_connection BlockConnected;
-    boost::signals2::scoped_connection BlockDisconnected;
-    boost::signals2::scoped_connection TransactionRemovedFromMempool;
-    boost::signals2::scoped_connection UpdatedBlockTip;
-    boost::signals2::scoped_connection SynchronousUpdatedBlockTip;
-    boost::signals2::scoped_connection NewPoWValidBlock;
-    boost::signals2::scoped_connection BlockFound;
-    boost::signals2::scoped_connection NotifyHeaderTip;
-    boost::signals2::scoped_connection AcceptedBlockHeader;
-    boost::signals2::scoped_connection NotifyGovernanceObject;
-    boost::signals2::scoped_connection NotifyGovernanceVote;
-    boost::signals2::scoped_connection NotifyInstantSendDoubleSpendAttempt;
-    boost::signals2::scoped_connection NotifySmartnodeListChanged;
-    boost::signals2::scoped_connection NotifyRecoveredSig;
+/** A single registration of a CValidationInterface */
+struct ValidationInterfaceRegistration {
+    CValidationInterface* const iface;
+    const std::string name;
+    const bool fBackpressure;
+    std::atomic<bool> fActive{true};
+
+    ValidationInterfaceRegistration(CValidationInterface* ifaceIn, const std::string& nameIn, bool fBackpressureIn) :
+        iface(ifaceIn), name(nameIn), fBackpressure(fBackpressureIn) {}
+};
+
+/**
+ * Background queue of one subscriber, serviced by a thread of its own so a
+ * slow subscriber neither holds up the others nor the scheduler. Slots are
+ * never freed while the scheduler is registered (barriers may still hold
+ * pointers to the queue), they are reused by later registrations once
+ * drained and idle instead.
+ */
+struct ValidationInterfaceSubscriber {
+    CScheduler m_scheduler;
+    SingleThreadedSchedulerClient m_schedulerClient;
+    std::thread m_thread;
+    std::shared_ptr<ValidationInterfaceRegistration> m_reg;
+    // Set while a callback runs, the queue is empty by then
+    std::atomic<bool> fRunning{false};
+
+    std::atomic<uint64_t> nProcessed{0};
+    std::atomic<uint64_t> nDropped{0};
+    std::atomic<int64_t> nTotalLatency{0};
+    std::atomic<int64_t> nMaxLatency{0};
+
+    ValidationInterfaceSubscriber() : m_schedulerClient(&m_scheduler)
+    {
+        m_thread = std::thread(&TraceThread<CScheduler::Function>, "valqueue", CScheduler::Function(std::bind(&CScheduler::serviceQueue, &m_scheduler)));
+    }
+
+    ~ValidationInterfaceSubscriber()
+    {
+        Stop();
+    }
+
+    /** Stop the thread once the current callback returns, callbacks still queued are left for EmptyQueue */
+    void Stop()
+    {
+        if (m_thread.joinable()) {
+            m_scheduler.stop(false);
+            m_thread.join();
+        }
+    }
+
+    void RecordLatency(int64_t nLatency)
+    {
+        nProcessed++;
+        nTotalLatency += nLatency;
+        int64_t nMax = nMaxLatency;
+        while (nLatency > nMax && !nMaxLatency.compare_exchange_weak(nMax, nLatency)) {}
+    }
 };
 
+typedef std::pair<ValidationInterfaceSubscriber*, std::shared_ptr<ValidationInterfaceRegistration>> SubscriberRef;
+
 struct MainSignalsInstance {
-    boost::signals2::signal<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> UpdatedBlockTip;
-    boost::signals2::signal<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> SynchronousUpdatedBlockTip;
-    boost::signals2::signal<void (const CTransactionRef &, int64_t)> TransactionAddedToMempool;
-    boost::signals2::signal<void (const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex, const std::vector<CTransactionRef>&)> BlockConnected;
-    boost::signals2::signal<void (const std::shared_ptr<const CBlock> &, const CBlockIndex* pindexDisconnected)> BlockDisconnected;
-    boost::signals2::signal<void (const CTransactionRef &, MemPoolRemovalReason)> TransactionRemovedFromMempool;
-    boost::signals2::signal<void (const CBlockLocator &)> SetBestChain;
-    boost::signals2::signal<void (int64_t nBestBlockTime, CConnman* connman)> Broadcast;
-    boost::signals2::signal<void (const CBlock&, const CValidationState&)> BlockChecked;
-    boost::signals2::signal<void (const CBlockIndex *, const std::shared_ptr<const CBlock>&)> NewPoWValidBlock;
-    boost::signals2::signal<void (const uint256 &)> BlockFound;
-    boost::signals2::signal<void (const CBlockIndex *)>AcceptedBlockHeader;
-    boost::signals2::signal<void (const CBlockIndex *, bool)>NotifyHeaderTip;
-    boost::signals2::signal<void (const CTransactionRef& tx, const std::shared_ptr<const llmq::CInstantSendLock>& islock)>NotifyTransactionLock;
-    boost::signals2::signal<void (const CBlockIndex* pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig)>NotifyChainLock;
-    boost::signals2::signal<void (const std::shared_ptr<const CGovernanceVote>& vote)>NotifyGovernanceVote;
-    boost::signals2::signal<void (const std::shared_ptr<const CGovernanceObject>& object)>NotifyGovernanceObject;
-    boost::signals2::signal<void (const CTransactionRef& currentTx, const CTransactionRef& previousTx)>NotifyInstantSendDoubleSpendAttempt;
-    boost::signals2::signal<void (bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff)>NotifySmartnodeListChanged;
-    boost::signals2::signal<void (const std::shared_ptr<const llmq::CRecoveredSig>& sig)>NotifyRecoveredSig;
-    // We are not allowed to assume the scheduler only runs in one thread,
-    // but must ensure all callbacks happen in-order, so we end up creating
-    // our own queue here :(
+    CScheduler *m_pscheduler;
+    // Used for CallFunctionInValidationInterfaceQueue barriers only, every
+    // subscriber gets its own queue so a slow one doesn't hold up the others
     SingleThreadedSchedulerClient m_schedulerClient;
-    std::unordered_map<CValidationInterface*, ValidationInterfaceConnections> m_connMainSignals;
 
-    explicit MainSignalsInstance(CScheduler *pscheduler) : m_schedulerClient(pscheduler) {}
+    CCriticalSection cs_subscribers;
+    std::vector<std::unique_ptr<ValidationInterfaceSubscriber>> m_subscribers GUARDED_BY(cs_subscribers);
+
+    explicit MainSignalsInstance(CScheduler *pscheduler) : m_pscheduler(pscheduler), m_schedulerClient(pscheduler) {}
+
+    /** Active registrations, in registration order */
+    std::vector<SubscriberRef> GetSubscribers()
+    {
+        LOCK(cs_subscribers);
+        std::vector<SubscriberRef> ret;
+        ret.reserve(m_subscribers.size());
+        for (const auto& sub : m_subscribers) {
+            if (sub->m_reg) {
+                ret.emplace_back(sub.get(), sub->m_reg);
+            }
+        }
+        return ret;
+    }
+
+    void Register(CValidationInterface* iface, const std::string& name, bool fBackpressure)
+    {
+        LOCK(cs_subscribers);
+        Unregister(iface);
+        auto reg = std::make_shared<ValidationInterfaceRegistration>(iface, name, fBackpressure);
+        for (const auto& sub : m_subscribers) {
+            // Leftover callbacks of an unregistered interface are dropped when
+            // run, but wait for them to drain and for a callback that is still
+            // running so they don't count against the new registration
+            if (!sub->m_reg && sub->m_schedulerClient.CallbacksPending() == 0 && !sub->fRunning) {
+                sub->m_reg = reg;
+                sub->nProcessed = 0;
+                sub->nDropped = 0;
+                sub->nTotalLatency = 0;
+                sub->nMaxLatency = 0;
+                return;
+            }
+        }
+        m_subscribers.emplace_back(new ValidationInterfaceSubscriber());
+        m_subscribers.back()->m_reg = reg;
+    }
+
+    void Unregister(CValidationInterface* iface)
+    {
+        LOCK(cs_subscribers);
+        for (const auto& sub : m_subscribers) {
+            if (sub->m_reg && sub->m_reg->iface == iface) {
+                sub->m_reg->fActive = false;
+                sub->m_reg.reset();
+            }
+        }
+    }
+
+    void UnregisterAll()
+    {
+        LOCK(cs_subscribers);
+        for (const auto& sub : m_subscribers) {
+            if (sub->m_reg) {
+                sub->m_reg->fActive = false;
+                sub->m_reg.reset();
+            }
+        }
+    }
+
+    /**
+     * Queues to put barriers on. An unregistered subscriber's queue stays in
+     * the full set, as a callback that started before the unregistration may
+     * still be running on it and the caller may be about to free the
+     * subscriber.
+     */
+    std::vector<ValidationInterfaceSubscriber*> GetQueues(bool fBackpressureOnly)
+    {
+        LOCK(cs_subscribers);
+        std::vector<ValidationInterfaceSubscriber*> ret;
+        for (const auto& sub : m_subscribers) {
+            if (!fBackpressureOnly || (sub->m_reg && sub->m_reg->fBackpressure)) {
+                ret.push_back(sub.get());
+            }
+        }
+        return ret;
+    }
+
+    /** Call func once every queue in queues got through everything queued before this call */
+    void CallFunctionInQueues(const std::vector<ValidationInterfaceSubscriber*>& queues, std::function<void ()> func)
+    {
+        // Each queue counts down once, the last one to do so runs func
+        auto remaining = std::make_shared<std::atomic<size_t>>(queues.size() + 1);
+        auto pfunc = std::make_shared<std::function<void ()>>(std::move(func));
+        auto countDown = [remaining, pfunc] {
+            if (--*remaining == 0) {
+                (*pfunc)();
+            }
+        };
+        for (ValidationInterfaceSubscriber* psub : queues) {
+            psub->m_schedulerClient.AddToProcessQueue(countDown);
+        }
+        m_schedulerClient.AddToProcessQueue(countDown);
+    }
+
+    /** Call func for every subscriber on the calling thread */
+    template <typename Callable>
+    void Notify(Callable func)
+    {
+        for (const auto& sub : GetSubscribers()) {
+            if (sub.second->fActive) {
+                func(*sub.second->iface);
+            }
+        }
+    }
+
+    /**
+     * Queue func for every subscriber on its own background queue. Validation
+     * doesn't wait for a subscriber without backpressure, so its notifications
+     * are dropped instead once MAX_CALLBACKS_WITHOUT_BACKPRESSURE are queued.
+     */
+    template <typename Callable>
+    void Enqueue(Callable func)
+    {
+        for (const auto& sub : GetSubscribers()) {
+            ValidationInterfaceSubscriber* psub = sub.first;
+            std::shared_ptr<ValidationInterfaceRegistration> reg = sub.second;
+            if (!reg->fBackpressure && psub->m_schedulerClient.CallbacksPending() >= MAX_CALLBACKS_WITHOUT_BACKPRESSURE) {
+                if (psub->nDropped++ == 0) {
+                    LogPrintf("%s: queue of %s is full, dropping notifications\n", __func__, reg->name);
+                }
+                continue;
+            }
+            int64_t nQueued = GetTimeMicros();
+            psub->m_schedulerClient.AddToProcessQueue([psub, reg, func, nQueued] {
+                psub->fRunning = true;
+                if (reg->fActive) {
+                    func(*reg->iface);
+                    psub->RecordLatency(GetTimeMicros() - nQueued);
+                }
+                psub->fRunning = false;
+            });
+        }
+    }
 };
 
 static CMainSignals g_signals;
@@ -97,17 +249,51 @@ void CMainSignals::UnregisterBackgroundSignalScheduler() {
 
 void CMainSignals::FlushBackgroundCallbacks() {
     if (m_internals) {
+        std::vector<ValidationInterfaceSubscriber*> subscribers;
+        {
+            LOCK(m_internals->cs_subscribers);
+            for (const auto& sub : m_internals->m_subscribers) {
+                subscribers.push_back(sub.get());
+            }
+        }
+        for (ValidationInterfaceSubscriber* sub : subscribers) {
+            sub->Stop();
+            sub->m_schedulerClient.EmptyQueue();
+        }
         m_internals->m_schedulerClient.EmptyQueue();
     }
 }
 
 size_t CMainSignals::CallbacksPending() {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    // Only subscribers that need to stay consistent with validation hold it
+    // back, others (e.g. ZMQ) may fall behind
+    size_t nPending = m_internals->m_schedulerClient.CallbacksPending();
+    for (ValidationInterfaceSubscriber* psub : m_internals->GetQueues(true)) {
+        nPending = std::max(nPending, psub->m_schedulerClient.CallbacksPending());
+    }
+    return nPending;
+}
+
+std::vector<ValidationInterfaceQueueStats> CMainSignals::GetQueueStats() {
+    std::vector<ValidationInterfaceQueueStats> ret;
+    if (!m_internals) return ret;
+    for (const auto& sub : m_internals->GetSubscribers()) {
+        ValidationInterfaceQueueStats stats;
+        stats.name = sub.second->name;
+        stats.fBackpressure = sub.second->fBackpressure;
+        stats.nPending = sub.first->m_schedulerClient.CallbacksPending();
+        stats.nProcessed = sub.first->nProcessed;
+        stats.nDropped = sub.first->nDropped;
+        stats.nTotalLatencyMicros = sub.first->nTotalLatency;
+        stats.nMaxLatencyMicros = sub.first->nMaxLatency;
+        ret.push_back(stats);
+    }
+    return ret;
 }
 
 void CMainSignals::RegisterWithMempoolSignals(CTxMemPool& pool) {
-    g_connNotifyEntryRemoved.emplace(&pool, pool.NotifyEntryRemoved.connect(std::bind(&CMainSignals::MempoolEntryRemoved, this, pl::_1, pl::_2)));
+    g_connNotifyEntryRemoved.emplace(&pool, pool.NotifyEntryRemoved.connect(std::bind(&CMainSignals::MempoolEntryRemoved, this, std::placeholders::_1, std::placeholders::_2)));
 }
 
 void CMainSignals::UnregisterWithMempoolSignals(CTxMemPool& pool) {
@@ -119,43 +305,23 @@ CMainSignals& GetMainSignals()
     return g_signals;
 }
 
-void RegisterValidationInterface(CValidationInterface* pwalletIn) {
-    ValidationInterfaceConnections& conns = g_signals.m_internals->m_connMainSignals[pwalletIn];
-    conns.AcceptedBlockHeader = g_signals.m_internals->AcceptedBlockHeader.connect(std::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, pl::_1));
-    conns.NotifyHeaderTip = g_signals.m_internals->NotifyHeaderTip.connect(std::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, pl::_1, pl::_2));
-    conns.UpdatedBlockTip = g_signals.m_internals->UpdatedBlockTip.connect(std::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, pl::_1, pl::_2, pl::_3));
-    conns.SynchronousUpdatedBlockTip = g_signals.m_internals->SynchronousUpdatedBlockTip.connect(std::bind(&CValidationInterface::SynchronousUpdatedBlockTip, pwalletIn, pl::_1, pl::_2, pl::_3));
-    conns.TransactionAddedToMempool = g_signals.m_internals->TransactionAddedToMempool.connect(std::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, pl::_1, pl::_2));
-    conns.BlockConnected = g_signals.m_internals->BlockConnected.connect(std::bind(&CValidationInterface::BlockConnected, pwalletIn, pl::_1, pl::_2, pl::_3));
-    conns.BlockFound = g_signals.m_internals->BlockFound.connect(std::bind(&CValidationInterface::BlockFound, pwalletIn, pl::_1));
-    conns.UpdatedBlockTip = g_signals.m_internals->UpdatedBlockTip.connect(std::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, pl::_1, pl::_2, pl::_3));
-    conns.BlockDisconnected = g_signals.m_internals->BlockDisconnected.connect(std::bind(&CValidationInterface::BlockDisconnected, pwalletIn, pl::_1, pl::_2));
-    conns.NotifyTransactionLock = g_signals.m_internals->NotifyTransactionLock.connect(std::bind(&CValidationInterface::NotifyTransactionLock, pwalletIn, pl::_1, pl::_2));
-    conns.NotifyChainLock = g_signals.m_internals->NotifyChainLock.connect(std::bind(&CValidationInterface::NotifyChainLock, pwalletIn, pl::_1, pl::_2));
-    conns.TransactionRemovedFromMempool = g_signals.m_internals->TransactionRemovedFromMempool.connect(std::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, pl::_1, pl::_2));
-    conns.Broadcast = g_signals.m_internals->Broadcast.connect(std::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, pl::_1, pl::_2));
-    conns.BlockChecked = g_signals.m_internals->BlockChecked.connect(std::bind(&CValidationInterface::BlockChecked, pwalletIn, pl::_1, pl::_2));
-    conns.NewPoWValidBlock = g_signals.m_internals->NewPoWValidBlock.connect(std::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, pl::_1, pl::_2));
-    conns.NotifyGovernanceObject = g_signals.m_internals->NotifyGovernanceObject.connect(std::bind(&CValidationInterface::NotifyGovernanceObject, pwalletIn, pl::_1));
-    conns.NotifyGovernanceVote = g_signals.m_internals->NotifyGovernanceVote.connect(std::bind(&CValidationInterface::NotifyGovernanceVote, pwalletIn, pl::_1));
-    conns.NotifyInstantSendDoubleSpendAttempt = g_signals.m_internals->NotifyInstantSendDoubleSpendAttempt.connect(std::bind(&CValidationInterface::NotifyInstantSendDoubleSpendAttempt, pwalletIn, pl::_1, pl::_2));
-    conns.NotifyRecoveredSig = g_signals.m_internals->NotifyRecoveredSig.connect(std::bind(&CValidationInterface::NotifyRecoveredSig, pwalletIn, pl::_1));
-    conns.NotifySmartnodeListChanged = g_signals.m_internals->NotifySmartnodeListChanged.connect(std::bind(&CValidationInterface::NotifySmartnodeListChanged, pwalletIn, pl::_1, pl::_2, pl::_3));
+void RegisterValidationInterface(CValidationInterface* pwalletIn, const std::string& strName, bool fBackpressure) {
+    g_signals.m_internals->Register(pwalletIn, strName.empty() ? "unnamed" : strName, fBackpressure);
 }
 
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
-    g_signals.m_internals->m_connMainSignals.erase(pwalletIn);
+    g_signals.m_internals->Unregister(pwalletIn);
 }
 
 void UnregisterAllValidationInterfaces() {
     if (!g_signals.m_internals) {
         return;
     }
-    g_signals.m_internals->m_connMainSignals.clear();
+    g_signals.m_internals->UnregisterAll();
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void ()> func) {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    g_signals.m_internals->CallFunctionInQueues(g_signals.m_internals->GetQueues(false), std::move(func));
 }
 
 void SyncWithValidationInterfaceQueue() {
@@ -168,10 +334,19 @@ void SyncWithValidationInterfaceQueue() {
     promise.get_future().wait();
 }
 
+void SyncWithBackpressureValidationInterfaceQueues() {
+    AssertLockNotHeld(cs_main);
+    std::promise<void> promise;
+    g_signals.m_internals->CallFunctionInQueues(g_signals.m_internals->GetQueues(true), [&promise] {
+        promise.set_value();
+    });
+    promise.get_future().wait();
+}
+
 void CMainSignals::MempoolEntryRemoved(CTransactionRef ptx, MemPoolRemovalReason reason) {
     if (reason != MemPoolRemovalReason::BLOCK) {
-        m_internals->m_schedulerClient.AddToProcessQueue([ptx, reason, this] {
-            m_internals->TransactionRemovedFromMempool(ptx, reason);
+        m_internals->Enqueue([ptx, reason](CValidationInterface& iface) {
+            iface.TransactionRemovedFromMempool(ptx, reason);
         });
     }
 }
@@ -181,99 +356,115 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     // the chain actually updates. One way to ensure this is for the caller to invoke this signal
     // in the same critical section where the chain is updated
 
-    m_internals->m_schedulerClient.AddToProcessQueue([pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    m_internals->Enqueue([pindexNew, pindexFork, fInitialDownload](CValidationInterface& iface) {
+        iface.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     });
 }
 
 void CMainSignals::SynchronousUpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) {
-    m_internals->SynchronousUpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    m_internals->Notify([&](CValidationInterface& iface) {
+        iface.SynchronousUpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    });
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef &ptx, int64_t nAcceptTime) {
-    m_internals->m_schedulerClient.AddToProcessQueue([ptx, nAcceptTime, this] {
-        m_internals->TransactionAddedToMempool(ptx, nAcceptTime);
+    m_internals->Enqueue([ptx, nAcceptTime](CValidationInterface& iface) {
+        iface.TransactionAddedToMempool(ptx, nAcceptTime);
     });
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CTransactionRef>>& pvtxConflicted) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, pindex, pvtxConflicted, this] {
-        m_internals->BlockConnected(pblock, pindex, *pvtxConflicted);
+    m_internals->Enqueue([pblock, pindex, pvtxConflicted](CValidationInterface& iface) {
+        iface.BlockConnected(pblock, pindex, *pvtxConflicted);
     });
 }
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex* pindexDisconnected) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, pindexDisconnected, this] {
-        m_internals->BlockDisconnected(pblock, pindexDisconnected);
+    m_internals->Enqueue([pblock, pindexDisconnected](CValidationInterface& iface) {
+        iface.BlockDisconnected(pblock, pindexDisconnected);
     });
 }
 
 void CMainSignals::SetBestChain(const CBlockLocator &locator) {
-    m_internals->m_schedulerClient.AddToProcessQueue([locator, this] {
-        m_internals->SetBestChain(locator);
+    m_internals->Enqueue([locator](CValidationInterface& iface) {
+        iface.SetBestChain(locator);
     });
 }
 
 void CMainSignals::Broadcast(int64_t nBestBlockTime, CConnman* connman) {
-    m_internals->Broadcast(nBestBlockTime, connman);
+    m_internals->Notify([&](CValidationInterface& iface) {
+        iface.ResendWalletTransactions(nBestBlockTime, connman);
+    });
 }
 
 void CMainSignals::BlockChecked(const CBlock& block, const CValidationState& state) {
-    m_internals->BlockChecked(block, state);
+    m_internals->Notify([&](CValidationInterface& iface) {
+        iface.BlockChecked(block, state);
+    });
 }
 
 void CMainSignals::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock> &block) {
-    m_internals->NewPoWValidBlock(pindex, block);
+    m_internals->Notify([&](CValidationInterface& iface) {
+        iface.NewPoWValidBlock(pindex, block);
+    });
 }
 
 void CMainSignals::BlockFound(const uint256 &hash) {
-    m_internals->BlockFound(hash);
+    m_internals->Notify([&](CValidationInterface& iface) {
+        iface.BlockFound(hash);
+    });
 }
 
 void CMainSignals::AcceptedBlockHeader(const CBlockIndex *pindexNew) {
-    m_internals->AcceptedBlockHeader(pindexNew);
+    m_internals->Notify([&](CValidationInterface& iface) {
+        iface.AcceptedBlockHeader(pindexNew);
+    });
 }
 
 void CMainSignals::NotifyHeaderTip(const CBlockIndex *pindexNew, bool fInitialDownload) {
-    m_internals->NotifyHeaderTip(pindexNew, fInitialDownload);
+    m_internals->Notify([&](CValidationInterface& iface) {
+        iface.NotifyHeaderTip(pindexNew, fInitialDownload);
+    });
 }
 
 void CMainSignals::NotifyTransactionLock(const CTransactionRef &tx, const std::shared_ptr<const llmq::CInstantSendLock>& islock) {
-    m_internals->m_schedulerClient.AddToProcessQueue([tx, islock, this] {
-        m_internals->NotifyTransactionLock(tx, islock);
+    m_internals->Enqueue([tx, islock](CValidationInterface& iface) {
+        iface.NotifyTransactionLock(tx, islock);
     });
 }
 
 void CMainSignals::NotifyChainLock(const CBlockIndex* pindex, const std::shared_ptr<const llmq::CChainLockSig>& clsig) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pindex, clsig, this] {
-        m_internals->NotifyChainLock(pindex, clsig);
+    m_internals->Enqueue([pindex, clsig](CValidationInterface& iface) {
+        iface.NotifyChainLock(pindex, clsig);
     });
 }
 
 void CMainSignals::NotifyGovernanceVote(const std::shared_ptr<const CGovernanceVote>& vote) {
-    m_internals->m_schedulerClient.AddToProcessQueue([vote, this] {
-        m_internals->NotifyGovernanceVote(vote);
+    m_internals->Enqueue([vote](CValidationInterface& iface) {
+        iface.NotifyGovernanceVote(vote);
     });
 }
 
 void CMainSignals::NotifyGovernanceObject(const std::shared_ptr<const CGovernanceObject>& object) {
-    m_internals->m_schedulerClient.AddToProcessQueue([object, this] {
-        m_internals->NotifyGovernanceObject(object);
+    m_internals->Enqueue([object](CValidationInterface& iface) {
+        iface.NotifyGovernanceObject(object);
     });
 }
 
 void CMainSignals::NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx) {
-    m_internals->m_schedulerClient.AddToProcessQueue([currentTx, previousTx, this] {
-        m_internals->NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx);
+    m_internals->Enqueue([currentTx, previousTx](CValidationInterface& iface) {
+        iface.NotifyInstantSendDoubleSpendAttempt(currentTx, previousTx);
     });
 }
 
 void CMainSignals::NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig) {
-    m_internals->m_schedulerClient.AddToProcessQueue([sig, this] {
-        m_internals->NotifyRecoveredSig(sig);
+    m_internals->Enqueue([sig](CValidationInterface& iface) {
+        iface.NotifyRecoveredSig(sig);
     });
 }
 
 void CMainSignals::NotifySmartnodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff) {
-    m_internals->NotifySmartnodeListChanged(undo, oldMNList, diff);
-}
\ No newline at end of file
+    m_internals->Notify([&](CValidationInterface& iface) {
+        iface.NotifySmartnodeListChanged(undo, oldMNList, diff);
+    });
+}
@@ -10,6 +10,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
@@ -33,16 +35,27 @@ namespace llmq {
     class CRecoveredSig;
 } // namespace llmq
 
+/** Background callbacks queued for a subscriber without backpressure before further ones are dropped */
+static const size_t MAX_CALLBACKS_WITHOUT_BACKPRESSURE = 1000;
+
 // These functions dispatch to one or all registered wallets
 
-/** Register a wallet to receive updates from core */
-void RegisterValidationInterface(CValidationInterface* pwalletIn);
+/**
+ * Register a wallet to receive updates from core. Background callbacks of
+ * each registered interface are queued separately and run on a thread of
+ * its own. fBackpressure means validation waits for this subscriber when it
+ * falls too far behind, it should only be cleared for subscribers that don't
+ * need to keep up with the chain state (e.g. external notifications). Such a
+ * subscriber misses notifications while MAX_CALLBACKS_WITHOUT_BACKPRESSURE
+ * are queued for it.
+ */
+void RegisterValidationInterface(CValidationInterface* pwalletIn, const std::string& strName = "", bool fBackpressure = true);
 /** Unregister a wallet from core */
 void UnregisterValidationInterface(CValidationInterface* pwalletIn);
 /** Unregister all wallets from core */
 void UnregisterAllValidationInterfaces();
 /**
- * Pushes a function to callback onto the notification queue, guaranteeing any
+ * Pushes a function to callback onto the notification queues, guaranteeing any
  * callbacks generated prior to now are finished when the function is called.
  *
  * Be very careful blocking on func to be called if any locks are held -
@@ -61,6 +74,12 @@ void CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
  *     promise.get_future().wait();
  */
 void SyncWithValidationInterfaceQueue();
+/**
+ * Like SyncWithValidationInterfaceQueue, but only waits for the subscribers
+ * registered with backpressure. This is what validation uses to avoid
+ * running too far ahead of its subscribers.
+ */
+void SyncWithBackpressureValidationInterfaceQueues();
 
 /**
  * Implement this to subscribe to events generated in validation
@@ -153,9 +172,18 @@ protected:
      * has been received and connected to the headers tree, though not validated yet */
     virtual void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) {};
     virtual void BlockFound(const uint256 &hash) {};
-    friend void ::RegisterValidationInterface(CValidationInterface*);
-    friend void ::UnregisterValidationInterface(CValidationInterface*);
-    friend void ::UnregisterAllValidationInterfaces();
+    friend class CMainSignals;
+};
+
+/** Queue statistics of a registered validation interface */
+struct ValidationInterfaceQueueStats {
+    std::string name;
+    bool fBackpressure;
+    size_t nPending;
+    uint64_t nProcessed;
+    uint64_t nDropped;
+    int64_t nTotalLatencyMicros;
+    int64_t nMaxLatencyMicros;
 };
 
 struct MainSignalsInstance;
@@ -163,10 +191,11 @@ class CMainSignals {
 private:
     std::unique_ptr<MainSignalsInstance> m_internals;
 
-    friend void ::RegisterValidationInterface(CValidationInterface*);
+    friend void ::RegisterValidationInterface(CValidationInterface*, const std::string&, bool);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
     friend void ::CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
+    friend void ::SyncWithBackpressureValidationInterfaceQueues();
 
     void MempoolEntryRemoved(CTransactionRef tx, MemPoolRemovalReason reason);
 
@@ -178,7 +207,10 @@ public:
     /** Call any remaining callbacks on the calling thread */
     void FlushBackgroundCallbacks();
 
+    /** Longest background queue of the subscribers with backpressure, see RegisterValidationInterface */
     size_t CallbacksPending();
+    /** Per subscriber queue depth and latency, in registration order */
+    std::vector<ValidationInterfaceQueueStats> GetQueueStats();
 
     /** Register with mempool to call TransactionRemovedFromMempool callbacks */
     void RegisterWithMempoolSignals(CTxMemPool& pool);
@@ -303,7 +303,8 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
             CWalletTx wtx(nullptr /* pwallet */, MakeTransactionRef());
             ssValue >> wtx;
             CValidationState state;
-            if (!(CheckTransaction(*wtx.tx, state, 0, 0) && (wtx.GetHash() == hash) && state.IsValid()))
+            const CTxCheckContext txCheckContext = WITH_LOCK(cs_main, return CTxCheckContext(chainActive.Tip()));
+            if (!(CheckTransaction(*wtx.tx, state, txCheckContext, 0) && (wtx.GetHash() == hash) && state.IsValid()))
                 return false;
 
             // Undo serialize changes in 31600
@@ -878,8 +879,8 @@ bool WalletBatch::RecoverKeysOnlyFilter(void *callbackData, CDataStream ssKey, C
     std::string strType, strErr;
     bool fReadOK;
     {
-        // Required in LoadKeyMetadata():
-        LOCK(dummyWallet->cs_wallet);
+        // Required in LoadKeyMetadata(), cs_main is taken for tx records in ReadKeyValue()
+        LOCK2(cs_main, dummyWallet->cs_wallet);
         fReadOK = ReadKeyValue(dummyWallet, ssKey, ssValue,
                                dummyWss, strType, strErr);
     }
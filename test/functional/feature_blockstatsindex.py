@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020-2022 The Raptoreum developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the block stats index and getblockstats height ranges.
+
+- Node 0 runs -blockstatsindex, node 1 computes the statistics from the blocks
+  (-blockstatsindex=0 -txindex).
+- Mine plain and future transactions with the special tx fee spork enabled and
+  check the Raptoreum specific statistics of node 0.
+- Reorg a block with a future transaction away and verify the lock is counted
+  as matured at the height of the block it ends up in, not the original one.
+- Compare a height range answered by the index with node 1's per block
+  computation and check the range limits.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+    connect_nodes_bi,
+    disconnect_nodes,
+    wait_until,
+)
+
+COIN = 100000000
+SPORK_KEY = "cP4EKFyJsHT39LDqgdcB43Y3YXjNyjb5Fuas1GQSeAtjnZWmZEQK"
+FUTURE_FEE = 1
+FUTURE_MATURITY = 5
+FUTURE_AMOUNT = 10
+
+RAPTOREUM_STATS = [
+    'specialtxfee',
+    'protxs',
+    'quorumcommitments',
+    'futuretxs',
+    'futurelocked',
+    'futurelockedamount',
+    'futurematured',
+    'futurematuredamount',
+    'smartnodepayment',
+    'founderpayment',
+]
+
+class BlockStatsIndexTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [['-blockstatsindex', '-sporkkey=%s' % SPORK_KEY], ['-blockstatsindex=0', '-txindex']]
+
+    def send_future(self, node):
+        return node.sendtoaddress(node.getnewaddress(), FUTURE_AMOUNT, {"future_maturity": FUTURE_MATURITY, "future_locktime": 100000000})
+
+    def run_test(self):
+        node0, node1 = self.nodes
+        node0.generate(110)
+        self.sync_all()
+
+        self.log.info("Enable the special tx fee")
+        node0.spork("SPORK_22_SPECIAL_TX_FEE", FUTURE_FEE)
+        wait_until(lambda: node1.spork("show")["SPORK_22_SPECIAL_TX_FEE"] == FUTURE_FEE, timeout=10)
+
+        self.log.info("Mine plain and future transactions")
+        node0.sendtoaddress(node1.getnewaddress(), 5)
+        node0.sendtoaddress(node0.getnewaddress(), 3, "", "", True)
+        self.send_future(node0)
+        self.sync_all()
+        node0.generate(1)
+        self.sync_all()
+        future_height = node0.getblockcount()
+
+        stats = node0.getblockstats(future_height)
+        for stat in RAPTOREUM_STATS:
+            assert stat in stats
+        assert_equal(stats["txs"], 4)
+        assert_equal(stats["futuretxs"], 1)
+        assert_equal(stats["futurelocked"], 1)
+        assert_equal(stats["futurelockedamount"], FUTURE_AMOUNT * COIN)
+        assert_equal(stats["futurematured"], 0)
+        assert_equal(stats["specialtxfee"], FUTURE_FEE * COIN)
+        # The special tx fee counts as part of the fee
+        assert stats["totalfee"] > FUTURE_FEE * COIN
+        # No smartnodes are registered and the regtest founder payment starts at height 500
+        assert_equal(stats["smartnodepayment"], 0)
+        assert_equal(stats["founderpayment"], 0)
+
+        node0.generate(FUTURE_MATURITY)
+        self.sync_all()
+        assert_equal(node0.getblockstats(future_height + FUTURE_MATURITY - 1, ["futurematured"])["futurematured"], 0)
+        stats = node0.getblockstats(future_height + FUTURE_MATURITY, ["futurematured", "futurematuredamount", "specialtxfee"])
+        assert_equal(stats, {"futurematured": 1, "futurematuredamount": FUTURE_AMOUNT * COIN, "specialtxfee": 0})
+
+        self.log.info("Reorg a future transaction into a later block")
+        disconnect_nodes(node0, 1)
+        disconnect_nodes(node1, 0)
+        fork_height = node0.getblockcount()
+        self.send_future(node0)
+        node0.generate(1)
+        node1.generate(3)
+        connect_nodes_bi(self.nodes, 0, 1)
+        self.sync_blocks()
+        assert_equal(node0.getblockcount(), fork_height + 3)
+        # The disconnected transaction is back in the mempool
+        assert_equal(node0.getmempoolinfo()["size"], 1)
+        node0.generate(1)
+        self.sync_all()
+        reorg_height = fork_height + 4
+        assert_equal(node0.getblockstats(reorg_height, ["futurelocked"])["futurelocked"], 1)
+        node0.generate(FUTURE_MATURITY)
+        self.sync_all()
+        # The lock recorded by the disconnected block at fork_height + 1 is gone
+        assert_equal(node0.getblockstats(fork_height + 1 + FUTURE_MATURITY, ["futurematured"])["futurematured"], 0)
+        assert_equal(node0.getblockstats(reorg_height + FUTURE_MATURITY, ["futurematured"])["futurematured"], 1)
+
+        self.log.info("Compare a range from the index with the statistics computed from the blocks")
+        tip = node0.getblockcount()
+        ranged = node0.getblockstats(1, None, tip)
+        assert_equal(len(ranged), tip)
+        for height, stats in enumerate(ranged, 1):
+            assert_equal(stats["height"], height)
+            assert_equal(stats["blockhash"], node0.getblockhash(height))
+            computed = node1.getblockstats(height)
+            assert_equal({k: stats[k] for k in computed.keys()}, computed)
+            assert_equal(set(stats.keys()), set(computed.keys()) | set(RAPTOREUM_STATS))
+            # Single block lookups come from the index too
+            assert_equal(node0.getblockstats(height), stats)
+
+        selected = node0.getblockstats(future_height, ["height", "futurelocked"], future_height + 1)
+        assert_equal(selected, [{"height": future_height, "futurelocked": 1}, {"height": future_height + 1, "futurelocked": 0}])
+
+        self.log.info("Check the range limits")
+        assert_raises_rpc_error(-8, "end_height %d must be between %d" % (future_height - 1, future_height), node0.getblockstats, future_height, None, future_height - 1)
+        assert_raises_rpc_error(-8, "and the current tip %d" % tip, node0.getblockstats, 1, None, tip + 1)
+        assert_raises_rpc_error(-8, "Height ranges must start after the genesis block", node0.getblockstats, 0, None, 1)
+        assert_raises_rpc_error(-8, "Height ranges require -blockstatsindex", node1.getblockstats, 1, None, 2)
+        assert_raises_rpc_error(-8, "Raptoreum specific statistics require -blockstatsindex", node1.getblockstats, 1, ["specialtxfee"])
+        assert_equal(node0.getblockstats(tip, None, tip), [node0.getblockstats(tip)])
+
+if __name__ == '__main__':
+    BlockStatsIndexTest().main()
@@ -296,6 +296,11 @@ class DIP3Test(BitcoinTestFramework):
             mn_list = node.smartnode('list')
             assert_equal(protx_info['state']['service'], '127.0.0.2:%d' % mn.p2p_port)
             assert_equal(mn_list['%s-%d' % (mn.collateral_txid, mn.collateral_vout)]['address'], '127.0.0.2:%d' % mn.p2p_port)
+            protx_list = node.protx('list', 'registered', True, 0, {'owner': mn.ownerAddr})
+            assert_equal(len(protx_list), 1)
+            assert_equal(protx_list[0]['proTxHash'], mn.protx_hash)
+            assert_equal(protx_list[0]['state']['service'], '127.0.0.2:%d' % mn.p2p_port)
+            assert_equal(node.protx('list', 'registered', False, 0, {'owner': mn.ownerAddr, 'skip': 1}), [])
 
         # undo
         self.nodes[0].protx('update_service', mn.protx_hash, '127.0.0.1:%d' % mn.p2p_port, mn.blsMnkey, "", mn.fundsAddr)
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020-2022 The Raptoreum developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the exportchain RPC and the -loadbootstrap startup option.
+
+- Generate blocks on node 0 and export them with exportchain.
+- Start node 1, which isn't connected to node 0, with -loadbootstrap pointing at the export
+  and verify it ends up on the same tip.
+- Restart node 1 with the same bootstrap to check already known blocks are skipped.
+"""
+
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error, wait_until
+
+class LoadBootstrapTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+
+    def setup_network(self):
+        self.setup_nodes()
+
+    def run_test(self):
+        node0 = self.nodes[0]
+        node0.generate(150)
+        tip = node0.getbestblockhash()
+
+        self.log.info("Check the height range is validated")
+        bootstrap_dir = os.path.join(self.options.tmpdir, "bootstrap")
+        assert_raises_rpc_error(-8, "Block heights out of range", node0.exportchain, bootstrap_dir, 0, 151)
+        assert_raises_rpc_error(-8, "Block heights out of range", node0.exportchain, bootstrap_dir, 10, 5)
+
+        self.log.info("Export the chain")
+        res = node0.exportchain(bootstrap_dir)
+        assert_equal(res["start_height"], 0)
+        assert_equal(res["end_height"], 150)
+        assert_equal(res["blocks"], 151)
+        assert os.path.isfile(os.path.join(bootstrap_dir, "index.dat"))
+        assert os.path.isfile(os.path.join(bootstrap_dir, "blocks00000.dat"))
+
+        self.log.info("Import it on an unconnected node")
+        self.stop_node(1)
+        self.start_node(1, ["-loadbootstrap=%s" % bootstrap_dir])
+        wait_until(lambda: self.nodes[1].getbestblockhash() == tip)
+
+        self.log.info("Import it again, everything is already known")
+        self.stop_node(1)
+        self.start_node(1, ["-loadbootstrap=%s" % bootstrap_dir])
+        wait_until(lambda: self.nodes[1].getbestblockhash() == tip)
+        assert_equal(self.nodes[1].getblockcount(), 150)
+
+if __name__ == '__main__':
+    LoadBootstrapTest().main()
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020-2022 The Raptoreum developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the dumptxoutset RPC and the -loadtxoutset startup option.
+
+- Generate blocks on node 0 and write a UTXO snapshot with dumptxoutset.
+- Starting node 1 from the snapshot fails without the snapshot hash or with a
+  different one, and leaves the datadir empty. It also fails with an index
+  like -txindex that would miss the history below the snapshot.
+- Start node 1 on an empty datadir with -loadtxoutset and verify it starts at the
+  snapshot's block with the same UTXO set.
+- Connect the nodes and verify node 1 follows the tip, with the UTXO set
+  statistics maintained by -coinstatsindex matching a full scan on node 0.
+- Restart node 1, -loadtxoutset is ignored once the datadir is in use.
+"""
+
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error, connect_nodes
+
+class UTXOSnapshotTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+
+    def setup_network(self):
+        # node 1 must not create its genesis block before the snapshot exists
+        self.add_nodes(self.num_nodes)
+        self.start_node(0)
+
+    def run_test(self):
+        node0 = self.nodes[0]
+        node0.generate(150)
+        node0.sendtoaddress(node0.getnewaddress(), 10)
+        node0.generate(1)
+
+        self.log.info("Write the snapshot")
+        res = node0.dumptxoutset("utxo.dat")
+        snapshot_path = os.path.join(node0.datadir, "regtest", "utxo.dat")
+        assert_equal(res["path"], snapshot_path)
+        assert_equal(res["base_hash"], node0.getbestblockhash())
+        assert_equal(res["base_height"], 151)
+        assert res["evo_entries_written"] > 0
+        utxo_info = node0.gettxoutsetinfo("muhash")
+        assert_equal(res["muhash"], utxo_info["muhash"])
+        assert_equal(res["coins_written"], utxo_info["txouts"])
+        assert_raises_rpc_error(-8, "already exists", node0.dumptxoutset, "utxo.dat")
+        assert_raises_rpc_error(-8, "requires -coinstatsindex", node0.gettxoutsetinfo, "muhash", 151)
+
+        self.log.info("Refuse the snapshot without the trusted snapshot hash")
+        self.nodes[1].assert_start_raises_init_error(["-loadtxoutset=%s" % snapshot_path],
+                                                     "-loadtxoutset requires -loadtxoutsethash", partial_match=True)
+        self.nodes[1].assert_start_raises_init_error(["-loadtxoutset=%s" % snapshot_path, "-loadtxoutsethash=%s" % ("00" * 32)],
+                                                     "doesn't match the expected", partial_match=True)
+
+        self.log.info("Refuse the snapshot with indexes it can't provide the history for")
+        self.nodes[1].assert_start_raises_init_error(["-loadtxoutset=%s" % snapshot_path, "-loadtxoutsethash=%s" % res["snapshot_hash"], "-txindex=1"],
+                                                     "-loadtxoutset is incompatible with -txindex", partial_match=True)
+        self.nodes[1].assert_start_raises_init_error(["-loadtxoutset=%s" % snapshot_path, "-loadtxoutsethash=%s" % res["snapshot_hash"], "-addressindex=1"],
+                                                     "-loadtxoutset is incompatible with -txindex", partial_match=True)
+
+        self.log.info("Start a new node from the snapshot")
+        self.start_node(1, ["-loadtxoutset=%s" % snapshot_path, "-loadtxoutsethash=%s" % res["snapshot_hash"], "-coinstatsindex"])
+        node1 = self.nodes[1]
+        assert_equal(node1.getbestblockhash(), res["base_hash"])
+        assert_equal(node1.gettxoutsetinfo("muhash")["muhash"], res["muhash"])
+        assert_raises_rpc_error(-1, "pruned data", node1.getblock, node0.getblockhash(100))
+
+        self.log.info("Follow the tip")
+        connect_nodes(node1, 0)
+        node0.generate(10)
+        self.sync_blocks()
+        assert_equal(node1.getblockcount(), 161)
+        assert_equal(node1.gettxoutsetinfo("muhash")["muhash"], node0.gettxoutsetinfo("muhash")["muhash"])
+        assert_equal(node1.gettxoutsetinfo("muhash", 151)["muhash"], res["muhash"])
+        assert_equal(node1.gettxoutsetinfo("none", res["base_hash"])["txouts"], res["coins_written"])
+        assert_raises_rpc_error(-1, "No UTXO set statistics", node1.gettxoutsetinfo, "muhash", 150)
+
+        self.log.info("Restart, the snapshot is only loaded once")
+        self.restart_node(1, ["-loadtxoutset=%s" % snapshot_path, "-coinstatsindex"])
+        assert_equal(self.nodes[1].getblockcount(), 161)
+        # The statistics were persisted, including the per block entries
+        assert_equal(self.nodes[1].gettxoutsetinfo("muhash")["muhash"], node0.gettxoutsetinfo("muhash")["muhash"])
+        assert_equal(self.nodes[1].gettxoutsetinfo("none", 160)["height"], 160)
+
+if __name__ == '__main__':
+    UTXOSnapshotTest().main()
@@ -3,6 +3,8 @@
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test raptoreum-cli"""
+import json
+
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import assert_equal, assert_raises_process_error, get_auth_cookie
 
@@ -35,6 +37,17 @@ class TestBitcoinCli(BitcoinTestFramework):
         assert_equal(["foo", "bar"], self.nodes[0].cli('-rpcuser=%s' % user, '-stdin', '-stdinrpcpass', input=password + "\nfoo\nbar").echo())
         assert_raises_process_error(1, "Incorrect rpcuser or rpcpassword", self.nodes[0].cli('-rpcuser=%s' % user, '-stdin', '-stdinrpcpass', input="foo").echo)
 
+        self.log.info("Test -stdinbatch")
+        commands = "getblockcount\necho 'a b' \"c\"\n\ngetblockhash 0\n"
+        for options in (['-stdinbatch'], ['-stdinbatch', '-stdinbatchsize=2'], ['-stdinbatch', '-stdinbatchconnections=2']):
+            cli_response = self.nodes[0].cli(*options, input=commands).send_cli()
+            replies = sorted((json.loads(line) for line in cli_response.splitlines()), key=lambda reply: reply['id'])
+            assert_equal([reply['id'] for reply in replies], [1, 2, 4])
+            assert_equal(replies[0]['result'], 0)
+            assert_equal(replies[1]['result'], ["a b", "c"])
+            assert_equal(replies[2]['result'], self.nodes[0].getblockhash(0))
+        assert_raises_process_error(1, "-stdinbatch takes the commands from standard input only", self.nodes[0].cli('-stdinbatch').echo)
+
         self.log.info("Test connecting to a non-existing server")
         assert_raises_process_error(1, "Could not connect to the server", self.nodes[0].cli('-rpcport=1').echo)
 
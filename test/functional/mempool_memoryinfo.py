@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020-2022 The Raptoreum developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the getmempoolmemoryinfo RPC.
+
+- Check every field is reported and that the structures counted against
+  -maxmempool add up to the usage reported by getmempoolinfo.
+- Fill the mempool with a chain of transactions, prioritise one of them and
+  check each structure grows.
+- Mine the transactions and check the per transaction structures are empty
+  again.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+FIELDS = [
+    'size',
+    'usage',
+    'entries',
+    'transactions',
+    'links',
+    'nexttx',
+    'deltas',
+    'txhashes',
+    'addressindex',
+    'spentindex',
+    'futureindex',
+    'protx',
+]
+
+# Counted against -maxmempool, they make up getmempoolinfo's usage
+USAGE_FIELDS = ['entries', 'transactions', 'links', 'nexttx', 'deltas', 'txhashes']
+
+# Structures holding one or more items per mempool transaction
+PER_TX_FIELDS = ['entries', 'transactions', 'nexttx', 'addressindex', 'spentindex']
+
+class MempoolMemoryInfoTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+        self.extra_args = [['-addressindex', '-spentindex']]
+
+    def check_memoryinfo(self):
+        node = self.nodes[0]
+        info = node.getmempoolmemoryinfo()
+        assert_equal(sorted(info.keys()), sorted(FIELDS))
+        for field in FIELDS:
+            assert isinstance(info[field], int)
+            assert info[field] >= 0
+        mempoolinfo = node.getmempoolinfo()
+        assert_equal(info['size'], mempoolinfo['size'])
+        assert_equal(info['usage'], mempoolinfo['usage'])
+        assert_equal(info['usage'], sum(info[field] for field in USAGE_FIELDS))
+        return info
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.generate(110)
+
+        self.log.info("Check an empty mempool")
+        info = self.check_memoryinfo()
+        assert_equal(info['size'], 0)
+        for field in PER_TX_FIELDS + ['deltas', 'futureindex', 'protx']:
+            assert_equal(info[field], 0)
+
+        self.log.info("Check a chain of unconfirmed transactions")
+        txids = []
+        for i in range(10):
+            # Each send spends the change of the previous one
+            txids.append(node.sendtoaddress(node.getnewaddress(), 1))
+        info = self.check_memoryinfo()
+        assert_equal(info['size'], len(txids))
+        for field in PER_TX_FIELDS + ['links', 'txhashes']:
+            assert info[field] > 0
+        # Entries are fixed size
+        assert_equal(info['entries'] % len(txids), 0)
+        assert_equal(info['deltas'], 0)
+
+        node.prioritisetransaction(txids[0], 1000)
+        prioritised = self.check_memoryinfo()
+        assert prioritised['deltas'] > 0
+        assert_equal(prioritised['entries'], info['entries'])
+
+        self.log.info("Check the mempool is empty again after mining")
+        node.generate(1)
+        info = self.check_memoryinfo()
+        assert_equal(info['size'], 0)
+        for field in PER_TX_FIELDS + ['deltas']:
+            assert_equal(info[field], 0)
+
+if __name__ == '__main__':
+    MempoolMemoryInfoTest().main()
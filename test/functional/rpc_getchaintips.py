@@ -62,5 +62,13 @@ class GetChainTipsTest (BitcoinTestFramework):
         tips[1]['forkpoint'] = tips[1]['hash']
         assert_equal (tips[1], shortTip)
 
+        # Only the nodes on the short chain reorged, and all 10 of its blocks at once
+        reorgs = self.nodes[0].getblockchaininfo()['reorgs']
+        assert_equal (reorgs['count'], 1)
+        assert_equal (reorgs['blocks_disconnected'], 10)
+        assert_equal (reorgs['last_depth'], 10)
+        assert_equal (reorgs['max_depth'], 10)
+        assert_equal (self.nodes[3].getblockchaininfo()['reorgs']['count'], 0)
+
 if __name__ == '__main__':
     GetChainTipsTest ().main ()
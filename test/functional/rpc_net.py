@@ -101,6 +101,10 @@ class NetTest(BitcoinTestFramework):
         # the address bound to on one side will be the source address for the other node
         assert_equal(peer_info[0][0]['addrbind'], peer_info[1][0]['addr'])
         assert_equal(peer_info[1][0]['addrbind'], peer_info[0][0]['addr'])
+        # no blocks were requested since the nodes started from the same cached chain
+        for info in peer_info:
+            assert_equal(info[0]['block_download'], {'blocks': 0, 'bytes': 0, 'avg_block_time': 0, 'bytes_per_sec': 0,
+                                                     'rerequested_away': 0, 'rerequested_here': 0})
 
 if __name__ == '__main__':
     NetTest().main()
@@ -96,12 +96,16 @@ BASE_SCRIPTS= [
     'feature_csv_activation.py',
     'rpc_rawtransaction.py',
     'feature_reindex.py',
+    'feature_loadbootstrap.py',
+    'feature_utxo_snapshot.py',
+    'feature_blockstatsindex.py',
     # vv Tests less than 30s vv
     'wallet_keypool_topup.py',
     'interface_zmq_dash.py',
     'interface_zmq.py',
     'interface_bitcoin_cli.py',
     'mempool_resurrect.py',
+    'mempool_memoryinfo.py',
     'wallet_txn_doublespend.py --mineblock',
     'wallet_txn_clone.py',
     'rpc_getchaintips.py',